@@ -0,0 +1,358 @@
+#include "io/ioapi_sys.hpp"
+#include "io/instrumented_ioapi.hpp"
+#include "bench/load.hpp"
+#include "metrics.hpp"
+#include "server.hpp"
+
+#include <cstdio>
+#include <thread>
+#include <optional>
+#include <csignal>
+#include <iostream>
+#include <exception>
+
+/* Starts a Server on loopback and measures it with the load generator,
+ * printing one JSON object. For example:
+ *
+ *     alewa_bench --backend=epoll --connections=64 --pipeline=8 \
+ *                 --request=GET:/alewa.jpg:9 --request=GET:/missing:1
+ *
+ * Running it with --topology=reuseport and then --topology=acceptor at the
+ * same --server-threads compares the two ways of spreading clients.
+ */
+
+namespace {
+
+using namespace alewa;
+
+struct Options
+{
+    std::string backend = "poll";  /* poll, epoll or uring */
+    unsigned server_threads = 1;
+    std::string topology = "reuseport";  /* or acceptor */
+    unsigned client_threads = 1;
+    unsigned backlog = 4096;
+    double duration = 5.0;  /* seconds measured, after the warm-up */
+    double warmup = 1.0;
+    std::string docroot = "data";
+    bool response_cache = true;
+    bool instrument = false;  /* report the server's own metrics too */
+    bench::LoadConfig load{};
+};
+
+struct Measurement
+{
+    bench::LoadResult load;
+    std::optional<MetricsSnapshot> server;  /* whole run, warm-up included */
+};
+
+auto usage() -> char const *
+{
+    return "usage: alewa_bench [--backend=poll|epoll|uring]"
+           " [--server-threads=N] [--topology=reuseport|acceptor]"
+           " [--client-threads=N] [--connections=N]"
+           " [--pipeline=N] [--keep-alive=0|1] [--duration=S] [--warmup=S]"
+           " [--port=P] [--backlog=N] [--docroot=DIR] [--response-cache=0|1]"
+           " [--instrument=0|1] [--request=METHOD:TARGET[:WEIGHT]]...";
+}
+
+auto to_unsigned(std::string_view value) -> unsigned
+{
+    unsigned n = 0;
+    auto const [p, ec] = std::from_chars(value.data(),
+                                         value.data() + value.size(), n);
+    if (ec != std::errc{} || p != value.data() + value.size()) {
+        throw std::runtime_error{"not a number: " + std::string{value}};
+    }
+    return n;
+}
+
+auto to_seconds(std::string_view value) -> double
+{
+    std::size_t used = 0;
+    double const s = std::stod(std::string{value}, &used);
+    if (used != value.size() || s < 0) {
+        throw std::runtime_error{"not a duration: " + std::string{value}};
+    }
+    return s;
+}
+
+auto to_request(std::string_view value) -> bench::Request
+{
+    auto const colon = value.find(':');
+    if (colon == value.npos) {
+        throw std::runtime_error{"not METHOD:TARGET: " + std::string{value}};
+    }
+    bench::Request request{std::string{value.substr(0, colon)}, {}, 1};
+    value.remove_prefix(colon + 1);
+    auto const weight = value.rfind(':');
+    if (weight != value.npos) {
+        request.weight = to_unsigned(value.substr(weight + 1));
+        value = value.substr(0, weight);
+    }
+    request.target = value;
+    return request;
+}
+
+auto parse(int argc, char* argv[]) -> Options
+{
+    Options options;
+    options.load.port = "18700";
+    options.load.mix = {{"GET", "/alewa.jpg", 1}};
+    std::vector<bench::Request> mix;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        auto const eq = arg.find('=');
+        if (arg.substr(0, 2) != "--" || eq == arg.npos) {
+            throw std::runtime_error{"bad argument: " + std::string{arg}};
+        }
+        std::string_view const name = arg.substr(2, eq - 2);
+        std::string_view const value = arg.substr(eq + 1);
+
+        if (name == "backend") { options.backend = value; }
+        else if (name == "server-threads") {
+            options.server_threads = to_unsigned(value);
+        }
+        else if (name == "topology") { options.topology = value; }
+        else if (name == "client-threads") {
+            options.client_threads = std::max(to_unsigned(value), 1u);
+        }
+        else if (name == "connections") {
+            options.load.connections = to_unsigned(value);
+        }
+        else if (name == "pipeline") {
+            options.load.pipeline = to_unsigned(value);
+        }
+        else if (name == "keep-alive") {
+            options.load.keep_alive = to_unsigned(value) != 0;
+        }
+        else if (name == "duration") { options.duration = to_seconds(value); }
+        else if (name == "warmup") { options.warmup = to_seconds(value); }
+        else if (name == "port") { options.load.port = value; }
+        else if (name == "backlog") { options.backlog = to_unsigned(value); }
+        else if (name == "docroot") { options.docroot = value; }
+        else if (name == "response-cache") {
+            options.response_cache = to_unsigned(value) != 0;
+        }
+        else if (name == "instrument") {
+            options.instrument = to_unsigned(value) != 0;
+        }
+        else if (name == "request") { mix.push_back(to_request(value)); }
+        else {
+            throw std::runtime_error{"unknown option: " + std::string{arg}};
+        }
+    }
+    if (options.backend != "poll" && options.backend != "epoll"
+        && options.backend != "uring") {
+        throw std::runtime_error{"unknown backend: " + options.backend};
+    }
+    if (options.topology != "reuseport" && options.topology != "acceptor") {
+        throw std::runtime_error{"unknown topology: " + options.topology};
+    }
+    if (!mix.empty()) { options.load.mix = std::move(mix); }
+    return options;
+}
+
+/* Connections are dealt out round robin, so every client thread gets at
+ * least one as long as there are enough to go round. */
+auto share(bench::LoadConfig load, unsigned thread, unsigned nthreads)
+        -> bench::LoadConfig
+{
+    load.connections = load.connections / nthreads
+                       + (thread < load.connections % nthreads ? 1 : 0);
+    load.seed += thread;
+    return load;
+}
+
+template <io::IoApi T>
+auto measure(Options const & options) -> Measurement
+{
+    ServerConfig config;
+    config.threads = options.server_threads;
+    config.single_acceptor = options.topology == "acceptor";
+    config.docroot = options.docroot;
+    config.io_uring = options.backend == "uring";
+    config.backlog = static_cast<int>(options.backlog);
+    if (!options.response_cache) { config.response_cache_bytes = 0; }
+
+    T server_api;
+    Server<T> server{server_api, config};
+    std::exception_ptr server_error;
+    std::thread serving{[&] {
+        try {
+            server.start(options.load.port);
+        }
+        catch (...) {
+            server_error = std::current_exception();
+        }
+    }};
+
+    /* the server is up once its listener takes a connection */
+    io::EpollIoApi client_api;
+    for (int attempt = 0;; ++attempt) {
+        try {
+            bench::LoadConfig probe = options.load;
+            probe.connections = 1;
+            bench::LoadGenerator<io::EpollIoApi> generator{client_api, probe};
+            auto const now = bench::Clock::now();
+            generator.run(now, now);
+            break;
+        }
+        catch (std::runtime_error const &) {
+            if (attempt == 500 || server_error) {
+                server.stop();
+                serving.join();
+                if (server_error) { std::rethrow_exception(server_error); }
+                throw;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        }
+    }
+
+    auto const start = bench::Clock::now();
+    auto const from = start + std::chrono::duration_cast<
+            bench::Clock::duration>(std::chrono::duration<double>{
+                    options.warmup});
+    auto const until = from + std::chrono::duration_cast<
+            bench::Clock::duration>(std::chrono::duration<double>{
+                    options.duration});
+
+    unsigned const n = options.client_threads;
+    std::vector<bench::LoadResult> results(n);
+    std::vector<std::exception_ptr> errors(n);
+    std::vector<std::thread> clients;
+    for (unsigned i = 0; i < n; ++i) {
+        clients.emplace_back([&, i] {
+            try {
+                bench::LoadGenerator<io::EpollIoApi> generator{
+                        client_api, share(options.load, i, n)};
+                results[i] = generator.run(from, until);
+            }
+            catch (...) {
+                errors[i] = std::current_exception();
+            }
+        });
+    }
+    for (auto& client : clients) { client.join(); }
+
+    server.stop();
+    serving.join();
+    if (server_error) { std::rethrow_exception(server_error); }
+    for (auto const & error : errors) {
+        if (error) { std::rethrow_exception(error); }
+    }
+
+    Measurement m;
+    for (auto const & result : results) { m.load.merge(result); }
+    if constexpr (requires { server_api.metrics(); }) {
+        m.server = server_api.metrics().scrape();
+    }
+    return m;
+}
+
+template <io::IoApi T>
+auto measure_on(Options const & options) -> Measurement
+{
+    if (options.instrument) { return measure<io::Instrumented<T>>(options); }
+    return measure<T>(options);
+}
+
+void report(MetricsSnapshot const & s)
+{
+    auto const us = [](Histogram const & h, double q) {
+        return static_cast<double>(h.quantile(q)) / 1e3;
+    };
+
+    std::printf(",\"server\":{\"wakeups\":%lu,\"ready_per_wakeup\":"
+                "{\"mean\":%.2f,\"p99\":%lu},\"accepts\":%lu,"
+                "\"accepts_per_batch_p99\":%lu,\"bytes_in\":%lu,"
+                "\"bytes_out\":%lu,\"syscalls\":{",
+                s.wakeups, s.ready_per_wakeup.mean(),
+                s.ready_per_wakeup.quantile(0.99), s.accepts,
+                s.accepts_per_batch.quantile(0.99), s.bytes_in, s.bytes_out);
+    char const * sep = "";
+    for (std::size_t i = 0; i < s.syscalls.size(); ++i) {
+        auto const & c = s.syscalls[i];
+        if (c.calls == 0) { continue; }
+        std::string const name{syscall_name(static_cast<Syscall>(i))};
+        std::printf("%s\"%s\":{\"calls\":%lu,\"errors\":%lu,"
+                    "\"mean_us\":%.2f,\"p50_us\":%.2f,\"p99_us\":%.2f,"
+                    "\"p999_us\":%.2f}",
+                    sep, name.c_str(), c.calls, c.errors,
+                    static_cast<double>(c.ns) / static_cast<double>(c.calls)
+                    / 1e3,
+                    us(c.latency, 0.5), us(c.latency, 0.99),
+                    us(c.latency, 0.999));
+        sep = ",";
+    }
+    std::printf("}}");
+}
+
+void report(Options const & options, Measurement const & m)
+{
+    bench::LoadResult const & result = m.load;
+    auto const us = [&](double q) {
+        return static_cast<double>(result.latency.quantile(q)) / 1e3;
+    };
+
+    std::printf("{\"backend\":\"%s\",\"server_threads\":%u,"
+                "\"topology\":\"%s\",\"client_threads\":%u,\"connections\":%u,\"pipeline\":%u,"
+                "\"keep_alive\":%s,\"duration_s\":%.3f,",
+                options.backend.c_str(), options.server_threads,
+                options.topology.c_str(), options.client_threads, options.load.connections,
+                options.load.keep_alive ? options.load.pipeline : 1u,
+                options.load.keep_alive ? "true" : "false", options.duration);
+    std::printf("\"requests\":%lu,\"requests_per_s\":%.1f,\"bytes\":%lu,"
+                "\"connects\":%lu,\"errors\":%lu,\"status\":{",
+                result.responses,
+                static_cast<double>(result.responses) / options.duration,
+                result.bytes, result.connects, result.errors);
+    char const * sep = "";
+    for (auto const & [status, n] : result.statuses) {
+        std::printf("%s\"%d\":%lu", sep, status, n);
+        sep = ",";
+    }
+    std::printf("},\"latency_us\":{\"min\":%.1f,\"mean\":%.1f,\"p50\":%.1f,"
+                "\"p90\":%.1f,\"p99\":%.1f,\"p999\":%.1f,\"max\":%.1f}",
+                static_cast<double>(result.latency.min()) / 1e3,
+                result.latency.mean() / 1e3, us(0.5), us(0.9), us(0.99),
+                us(0.999), static_cast<double>(result.latency.max()) / 1e3);
+    if (m.server) { report(*m.server); }
+    std::printf("}\n");
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    std::signal(SIGPIPE, SIG_IGN);
+
+    Options options;
+    try {
+        options = parse(argc, argv);
+    }
+    catch (std::exception const & e) {
+        std::cerr << e.what() << "\n" << usage() << std::endl;
+        return 2;
+    }
+
+    try {
+        Measurement m;
+        if (options.backend == "poll") {
+            m = measure_on<io::SysIoApi>(options);
+        }
+        else if (options.backend == "epoll") {
+            m = measure_on<io::EpollIoApi>(options);
+        }
+        else {
+            m = measure_on<io::IoUringIoApi>(options);
+        }
+        report(options, m);
+    }
+    catch (std::exception const & e) {
+        std::cerr << "alewa_bench: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -1,17 +1,57 @@
 #include "io/ioapi_sys.hpp"
+#include "io/instrumented_ioapi.hpp"
 #include "server.hpp"
 
+#include <atomic>
+#include <csignal>
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+using IoApi = alewa::io::Instrumented<alewa::io::IoUringIoApi>;
+
+/* Read by the signal handler, which only lock-free atomics are safe in. */
+std::atomic<alewa::Server<IoApi>*> running{nullptr};
+static_assert(std::atomic<alewa::Server<IoApi>*>::is_always_lock_free);
+
+extern "C" void on_terminate(int)
+{
+    if (auto* server = running.load()) { server->stop(); }
+}
+
+}  // namespace
+
 int main(/*int argc, char* argv[]*/)
 {
     using namespace alewa;
 
     std::string const PORT = "8080";
-    int const BACKLOG = 10;
 
-    io::SysIoApi ioapi;
+    ServerConfig config;
+    config.threads = std::thread::hardware_concurrency();
+    config.admin_port = "8081";  /* GET /metrics, loopback only */
+    /* gzips files for the reactors, which would otherwise send only the
+     * precompressed ones */
+    config.pool_threads = std::max(config.threads / 2, 1u);
+    /* A restart takes over from us through a socket in the per-user runtime
+     * directory, which only our user can reach; without one, restarts
+     * drop the listeners. */
+    char const * const runtime = std::getenv("XDG_RUNTIME_DIR");
+    if (runtime && runtime[0] == '/') {
+        config.handoff_path = std::string{runtime} + "/alewa.handoff";
+    }
+
+    IoApi ioapi;
+
+    Server<IoApi> server{ioapi, config};
+    running = &server;
+    std::signal(SIGINT, on_terminate);
+    std::signal(SIGTERM, on_terminate);
+    std::signal(SIGPIPE, SIG_IGN);  /* a vanished peer fails the write */
 
-    Server<io::SysIoApi> server{ioapi};
-    server.start(PORT, BACKLOG);
+    server.start(PORT);
 
+    running = nullptr;
     return 0;
 }
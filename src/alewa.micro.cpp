@@ -0,0 +1,97 @@
+#include "bench/micro.hpp"
+#include "io/socket.micro.cpp"
+#include "registry.micro.cpp"
+#include "spsc_queue.micro.cpp"
+#include "work_pool.micro.cpp"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <charconv>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <string_view>
+
+/* Runs every registered microbenchmark at each problem size and prints one
+ * JSON object per line with the fastest and the median time per operation
+ * over the repetitions:
+ *
+ *     alewa_micro [--filter=SUBSTRING] [--sizes=N,...] [--repeat=N]
+ */
+
+using namespace alewa::bench;
+
+namespace {
+
+auto to_size(std::string_view value) -> std::size_t
+{
+    std::size_t n = 0;
+    auto const [p, ec] = std::from_chars(value.data(),
+                                         value.data() + value.size(), n);
+    if (ec != std::errc{} || p != value.data() + value.size() || n == 0) {
+        throw std::runtime_error{"not a count: " + std::string{value}};
+    }
+    return n;
+}
+
+void run(BenchCase const & bench, std::size_t size, std::size_t repeat)
+{
+    std::vector<double> times;
+    for (std::size_t r = 0; r < repeat; ++r) {
+        State state{size};
+        bench.run(state);
+        times.push_back(state.ns_per_op());
+    }
+    std::sort(times.begin(), times.end());
+    std::printf("{\"bench\":\"%s\",\"size\":%zu,\"ns_per_op_min\":%.2f,"
+                "\"ns_per_op_median\":%.2f}\n",
+                bench.name.c_str(), size, times.front(),
+                times[times.size() / 2]);
+    std::fflush(stdout);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    std::string filter;
+    std::vector<std::size_t> sizes{1'000, 10'000, 100'000, 1'000'000};
+    std::size_t repeat = 5;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string_view const arg = argv[i];
+            auto const eq = arg.find('=');
+            std::string_view const name = arg.substr(0, eq);
+            std::string_view value = (eq == arg.npos) ? ""
+                                                      : arg.substr(eq + 1);
+            if (name == "--filter") { filter = value; }
+            else if (name == "--repeat") { repeat = to_size(value); }
+            else if (name == "--sizes") {
+                sizes.clear();
+                for (auto comma = value.find(','); !value.empty();
+                     comma = value.find(',')) {
+                    sizes.push_back(to_size(value.substr(0, comma)));
+                    value = (comma == value.npos) ? ""
+                                                  : value.substr(comma + 1);
+                }
+            }
+            else {
+                throw std::runtime_error{"unknown option: "
+                                         + std::string{arg}};
+            }
+        }
+    }
+    catch (std::exception const & e) {
+        std::cerr << e.what() << "\nusage: alewa_micro [--filter=SUBSTRING]"
+                  << " [--sizes=N,...] [--repeat=N]" << std::endl;
+        return 2;
+    }
+
+    for (BenchCase const & bench : benches) {
+        if (bench.name.find(filter) == std::string::npos) { continue; }
+        for (std::size_t size : sizes) { run(bench, size, repeat); }
+    }
+    return 0;
+}
@@ -1,7 +1,36 @@
 #include <algorithm>
 
 #include "test/test_utils.hpp"
+#include "io/ring.test.cpp"
 #include "io/socket.test.cpp"
+#include "io/poller.test.cpp"
+#include "io/waker.test.cpp"
+#include "io/instrumented_ioapi.test.cpp"
+#include "timer_wheel.test.cpp"
+#include "histogram.test.cpp"
+#include "exporter.test.cpp"
+#include "admission.test.cpp"
+#include "spsc_queue.test.cpp"
+#include "mpmc_queue.test.cpp"
+#include "dispatch.test.cpp"
+#include "work_pool.test.cpp"
+#include "loop.test.cpp"
+#include "listener.test.cpp"
+#include "handoff.test.cpp"
+#include "registry.test.cpp"
+#include "buffer_pool.test.cpp"
+#include "output_queue.test.cpp"
+#include "file_cache.test.cpp"
+#include "response_cache.test.cpp"
+#include "compressor.test.cpp"
+#include "http/parser.test.cpp"
+#include "http/response.test.cpp"
+#include "http/path.test.cpp"
+#include "reactor.test.cpp"
+#include "uring_reactor.test.cpp"
+#include "server.test.cpp"
+#include "tls.test.cpp"
+#include "bench/load.test.cpp"
 
 using namespace alewa::test;
 
@@ -0,0 +1 @@
+#include "admission.hpp"
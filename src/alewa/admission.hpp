@@ -0,0 +1,171 @@
+#pragma once
+
+#include <limits>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+#include "io/ioapi.hpp"
+#include "config.hpp"
+#include "listener.hpp"
+#include "buffer_pool.hpp"
+#include "timer_wheel.hpp"
+
+namespace alewa {
+
+namespace detail {
+/* See listener.hpp. */
+#include <fcntl.h>
+
+static int const SPARE_FLAGS = O_RDONLY | O_CLOEXEC;
+static char const SPARE_PATH[] = "/dev/null";
+}  // namespace alewa::detail
+
+/* When one reactor takes new clients from its main listener. It stops at
+ * its share of config.max_connections or once every 4 KiB buffer is lent
+ * out, and resumes when both are back to the low watermark, so a spike
+ * waits in the backlog instead of slowing down the clients already served.
+ * Out of fds altogether, a reactor refuses clients instead: a spare fd kept
+ * open for the purpose is given up to accept each waiting client and hang
+ * up on it at once, where it would otherwise sit in the backlog until it
+ * timed out. If not even that fd can be had, accepting pauses until a
+ * client has gone or, should none go, for RETRY_AFTER milliseconds: with
+ * fds exhausted system-wide a reactor holding no clients would otherwise
+ * be woken by the same waiting client on every turn. */
+template <io::IoApi T>
+class Admission
+{
+private:
+    using Tick = TimerWheel::Tick;
+
+    static constexpr std::size_t NOT_STARVED =
+            std::numeric_limits<std::size_t>::max();
+    static constexpr Tick RETRY_AFTER = 100;
+
+    T const & ioapi;
+    std::size_t max_clients;
+    std::size_t resume_clients;
+    std::size_t max_buffers;
+    std::size_t resume_buffers;
+    std::size_t max_shed;
+    std::size_t starved_at = NOT_STARVED;  /* clients when fds ran out */
+    Tick retry_at = 0;  /* when accepting is tried again regardless */
+    int spare;
+    bool pausing = false;
+    std::uint64_t refused = 0;
+
+public:
+    Admission(T const & ioapi, ServerConfig const & config);
+    ~Admission();
+
+    Admission(Admission&) = delete;
+    Admission& operator=(Admission&) = delete;
+
+    /* Clients that may still be accepted while `clients` are held. */
+    [[nodiscard]]
+    auto room(std::size_t clients) const noexcept -> std::size_t
+    {
+        return clients < max_clients ? max_clients - clients : 0;
+    }
+
+    /* Whether accepting is paused from now on, given the clients held,
+     * the buffers lent out and the reactor's Deadlines::now(). */
+    auto update(std::size_t clients, BufferPool const & buffers, Tick now)
+            noexcept -> bool;
+
+    [[nodiscard]]
+    auto paused() const noexcept -> bool { return pausing; }
+
+    /* Milliseconds the reactor may block for before accepting is retried,
+     * -1 when no retry is due. */
+    [[nodiscard]]
+    auto poll_timeout(Tick now) const noexcept -> int;
+
+    /* Refuse the clients waiting on `listener`, which accept could not take
+     * for want of an fd, up to one batch of them. Returns how many. */
+    auto shed(int listener, std::size_t clients, Tick now) -> std::size_t;
+
+    /* Clients refused so far. */
+    [[nodiscard]]
+    auto rejected() const noexcept -> std::uint64_t { return refused; }
+};
+
+template <io::IoApi T>
+Admission<T>::Admission(T const & ioapi, ServerConfig const & config)
+        : ioapi(ioapi),
+          max_shed(std::max<std::size_t>(config.accept_batch, 1)),
+          spare(ioapi.open(detail::SPARE_PATH, detail::SPARE_FLAGS))
+{
+    std::size_t const reactors = std::max(config.threads, 1u);
+    std::size_t const percent = std::min(config.accept_resume_percent, 100u);
+    max_clients = std::max<std::size_t>(config.max_connections / reactors, 1);
+    resume_clients = max_clients * percent / 100;
+    max_buffers = config.buffer_limits[0];
+    resume_buffers = max_buffers * percent / 100;
+}
+
+template <io::IoApi T>
+Admission<T>::~Admission()
+{
+    if (spare != T::ERROR) { ioapi.close(spare); }
+}
+
+template <io::IoApi T>
+auto Admission<T>::update(std::size_t clients, BufferPool const & buffers,
+                          Tick now) noexcept -> bool
+{
+    if (starved_at != NOT_STARVED && now >= retry_at) {
+        starved_at = NOT_STARVED;
+    }
+    std::size_t const lent = buffers.stats(0).in_use;
+    bool const buffers_out = max_buffers > 0 && lent >= max_buffers;
+    if (!pausing) {
+        pausing = clients >= max_clients || buffers_out
+                  || clients >= starved_at;
+    }
+    else if (clients <= resume_clients && clients < starved_at
+             && (max_buffers == 0 || lent <= resume_buffers)) {
+        pausing = false;
+        starved_at = NOT_STARVED;
+    }
+    return pausing;
+}
+
+template <io::IoApi T>
+auto Admission<T>::poll_timeout(Tick now) const noexcept -> int
+{
+    if (starved_at == NOT_STARVED) { return -1; }
+    if (retry_at <= now) { return 0; }
+    Tick const ticks = retry_at - now;
+    return (ticks > INT_MAX) ? INT_MAX : static_cast<int>(ticks);
+}
+
+template <io::IoApi T>
+auto Admission<T>::shed(int listener, std::size_t clients, Tick now)
+        -> std::size_t
+{
+    if (spare == T::ERROR) {
+        spare = ioapi.open(detail::SPARE_PATH, detail::SPARE_FLAGS);
+    }
+    if (spare == T::ERROR) {
+        starved_at = clients;
+        retry_at = now + RETRY_AFTER;
+        pausing = true;
+        return 0;
+    }
+
+    ioapi.close(spare);
+    std::size_t n = 0;
+    for (; n < max_shed; ++n) {
+        int const fd = ioapi.accept4(listener, nullptr, nullptr,
+                                     detail::ACCEPT_FLAGS);
+        if (fd == T::ERROR) { break; }
+        ioapi.close(fd);
+    }
+    spare = ioapi.open(detail::SPARE_PATH, detail::SPARE_FLAGS);
+    refused += n;
+    return n;
+}
+
+}  // namespace alewa
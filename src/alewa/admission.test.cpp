@@ -0,0 +1,102 @@
+#include "test/test_utils.hpp"
+
+#include <vector>
+
+#include "admission.hpp"
+#include "io/sockapi_mock.hpp"
+
+namespace alewa::test {
+
+using io::test::MockIoApi;
+
+namespace {
+
+auto admission_config() -> ServerConfig
+{
+    ServerConfig config;
+    config.threads = 2;
+    config.max_connections = 20;  /* 10 per reactor */
+    config.accept_resume_percent = 50;
+    config.accept_batch = 4;
+    config.buffer_limits = {4, 4, 4};
+    return config;
+}
+
+}  // namespace
+
+ALW_TEST(admission_pauses_at_limit_and_resumes_at_watermark)
+{
+    MockIoApi api;
+    api.files["/dev/null"] = {};
+    BufferPool buffers{{4, 4, 4}};
+    Admission<MockIoApi> admission{api, admission_config()};
+
+    ALW_EXPECT_EQ(admission.room(7), 3ul);
+    ALW_EXPECT_EQ(admission.room(12), 0ul);
+
+    ALW_EXPECT_EQ(admission.update(9, buffers, 0), false);
+    ALW_EXPECT_EQ(admission.update(10, buffers, 0), true);
+    ALW_EXPECT_EQ(admission.update(6, buffers, 0), true);  /* above 5 */
+    ALW_EXPECT_EQ(admission.update(5, buffers, 0), false);
+
+    /* lending out every 4 KiB buffer pauses too */
+    std::vector<Buffer> held;
+    for (int i = 0; i < 4; ++i) { held.push_back(buffers.acquire()); }
+    ALW_EXPECT_EQ(admission.update(1, buffers, 0), true);
+    held.pop_back();
+    ALW_EXPECT_EQ(admission.update(1, buffers, 0), true);  /* 3 lent, over 2 */
+    held.pop_back();
+    ALW_EXPECT_EQ(admission.update(1, buffers, 0), false);
+    ALW_EXPECT_EQ(admission.paused(), false);
+}
+
+ALW_TEST(admission_sheds_waiting_clients_with_spare_fd)
+{
+    MockIoApi api;
+    api.files["/dev/null"] = {};
+    Admission<MockIoApi> admission{api, admission_config()};
+
+    /* up to a batch of clients are accepted and hung up on at once */
+    api.backlog = {8, 9, 10, 11, 12};
+    ALW_EXPECT_EQ(admission.shed(0, 3, 0), 4ul);
+    ALW_EXPECT_EQ(admission.rejected(), 4ul);
+    ALW_EXPECT_EQ(api.backlog.size(), 1ul);
+    ALW_EXPECT_EQ(admission.paused(), false);
+}
+
+ALW_TEST(admission_without_spare_fd_pauses_until_a_client_goes)
+{
+    MockIoApi api;  /* no /dev/null: the spare fd cannot be opened */
+    BufferPool buffers{{4, 4, 4}};
+    Admission<MockIoApi> admission{api, admission_config()};
+
+    api.backlog = {8};
+    ALW_EXPECT_EQ(admission.shed(0, 3, 1000), 0ul);
+    ALW_EXPECT_EQ(admission.paused(), true);
+    ALW_EXPECT_EQ(api.backlog.size(), 1ul);
+    ALW_EXPECT_EQ(admission.update(3, buffers, 1010), true);
+    ALW_EXPECT_EQ(admission.update(2, buffers, 1020), false);
+    ALW_EXPECT_EQ(admission.poll_timeout(1020), -1);
+
+    /* with no clients to wait for, accepting backs off before retrying */
+    ALW_EXPECT_EQ(admission.shed(0, 0, 2000), 0ul);
+    ALW_EXPECT_EQ(admission.update(0, buffers, 2000), true);
+    ALW_EXPECT_EQ(admission.poll_timeout(2040), 60);
+    ALW_EXPECT_EQ(admission.update(0, buffers, 2099), true);
+    ALW_EXPECT_EQ(admission.update(0, buffers, 2100), false);
+    ALW_EXPECT_EQ(admission.poll_timeout(2100), -1);
+}
+
+ALW_TEST(admission_without_spare_fd_retries_even_if_no_client_goes)
+{
+    MockIoApi api;
+    BufferPool buffers{{4, 4, 4}};
+    Admission<MockIoApi> admission{api, admission_config()};
+
+    api.backlog = {8};
+    ALW_EXPECT_EQ(admission.shed(0, 3, 0), 0ul);
+    ALW_EXPECT_EQ(admission.update(3, buffers, 50), true);
+    ALW_EXPECT_EQ(admission.update(3, buffers, 100), false);
+}
+
+}  // namespace alewa::test
@@ -0,0 +1,28 @@
+#include "affinity.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+#include <cstring>
+#include <string>
+#include <stdexcept>
+
+namespace alewa {
+
+void pin_current_thread(int cpu)
+{
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        throw std::runtime_error{"invalid cpu " + std::to_string(cpu)};
+    }
+    ::cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(static_cast<std::size_t>(cpu), &set);
+
+    int const err = ::pthread_setaffinity_np(::pthread_self(), sizeof(set),
+                                             &set);
+    if (err != 0) {
+        throw std::runtime_error{"pin to cpu " + std::to_string(cpu) + ": "
+                                 + ::strerror(err)};
+    }
+}
+
+}  // namespace alewa
@@ -0,0 +1,9 @@
+#pragma once
+
+namespace alewa {
+
+/* Restrict the calling thread to a single CPU. Throws if the CPU does not
+ * exist or the affinity mask cannot be applied. */
+void pin_current_thread(int cpu);
+
+}  // namespace alewa
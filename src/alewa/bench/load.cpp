@@ -0,0 +1,62 @@
+#include "load.hpp"
+
+#include <cctype>
+#include <charconv>
+
+namespace alewa::bench {
+
+void LoadResult::merge(LoadResult const & other)
+{
+    responses += other.responses;
+    bytes += other.bytes;
+    connects += other.connects;
+    errors += other.errors;
+    for (auto const & [status, n] : other.statuses) { statuses[status] += n; }
+    latency.merge(other.latency);
+}
+
+namespace {
+
+auto iequals(std::string_view a, std::string_view b) -> bool
+{
+    return a.size() == b.size()
+           && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+                  return std::tolower(static_cast<unsigned char>(x))
+                         == std::tolower(static_cast<unsigned char>(y));
+              });
+}
+
+}  // namespace
+
+auto parse_response_head(std::string_view head) -> std::optional<ResponseHead>
+{
+    /* "HTTP/1.x NNN ..." */
+    if (head.size() < 12 || head.substr(0, 7) != "HTTP/1.") { return {}; }
+    ResponseHead parsed{0, std::nullopt};
+    auto const [p, ec] = std::from_chars(head.data() + 9, head.data() + 12,
+                                         parsed.status);
+    if (ec != std::errc{} || p != head.data() + 12) { return {}; }
+
+    std::string_view const name = "content-length:";
+    for (auto eol = head.find("\r\n"); eol != head.npos;) {
+        std::size_t const start = eol + 2;
+        eol = head.find("\r\n", start);
+        if (eol == head.npos) { break; }
+        std::string_view line = head.substr(start, eol - start);
+        if (line.size() <= name.size()
+            || !iequals(line.substr(0, name.size()), name)) {
+            continue;
+        }
+        line.remove_prefix(name.size());
+        while (!line.empty() && line.front() == ' ') { line.remove_prefix(1); }
+        std::size_t length = 0;
+        auto const [q, err] = std::from_chars(line.data(),
+                                              line.data() + line.size(),
+                                              length);
+        if (err != std::errc{}) { return {}; }
+        parsed.content_length = length;
+    }
+    return parsed;
+}
+
+}  // namespace alewa::bench
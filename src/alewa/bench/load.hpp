@@ -0,0 +1,374 @@
+#pragma once
+
+#include <map>
+#include <deque>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <algorithm>
+#include <stdexcept>
+#include <string_view>
+
+/* Not in detail, see file_cache.hpp. */
+#include <netinet/tcp.h>
+
+#include "io/ioapi.hpp"
+#include "io/poller.hpp"
+#include "io/socket.hpp"
+#include "histogram.hpp"
+
+namespace alewa::bench {
+
+namespace detail {
+#include <netdb.h>
+#include <fcntl.h>
+
+static int const STREAM = SOCK_STREAM;
+static int const TCP = IPPROTO_TCP;
+}  // namespace alewa::bench::detail
+
+using Clock = std::chrono::steady_clock;
+
+/* One entry of the request mix, sent `weight` times as often as a weight 1
+ * entry. */
+struct Request
+{
+    std::string method;
+    std::string target;
+    unsigned weight = 1;
+};
+
+struct LoadConfig
+{
+    std::string host = "127.0.0.1";
+    std::string port;
+
+    /* Requests kept in flight on each connection; with keep_alive off every
+     * request gets a connection of its own and the depth is 1. */
+    unsigned connections = 16;
+    unsigned pipeline = 1;
+    bool keep_alive = true;
+
+    std::vector<Request> mix{{"GET", "/", 1}};
+    std::uint32_t seed = 1;  /* shuffles the order of the mix */
+};
+
+struct LoadResult
+{
+    std::uint64_t responses = 0;
+    std::uint64_t bytes = 0;  /* received while measuring, heads included */
+    std::uint64_t connects = 0;
+    std::uint64_t errors = 0;  /* connections lost with requests in flight */
+    std::map<int, std::uint64_t> statuses{};
+    Histogram latency{};  /* nanoseconds, send to last byte */
+
+    void merge(LoadResult const & other);
+};
+
+/* The parts of a response head the generator needs. */
+struct ResponseHead
+{
+    int status;
+    std::optional<std::size_t> content_length;
+};
+
+/* Parse the status line and Content-Length of a complete head, ending in
+ * an empty line; nullopt if the status line is malformed. */
+auto parse_response_head(std::string_view head) -> std::optional<ResponseHead>;
+
+/* Closed-loop HTTP/1.1 client: a fixed number of connections, each keeping
+ * `pipeline` requests outstanding and sending the next as soon as a response
+ * completes, driven from the calling thread over one poller. Latency is
+ * measured per request from its write to the end of its response, so with a
+ * pipeline it includes the time spent queued behind earlier requests. */
+template <io::EpollApi T>
+class LoadGenerator
+{
+private:
+    struct Pending
+    {
+        Clock::time_point sent;
+        bool head_only;
+    };
+
+    struct Conn
+    {
+        std::optional<io::Socket<T>> socket{};
+        std::string out{};
+        std::size_t written = 0;
+        std::deque<Pending> inflight{};
+        std::string head{};  /* partial head of the next response */
+        std::size_t body_left = 0;
+        int status = 0;
+        bool want_out = false;
+    };
+
+    T const & api;
+    LoadConfig config;
+    io::Poller<T> poller;
+    std::vector<std::string> requests;  /* rendered, in shuffled mix order */
+    std::vector<bool> head_only;
+    std::size_t cursor = 0;
+    std::vector<Conn> conns;
+    std::vector<std::size_t> owner;  /* fd to index in conns */
+    std::vector<char> chunk;
+
+    LoadResult result;
+    Clock::time_point from;
+    Clock::time_point until;
+
+public:
+    LoadGenerator(T const & api, LoadConfig config);
+
+    LoadGenerator(LoadGenerator&) = delete;
+    LoadGenerator& operator=(LoadGenerator&) = delete;
+
+    /* Keep every connection busy until `until`, counting only the responses
+     * that complete from `from` on, so that a warm-up can be left out.
+     * Requests still in flight at the end are abandoned. */
+    auto run(Clock::time_point from, Clock::time_point until) -> LoadResult;
+
+private:
+    void connect(std::size_t i);
+    void disconnect(std::size_t i, bool failed);
+    void fill(std::size_t i);
+    void flush(std::size_t i);
+    void receive(std::size_t i);
+    auto consume(std::size_t i, std::string_view data, Clock::time_point now)
+            -> bool;
+    void complete(std::size_t i, Clock::time_point now);
+};
+
+template <io::EpollApi T>
+LoadGenerator<T>::LoadGenerator(T const & api, LoadConfig config)
+        : api(api), config(std::move(config)), poller(api), chunk(1 << 16)
+{
+    if (this->config.mix.empty()) {
+        throw std::runtime_error{"load: empty request mix"};
+    }
+    if (!this->config.keep_alive) { this->config.pipeline = 1; }
+    this->config.pipeline = std::max(this->config.pipeline, 1u);
+
+    std::string const connection = this->config.keep_alive
+                                   ? "" : "Connection: close\r\n";
+    for (Request const & r : this->config.mix) {
+        std::string const request = r.method + " " + r.target + " HTTP/1.1\r\n"
+                                    "Host: " + this->config.host + "\r\n"
+                                    + connection + "\r\n";
+        for (unsigned n = 0; n < r.weight; ++n) {
+            requests.push_back(request);
+            head_only.push_back(r.method == "HEAD");
+        }
+    }
+    std::vector<std::size_t> order(requests.size());
+    for (std::size_t n = 0; n < order.size(); ++n) { order[n] = n; }
+    std::shuffle(order.begin(), order.end(),
+                 std::mt19937{this->config.seed});
+
+    std::vector<std::string> shuffled;
+    std::vector<bool> shuffled_head;
+    for (std::size_t n : order) {
+        shuffled.push_back(std::move(requests[n]));
+        shuffled_head.push_back(head_only[n]);
+    }
+    requests = std::move(shuffled);
+    head_only = std::move(shuffled_head);
+
+    conns.resize(this->config.connections);
+}
+
+template <io::EpollApi T>
+auto LoadGenerator<T>::run(Clock::time_point from, Clock::time_point until)
+        -> LoadResult
+{
+    this->from = from;
+    this->until = until;
+    result = {};
+
+    for (std::size_t i = 0; i < conns.size(); ++i) {
+        connect(i);
+        fill(i);
+    }
+
+    for (auto now = Clock::now(); now < until; now = Clock::now()) {
+        auto const left = std::chrono::ceil<std::chrono::milliseconds>(
+                until - now);
+        for (io::Event const & ev : poller.wait(static_cast<int>(
+                     std::min<std::int64_t>(left.count(), 100)))) {
+            std::size_t const i = owner[static_cast<std::size_t>(ev.fd)];
+            if (ev.events & io::EV_OUT) { flush(i); }
+            if (ev.events & (io::EV_IN | io::EV_ERR | io::EV_HUP)) {
+                receive(i);
+            }
+        }
+    }
+
+    for (std::size_t i = 0; i < conns.size(); ++i) { disconnect(i, false); }
+    return std::move(result);
+}
+
+template <io::EpollApi T>
+void LoadGenerator<T>::connect(std::size_t i)
+{
+    typename T::AddrInfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = detail::STREAM;
+    io::AddrInfoList<T> spec{api, config.host.c_str(), config.port.c_str(),
+                             &hints};
+
+    /* blocking, which on loopback costs no more than waiting for EV_OUT */
+    io::Socket<T> socket{api, spec};
+    socket.connect(*spec.current());
+    socket.set_socket_option(detail::TCP, TCP_NODELAY, 1);
+    socket.set_file_option(F_SETFL, O_NONBLOCK);
+
+    auto const fd = static_cast<std::size_t>(socket.fd());
+    if (fd >= owner.size()) { owner.resize(fd + 1); }
+    owner[fd] = i;
+    poller.add(socket.fd(), io::EV_IN);
+
+    Conn& c = conns[i];
+    c = {};
+    c.socket.emplace(std::move(socket));
+    ++result.connects;
+}
+
+template <io::EpollApi T>
+void LoadGenerator<T>::disconnect(std::size_t i, bool failed)
+{
+    Conn& c = conns[i];
+    if (!c.socket) { return; }
+    if (failed && !c.inflight.empty()) { ++result.errors; }
+    poller.remove(c.socket->fd());
+    c.socket.reset();
+}
+
+/* Top the connection up to its pipeline depth and send what was added. */
+template <io::EpollApi T>
+void LoadGenerator<T>::fill(std::size_t i)
+{
+    Conn& c = conns[i];
+    Clock::time_point const now = Clock::now();
+    if (now >= until) { return; }
+    while (c.inflight.size() < config.pipeline) {
+        c.out += requests[cursor];
+        c.inflight.push_back({now, head_only[cursor]});
+        cursor = (cursor + 1 == requests.size()) ? 0 : cursor + 1;
+    }
+    flush(i);
+}
+
+template <io::EpollApi T>
+void LoadGenerator<T>::flush(std::size_t i)
+{
+    Conn& c = conns[i];
+    if (!c.socket) { return; }
+    while (c.written < c.out.size()) {
+        auto const n = api.write(c.socket->fd(), c.out.data() + c.written,
+                                 c.out.size() - c.written);
+        if (n == T::ERROR) {
+            int const err = api.errnum();
+            if (err == EAGAIN || err == EWOULDBLOCK) { break; }
+            if (err == EINTR) { continue; }
+            disconnect(i, true);
+            return;
+        }
+        c.written += static_cast<std::size_t>(n);
+    }
+    if (c.written == c.out.size()) {
+        c.out.clear();
+        c.written = 0;
+    }
+
+    bool const want_out = !c.out.empty();
+    if (want_out != c.want_out) {
+        c.want_out = want_out;
+        poller.modify(c.socket->fd(), want_out ? io::EV_IN | io::EV_OUT
+                                               : io::EV_IN);
+    }
+}
+
+template <io::EpollApi T>
+void LoadGenerator<T>::receive(std::size_t i)
+{
+    while (conns[i].socket) {
+        Conn& c = conns[i];
+        auto const n = api.read(c.socket->fd(), chunk.data(), chunk.size());
+        Clock::time_point const now = Clock::now();
+        if (n == T::ERROR) {
+            int const err = api.errnum();
+            if (err == EAGAIN || err == EWOULDBLOCK) { return; }
+            if (err == EINTR) { continue; }
+        }
+        if (n <= 0) {
+            /* the server hung up: expected after Connection: close */
+            disconnect(i, true);
+            if (!config.keep_alive && now < until) {
+                connect(i);
+                fill(i);
+            }
+            return;
+        }
+        if (now >= from) { result.bytes += static_cast<std::uint64_t>(n); }
+        if (!consume(i, {chunk.data(), static_cast<std::size_t>(n)}, now)) {
+            disconnect(i, true);
+            return;
+        }
+    }
+}
+
+/* Feed received bytes through the response framing, completing requests
+ * as their responses end. False if the stream makes no sense. */
+template <io::EpollApi T>
+auto LoadGenerator<T>::consume(std::size_t i, std::string_view data,
+                               Clock::time_point now) -> bool
+{
+    Conn& c = conns[i];
+    while (c.socket && !data.empty()) {
+        if (c.body_left > 0) {
+            std::size_t const n = std::min(c.body_left, data.size());
+            c.body_left -= n;
+            data.remove_prefix(n);
+            if (c.body_left == 0) { complete(i, now); }
+            continue;
+        }
+
+        std::size_t const old = c.head.size();
+        c.head.append(data);
+        std::size_t const end = c.head.find("\r\n\r\n",
+                                            old < 3 ? 0 : old - 3);
+        if (end == c.head.npos) { return true; }
+
+        c.head.resize(end + 4);
+        data.remove_prefix(c.head.size() - old);
+        auto const head = parse_response_head(c.head);
+        c.head.clear();
+        if (!head || c.inflight.empty()) { return false; }
+
+        c.status = head->status;
+        c.body_left = c.inflight.front().head_only
+                      ? 0 : head->content_length.value_or(0);
+        if (c.body_left == 0) { complete(i, now); }
+    }
+    return true;
+}
+
+template <io::EpollApi T>
+void LoadGenerator<T>::complete(std::size_t i, Clock::time_point now)
+{
+    Conn& c = conns[i];
+    Pending const request = c.inflight.front();
+    c.inflight.pop_front();
+    if (request.sent >= from) {
+        ++result.responses;
+        ++result.statuses[c.status];
+        result.latency.record(static_cast<std::uint64_t>(
+                std::chrono::nanoseconds{now - request.sent}.count()));
+    }
+    if (config.keep_alive) { fill(i); }
+}
+
+}  // namespace alewa::bench
@@ -0,0 +1,26 @@
+#include "test/test_utils.hpp"
+
+#include "bench/load.hpp"
+
+namespace alewa::test {
+
+ALW_TEST(bench_parses_response_heads)
+{
+    auto head = bench::parse_response_head(
+            "HTTP/1.1 200 OK\r\ncontent-LENGTH:  1234\r\nX: y\r\n\r\n");
+    ALW_EXPECT_EQ(head.has_value(), true);
+    ALW_EXPECT_EQ(head->status, 200);
+    ALW_EXPECT_EQ(head->content_length.value_or(0), 1234ul);
+
+    head = bench::parse_response_head("HTTP/1.0 304 Not Modified\r\n\r\n");
+    ALW_EXPECT_EQ(head->status, 304);
+    ALW_EXPECT_EQ(head->content_length.has_value(), false);
+
+    ALW_EXPECT_EQ(bench::parse_response_head("HTTP/1.1 2x0 OK\r\n\r\n")
+                          .has_value(),
+                  false);
+    ALW_EXPECT_EQ(bench::parse_response_head("SSH-2.0\r\n\r\n").has_value(),
+                  false);
+}
+
+}  // namespace alewa::test
@@ -0,0 +1 @@
+#include "micro.hpp"
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstddef>
+
+/* Microbenchmarks register themselves like tests do. The body runs once per
+ * repetition and problem size, does its own setup and times only the part
+ * that matters with state.time(), e.g.
+ *
+ *     ALW_BENCH(vector_push_back)
+ *     {
+ *         std::vector<int> v;
+ *         state.time(state.size, [&] {
+ *             for (std::size_t i = 0; i < state.size; ++i) { v.push_back(1); }
+ *         });
+ *     }
+ */
+#define ALW_BENCH(bname)                                                       \
+    void (_bench_##bname)(alewa::bench::State&);                               \
+                                                                               \
+    struct _add_bench_##bname                                                  \
+    {                                                                          \
+        _add_bench_##bname()                                                   \
+        {                                                                      \
+            alewa::bench::benches.push_back({#bname, _bench_##bname});         \
+        }                                                                      \
+    };                                                                         \
+                                                                               \
+    static _add_bench_##bname call_add_bench_##bname;                          \
+                                                                               \
+    void (_bench_##bname)(alewa::bench::State& state [[maybe_unused]])
+
+namespace alewa::bench {
+
+class State
+{
+public:
+    std::size_t const size;  /* problem size: fds, addresses, ... */
+
+private:
+    std::chrono::nanoseconds elapsed{0};
+    std::size_t nops = 0;
+
+public:
+    explicit State(std::size_t size) : size(size) {}
+
+    /* Time f(), which performs `ops` operations. May be called more than
+     * once; the times and operations add up. */
+    template <typename F>
+    void time(std::size_t ops, F&& f)
+    {
+        auto const start = std::chrono::steady_clock::now();
+        f();
+        elapsed += std::chrono::steady_clock::now() - start;
+        nops += ops;
+    }
+
+    [[nodiscard]] auto ns_per_op() const -> double
+    {
+        return (nops == 0) ? 0.0 : static_cast<double>(elapsed.count())
+                                   / static_cast<double>(nops);
+    }
+};
+
+struct BenchCase
+{
+    std::string name;
+    void (*run)(State&);
+};
+
+inline std::vector<BenchCase> benches;
+
+/* Keep the compiler from discarding a result it can see is unused. */
+template <typename T>
+inline void keep(T const & value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+}  // namespace alewa::bench
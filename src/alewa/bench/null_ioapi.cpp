@@ -0,0 +1 @@
+#include "null_ioapi.hpp"
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace alewa::bench {
+
+/* An IoApi that does nothing and always succeeds, with every call inline,
+ * so that code instantiated over it costs exactly its user-space overhead.
+ * socket() and accept4() hand out ascending fds from next_fd, the latter
+ * failing with EAGAIN once `pending` clients have been taken; getaddrinfo
+ * returns the `addresses` chain, which the caller sizes with resolve(). */
+struct NullIoApi
+{
+    struct SockAddr
+    {
+        unsigned short sa_family;
+        char sa_data[14];
+    };
+
+    struct AddrInfo
+    {
+        int ai_flags;
+        int ai_family;
+        int ai_socktype;
+        int ai_protocol;
+        unsigned ai_addrlen;
+        SockAddr* ai_addr;
+        AddrInfo* ai_next;
+    };
+
+    using AiDeleter = void (*)(AddrInfo*);
+    using SockLen = unsigned;
+    using SSize = long;
+    using Off = long;
+    using Nfds = unsigned long;
+
+    struct IoVec
+    {
+        void* iov_base;
+        std::size_t iov_len;
+    };
+
+    struct MsgHdr
+    {
+        void* msg_name;
+        SockLen msg_namelen;
+        IoVec* msg_iov;
+        std::size_t msg_iovlen;
+        void* msg_control;
+        std::size_t msg_controllen;
+        int msg_flags;
+    };
+
+    struct PollFd
+    {
+        int fd;
+        short events;
+        short revents;
+    };
+
+    struct Stat
+    {
+        unsigned st_mode;
+        long st_size;
+    };
+
+    struct EpollEvent
+    {
+        unsigned events;
+        struct { int fd; } data;
+    };
+
+    static int const ERROR = -1;
+    static int const SUCCESS = 0;
+
+    mutable int next_fd = 3;
+    mutable std::size_t pending = 0;
+    mutable int errorno = 0;
+    SockAddr addr{};
+    std::vector<AddrInfo> addresses{};
+
+    /* Make getaddrinfo return a chain of n addresses. */
+    void resolve(std::size_t n)
+    {
+        addresses.assign(n, {0, 0, 0, 0, sizeof(SockAddr), &addr, nullptr});
+        for (std::size_t i = 0; i + 1 < n; ++i) {
+            addresses[i].ai_next = &addresses[i + 1];
+        }
+    }
+
+    [[nodiscard]] auto error() const -> std::string { return "null"; }
+    [[nodiscard]] auto errnum() const -> int { return errorno; }
+
+    auto getaddrinfo(char const *, char const *, AddrInfo const *,
+                     AddrInfo** ai_list) const -> int
+    {
+        *ai_list = const_cast<AddrInfo*>(addresses.data());
+        return SUCCESS;
+    }
+    static void freeaddrinfo(AddrInfo*) {}
+    auto gai_strerror(int) const -> char const * { return "null"; }
+
+    auto socket(int, int, int) const -> int { return next_fd++; }
+    auto close(int) const -> int { return SUCCESS; }
+    auto bind(int, SockAddr const *, SockLen) const -> int { return SUCCESS; }
+    auto connect(int, SockAddr const *, SockLen) const -> int
+    {
+        return SUCCESS;
+    }
+    auto listen(int, int) const -> int { return SUCCESS; }
+    auto accept(int, SockAddr*, SockLen*) const -> int { return next_fd++; }
+    auto accept4(int, SockAddr*, SockLen*, int) const -> int
+    {
+        if (pending == 0) {
+            errorno = EAGAIN;
+            return ERROR;
+        }
+        --pending;
+        return next_fd++;
+    }
+    auto setsockopt(int, int, int, void const *, SockLen) const -> int
+    {
+        return SUCCESS;
+    }
+    auto fcntl(int, int, int) const -> int { return SUCCESS; }
+
+    auto readv(int, IoVec*, int) const -> SSize { return 0; }
+    auto writev(int, IoVec const *, int) const -> SSize { return 0; }
+    auto sendmsg(int, MsgHdr const *, int) const -> SSize { return 0; }
+    auto recvmsg(int, MsgHdr*, int) const -> SSize { return 0; }
+
+    auto poll(PollFd*, Nfds, int) const -> int { return 0; }
+    auto eventfd(unsigned, int) const -> int { return next_fd++; }
+    auto read(int, void*, std::size_t) const -> SSize { return 0; }
+    auto write(int, void const *, std::size_t count) const -> SSize
+    {
+        return static_cast<SSize>(count);
+    }
+
+    auto open(char const *, int) const -> int { return next_fd++; }
+    auto fstat(int, Stat*) const -> int { return SUCCESS; }
+    auto stat(char const *, Stat*) const -> int { return SUCCESS; }
+    auto lstat(char const *, Stat*) const -> int { return SUCCESS; }
+    auto sendfile(int, int, Off*, std::size_t count) const -> SSize
+    {
+        return static_cast<SSize>(count);
+    }
+    auto pread(int, void*, std::size_t, Off) const -> SSize { return 0; }
+    auto unlink(char const *) const -> int { return SUCCESS; }
+
+    auto epoll_create1(int) const -> int { return next_fd++; }
+    auto epoll_ctl(int, int, int, EpollEvent*) const -> int { return SUCCESS; }
+    auto epoll_wait(int, EpollEvent*, int, int) const -> int { return 0; }
+};
+
+}  // namespace alewa::bench
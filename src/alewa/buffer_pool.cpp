@@ -0,0 +1,147 @@
+#include "buffer_pool.hpp"
+
+#include <new>
+#include <cassert>
+#include <cstring>
+#include <utility>
+
+namespace alewa {
+
+namespace {
+
+std::align_val_t const ALIGNMENT{64};
+
+}  // namespace
+
+Buffer::Buffer(Buffer&& other) noexcept
+        : pool(std::exchange(other.pool, nullptr)),
+          base(std::exchange(other.base, nullptr)),
+          cap(std::exchange(other.cap, 0)),
+          head(std::exchange(other.head, 0)),
+          tail(std::exchange(other.tail, 0)),
+          size_class(other.size_class)
+{
+}
+
+auto Buffer::operator=(Buffer&& other) noexcept -> Buffer&
+{
+    if (this == &other) { return *this; }
+    release();
+    pool = std::exchange(other.pool, nullptr);
+    base = std::exchange(other.base, nullptr);
+    cap = std::exchange(other.cap, 0);
+    head = std::exchange(other.head, 0);
+    tail = std::exchange(other.tail, 0);
+    size_class = other.size_class;
+    return *this;
+}
+
+void Buffer::commit(std::size_t n) noexcept
+{
+    assert(n <= cap - tail);
+    tail += static_cast<std::uint32_t>(n);
+}
+
+void Buffer::consume(std::size_t n) noexcept
+{
+    assert(n <= size());
+    head += static_cast<std::uint32_t>(n);
+    if (head == tail) { head = tail = 0; }
+}
+
+void Buffer::compact() noexcept
+{
+    if (head == 0) { return; }
+    std::memmove(base, base + head, size());
+    tail -= head;
+    head = 0;
+}
+
+void Buffer::release() noexcept
+{
+    if (base == nullptr) { return; }
+    pool->give_back(size_class, base);
+    pool = nullptr;
+    base = nullptr;
+    cap = head = tail = 0;
+}
+
+BufferPool::BufferPool(std::array<std::size_t, CLASSES> limits)
+        : limits(limits)
+{
+    /* sized up front so give_back never allocates */
+    for (std::size_t i = 0; i < CLASSES; ++i) {
+        free_lists[i].reserve(limits[i]);
+    }
+}
+
+BufferPool::~BufferPool()
+{
+    for (auto& list : free_lists) {
+        for (char* block : list) { ::operator delete[](block, ALIGNMENT); }
+    }
+}
+
+auto BufferPool::acquire(std::size_t min_size) -> Buffer
+{
+    for (std::size_t i = 0; i < CLASSES; ++i) {
+        if (SIZES[i] >= min_size) { return take(i); }
+    }
+    return {};
+}
+
+auto BufferPool::grow(Buffer& buffer) -> bool
+{
+    std::size_t const next = buffer.size_class + 1;
+    if (!buffer || next >= CLASSES) { return false; }
+
+    Buffer bigger = take(next);
+    if (!bigger) { return false; }
+
+    auto const data = buffer.readable();
+    std::memcpy(bigger.base, data.data(), data.size());
+    bigger.tail = static_cast<std::uint32_t>(data.size());
+    buffer = std::move(bigger);
+    return true;
+}
+
+auto BufferPool::take(std::size_t size_class) -> Buffer
+{
+    Stats& stats = counters[size_class];
+    if (stats.in_use >= limits[size_class]) {
+        ++stats.exhausted;
+        return {};
+    }
+
+    auto& list = free_lists[size_class];
+    char* block;
+    if (!list.empty()) {
+        block = list.back();
+        list.pop_back();
+        ++stats.hits;
+    }
+    else {
+        block = static_cast<char*>(
+                ::operator new[](SIZES[size_class], ALIGNMENT));
+        ++stats.misses;
+    }
+    stats.free = list.size();
+    if (++stats.in_use > stats.high_water) { stats.high_water = stats.in_use; }
+
+    Buffer buffer;
+    buffer.pool = this;
+    buffer.base = block;
+    buffer.cap = static_cast<std::uint32_t>(SIZES[size_class]);
+    buffer.size_class = static_cast<std::uint32_t>(size_class);
+    return buffer;
+}
+
+void BufferPool::give_back(std::size_t size_class, char* block) noexcept
+{
+    Stats& stats = counters[size_class];
+    --stats.in_use;
+    free_lists[size_class].push_back(block);
+    stats.free = free_lists[size_class].size();
+}
+
+}  // namespace alewa
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <span>
+#include <array>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace alewa {
+
+class BufferPool;
+
+/* A fixed-capacity byte buffer borrowed from a BufferPool, returned to it on
+ * destruction or release(). Bytes are appended at the tail (writable(), then
+ * commit()) and taken from the head (readable(), then consume()). */
+class Buffer
+{
+private:
+    friend class BufferPool;
+
+    BufferPool* pool = nullptr;
+    char* base = nullptr;
+    std::uint32_t cap = 0;
+    std::uint32_t head = 0;
+    std::uint32_t tail = 0;
+    std::uint32_t size_class = 0;
+
+public:
+    Buffer() = default;
+    ~Buffer() { release(); }
+
+    Buffer(Buffer&) = delete;
+    Buffer& operator=(Buffer&) = delete;
+
+    Buffer(Buffer&& other) noexcept;
+    Buffer& operator=(Buffer&& other) noexcept;
+
+    explicit operator bool() const noexcept { return base != nullptr; }
+
+    [[nodiscard]]
+    auto capacity() const noexcept -> std::size_t { return cap; }
+
+    [[nodiscard]]
+    auto size() const noexcept -> std::size_t { return tail - head; }
+
+    [[nodiscard]]
+    auto empty() const noexcept -> bool { return head == tail; }
+
+    [[nodiscard]]
+    auto full() const noexcept -> bool { return tail == cap; }
+
+    [[nodiscard]]
+    auto readable() const noexcept -> std::span<char const>
+    {
+        return {base + head, size()};
+    }
+
+    [[nodiscard]]
+    auto writable() noexcept -> std::span<char>
+    {
+        return {base + tail, cap - tail};
+    }
+
+    void commit(std::size_t n) noexcept;
+    void consume(std::size_t n) noexcept;
+
+    /* Move unread bytes to the front to make room at the tail. */
+    void compact() noexcept;
+
+    /* Hand the memory back to its pool; the buffer becomes empty. */
+    void release() noexcept;
+};
+
+/* Fixed-size buffers in a few size classes, recycled through per-class free
+ * lists so that steady-state serving does not touch the heap. A pool belongs
+ * to one reactor and is not thread-safe. Each class has a limit on buffers
+ * outstanding; past it acquire() fails instead of allocating. */
+class BufferPool
+{
+public:
+    static constexpr std::size_t CLASSES = 3;
+    static constexpr std::array<std::size_t, CLASSES> SIZES{
+            4 * 1024, 16 * 1024, 64 * 1024};
+
+    struct Stats
+    {
+        std::uint64_t hits = 0;       /* served from the free list */
+        std::uint64_t misses = 0;     /* had to allocate */
+        std::uint64_t exhausted = 0;  /* refused, limit reached */
+        std::size_t in_use = 0;
+        std::size_t high_water = 0;
+        std::size_t free = 0;
+    };
+
+private:
+    friend class Buffer;
+
+    std::array<std::size_t, CLASSES> limits;
+    std::array<std::vector<char*>, CLASSES> free_lists;
+    std::array<Stats, CLASSES> counters{};
+
+public:
+    explicit BufferPool(std::array<std::size_t, CLASSES> limits);
+    ~BufferPool();
+
+    BufferPool(BufferPool&) = delete;
+    BufferPool& operator=(BufferPool&) = delete;
+
+    /* A buffer from the smallest class holding min_size bytes, or an empty
+     * Buffer if that class is at its limit or min_size is too large. */
+    [[nodiscard]]
+    auto acquire(std::size_t min_size = SIZES[0]) -> Buffer;
+
+    /* Move `buffer`'s unread bytes into a buffer of the next larger class.
+     * Returns false, leaving `buffer` untouched, if there is none. */
+    auto grow(Buffer& buffer) -> bool;
+
+    [[nodiscard]]
+    auto stats(std::size_t size_class) const -> Stats const &
+    {
+        return counters[size_class];
+    }
+
+private:
+    auto take(std::size_t size_class) -> Buffer;
+    void give_back(std::size_t size_class, char* block) noexcept;
+};
+
+}  // namespace alewa
@@ -0,0 +1,110 @@
+#include "test/test_utils.hpp"
+
+#include <cstring>
+
+#include "buffer_pool.hpp"
+
+namespace alewa::test {
+
+namespace {
+
+void fill(Buffer& buffer, char const * text)
+{
+    std::size_t const n = std::strlen(text);
+    std::memcpy(buffer.writable().data(), text, n);
+    buffer.commit(n);
+}
+
+auto contents(Buffer const & buffer) -> std::string
+{
+    auto const data = buffer.readable();
+    return {data.data(), data.size()};
+}
+
+}  // namespace
+
+ALW_TEST(buffer_pool_size_classes)
+{
+    BufferPool pool{{4, 4, 4}};
+    ALW_EXPECT_EQ(pool.acquire().capacity(), 4096ul);
+    ALW_EXPECT_EQ(pool.acquire(4097).capacity(), 16384ul);
+    ALW_EXPECT_EQ(pool.acquire(65536).capacity(), 65536ul);
+    ALW_EXPECT_EQ(static_cast<bool>(pool.acquire(65537)), false);
+}
+
+ALW_TEST(buffer_pool_recycles_buffers)
+{
+    BufferPool pool{{4, 4, 4}};
+    {
+        Buffer a = pool.acquire();
+        Buffer b = pool.acquire();
+        ALW_EXPECT_EQ(pool.stats(0).misses, 2ul);
+        ALW_EXPECT_EQ(pool.stats(0).in_use, 2ul);
+    }
+    ALW_EXPECT_EQ(pool.stats(0).in_use, 0ul);
+    ALW_EXPECT_EQ(pool.stats(0).free, 2ul);
+
+    Buffer c = pool.acquire();
+    ALW_EXPECT_EQ(pool.stats(0).hits, 1ul);
+    ALW_EXPECT_EQ(pool.stats(0).misses, 2ul);
+    ALW_EXPECT_EQ(pool.stats(0).high_water, 2ul);
+
+    c.release();
+    ALW_EXPECT_EQ(static_cast<bool>(c), false);
+    ALW_EXPECT_EQ(pool.stats(0).in_use, 0ul);
+}
+
+ALW_TEST(buffer_pool_limit)
+{
+    BufferPool pool{{2, 0, 0}};
+    Buffer a = pool.acquire();
+    Buffer b = pool.acquire();
+    Buffer c = pool.acquire();
+    ALW_EXPECT_EQ(static_cast<bool>(b), true);
+    ALW_EXPECT_EQ(static_cast<bool>(c), false);
+    ALW_EXPECT_EQ(pool.stats(0).exhausted, 1ul);
+
+    a = std::move(b);  /* returns a's block */
+    ALW_EXPECT_EQ(pool.stats(0).in_use, 1ul);
+    ALW_EXPECT_EQ(static_cast<bool>(pool.acquire()), true);
+}
+
+ALW_TEST(buffer_reads_and_writes)
+{
+    BufferPool pool{{1, 0, 0}};
+    Buffer buffer = pool.acquire();
+    ALW_EXPECT_EQ(buffer.empty(), true);
+
+    fill(buffer, "GET / HTTP/1.1");
+    ALW_EXPECT_EQ(buffer.size(), 14ul);
+    buffer.consume(4);
+    ALW_EXPECT_EQ(contents(buffer), "/ HTTP/1.1");
+    ALW_EXPECT_EQ(buffer.writable().size(), 4096ul - 14);
+
+    buffer.compact();
+    ALW_EXPECT_EQ(contents(buffer), "/ HTTP/1.1");
+    ALW_EXPECT_EQ(buffer.writable().size(), 4096ul - 10);
+
+    buffer.consume(buffer.size());  /* fully read rewinds */
+    ALW_EXPECT_EQ(buffer.writable().size(), 4096ul);
+}
+
+ALW_TEST(buffer_pool_grow)
+{
+    BufferPool pool{{1, 1, 0}};
+    Buffer buffer = pool.acquire();
+    fill(buffer, "partial header");
+    buffer.consume(8);
+
+    ALW_EXPECT_EQ(pool.grow(buffer), true);
+    ALW_EXPECT_EQ(buffer.capacity(), 16384ul);
+    ALW_EXPECT_EQ(contents(buffer), "header");
+    ALW_EXPECT_EQ(pool.stats(0).in_use, 0ul);
+    ALW_EXPECT_EQ(pool.stats(1).in_use, 1ul);
+
+    /* no 64 KiB buffers allowed */
+    ALW_EXPECT_EQ(pool.grow(buffer), false);
+    ALW_EXPECT_EQ(contents(buffer), "header");
+}
+
+}  // namespace alewa::test
@@ -0,0 +1,151 @@
+#include "compressor.hpp"
+
+#include <memory>
+#include <limits>
+#include <algorithm>
+
+#include <zlib.h>
+
+namespace alewa {
+
+auto gzip(std::string_view data, int level) -> std::string
+{
+    ::z_stream z{};
+    /* 15 bits of window, plus 16 for a gzip header and trailer */
+    if (::deflateInit2(&z, level, Z_DEFLATED, 15 + 16, 8,
+                       Z_DEFAULT_STRATEGY) != Z_OK) {
+        return {};
+    }
+    std::string out;
+    out.resize(::deflateBound(&z, static_cast<::uLong>(data.size())));
+
+    z.next_in = reinterpret_cast<::Bytef*>(const_cast<char*>(data.data()));
+    z.avail_in = static_cast<::uInt>(data.size());
+    z.next_out = reinterpret_cast<::Bytef*>(out.data());
+    z.avail_out = static_cast<::uInt>(out.size());
+    int const status = ::deflate(&z, Z_FINISH);
+    out.resize(z.total_out);
+    ::deflateEnd(&z);
+    if (status != Z_STREAM_END) { return {}; }
+    return out;
+}
+
+auto encoded_fields(std::string_view fields, http::Coding coding, bool retag)
+        -> std::string
+{
+    std::size_t const etag = retag ? fields.find("ETag: \"") : fields.npos;
+    std::size_t const end = (etag == fields.npos)
+            ? fields.npos
+            : fields.find('"', etag + 7);
+    std::string out{fields.substr(0, end)};
+    if (end != fields.npos) {
+        out += '-';
+        out += http::coding_name(coding);
+        out += fields.substr(end);
+    }
+    out += "Content-Encoding: ";
+    out += http::coding_name(coding);
+    out += "\r\n";
+    return out;
+}
+
+Compressor::Compressor(ServerConfig const & config, std::size_t readers,
+                       WorkPool* pool)
+        : variants(config.compressed_cache_bytes,
+                   config.response_cache_max_file,
+                   config.file_cache_revalidate, readers),
+          pool(pool), level(config.compression_level)
+{}
+
+void Compressor::variant_key(std::string_view path, http::Coding coding,
+                             std::string& key)
+{
+    /* NUL cannot occur in a normalized path */
+    key.assign(path);
+    key += '\0';
+    key += http::coding_name(coding);
+}
+
+auto Compressor::claim(std::string const & key) -> bool
+{
+    std::lock_guard const guard{lock};
+    return pending.insert(key).second;
+}
+
+void Compressor::abandon(std::string const & key)
+{
+    std::lock_guard const guard{lock};
+    pending.erase(key);
+}
+
+void Compressor::compress(Source source)
+{
+    if (pool == nullptr) {
+        run(source);
+        return;
+    }
+    /* freed by the job, once run */
+    auto job = std::make_unique<Job>(*this, std::move(source));
+    /* a pool with no room is behind already: the plain file does, and a
+     * later request tries again */
+    if (!pool->submit(*job)) {
+        abandon(job->source.key);
+        return;
+    }
+    (void) job.release();
+}
+
+void Compressor::Job::execute(WorkPool::Job& job) noexcept
+{
+    std::unique_ptr<Job> const self{static_cast<Job*>(&job)};
+    self->compressor.run(self->source);
+}
+
+auto Compressor::stats() const noexcept -> Stats
+{
+    auto constexpr relaxed = std::memory_order_relaxed;
+    return {compressed.load(relaxed), bytes_in.load(relaxed),
+            bytes_out.load(relaxed)};
+}
+
+void Compressor::run(Source& source) noexcept
+{
+    try {
+        std::string plain(source.size, '\0');
+        if (!source.read(plain)) {
+            abandon(source.key);
+            return;
+        }
+        std::string encoded = (plain.size()
+                               <= std::numeric_limits<::uInt>::max())
+                ? gzip(plain, level)
+                : std::string{};
+        bool const smaller = !encoded.empty()
+                             && encoded.size() < plain.size();
+        std::string const fields = smaller
+                ? encoded_fields(source.fields, http::Coding::GZIP, true)
+                : source.fields;
+        std::string const & body = smaller ? encoded : plain;
+
+        http::Response response{200, source.content_type, {}, true};
+        response.headers = fields;
+        response.content_length = body.size();
+        char head[1024];
+        std::size_t const n = http::write_head(response, head);
+        if (n > 0) {
+            auto cached = std::make_shared<CachedResponse>(
+                    std::string_view{head, n}, body.size(), source.version);
+            std::copy(body.begin(), body.end(), cached->body().begin());
+            variants.insert(source.key, std::move(cached));
+        }
+        compressed.fetch_add(1, std::memory_order_relaxed);
+        bytes_in.fetch_add(plain.size(), std::memory_order_relaxed);
+        bytes_out.fetch_add(body.size(), std::memory_order_relaxed);
+    }
+    catch (...) {
+        /* out of memory: leave it to a later request */
+    }
+    abandon(source.key);
+}
+
+}  // namespace alewa
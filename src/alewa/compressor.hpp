@@ -0,0 +1,122 @@
+#pragma once
+
+#include <span>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <cstddef>
+#include <functional>
+#include <cstdint>
+#include <string_view>
+#include <unordered_set>
+
+#include "config.hpp"
+#include "work_pool.hpp"
+#include "response_cache.hpp"
+#include "http/response.hpp"
+
+namespace alewa {
+
+/* `data` gzipped at `level`, 1 to 9, or empty if zlib failed. */
+auto gzip(std::string_view data, int level) -> std::string;
+
+/* `fields`, the header lines of a file's plain response, for its variant in
+ * `coding`: with Content-Encoding, and with a tag of its own in the ETag if
+ * `retag`, as a variant made from the same file must not share it. */
+auto encoded_fields(std::string_view fields, http::Coding coding, bool retag)
+        -> std::string;
+
+/* Responses in a content coding, shared by all reactors: a ResponseCache
+ * keyed by variant_key(), kept within config.compressed_cache_bytes for
+ * files up to config.response_cache_max_file bytes. Reactors fill it with
+ * the precompressed siblings they read, and hand it the files to gzip,
+ * which compress() reads and compresses on the pool if there is one and on
+ * the calling thread otherwise; reactors only do so when it offloads(). A
+ * file that gzip does not shrink is cached as it is under its gzip key, so
+ * it is only tried once per version. The pool, if any, must run every job
+ * it was given before the compressor goes. */
+class Compressor
+{
+public:
+    /* A file to gzip, which `read` fills a span of its `size` with, false
+     * if it cannot; called where the file is compressed. */
+    struct Source
+    {
+        std::string key;
+        std::string_view content_type;
+        std::string fields;  /* of the plain response */
+        std::size_t size;
+        std::function<bool(std::span<char>)> read;
+        FileVersion version;
+    };
+
+    struct Stats
+    {
+        std::uint64_t compressed = 0;
+        std::uint64_t bytes_in = 0;
+        std::uint64_t bytes_out = 0;
+    };
+
+private:
+    struct Job : WorkPool::Job
+    {
+        Compressor& compressor;
+        Source source;
+
+        Job(Compressor& compressor, Source source)
+                : WorkPool::Job{&Job::execute}, compressor(compressor),
+                  source(std::move(source)) {}
+
+        static void execute(WorkPool::Job& job) noexcept;
+    };
+
+    ResponseCache variants;
+    WorkPool* pool;
+    int level;
+
+    std::mutex lock;
+    std::unordered_set<std::string> pending;  /* keys being compressed */
+
+    std::atomic<std::uint64_t> compressed{0};
+    std::atomic<std::uint64_t> bytes_in{0};
+    std::atomic<std::uint64_t> bytes_out{0};
+
+public:
+    /* `readers` is the number of threads that will look variants up. */
+    Compressor(ServerConfig const & config, std::size_t readers,
+               WorkPool* pool = nullptr);
+
+    Compressor(Compressor&) = delete;
+    Compressor& operator=(Compressor&) = delete;
+
+    [[nodiscard]]
+    auto cache() noexcept -> ResponseCache& { return variants; }
+
+    /* Whether compress() leaves the calling thread to get on. */
+    [[nodiscard]]
+    auto offloads() const noexcept -> bool { return pool != nullptr; }
+
+    /* The cache key of `path` in `coding`, into `key`. */
+    static void variant_key(std::string_view path, http::Coding coding,
+                            std::string& key);
+
+    /* Before reading a file to compress: false if `key` is already being
+     * compressed, else true, and the caller must compress() or abandon()
+     * it. */
+    auto claim(std::string const & key) -> bool;
+
+    void abandon(std::string const & key);
+
+    /* Gzip a claimed source and cache the response; done by the time this
+     * returns only without a pool, and abandoned if the pool refuses it. */
+    void compress(Source source);
+
+    /* Thread-safe. */
+    [[nodiscard]]
+    auto stats() const noexcept -> Stats;
+
+private:
+    void run(Source& source) noexcept;
+};
+
+}  // namespace alewa
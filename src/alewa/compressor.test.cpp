@@ -0,0 +1,149 @@
+#include "test/test_utils.hpp"
+
+#include <span>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <algorithm>
+#include <zlib.h>
+
+#include "compressor.hpp"
+#include "work_pool.hpp"
+
+namespace alewa::test {
+
+namespace {
+
+auto gunzip(std::string const & data) -> std::string
+{
+    ::z_stream z{};
+    if (::inflateInit2(&z, 15 + 16) != Z_OK) { return {}; }
+    std::string out(1 << 16, '\0');
+    z.next_in = reinterpret_cast<::Bytef*>(const_cast<char*>(data.data()));
+    z.avail_in = static_cast<::uInt>(data.size());
+    z.next_out = reinterpret_cast<::Bytef*>(out.data());
+    z.avail_out = static_cast<::uInt>(out.size());
+    int const status = ::inflate(&z, Z_FINISH);
+    out.resize(z.total_out);
+    ::inflateEnd(&z);
+    return (status == Z_STREAM_END) ? out : std::string{};
+}
+
+auto source(std::string body) -> Compressor::Source
+{
+    std::string key;
+    Compressor::variant_key("/app.js", http::Coding::GZIP, key);
+    std::size_t const size = body.size();
+    return {key, "text/javascript; charset=utf-8",
+            "ETag: \"1-2\"\r\nVary: Accept-Encoding\r\n", size,
+            [body = std::move(body)](std::span<char> into) {
+                if (into.size() != body.size()) { return false; }
+                std::copy(body.begin(), body.end(), into.begin());
+                return true;
+            },
+            FileVersion{1, size, 2, 0}};
+}
+
+}  // namespace
+
+ALW_TEST(compressor_gzip_round_trip)
+{
+    std::string text;
+    for (int i = 0; i < 200; ++i) { text += "function f() { return 1; }\n"; }
+    std::string const packed = gzip(text, 6);
+    ALW_EXPECT_EQ(packed.size() < text.size() / 10, true);
+    ALW_EXPECT_EQ(packed.substr(0, 2), "\x1f\x8b");
+    ALW_EXPECT_EQ(gunzip(packed), text);
+    ALW_EXPECT_EQ(gunzip(gzip("", 1)), "");
+
+    ALW_EXPECT_EQ(encoded_fields("Last-Modified: x\r\nETag: \"64-5\"\r\n",
+                                 http::Coding::GZIP, true),
+                  "Last-Modified: x\r\nETag: \"64-5-gzip\"\r\n"
+                  "Content-Encoding: gzip\r\n");
+    ALW_EXPECT_EQ(encoded_fields("ETag: \"64-5\"\r\n", http::Coding::BR,
+                                 false),
+                  "ETag: \"64-5\"\r\nContent-Encoding: br\r\n");
+}
+
+ALW_TEST(compressor_caches_variant_inline)
+{
+    ServerConfig config;
+    Compressor compressor{config, 1};
+    std::string const text(4000, 'a');
+    auto const s = source(text);
+    FileVersion const version = s.version;
+    std::string const key = s.key;
+
+    ALW_EXPECT_EQ(compressor.claim(key), true);
+    ALW_EXPECT_EQ(compressor.claim(key), false);  /* one at a time */
+    compressor.compress(s);
+    ALW_EXPECT_EQ(compressor.claim(key), true);  /* released once done */
+    compressor.abandon(key);
+
+    auto const cached = compressor.cache().revalidate(key, version);
+    ALW_EXPECT_EQ(cached != nullptr, true);
+    std::string const head{cached->head()};
+    ALW_EXPECT_EQ(head.find("Content-Encoding: gzip\r\n") != head.npos, true);
+    ALW_EXPECT_EQ(head.find("ETag: \"1-2-gzip\"") != head.npos, true);
+    ALW_EXPECT_EQ(head.find("Vary: Accept-Encoding\r\n") != head.npos, true);
+    std::string const body{cached->full().substr(head.size())};
+    ALW_EXPECT_EQ(gunzip(body), text);
+    ALW_EXPECT_EQ(compressor.stats().compressed, 1ul);
+    ALW_EXPECT_EQ(compressor.stats().bytes_out, body.size());
+}
+
+ALW_TEST(compressor_keeps_incompressible_file_plain)
+{
+    ServerConfig config;
+    Compressor compressor{config, 1};
+    std::string noise;
+    std::uint32_t x = 1;
+    for (int i = 0; i < 1000; ++i) {
+        x = x * 1664525u + 1013904223u;
+        noise += static_cast<char>(x >> 24);
+    }
+    auto const s = source(noise);
+    compressor.compress(s);
+
+    auto const cached = compressor.cache().revalidate(s.key, s.version);
+    ALW_EXPECT_EQ(cached != nullptr, true);
+    std::string const head{cached->head()};
+    ALW_EXPECT_EQ(head.find("Content-Encoding"), head.npos);
+    ALW_EXPECT_EQ(cached->full().substr(head.size()), noise);
+}
+
+/* A file that cannot be read in full is left to a later request. */
+ALW_TEST(compressor_abandons_unreadable_file)
+{
+    ServerConfig config;
+    Compressor compressor{config, 1};
+    auto s = source(std::string(4000, 'a'));
+    s.read = [](std::span<char>) { return false; };
+    ALW_EXPECT_EQ(compressor.claim(s.key), true);
+    compressor.compress(s);
+
+    ALW_EXPECT_EQ(compressor.cache().revalidate(s.key, s.version), nullptr);
+    ALW_EXPECT_EQ(compressor.stats().compressed, 0ul);
+    ALW_EXPECT_EQ(compressor.claim(s.key), true);
+}
+
+ALW_TEST(compressor_compresses_on_pool)
+{
+    using namespace std::chrono_literals;
+    ServerConfig config;
+    WorkPool pool{1, 16};
+    Compressor compressor{config, 1, &pool};
+    auto const s = source(std::string(4000, 'b'));
+    ALW_EXPECT_EQ(compressor.claim(s.key), true);
+    compressor.compress(s);
+
+    for (int i = 0; i < 1000 && compressor.stats().compressed == 0; ++i) {
+        std::this_thread::sleep_for(1ms);
+    }
+    ALW_EXPECT_EQ(compressor.stats().compressed, 1ul);
+    ALW_EXPECT_EQ(compressor.cache().revalidate(s.key, s.version) != nullptr,
+                  true);
+    ALW_EXPECT_EQ(pool.stats().submitted, 1ul);
+}
+
+}  // namespace alewa::test
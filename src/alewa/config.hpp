@@ -0,0 +1,135 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+namespace alewa {
+
+struct ServerConfig
+{
+    /* Number of reactor threads. Each one owns a SO_REUSEPORT listener, its
+     * own registry and event loop, and shares nothing with the others. */
+    unsigned threads = 1;
+
+    /* Reactor i is pinned to cpus[i % cpus.size()]; empty leaves placement
+     * to the scheduler. */
+    std::vector<int> cpus{};
+
+    /* With more than one thread: accept on a single listener, from reactor
+     * 0, and hand each client to the reactor holding the fewest, reactor 0
+     * included, instead of each reactor accepting on a SO_REUSEPORT
+     * listener of its own. Clients are spread by load rather than by the
+     * kernel's hash of their addresses, for one cross-thread handoff each.
+     * A reactor is handed at most dispatch_queue clients between two of its
+     * wakeups; the acceptor keeps those that find the queue full. */
+    bool single_acceptor = false;
+    std::size_t dispatch_queue = 1024;
+
+    /* Worker threads shared by every reactor's loop, for tasks to offload
+     * blocking or CPU-heavy calls to, each queueing at most pool_queue jobs
+     * from the reactors; 0 runs offloaded calls inline on the reactor's
+     * thread instead, as do calls that find every worker's queue full. */
+    unsigned pool_threads = 0;
+    std::size_t pool_queue = 1024;
+
+    /* Upper bound on clients accepted per listener wakeup, so a connection
+     * storm cannot starve established clients of the loop. */
+    std::size_t accept_batch = 64;
+
+    /* Length of each listener's queue of clients waiting to be accepted. */
+    int backlog = 4096;
+
+    /* Clients the server holds at once, split evenly between the reactors.
+     * A reactor stops accepting when it holds its share or has lent out
+     * every 4 KiB buffer, leaving newcomers in the backlog so the clients
+     * it has keep their latency, and resumes once both are down to
+     * accept_resume_percent of the limit. */
+    std::size_t max_connections = 16'384;
+    unsigned accept_resume_percent = 90;
+
+    /* Per-reactor cap on outstanding 4, 16 and 64 KiB buffers. */
+    std::array<std::size_t, 3> buffer_limits{8192, 1024, 256};
+
+    /* A connection is always waiting on exactly one of these: the rest of a
+     * request's headers, its next request, or the peer draining our output. */
+    std::chrono::milliseconds header_timeout{10'000};
+    std::chrono::milliseconds idle_timeout{60'000};
+    std::chrono::milliseconds write_timeout{30'000};
+
+    /* Directory whose files are served. */
+    std::string docroot = "data";
+
+    /* Open files each reactor keeps cached, with their metadata and headers,
+     * and how long a cached file is trusted before a hit checks it for
+     * changes. */
+    std::size_t file_cache_entries = 1024;
+    std::chrono::milliseconds file_cache_revalidate{1'000};
+
+    /* Complete responses for files up to response_cache_max_file bytes are
+     * kept in memory, shared by all reactors, within this many bytes in
+     * total; 0 disables the cache. They are revalidated like open files. */
+    std::size_t response_cache_bytes = 64 << 20;
+    std::size_t response_cache_max_file = 64 << 10;
+
+    /* Answer a client that accepts a content coding for a compressible
+     * file (text, scripts, JSON, XML, SVG, WebAssembly) with the file's
+     * .br, .zst or .gz sibling if it has one, preferred in that order, and
+     * otherwise with gzip at compression_level, made on the first request.
+     * Encoded responses for files up to response_cache_max_file bytes are
+     * kept in memory, shared by all reactors, within this many bytes in
+     * total; 0 serves every file as it is. Files are read and gzipped on
+     * the work pool, the plain file going out meanwhile; without a pool
+     * only the siblings are sent. */
+    std::size_t compressed_cache_bytes = 16 << 20;
+    int compression_level = 6;
+
+    /* Serve through io_uring where the kernel supports it (Linux 6.0), with
+     * this many submission entries and 4 KiB receive buffers per reactor;
+     * otherwise, or when disabled, through epoll. */
+    bool io_uring = true;
+    unsigned uring_entries = 1024;
+    unsigned uring_buffers = 1024;
+
+    /* Also serve on this Unix stream socket, from reactor 0, for clients on
+     * the same host that can skip TCP; a leading '@' puts it in the
+     * abstract namespace. A socket left at the path is replaced; anything
+     * else there is left alone, and the server does not start. Empty
+     * disables it. */
+    std::string unix_path{};
+
+    /* Also serve HTTPS on this port, with the PEM certificate chain at
+     * tls_cert and the key at tls_key, each reactor accepting on a
+     * SO_REUSEPORT listener of its own and shaking hands on its loop within
+     * header_timeout. The kernel encrypts for a client once it is through
+     * (kTLS), where it supports the cipher, so its responses go out with
+     * writev and sendfile like any other's; where the kernel does not take
+     * both directions over, as OpenSSL 3.0 only lets it receive TLS 1.2,
+     * the reactor serves the client through a socketpair that OpenSSL is
+     * relayed across. Clients resume their sessions from tickets, or else
+     * from a cache of tls_sessions shared by every reactor. With
+     * handoff_path the listeners are handed over on restarts like the
+     * others. Empty disables it. */
+    std::string tls_port{};
+    std::string tls_cert{};
+    std::string tls_key{};
+    std::size_t tls_sessions = 20'480;
+
+    /* Serve GET /metrics in the Prometheus text format on this port of
+     * admin_host, from reactor 0's loop; empty disables it. */
+    std::string admin_port{};
+    std::string admin_host = "127.0.0.1";
+
+    /* Unix socket path for restarts without downtime: a server started with
+     * it takes over the listeners of the one running there, which stops
+     * accepting, answers what its clients have already sent and exits once
+     * they are gone, as the timeouts above bound. Inherited listeners are
+     * used as they are, so the successor should serve the same ports with
+     * the same number of threads. As with unix_path, only a socket at the
+     * path is replaced. Empty disables it. */
+    std::string handoff_path{};
+};
+
+}  // namespace alewa
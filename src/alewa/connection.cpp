@@ -0,0 +1 @@
+#include "connection.hpp"
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "io/socket.hpp"
+#include "io/ioapi.hpp"
+#include "io/poller.hpp"
+#include "http/parser.hpp"
+#include "buffer_pool.hpp"
+#include "file_cache.hpp"
+#include "deadlines.hpp"
+#include "output_queue.hpp"
+
+namespace alewa {
+
+/* Everything a reactor tracks for one client, kept in a single struct so the
+ * registry can store it inline in its fd-indexed slab. */
+template <io::IoApi T>
+struct Connection
+{
+    io::Socket<T> socket;
+    Deadline deadline = Deadline::HEADER;
+    unsigned events = io::EV_IN;  /* current poller interest */
+    bool keep_alive = true;  /* false once the last response is queued */
+    bool admin = false;  /* came in on the admin listener */
+    Buffer in{};  /* borrowed while input is pending, empty when idle */
+    Buffer out{};  /* formatted response heads, referenced from queue */
+    OutputQueue queue{};  /* response bytes not yet taken by the socket */
+    std::vector<std::shared_ptr<void const>> sending{};  /* keep queue valid */
+    http::Parser parser{};  /* progress on the request at the front of in */
+
+    explicit Connection(io::Socket<T>&& socket) : socket(std::move(socket)) {}
+
+    [[nodiscard]]
+    auto fd() const noexcept -> int { return socket.fd(); }
+};
+
+}  // namespace alewa
@@ -0,0 +1,37 @@
+#include "deadlines.hpp"
+
+#include <climits>
+
+namespace alewa {
+
+Deadlines::Deadlines(ServerConfig const & config)
+        : config(config), epoch(Clock::now()), timers(now())
+{}
+
+auto Deadlines::now() const -> TimerWheel::Tick
+{
+    auto const elapsed = Clock::now() - epoch;
+    return static_cast<TimerWheel::Tick>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(elapsed)
+                    .count());
+}
+
+auto Deadlines::poll_timeout() const -> int
+{
+    auto const ticks = timers.next_timeout();
+    if (!ticks) { return -1; }  /* nothing to expire, block until I/O */
+    return (*ticks > INT_MAX) ? INT_MAX : static_cast<int>(*ticks);
+}
+
+void Deadlines::schedule(int fd, Deadline deadline)
+{
+    std::chrono::milliseconds timeout{};
+    switch (deadline) {
+    case Deadline::HEADER: timeout = config.header_timeout; break;
+    case Deadline::IDLE: timeout = config.idle_timeout; break;
+    case Deadline::WRITE: timeout = config.write_timeout; break;
+    }
+    timers.schedule(fd, now() + static_cast<TimerWheel::Tick>(timeout.count()));
+}
+
+}  // namespace alewa
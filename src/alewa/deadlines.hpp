@@ -0,0 +1,55 @@
+#pragma once
+
+#include <chrono>
+#include <utility>
+
+#include "config.hpp"
+#include "timer_wheel.hpp"
+
+namespace alewa {
+
+enum class Deadline { HEADER, IDLE, WRITE };
+
+/* A reactor's connection deadlines: a timer wheel whose ticks are
+ * milliseconds since construction, with the timeouts from the config. */
+class Deadlines
+{
+private:
+    using Clock = std::chrono::steady_clock;
+
+    ServerConfig const & config;
+    Clock::time_point const epoch;
+    TimerWheel timers;
+
+public:
+    explicit Deadlines(ServerConfig const & config);
+
+    [[nodiscard]]
+    auto now() const -> TimerWheel::Tick;
+
+    /* Milliseconds the loop may block for, -1 when nothing is pending. */
+    [[nodiscard]]
+    auto poll_timeout() const -> int;
+
+    /* (Re)start the timer for what `connection` now waits on. */
+    template <typename C>
+    void arm(C& connection, Deadline deadline)
+    {
+        connection.deadline = deadline;
+        schedule(connection.fd(), deadline);
+    }
+
+    void cancel(int fd) { timers.cancel(fd); }
+
+    /* Call on_expire(fd) for every connection whose deadline has passed. */
+    template <typename F>
+    void expire(F&& on_expire)
+    {
+        timers.advance(now(), std::forward<F>(on_expire));
+    }
+
+private:
+    void schedule(int fd, Deadline deadline);
+};
+
+}  // namespace alewa
@@ -0,0 +1 @@
+#include "dispatch.hpp"
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <limits>
+
+#include "io/ioapi.hpp"
+#include "io/waker.hpp"
+#include "spsc_queue.hpp"
+
+namespace alewa {
+
+/* The single-acceptor topology: the reactor that owns the listener hands
+ * each client it accepts to whichever reactor, itself included, has the
+ * fewest, through that reactor's SpscQueue of fds and a notify on its
+ * waker. Load is what each reactor last published plus what waits in its
+ * queue. The acceptor is the only producer and each reactor the only
+ * consumer of its own queue; fds still queued when the dispatch goes are
+ * closed. Where the IoApi counts sockets per thread, as io::Instrumented
+ * does, a client it counted is released by the acceptor and adopted by the
+ * worker that takes it. */
+template <io::IoApi T>
+class Dispatch
+{
+private:
+    struct Handed
+    {
+        int fd;
+        bool counted;  /* by the acceptor's thread, until released */
+    };
+
+    struct alignas(64) Worker
+    {
+        SpscQueue<Handed> inbox;
+        std::atomic<std::size_t> clients{0};
+        io::Waker<T> const * waker = nullptr;
+        bool handed = false;  /* since the last flush; acceptor only */
+
+        explicit Worker(std::size_t capacity) : inbox(capacity) {}
+    };
+
+    T const & ioapi;
+    std::vector<std::unique_ptr<Worker>> workers;
+
+public:
+    Dispatch(T const & ioapi, std::size_t nworkers, std::size_t capacity);
+    ~Dispatch();
+
+    Dispatch(Dispatch&) = delete;
+    Dispatch& operator=(Dispatch&) = delete;
+
+    [[nodiscard]]
+    auto size() const noexcept -> std::size_t { return workers.size(); }
+
+    /* Before any client is handed out: how to wake `worker`. */
+    void attach(std::size_t worker, io::Waker<T> const & waker) noexcept
+    {
+        workers[worker]->waker = &waker;
+    }
+
+    /* The worker with the fewest clients, the lowest-numbered on a tie. */
+    [[nodiscard]]
+    auto pick() const noexcept -> std::size_t;
+
+    /* Clients held or queued by the least loaded worker. */
+    [[nodiscard]]
+    auto least_load() const noexcept -> std::size_t
+    {
+        return load(pick());
+    }
+
+    /* Acceptor side: queue `fd` for `worker`, which takes ownership once
+     * this returns true. False if its queue is full. */
+    auto hand(std::size_t worker, int fd) noexcept -> bool;
+
+    /* Acceptor side: wake every worker handed a client since the last
+     * flush, once however many it was handed. */
+    void flush() noexcept;
+
+    /* Worker side: pass each fd queued for `worker` to f. */
+    template <typename F>
+    auto take(std::size_t worker, F&& f) -> std::size_t;
+
+    /* Worker side: how many clients `worker` holds now. */
+    void publish(std::size_t worker, std::size_t clients) noexcept
+    {
+        workers[worker]->clients.store(clients, std::memory_order_relaxed);
+    }
+
+private:
+    auto load(std::size_t worker) const noexcept -> std::size_t
+    {
+        Worker const & w = *workers[worker];
+        return w.clients.load(std::memory_order_relaxed) + w.inbox.size();
+    }
+};
+
+template <io::IoApi T>
+Dispatch<T>::Dispatch(T const & ioapi, std::size_t nworkers,
+                      std::size_t capacity)
+        : ioapi(ioapi)
+{
+    workers.reserve(nworkers);
+    for (std::size_t i = 0; i < nworkers; ++i) {
+        workers.push_back(std::make_unique<Worker>(capacity));
+    }
+}
+
+template <io::IoApi T>
+Dispatch<T>::~Dispatch()
+{
+    for (std::size_t i = 0; i < workers.size(); ++i) {
+        take(i, [this](int fd) { ioapi.close(fd); });
+    }
+}
+
+template <io::IoApi T>
+auto Dispatch<T>::pick() const noexcept -> std::size_t
+{
+    std::size_t best = 0;
+    std::size_t least = std::numeric_limits<std::size_t>::max();
+    for (std::size_t i = 0; i < workers.size(); ++i) {
+        std::size_t const n = load(i);
+        if (n < least) {
+            best = i;
+            least = n;
+        }
+    }
+    return best;
+}
+
+template <io::IoApi T>
+auto Dispatch<T>::hand(std::size_t worker, int fd) noexcept -> bool
+{
+    Worker& w = *workers[worker];
+    bool counted = false;
+    if constexpr (requires { ioapi.released(fd); }) {
+        counted = ioapi.released(fd);
+    }
+    if (!w.inbox.push({fd, counted})) {
+        if constexpr (requires { ioapi.adopted(fd); }) {
+            if (counted) { ioapi.adopted(fd); }
+        }
+        return false;
+    }
+    w.handed = true;
+    return true;
+}
+
+template <io::IoApi T>
+void Dispatch<T>::flush() noexcept
+{
+    for (auto& w : workers) {
+        if (!w->handed) { continue; }
+        w->handed = false;
+        if (w->waker) { w->waker->notify(); }
+    }
+}
+
+template <io::IoApi T>
+template <typename F>
+auto Dispatch<T>::take(std::size_t worker, F&& f) -> std::size_t
+{
+    std::size_t n = 0;
+    Handed handed{};
+    while (workers[worker]->inbox.pop(handed)) {
+        if constexpr (requires { ioapi.adopted(handed.fd); }) {
+            if (handed.counted) { ioapi.adopted(handed.fd); }
+        }
+        f(handed.fd);
+        ++n;
+    }
+    return n;
+}
+
+}  // namespace alewa
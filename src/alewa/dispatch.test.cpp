@@ -0,0 +1,99 @@
+#include "test/test_utils.hpp"
+
+#include <vector>
+#include <optional>
+
+#include "dispatch.hpp"
+#include "reactor.hpp"
+#include "io/waker.hpp"
+#include "io/sockapi_mock.hpp"
+
+namespace alewa::test {
+
+using io::test::MockIoApi;
+using io::test::MockEpollIoApi;
+
+ALW_TEST(dispatch_picks_least_loaded_and_wakes_once)
+{
+    MockIoApi api;
+    io::Waker<MockIoApi> waker{api};  /* the mock's wakers share a counter */
+    Dispatch<MockIoApi> dispatch{api, 3, 2};
+    for (std::size_t i = 0; i < 3; ++i) { dispatch.attach(i, waker); }
+
+    dispatch.publish(0, 2);
+    dispatch.publish(1, 1);
+    dispatch.publish(2, 1);
+    ALW_EXPECT_EQ(dispatch.pick(), 1ul);  /* the first of the least loaded */
+
+    /* queued clients count until they are taken */
+    ALW_EXPECT_EQ(dispatch.hand(1, 7), true);
+    ALW_EXPECT_EQ(dispatch.pick(), 2ul);
+    ALW_EXPECT_EQ(dispatch.hand(1, 8), true);
+    ALW_EXPECT_EQ(dispatch.hand(1, 9), false);  /* full */
+    ALW_EXPECT_EQ(dispatch.hand(2, 9), true);
+    ALW_EXPECT_EQ(dispatch.least_load(), 2ul);
+
+    dispatch.flush();
+    ALW_EXPECT_EQ(api.counter, 2ull);  /* one notify per worker handed to */
+    dispatch.flush();
+    ALW_EXPECT_EQ(api.counter, 2ull);
+
+    std::vector<int> taken;
+    ALW_EXPECT_EQ(dispatch.take(1, [&](int fd) { taken.push_back(fd); }),
+                  2ul);
+    ALW_EXPECT_EQ(taken, (std::vector<int>{7, 8}));
+    ALW_EXPECT_EQ(dispatch.pick(), 1ul);
+}
+
+ALW_TEST(dispatch_closes_clients_never_taken)
+{
+    MockIoApi api;
+    bool is_closed = false;
+    MockIoApi::set_is_closed(&is_closed);
+    {
+        Dispatch<MockIoApi> dispatch{api, 2, 4};
+        (void) dispatch.hand(1, 7);
+    }
+    MockIoApi::set_is_closed(nullptr);
+    ALW_EXPECT_EQ(is_closed, true);
+}
+
+ALW_TEST(dispatch_reactor_hands_clients_to_worker)
+{
+    MockEpollIoApi api;
+    MockEpollIoApi::SockAddr addr{};
+    api.ai.ai_addr = &addr;
+    ServerConfig config;
+    Dispatch<MockEpollIoApi> dispatch{api, 2, 8};  /* outlives the reactors */
+
+    Listeners<MockEpollIoApi> first;
+    first.main.emplace(create_listener(api, "8080", false));
+    first.main->listen(10);
+    first.dispatch = &dispatch;
+    Reactor<MockEpollIoApi> acceptor{api, config, std::move(first)};
+
+    Listeners<MockEpollIoApi> second;
+    second.dispatch = &dispatch;
+    second.worker = 1;
+    Reactor<MockEpollIoApi> worker{api, config, std::move(second)};
+
+    /* alternately kept and handed over, the acceptor serving as a worker */
+    api.backlog = {7, 8, 9, 10};
+    int const listener = MockEpollIoApi::SUCCESS;  /* returned by socket() */
+    api.ready[listener] = io::EV_IN;
+    acceptor.run_once();
+    api.ready.clear();
+    auto const & kept = api.interests.at(MockEpollIoApi::EPOLL_FD);
+    ALW_EXPECT_EQ(kept.contains(7) && kept.contains(9), true);
+    ALW_EXPECT_EQ(kept.contains(8) || kept.contains(10), false);
+    ALW_EXPECT_EQ(api.counter, 1ull);
+
+    int const waker = MockEpollIoApi::EVENT_FD;
+    api.ready[waker] = io::EV_IN;
+    worker.run_once();
+    auto const & handed = api.interests.at(MockEpollIoApi::EPOLL_FD + 1);
+    ALW_EXPECT_EQ(handed.contains(8) && handed.contains(10), true);
+    ALW_EXPECT_EQ(dispatch.least_load(), 2ul);
+}
+
+}  // namespace alewa::test
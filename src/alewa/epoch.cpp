@@ -0,0 +1,44 @@
+#include "epoch.hpp"
+
+#include <stdexcept>
+
+namespace alewa {
+
+EpochDomain::EpochDomain(std::size_t readers)
+        : nslots(readers), slots(std::make_unique<Slot[]>(readers))
+{}
+
+auto EpochDomain::join() -> std::size_t
+{
+    std::size_t const reader = joined.fetch_add(1);
+    if (reader >= nslots) {
+        throw std::runtime_error{"epoch domain: no reader slot left"};
+    }
+    return reader;
+}
+
+auto EpochDomain::pin(std::size_t reader) noexcept -> Guard
+{
+    /* a writer advancing in between leaves us pinned at an older epoch,
+     * which only delays reclamation */
+    std::atomic<Epoch>& slot = slots[reader].pinned;
+    slot.store(current.load());
+    return Guard{slot};
+}
+
+auto EpochDomain::advance() noexcept -> Epoch
+{
+    return current.fetch_add(1);
+}
+
+auto EpochDomain::oldest_pinned() const noexcept -> Epoch
+{
+    Epoch oldest = current.load();
+    for (std::size_t i = 0; i < nslots; ++i) {
+        Epoch const pinned = slots[i].pinned.load();
+        if (pinned < oldest) { oldest = pinned; }
+    }
+    return oldest;
+}
+
+}  // namespace alewa
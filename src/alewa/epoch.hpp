@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+namespace alewa {
+
+/* Epoch-based reclamation for data that reactors read without taking locks
+ * while a writer replaces it. Readers bracket each access with a Guard; a
+ * writer that unlinks something retires it at the current epoch and may
+ * free it once oldest_pinned() has moved past that epoch, as by then no
+ * reader can still be looking at it. Each reader slot sits on its own cache
+ * line, so pinning never contends with other readers. */
+class EpochDomain
+{
+public:
+    using Epoch = std::uint64_t;
+
+    /* While alive, whatever was reachable when it was made stays valid. */
+    class Guard
+    {
+    private:
+        std::atomic<Epoch>* slot;
+
+    public:
+        explicit Guard(std::atomic<Epoch>& slot) noexcept : slot(&slot) {}
+        ~Guard() { slot->store(IDLE, std::memory_order_release); }
+
+        Guard(Guard&) = delete;
+        Guard& operator=(Guard&) = delete;
+    };
+
+private:
+    static constexpr Epoch IDLE = UINT64_MAX;
+
+    struct alignas(64) Slot
+    {
+        std::atomic<Epoch> pinned{IDLE};
+    };
+
+    std::atomic<Epoch> current{1};
+    std::size_t nslots;
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<std::size_t> joined{0};
+
+public:
+    explicit EpochDomain(std::size_t readers);
+
+    /* Claim a reader slot; each reader thread needs its own. Throws once
+     * all of them are taken. */
+    auto join() -> std::size_t;
+
+    [[nodiscard]]
+    auto pin(std::size_t reader) noexcept -> Guard;
+
+    /* Writer side, serialized by the caller. Returns the epoch to retire
+     * what was just unlinked at and starts a new one. */
+    auto advance() noexcept -> Epoch;
+
+    /* The earliest epoch a reader may still be in. */
+    [[nodiscard]]
+    auto oldest_pinned() const noexcept -> Epoch;
+};
+
+}  // namespace alewa
@@ -0,0 +1,247 @@
+#include "exporter.hpp"
+
+#include <cstdio>
+
+namespace alewa {
+
+namespace {
+
+/* Appends metric families one sample at a time. */
+class Text
+{
+private:
+    std::string& out;
+
+public:
+    explicit Text(std::string& out) : out(out) {}
+
+    void family(char const * name, char const * type, char const * help)
+    {
+        out += "# HELP ";
+        out += name;
+        out += ' ';
+        out += help;
+        out += "\n# TYPE ";
+        out += name;
+        out += ' ';
+        out += type;
+        out += '\n';
+    }
+
+    void sample(char const * name, std::string const & labels, double value)
+    {
+        char number[32];
+        std::snprintf(number, sizeof(number), "%.17g", value);
+        out += name;
+        if (!labels.empty()) {
+            out += '{';
+            out += labels;
+            out += '}';
+        }
+        out += ' ';
+        out += number;
+        out += '\n';
+    }
+
+    void sample(char const * name, std::string const & labels,
+                std::uint64_t value)
+    {
+        out += name;
+        if (!labels.empty()) {
+            out += '{';
+            out += labels;
+            out += '}';
+        }
+        out += ' ';
+        out += std::to_string(value);
+        out += '\n';
+    }
+};
+
+auto label(char const * name, std::string_view value) -> std::string
+{
+    return std::string{name} + "=\"" + std::string{value} + "\"";
+}
+
+auto get(std::atomic<std::uint64_t> const & counter) -> std::uint64_t
+{
+    return counter.load(std::memory_order_relaxed);
+}
+
+constexpr std::array<double, 4> QUANTILES{0.5, 0.9, 0.99, 0.999};
+
+/* A summary of ns samples, exported in seconds. */
+void summary(Text& text, char const * name, std::string const & labels,
+             Histogram const & h, std::uint64_t ns, double scale)
+{
+    std::string const sep = labels.empty() ? "" : labels + ",";
+    for (double q : QUANTILES) {
+        char quantile[16];
+        std::snprintf(quantile, sizeof(quantile), "%g", q);
+        text.sample(name, sep + label("quantile", quantile),
+                    static_cast<double>(h.quantile(q)) * scale);
+    }
+    std::string const base{name};
+    text.sample((base + "_sum").c_str(), labels,
+                static_cast<double>(ns) * scale);
+    text.sample((base + "_count").c_str(), labels, h.count());
+}
+
+void render_reactors(Text& text, std::span<ReactorStats const> reactors)
+{
+    auto const each = [&](char const * name, auto value) {
+        for (std::size_t i = 0; i < reactors.size(); ++i) {
+            text.sample(name, label("reactor", std::to_string(i)),
+                        value(reactors[i]));
+        }
+    };
+    text.family("alewa_connections", "gauge", "Open client connections.");
+    each("alewa_connections", [](ReactorStats const & r) {
+        return get(r.connections);
+    });
+    text.family("alewa_requests_total", "counter", "Requests answered.");
+    each("alewa_requests_total", [](ReactorStats const & r) {
+        return get(r.requests);
+    });
+    text.family("alewa_accept_paused", "gauge",
+                "1 while a reactor has stopped accepting at its limits.");
+    each("alewa_accept_paused", [](ReactorStats const & r) {
+        return get(r.paused);
+    });
+    text.family("alewa_connections_rejected_total", "counter",
+                "Clients hung up on at once for want of an fd.");
+    each("alewa_connections_rejected_total", [](ReactorStats const & r) {
+        return get(r.rejected);
+    });
+
+    auto const buffers = [&](char const * name, auto field) {
+        for (std::size_t i = 0; i < reactors.size(); ++i) {
+            for (std::size_t c = 0; c < BufferPool::CLASSES; ++c) {
+                text.sample(name,
+                            label("reactor", std::to_string(i)) + ","
+                            + label("size",
+                                    std::to_string(BufferPool::SIZES[c])),
+                            get((reactors[i].*field)[c]));
+            }
+        }
+    };
+    text.family("alewa_buffers_in_use", "gauge",
+                "Pool buffers lent out, by size class.");
+    buffers("alewa_buffers_in_use", &ReactorStats::buffers_in_use);
+    text.family("alewa_buffers_exhausted_total", "counter",
+                "Buffer requests refused at the class limit.");
+    buffers("alewa_buffers_exhausted_total", &ReactorStats::buffers_exhausted);
+}
+
+void render_metrics(Text& text, MetricsSnapshot const & s)
+{
+    text.family("alewa_wakeups_total", "counter",
+                "Event loop waits that returned.");
+    text.sample("alewa_wakeups_total", "", s.wakeups);
+    text.family("alewa_ready_fds_per_wakeup", "summary",
+                "File descriptors reported ready by one wait.");
+    summary(text, "alewa_ready_fds_per_wakeup", "", s.ready_per_wakeup,
+            s.ready, 1.0);
+    text.family("alewa_accepts_per_batch", "summary",
+                "Clients accepted between two waits.");
+    summary(text, "alewa_accepts_per_batch", "", s.accepts_per_batch,
+            s.accepts, 1.0);
+    text.family("alewa_accepts_total", "counter", "Clients accepted.");
+    text.sample("alewa_accepts_total", "", s.accepts);
+    text.family("alewa_received_bytes_total", "counter",
+                "Bytes read from clients.");
+    text.sample("alewa_received_bytes_total", "", s.bytes_in);
+    text.family("alewa_sent_bytes_total", "counter", "Bytes sent to clients.");
+    text.sample("alewa_sent_bytes_total", "", s.bytes_out);
+
+    text.family("alewa_syscall_duration_seconds", "summary",
+                "Time spent in each system call.");
+    for (std::size_t i = 0; i < s.syscalls.size(); ++i) {
+        auto const & c = s.syscalls[i];
+        if (c.calls == 0) { continue; }
+        summary(text, "alewa_syscall_duration_seconds",
+                label("call", syscall_name(static_cast<Syscall>(i))),
+                c.latency, c.ns, 1e-9);
+    }
+    text.family("alewa_syscall_errors_total", "counter",
+                "System calls that failed, EAGAIN included.");
+    for (std::size_t i = 0; i < s.syscalls.size(); ++i) {
+        auto const & c = s.syscalls[i];
+        if (c.calls == 0) { continue; }
+        text.sample("alewa_syscall_errors_total",
+                    label("call", syscall_name(static_cast<Syscall>(i))),
+                    c.errors);
+    }
+}
+
+void render_pool(Text& text, WorkPool::Stats const & s)
+{
+    text.family("alewa_pool_workers", "gauge", "Work pool threads.");
+    text.sample("alewa_pool_workers", "",
+                static_cast<std::uint64_t>(s.workers));
+    text.family("alewa_pool_queued", "gauge",
+                "Jobs offloaded to the work pool and not started yet.");
+    text.sample("alewa_pool_queued", "",
+                static_cast<std::uint64_t>(s.queued));
+    text.family("alewa_pool_queued_peak", "gauge",
+                "The most jobs ever queued on the work pool at once.");
+    text.sample("alewa_pool_queued_peak", "",
+                static_cast<std::uint64_t>(s.peak));
+    text.family("alewa_pool_jobs_total", "counter",
+                "Jobs the work pool has run.");
+    text.sample("alewa_pool_jobs_total", "", s.executed);
+    text.family("alewa_pool_rejected_total", "counter",
+                "Jobs the work pool refused, its queues being full.");
+    text.sample("alewa_pool_rejected_total", "", s.rejected);
+    text.family("alewa_pool_steals_total", "counter",
+                "Jobs a worker took from another worker's queues.");
+    text.sample("alewa_pool_steals_total", "", s.stolen);
+}
+
+void render_tls(Text& text, TlsContext::Stats const & s)
+{
+    text.family("alewa_tls_handshakes_total", "counter",
+                "TLS handshakes completed.");
+    text.sample("alewa_tls_handshakes_total", "", s.handshakes);
+    text.family("alewa_tls_resumed_total", "counter",
+                "TLS handshakes that resumed a session.");
+    text.sample("alewa_tls_resumed_total", "", s.resumed);
+    text.family("alewa_tls_offloaded_total", "counter",
+                "TLS clients the kernel encrypts for in both directions.");
+    text.sample("alewa_tls_offloaded_total", "", s.offloaded);
+    text.family("alewa_tls_failed_total", "counter",
+                "TLS handshakes that failed or timed out.");
+    text.sample("alewa_tls_failed_total", "", s.failed);
+}
+
+}  // namespace
+
+auto Exporter::render() const -> std::string
+{
+    std::string out;
+    Text text{out};
+
+    std::chrono::duration<double> const up =
+            std::chrono::steady_clock::now() - started;
+    text.family("alewa_uptime_seconds", "gauge", "Time since start.");
+    text.sample("alewa_uptime_seconds", "", up.count());
+
+    render_reactors(text, reactors);
+
+    if (responses) {
+        text.family("alewa_response_cache_entries", "gauge",
+                    "Complete responses cached.");
+        text.sample("alewa_response_cache_entries", "",
+                    static_cast<std::uint64_t>(responses->size()));
+        text.family("alewa_response_cache_bytes", "gauge",
+                    "Bytes held by cached responses.");
+        text.sample("alewa_response_cache_bytes", "",
+                    static_cast<std::uint64_t>(responses->bytes()));
+    }
+    if (pool) { render_pool(text, pool->stats()); }
+    if (tls) { render_tls(text, tls->stats()); }
+    if (metrics) { render_metrics(text, metrics->scrape()); }
+    return out;
+}
+
+}  // namespace alewa
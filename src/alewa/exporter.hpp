@@ -0,0 +1,79 @@
+#pragma once
+
+#include <span>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <cstdint>
+
+#include "metrics.hpp"
+#include "tls.hpp"
+#include "work_pool.hpp"
+#include "buffer_pool.hpp"
+#include "response_cache.hpp"
+
+namespace alewa {
+
+/* What a reactor shows the exporter: stored by the reactor's thread after
+ * every turn of its loop, read by whichever thread renders. */
+struct alignas(64) ReactorStats
+{
+    using Counter = std::atomic<std::uint64_t>;
+
+    Counter connections{0};
+    Counter requests{0};
+    Counter paused{0};
+    Counter rejected{0};
+    std::array<Counter, BufferPool::CLASSES> buffers_in_use{};
+    std::array<Counter, BufferPool::CLASSES> buffers_exhausted{};
+
+    void publish(std::size_t open, std::uint64_t served,
+                 BufferPool const & buffers, bool pausing,
+                 std::uint64_t refused) noexcept
+    {
+        auto constexpr relaxed = std::memory_order_relaxed;
+        connections.store(open, relaxed);
+        requests.store(served, relaxed);
+        paused.store(pausing ? 1 : 0, relaxed);
+        rejected.store(refused, relaxed);
+        for (std::size_t i = 0; i < BufferPool::CLASSES; ++i) {
+            buffers_in_use[i].store(buffers.stats(i).in_use, relaxed);
+            buffers_exhausted[i].store(buffers.stats(i).exhausted, relaxed);
+        }
+    }
+};
+
+/* Renders a server's live state in the Prometheus text exposition format:
+ * per-reactor connections, requests, admission and buffer usage, the shared
+ * response cache, the work pool's queue, TLS handshakes and, when the
+ * server runs over an instrumented IoApi, its loop counters and per-call
+ * latency quantiles. Request rates are left to the scraper, as rate() over
+ * the request counter. */
+class Exporter
+{
+private:
+    std::span<ReactorStats const> reactors;
+    ResponseCache* responses;
+    Metrics const * metrics;
+    WorkPool const * pool;
+    TlsContext const * tls;
+    std::chrono::steady_clock::time_point started;
+
+public:
+    explicit Exporter(std::span<ReactorStats const> reactors,
+                      ResponseCache* responses = nullptr,
+                      Metrics const * metrics = nullptr,
+                      WorkPool const * pool = nullptr,
+                      TlsContext const * tls = nullptr)
+            : reactors(reactors), responses(responses), metrics(metrics),
+              pool(pool), tls(tls),
+              started(std::chrono::steady_clock::now()) {}
+
+    [[nodiscard]] auto render() const -> std::string;
+
+    static constexpr std::string_view CONTENT_TYPE =
+            "text/plain; version=0.0.4; charset=utf-8";
+};
+
+}  // namespace alewa
@@ -0,0 +1,196 @@
+#include "test/test_utils.hpp"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "exporter.hpp"
+#include "reactor.hpp"
+#include "work_pool.hpp"
+#include "server.hpp"
+#include "io/ioapi_sys.hpp"
+#include "io/instrumented_ioapi.hpp"
+
+namespace alewa::test {
+
+using namespace std::chrono_literals;
+
+namespace {
+
+auto has(std::string const & page, std::string const & line) -> bool
+{
+    return page.find("\n" + line + "\n") != page.npos;
+}
+
+}  // namespace
+
+ALW_TEST(exporter_renders_reactor_stats)
+{
+    BufferPool buffers{{4, 4, 4}};
+    Buffer a = buffers.acquire();
+    Buffer b = buffers.acquire(10'000);
+
+    std::array<ReactorStats, 2> stats;
+    stats[0].publish(3, 41, buffers, true, 2);
+    stats[1].publish(0, 1, BufferPool{{0, 0, 0}}, false, 0);
+
+    Exporter const exporter{stats};
+    std::string const page = exporter.render();
+    ALW_EXPECT_EQ(page.starts_with("# HELP alewa_uptime_seconds "), true);
+    ALW_EXPECT_EQ(has(page, "# TYPE alewa_requests_total counter"), true);
+    ALW_EXPECT_EQ(has(page, "alewa_connections{reactor=\"0\"} 3"), true);
+    ALW_EXPECT_EQ(has(page, "alewa_connections{reactor=\"1\"} 0"), true);
+    ALW_EXPECT_EQ(has(page, "alewa_requests_total{reactor=\"0\"} 41"), true);
+    ALW_EXPECT_EQ(has(page, "alewa_requests_total{reactor=\"1\"} 1"), true);
+    ALW_EXPECT_EQ(has(page, "alewa_accept_paused{reactor=\"0\"} 1"), true);
+    ALW_EXPECT_EQ(has(page, "alewa_accept_paused{reactor=\"1\"} 0"), true);
+    ALW_EXPECT_EQ(
+            has(page, "alewa_connections_rejected_total{reactor=\"0\"} 2"),
+            true);
+    ALW_EXPECT_EQ(
+            has(page, "alewa_buffers_in_use{reactor=\"0\",size=\"4096\"} 1"),
+            true);
+    ALW_EXPECT_EQ(
+            has(page, "alewa_buffers_in_use{reactor=\"0\",size=\"16384\"} 1"),
+            true);
+
+    /* without a cache or metrics, those families are left out */
+    ALW_EXPECT_EQ(page.find("alewa_response_cache"), page.npos);
+    ALW_EXPECT_EQ(page.find("alewa_syscall"), page.npos);
+    ALW_EXPECT_EQ(page.find("alewa_pool"), page.npos);
+    ALW_EXPECT_EQ(page.find("alewa_tls"), page.npos);
+    ALW_EXPECT_EQ(page.ends_with("\n"), true);
+}
+
+ALW_TEST(exporter_renders_work_pool)
+{
+    ReactorStats stats;
+    WorkPool pool{2, 16};
+    Exporter const exporter{{&stats, 1}, nullptr, nullptr, &pool};
+    std::string const page = exporter.render();
+    ALW_EXPECT_EQ(has(page, "# TYPE alewa_pool_queued gauge"), true);
+    ALW_EXPECT_EQ(has(page, "alewa_pool_workers 2"), true);
+    ALW_EXPECT_EQ(has(page, "alewa_pool_queued 0"), true);
+    ALW_EXPECT_EQ(has(page, "alewa_pool_jobs_total 0"), true);
+    ALW_EXPECT_EQ(has(page, "alewa_pool_rejected_total 0"), true);
+    ALW_EXPECT_EQ(has(page, "alewa_pool_steals_total 0"), true);
+}
+
+/* Over loopback, like the uring reactor test: the admin port answers
+ * /metrics and nothing else, the main port never answers it. */
+ALW_TEST(exporter_served_on_admin_port_only)
+{
+    io::EpollIoApi api;
+    ServerConfig config;
+    Listeners<io::EpollIoApi> listeners;
+    listeners.main.emplace(create_listener(api, "18612", false));
+    listeners.main->listen(16);
+    listeners.admin.emplace(
+            create_listener(api, "18613", false, "127.0.0.1"));
+    listeners.admin->listen(16);
+    ReactorStats stats;
+    Exporter const exporter{{&stats, 1}};
+    Reactor<io::EpollIoApi> reactor{api, config, std::move(listeners),
+                                    nullptr, &stats, &exporter};
+
+    auto const exchange = [&](std::uint16_t port, std::string const & request)
+    {
+        int const client = connect_loopback(port);
+        api.write(client, request.data(), request.size());
+
+        /* drain before every turn: with no timers armed, a turn after the
+         * server hung up would wait forever */
+        std::string response;
+        for (int turn = 0; turn < 100; ++turn) {
+            reactor.run_once();
+            char chunk[65536];
+            long n = 0;
+            while ((n = ::recv(client, chunk, sizeof(chunk), MSG_DONTWAIT))
+                   > 0) {
+                response.append(chunk, static_cast<std::size_t>(n));
+            }
+            if (n == 0) { break; }
+        }
+        api.close(client);
+        return response;
+    };
+
+    std::string const close = " HTTP/1.1\r\nConnection: close\r\n\r\n";
+    std::string page = exchange(18613, "GET /metrics" + close);
+    ALW_EXPECT_EQ(page.starts_with("HTTP/1.1 200 OK\r\n"), true);
+    ALW_EXPECT_EQ(page.find("Content-Type: text/plain; version=0.0.4")
+                          != page.npos,
+                  true);
+    ALW_EXPECT_EQ(page.find("\r\n\r\n# HELP alewa_uptime_seconds")
+                          != page.npos,
+                  true);
+
+    /* the first scrape was rendered while it was being answered */
+    page = exchange(18613, "GET /metrics" + close);
+    ALW_EXPECT_EQ(has(page, "alewa_requests_total{reactor=\"0\"} 1"), true);
+
+    page = exchange(18613, "GET /index.html" + close);
+    ALW_EXPECT_EQ(page.starts_with("HTTP/1.1 404 Not Found\r\n"), true);
+    page = exchange(18613, "POST /metrics" + close);
+    ALW_EXPECT_EQ(page.starts_with("HTTP/1.1 405 Method Not Allowed\r\n"),
+                  true);
+    page = exchange(18612, "GET /metrics" + close);
+    ALW_EXPECT_EQ(page.starts_with("HTTP/1.1 404 Not Found\r\n"), true);
+    ALW_EXPECT_EQ(stats.requests.load(), 5ul);
+}
+
+/* With a single acceptor, the bytes of a client handed to another reactor
+ * are counted there. */
+ALW_TEST(exporter_counts_traffic_of_dispatched_clients)
+{
+    using Api = io::Instrumented<io::EpollIoApi>;
+    Api api;
+    ServerConfig config;
+    config.docroot = "/nonexistent";
+    config.threads = 2;
+    config.single_acceptor = true;
+    config.admin_port = "18634";
+    Server<Api> server{api, config};
+    std::thread thread{[&] { server.start("18633"); }};
+
+    std::string const again = "GET /a HTTP/1.1\r\n\r\n";
+    std::string const once = "GET /a HTTP/1.1\r\n"
+                             "Connection: close\r\n\r\n";
+    std::string const scrape = "GET /metrics HTTP/1.1\r\n"
+                               "Connection: close\r\n\r\n";
+
+    /* kept by reactor 0, so that reactor 1 is handed the next client */
+    int kept = -1;
+    for (int i = 0; i < 500 && kept < 0; ++i) {
+        kept = connect_loopback(18633);
+        if (kept < 0) { std::this_thread::sleep_for(1ms); }
+    }
+    ::send(kept, again.data(), again.size(), 0);
+    std::string const first = receive(kept, "Not Found\n");
+    int const handed = connect_loopback(18633);
+    ::send(handed, once.data(), once.size(), 0);
+    std::string const second = receive(handed);
+    ::close(handed);
+
+    int const admin = connect_loopback(18634);
+    ::send(admin, scrape.data(), scrape.size(), 0);
+    std::string const page = receive(admin);
+    ::close(admin);
+    ::close(kept);
+    server.stop();
+    thread.join();
+
+    std::size_t const in = again.size() + once.size() + scrape.size();
+    std::size_t const out = first.size() + second.size();
+    ALW_EXPECT_EQ(second.starts_with("HTTP/1.1 404 Not Found\r\n"), true);
+    ALW_EXPECT_EQ(has(page, "alewa_accepts_total 3"), true);
+    ALW_EXPECT_EQ(has(page, "alewa_received_bytes_total "
+                            + std::to_string(in)),
+                  true);
+    ALW_EXPECT_EQ(has(page, "alewa_sent_bytes_total " + std::to_string(out)),
+                  true);
+}
+
+}  // namespace alewa::test
@@ -0,0 +1 @@
+#include "file_cache.hpp"
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <list>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <charconv>
+#include <string_view>
+#include <unordered_map>
+
+/* Not in detail: it pulls in kernel headers that linux/io_uring.h shares,
+ * which must not end up declared inside a namespace. */
+#include <sys/stat.h>
+
+#include "io/ioapi.hpp"
+#include "http/response.hpp"
+
+namespace alewa {
+
+namespace detail {
+#include <fcntl.h>
+
+static int const OPEN_FLAGS = O_RDONLY | O_CLOEXEC;
+static unsigned const FILE_TYPE = S_IFMT;
+static unsigned const REGULAR_FILE = S_IFREG;
+}  // namespace alewa::detail
+
+/* An open regular file and what a response needs to know about it. The fd
+ * is closed once the cache has let go of the file and no connection is
+ * still sending it. */
+struct StaticFile
+{
+    int fd;
+    std::size_t size;
+    std::string_view content_type;
+    std::string headers;  /* Last-Modified and ETag lines */
+
+    /* identity when opened, compared on revalidation */
+    std::uint64_t ino;
+    std::int64_t mtime_sec;
+    std::int64_t mtime_nsec;
+};
+
+/* LRU cache of open files under a document root, so that a hit costs
+ * neither open nor fstat nor header formatting. A cached file is trusted for
+ * the revalidation interval; after that the next hit stats it and reopens it
+ * if it was replaced or modified. One cache per reactor, not thread-safe. */
+template <io::FileApi T>
+class FileCache
+{
+public:
+    using Tick = std::uint64_t;  /* milliseconds, like the reactor's timers */
+
+private:
+    struct Entry
+    {
+        std::string path;
+        std::shared_ptr<StaticFile const> file;
+        Tick checked;
+    };
+    using Iterator = typename std::list<Entry>::iterator;
+
+    T const & api;
+    std::string root;
+    std::size_t capacity;
+    Tick revalidate;
+
+    std::list<Entry> lru;  /* most recently used first */
+    std::unordered_map<std::string_view, Iterator> index;  /* views into lru */
+    std::string full_path;  /* scratch for root + path */
+
+public:
+    FileCache(T const & api, std::string root, std::size_t capacity,
+              std::chrono::milliseconds revalidate);
+
+    FileCache(FileCache&) = delete;
+    FileCache& operator=(FileCache&) = delete;
+
+    /* The regular file at `path`, a normalized path relative to the root,
+     * or nullptr if there is none. */
+    [[nodiscard]]
+    auto find(std::string const & path, Tick now)
+            -> std::shared_ptr<StaticFile const>;
+
+    [[nodiscard]]
+    auto size() const noexcept -> std::size_t { return lru.size(); }
+
+private:
+    auto open(std::string const & path) -> std::shared_ptr<StaticFile const>;
+    auto unchanged(Entry const & entry) -> bool;
+    void evict(Iterator entry);
+    auto resolve(std::string const & path) -> char const *;
+};
+
+template <io::FileApi T>
+FileCache<T>::FileCache(T const & api, std::string root, std::size_t capacity,
+                        std::chrono::milliseconds revalidate)
+        : api(api), root(std::move(root)), capacity(capacity),
+          revalidate(static_cast<Tick>(revalidate.count()))
+{
+    index.reserve(capacity);
+}
+
+template <io::FileApi T>
+auto FileCache<T>::find(std::string const & path, Tick now)
+        -> std::shared_ptr<StaticFile const>
+{
+    if (auto it = index.find(path); it != index.end()) {
+        Iterator const entry = it->second;
+        bool const trusted = now - entry->checked < revalidate;
+        if (trusted || unchanged(*entry)) {
+            if (!trusted) { entry->checked = now; }
+            lru.splice(lru.begin(), lru, entry);
+            return entry->file;
+        }
+        evict(entry);
+    }
+
+    auto file = open(path);
+    if (!file || capacity == 0) { return file; }
+
+    lru.push_front({path, file, now});
+    index.emplace(lru.front().path, lru.begin());
+    if (lru.size() > capacity) { evict(std::prev(lru.end())); }
+    return file;
+}
+
+template <io::FileApi T>
+auto FileCache<T>::open(std::string const & path)
+        -> std::shared_ptr<StaticFile const>
+{
+    int const fd = api.open(resolve(path), detail::OPEN_FLAGS);
+    if (fd == T::ERROR) { return nullptr; }
+
+    typename T::Stat st;
+    if (api.fstat(fd, &st) == T::ERROR
+        || (st.st_mode & detail::FILE_TYPE) != detail::REGULAR_FILE) {
+        api.close(fd);
+        return nullptr;
+    }
+
+    auto const size = static_cast<std::size_t>(st.st_size);
+    auto const mtime = static_cast<std::int64_t>(st.st_mtim.tv_sec);
+
+    char etag[40];
+    char* p = etag;
+    p = std::to_chars(p, etag + sizeof(etag), mtime, 16).ptr;
+    *p++ = '-';
+    p = std::to_chars(p, etag + sizeof(etag), size, 16).ptr;
+    std::string headers = "Last-Modified: " + http::format_date(mtime)
+                          + "\r\nETag: \"" + std::string(etag, p) + "\"\r\n";
+
+    auto* file = new StaticFile{fd,
+                                size,
+                                http::content_type(path),
+                                std::move(headers),
+                                static_cast<std::uint64_t>(st.st_ino),
+                                mtime,
+                                static_cast<std::int64_t>(st.st_mtim.tv_nsec)};
+    return {file, [&api = api](StaticFile* f) {
+        api.close(f->fd);
+        delete f;
+    }};
+}
+
+template <io::FileApi T>
+auto FileCache<T>::unchanged(Entry const & entry) -> bool
+{
+    typename T::Stat st;
+    StaticFile const & file = *entry.file;
+    return api.stat(resolve(entry.path), &st) != T::ERROR
+           && static_cast<std::uint64_t>(st.st_ino) == file.ino
+           && static_cast<std::size_t>(st.st_size) == file.size
+           && static_cast<std::int64_t>(st.st_mtim.tv_sec) == file.mtime_sec
+           && static_cast<std::int64_t>(st.st_mtim.tv_nsec)
+                      == file.mtime_nsec;
+}
+
+template <io::FileApi T>
+void FileCache<T>::evict(Iterator entry)
+{
+    index.erase(entry->path);
+    lru.erase(entry);  /* the fd closes when the last sender is done */
+}
+
+template <io::FileApi T>
+auto FileCache<T>::resolve(std::string const & path) -> char const *
+{
+    full_path.assign(root);
+    full_path += path;
+    return full_path.c_str();
+}
+
+}  // namespace alewa
@@ -0,0 +1,94 @@
+#include "test/test_utils.hpp"
+
+#include "file_cache.hpp"
+#include "io/sockapi_mock.hpp"
+
+namespace alewa::test {
+
+using io::test::MockIoApi;
+
+namespace {
+
+using namespace std::chrono_literals;
+
+auto make_api() -> MockIoApi
+{
+    MockIoApi api;
+    api.files["root/a.txt"] = {"alpha", 100};
+    api.files["root/b.jpg"] = {"bravo!", 200};
+    api.files["root/c.css"] = {"charlie", 300};
+    api.files["root/dir"] = {"", 0, true};
+    return api;
+}
+
+}  // namespace
+
+ALW_TEST(file_cache_hit_skips_open_and_stat)
+{
+    MockIoApi api = make_api();
+    FileCache<MockIoApi> cache{api, "root", 8, 1000ms};
+
+    auto a = cache.find("/a.txt", 0);
+    ALW_EXPECT_EQ(a != nullptr, true);
+    ALW_EXPECT_EQ(a->size, 5ul);
+    ALW_EXPECT_EQ(a->content_type, "text/plain; charset=utf-8");
+    ALW_EXPECT_EQ(a->headers, "Last-Modified: Thu, 01 Jan 1970 00:01:40 GMT"
+                              "\r\nETag: \"64-5\"\r\n");
+    ALW_EXPECT_EQ(api.opens, 1);
+
+    ALW_EXPECT_EQ(cache.find("/a.txt", 999), a);
+    ALW_EXPECT_EQ(api.opens, 1);
+    ALW_EXPECT_EQ(api.stats, 0);
+
+    ALW_EXPECT_EQ(cache.find("/missing", 0) == nullptr, true);
+    ALW_EXPECT_EQ(cache.find("/dir", 0) == nullptr, true);
+    ALW_EXPECT_EQ(cache.size(), 1ul);
+}
+
+ALW_TEST(file_cache_revalidates_after_interval)
+{
+    MockIoApi api = make_api();
+    FileCache<MockIoApi> cache{api, "root", 8, 1000ms};
+
+    auto a = cache.find("/a.txt", 0);
+    ALW_EXPECT_EQ(cache.find("/a.txt", 1000), a);  /* stat'ed, unchanged */
+    ALW_EXPECT_EQ(api.stats, 1);
+    ALW_EXPECT_EQ(api.opens, 1);
+
+    api.files["root/a.txt"] = {"alpha, edited", 101};
+    ALW_EXPECT_EQ(cache.find("/a.txt", 1500), a);  /* still trusted */
+    auto edited = cache.find("/a.txt", 2000);
+    ALW_EXPECT_EQ(edited != a, true);
+    ALW_EXPECT_EQ(edited->size, 13ul);
+    ALW_EXPECT_EQ(api.opens, 2);
+    ALW_EXPECT_EQ(a->size, 5ul);  /* holders keep the old file */
+
+    api.files.erase("root/a.txt");
+    ALW_EXPECT_EQ(cache.find("/a.txt", 5000) == nullptr, true);
+    ALW_EXPECT_EQ(cache.size(), 0ul);
+}
+
+ALW_TEST(file_cache_evicts_least_recently_used)
+{
+    MockIoApi api = make_api();
+    FileCache<MockIoApi> cache{api, "root", 2, 1000ms};
+
+    auto a = cache.find("/a.txt", 0);
+    auto b = cache.find("/b.jpg", 0);
+    ALW_EXPECT_EQ(cache.find("/a.txt", 0), a);  /* b is now the oldest */
+    auto c = cache.find("/c.css", 0);
+    ALW_EXPECT_EQ(cache.size(), 2ul);
+    ALW_EXPECT_EQ(api.opens, 3);
+
+    ALW_EXPECT_EQ(cache.find("/a.txt", 0), a);
+    ALW_EXPECT_EQ(cache.find("/c.css", 0), c);
+    ALW_EXPECT_EQ(api.opens, 3);
+    ALW_EXPECT_EQ(cache.find("/b.jpg", 0) != b, true);  /* reopened */
+    ALW_EXPECT_EQ(api.opens, 4);
+
+    FileCache<MockIoApi> uncached{api, "root", 0, 1000ms};
+    ALW_EXPECT_EQ(uncached.find("/a.txt", 0) != nullptr, true);
+    ALW_EXPECT_EQ(uncached.size(), 0ul);
+}
+
+}  // namespace alewa::test
@@ -0,0 +1,53 @@
+#include "frame_pool.hpp"
+
+#include <new>
+
+namespace alewa {
+
+FramePool::~FramePool()
+{
+    for (auto& blocks : free_lists) {
+        for (void* block : blocks) { ::operator delete(block); }
+    }
+}
+
+auto FramePool::allocate(std::size_t size) -> void*
+{
+    std::size_t const cls = size_class(size);
+    void* block;
+    if (cls < CLASSES && !free_lists[cls].empty()) {
+        block = free_lists[cls].back();
+        free_lists[cls].pop_back();
+        ++counters.hits;
+    }
+    else {
+        block = ::operator new(cls < CLASSES ? (cls + 1) * GRANULE
+                                             : size + sizeof(Header));
+        ++counters.misses;
+    }
+    ++counters.in_use;
+    auto* header = static_cast<Header*>(block);
+    header->pool = this;
+    return header + 1;
+}
+
+void FramePool::deallocate(void* frame, std::size_t size) noexcept
+{
+    auto* header = static_cast<Header*>(frame) - 1;
+    FramePool& pool = *header->pool;
+    --pool.counters.in_use;
+
+    std::size_t const cls = size_class(size);
+    if (cls >= CLASSES) {
+        ::operator delete(header);
+        return;
+    }
+    try {
+        pool.free_lists[cls].push_back(header);
+    }
+    catch (std::bad_alloc const &) {
+        ::operator delete(header);
+    }
+}
+
+}  // namespace alewa
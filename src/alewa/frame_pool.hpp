@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace alewa {
+
+/* Memory for one reactor's coroutine frames, recycled through per-size free
+ * lists so that a task suspended on a client costs no heap allocation once
+ * the pool has warmed up. Frame sizes are only known to the compiler, so
+ * blocks come in GRANULE steps up to MAX_POOLED bytes; larger frames go to
+ * the heap every time. Each block starts with a header naming its pool, as
+ * a frame is freed without one at hand. Not thread-safe. */
+class FramePool
+{
+public:
+    static constexpr std::size_t GRANULE = 64;
+    static constexpr std::size_t MAX_POOLED = 4096;
+
+    struct Stats
+    {
+        std::uint64_t hits = 0;    /* served from a free list */
+        std::uint64_t misses = 0;  /* had to allocate */
+        std::size_t in_use = 0;
+    };
+
+private:
+    static constexpr std::size_t CLASSES = MAX_POOLED / GRANULE;
+
+    struct alignas(alignof(std::max_align_t)) Header
+    {
+        FramePool* pool;
+    };
+
+    std::array<std::vector<void*>, CLASSES> free_lists;
+    Stats counters{};
+
+public:
+    FramePool() = default;
+    ~FramePool();
+
+    FramePool(FramePool&) = delete;
+    FramePool& operator=(FramePool&) = delete;
+
+    /* A frame of `size` bytes; throws std::bad_alloc like operator new. */
+    [[nodiscard]]
+    auto allocate(std::size_t size) -> void*;
+
+    /* Give a frame back to the pool it came from; `size` is the one it was
+     * allocated with. */
+    static void deallocate(void* frame, std::size_t size) noexcept;
+
+    [[nodiscard]]
+    auto stats() const noexcept -> Stats const & { return counters; }
+
+private:
+    static auto size_class(std::size_t size) noexcept -> std::size_t
+    {
+        return (size + sizeof(Header) + GRANULE - 1) / GRANULE - 1;
+    }
+};
+
+}  // namespace alewa
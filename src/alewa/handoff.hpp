@@ -0,0 +1,248 @@
+#pragma once
+
+#include <array>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+
+#include "io/socket.hpp"
+#include "io/ioapi.hpp"
+#include "io/poller.hpp"
+#include "listener.hpp"
+
+namespace alewa {
+
+namespace detail {
+/* See listener.hpp. The cmsg macros name struct cmsghdr unqualified, so
+ * they are only expanded in here, where either declaration is found. */
+#include <sys/socket.h>
+
+using CMsgHdr = cmsghdr;
+
+static int const HANDOFF_ACCEPT_FLAGS = SOCK_NONBLOCK | SOCK_CLOEXEC;
+static int const HANDOFF_SEND_FLAGS = MSG_NOSIGNAL;
+static int const HANDOFF_RECV_FLAGS = MSG_CMSG_CLOEXEC;
+static int const CONTROL_TRUNCATED = MSG_CTRUNC;
+
+/* The kernel's limit on fds in one SCM_RIGHTS message. */
+static std::size_t const MAX_HANDOFF = 253;
+static std::size_t const HANDOFF_CONTROL = CMSG_SPACE(sizeof(int)
+                                                      * MAX_HANDOFF);
+
+/* Point `msg` at `control`, filled with one SCM_RIGHTS message for `fds`. */
+template <typename MsgHdr>
+void attach_rights(MsgHdr& msg, char* control, std::vector<int> const & fds)
+{
+    std::size_t const size = sizeof(int) * fds.size();
+    msg.msg_control = control;
+    msg.msg_controllen = CMSG_SPACE(size);
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(size);
+    std::memcpy(CMSG_DATA(cmsg), fds.data(), size);
+}
+
+/* The fds a received `msg` carries, if any. */
+template <typename MsgHdr>
+auto rights(MsgHdr const & msg) -> std::vector<int>
+{
+    std::vector<int> fds;
+    cmsghdr const * cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg == nullptr || cmsg->cmsg_level != SOL_SOCKET
+        || cmsg->cmsg_type != SCM_RIGHTS) {
+        return fds;
+    }
+    fds.resize((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+    std::memcpy(fds.data(), CMSG_DATA(cmsg), sizeof(int) * fds.size());
+    return fds;
+}
+}  // namespace alewa::detail
+
+/* How a server's listening sockets are labelled when they are handed off. */
+enum class ListenerKind : char
+{
+    MAIN = 'L', LOCAL = 'U', ADMIN = 'A', TLS = 'T'
+};
+
+/* Listening sockets taken over from a running server: one per reactor it
+ * ran, in order, likewise its TLS listeners if it had any, and its Unix
+ * socket and admin listener if it had them. */
+template <io::SocketApi T>
+struct Inherited
+{
+    std::vector<io::Socket<T>> listeners{};
+    std::vector<io::Socket<T>> tls{};
+    std::optional<io::Socket<T>> local{};
+    std::optional<io::Socket<T>> admin{};
+};
+
+/* Take over the listening sockets of the server whose Handoff is at `path`,
+ * waiting at most timeout_ms for them. Returns none if no server listens
+ * there; otherwise that server stops accepting as soon as they are sent,
+ * and drains. The sockets keep their options, O_NONBLOCK included. */
+template <io::IoApi T>
+auto inherit_listeners(T const & ioapi, std::string const & path,
+                       int timeout_ms = 5'000) -> Inherited<T>
+{
+    Inherited<T> inherited;
+    detail::UnixAddr addr;
+    std::size_t const addrlen = detail::unix_address(path, addr);
+    int const fd = ioapi.socket(AF_UNIX, detail::UNIX_STREAM, 0);
+    if (fd == T::ERROR) {
+        throw std::runtime_error{"handoff: socket: " + ioapi.error()};
+    }
+    auto channel = io::Socket<T>::adopt(ioapi, fd);
+
+    auto const * target = reinterpret_cast<typename T::SockAddr const *>(
+            &addr);
+    if (T::ERROR == ioapi.connect(channel.fd(), target,
+                                  static_cast<typename T::SockLen>(addrlen))) {
+        int const err = ioapi.errnum();
+        if (err == ENOENT || err == ECONNREFUSED) { return inherited; }
+        throw std::runtime_error{"handoff: connect to " + path + ": "
+                                 + ioapi.error()};
+    }
+
+    typename T::PollFd answer{};
+    answer.fd = channel.fd();
+    answer.events = static_cast<short>(io::EV_IN);
+    int const nready = ioapi.poll(&answer, 1, timeout_ms);
+    if (nready != 1) {
+        std::string const why = (nready == 0) ? "timed out" : ioapi.error();
+        throw std::runtime_error{"handoff: waiting on " + path + ": " + why};
+    }
+
+    std::array<char, detail::MAX_HANDOFF> kinds{};
+    alignas(detail::CMsgHdr) std::array<char, detail::HANDOFF_CONTROL>
+            control{};
+    typename T::IoVec iov{kinds.data(), kinds.size()};
+    typename T::MsgHdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.data();
+    msg.msg_controllen = control.size();
+    auto const n = ioapi.recvmsg(channel.fd(), &msg,
+                                 detail::HANDOFF_RECV_FLAGS);
+    if (n < 0) {
+        throw std::runtime_error{"handoff: recvmsg: " + ioapi.error()};
+    }
+
+    /* adopted before anything else can throw, so none of them leaks */
+    std::vector<int> const fds = detail::rights(msg);
+    for (std::size_t i = 0; i < fds.size(); ++i) {
+        auto socket = io::Socket<T>::adopt(ioapi, fds[i]);
+        if (i >= static_cast<std::size_t>(n)) { continue; }  /* unlabelled */
+        auto const kind = static_cast<ListenerKind>(kinds[i]);
+        if (kind == ListenerKind::MAIN) {
+            inherited.listeners.push_back(std::move(socket));
+        }
+        else if (kind == ListenerKind::TLS) {
+            inherited.tls.push_back(std::move(socket));
+        }
+        else if (kind == ListenerKind::LOCAL) {
+            inherited.local.emplace(std::move(socket));
+        }
+        else if (kind == ListenerKind::ADMIN) {
+            inherited.admin.emplace(std::move(socket));
+        }
+    }
+    if (msg.msg_flags & detail::CONTROL_TRUNCATED) {
+        throw std::runtime_error{"handoff: listeners lost in transit"};
+    }
+    return inherited;
+}
+
+/* The Unix socket on which a running server hands its listening sockets to
+ * a successor started with the same path: every socket offered goes out in
+ * one SCM_RIGHTS message to whoever connects, after which on_handoff is
+ * called, and the server is expected to stop accepting and drain. A
+ * predecessor's socket at the path is unlinked before it is bound, as by
+ * create_unix_listener(), and this one is left in place on exit for the
+ * next successor. Whoever may connect to it may take
+ * the listeners, so it belongs where only the server's user can write. */
+template <io::IoApi T>
+class Handoff
+{
+public:
+    using Callback = void (*)(void*) noexcept;
+
+private:
+    T const & ioapi;
+    io::Socket<T> socket;
+    Callback on_handoff;
+    void* context;
+    std::vector<int> fds{};
+    std::string kinds{};
+
+public:
+    Handoff(T const & ioapi, std::string const & path, int backlog,
+            Callback on_handoff, void* context);
+
+    Handoff(Handoff&) = delete;
+    Handoff& operator=(Handoff&) = delete;
+
+    [[nodiscard]]
+    auto fd() const noexcept -> int { return socket.fd(); }
+
+    /* Hand `listener` over too; it stays owned by the caller. */
+    void offer(int listener, ListenerKind kind);
+
+    /* Answer every successor waiting to connect. Returns how many took the
+     * listeners; on_handoff has been called if any did. */
+    auto serve() -> std::size_t;
+};
+
+template <io::IoApi T>
+Handoff<T>::Handoff(T const & ioapi, std::string const & path, int backlog,
+                    Callback on_handoff, void* context)
+        : ioapi(ioapi), socket(create_unix_listener(ioapi, path)),
+          on_handoff(on_handoff), context(context)
+{
+    socket.listen(backlog);
+}
+
+template <io::IoApi T>
+void Handoff<T>::offer(int listener, ListenerKind kind)
+{
+    if (fds.size() == detail::MAX_HANDOFF) {
+        throw std::runtime_error{"handoff: too many listeners"};
+    }
+    fds.push_back(listener);
+    kinds.push_back(static_cast<char>(kind));
+}
+
+template <io::IoApi T>
+auto Handoff<T>::serve() -> std::size_t
+{
+    std::size_t served = 0;
+    socket.accept_batch(
+            [this, &served](io::Socket<T>&& successor,
+                            io::SockInfo<T> const &) {
+                alignas(detail::CMsgHdr)
+                        std::array<char, detail::HANDOFF_CONTROL> control{};
+                typename T::IoVec iov{kinds.data(), kinds.size()};
+                typename T::MsgHdr msg{};
+                msg.msg_iov = &iov;
+                msg.msg_iovlen = 1;
+                if (!fds.empty()) {
+                    detail::attach_rights(msg, control.data(), fds);
+                }
+                /* a successor that went away gets nothing and changes
+                 * nothing */
+                auto const n = ioapi.sendmsg(successor.fd(), &msg,
+                                             detail::HANDOFF_SEND_FLAGS);
+                if (n == static_cast<typename T::SSize>(kinds.size())) {
+                    ++served;
+                }
+            },
+            detail::MAX_HANDOFF, detail::HANDOFF_ACCEPT_FLAGS);
+    if (served > 0) { on_handoff(context); }
+    return served;
+}
+
+}  // namespace alewa
@@ -0,0 +1,155 @@
+#include "test/test_utils.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+
+#include "handoff.hpp"
+#include "listener.hpp"
+#include "server.hpp"
+#include "io/ioapi_sys.hpp"
+#include "io/ring.hpp"
+
+namespace alewa::test {
+
+using namespace std::chrono_literals;
+using io::EpollIoApi;
+using io::IoUringIoApi;
+
+namespace {
+
+auto inode(std::string const & path) -> ino_t
+{
+    struct ::stat st{};
+    return ::stat(path.c_str(), &st) == 0 ? st.st_ino : 0;
+}
+
+/* A server restarted under a client with a request half sent: the old one
+ * answers it once it is complete, closes and returns, while the new one
+ * serves on the same port from the listener it inherited. */
+template <io::IoApi T>
+void restart_while_serving(std::string& fail_expr, std::uint16_t port)
+{
+    T api;
+    ServerConfig config;
+    config.docroot = "/nonexistent";
+    config.handoff_path = "/tmp/alewa-handoff-" + std::to_string(port);
+    std::string const service = std::to_string(port);
+
+    Server<T> old_server{api, config};
+    std::thread old_thread{[&] { old_server.start(service); }};
+    int client = -1;
+    for (int i = 0; i < 500 && client < 0; ++i) {
+        client = connect_loopback(port);
+        if (client < 0) { std::this_thread::sleep_for(1ms); }
+    }
+    std::string const request = "GET /a HTTP/1.1\r\n\r\n";
+    ::send(client, request.data(), request.size(), 0);
+    std::string const first = receive(client, "Not Found\n");
+
+    ino_t const before = inode(config.handoff_path);
+    ::send(client, request.data(), request.size() - 2, 0);
+
+    Server<T> new_server{api, config};
+    std::thread new_thread{[&] { new_server.start(service); }};
+    for (int i = 0; i < 5000 && inode(config.handoff_path) == before; ++i) {
+        std::this_thread::sleep_for(1ms);
+    }
+
+    ::send(client, "\r\n", 2, 0);
+    std::string const last = receive(client);
+    ::close(client);
+    old_thread.join();  /* returns once its last client is gone */
+
+    client = connect_loopback(port);
+    ::send(client, request.data(), request.size(), 0);
+    std::string const next = receive(client, "Not Found\n");
+    ::close(client);
+    new_server.stop();
+    new_thread.join();
+    std::remove(config.handoff_path.c_str());
+
+    ALW_EXPECT_EQ(first.find("Connection: keep-alive") != first.npos, true);
+    ALW_EXPECT_EQ(last.starts_with("HTTP/1.1 404 Not Found\r\n"), true);
+    ALW_EXPECT_EQ(last.ends_with("Not Found\n"), true);  /* then closed */
+    ALW_EXPECT_EQ(next.starts_with("HTTP/1.1 404 Not Found\r\n"), true);
+}
+
+}  // namespace
+
+ALW_TEST(handoff_without_predecessor_inherits_nothing)
+{
+    EpollIoApi api;
+    auto inherited = inherit_listeners(api, "/tmp/alewa-handoff-none");
+    ALW_EXPECT_EQ(inherited.listeners.empty(), true);
+    ALW_EXPECT_EQ(inherited.admin.has_value(), false);
+}
+
+ALW_TEST(handoff_passes_listeners_over_unix_socket)
+{
+    EpollIoApi api;
+    std::string const path = "/tmp/alewa-handoff-18614";
+    auto main = create_listener(api, "18614", false, "127.0.0.1");
+    auto admin = create_listener(api, "18615", false, "127.0.0.1");
+    auto tls = create_listener(api, "18628", false, "127.0.0.1");
+    main.listen(16);
+    admin.listen(16);
+    tls.listen(16);
+
+    bool handed_off = false;
+    Handoff<EpollIoApi> handoff{api, path, 4,
+                                [](void* flag) noexcept {
+                                    *static_cast<bool*>(flag) = true;
+                                },
+                                &handed_off};
+    handoff.offer(main.fd(), ListenerKind::MAIN);
+    handoff.offer(admin.fd(), ListenerKind::ADMIN);
+    handoff.offer(tls.fd(), ListenerKind::TLS);
+    ALW_EXPECT_EQ(handoff.serve(), 0ul);  /* nobody asked yet */
+
+    Inherited<EpollIoApi> inherited;
+    std::thread successor{[&] {
+        inherited = inherit_listeners(api, path);
+    }};
+    std::size_t served = 0;
+    for (int i = 0; i < 5000 && served == 0; ++i) {
+        served = handoff.serve();
+        if (served == 0) { std::this_thread::sleep_for(1ms); }
+    }
+    successor.join();
+    std::remove(path.c_str());
+    ALW_EXPECT_EQ(served, 1ul);
+    ALW_EXPECT_EQ(handed_off, true);
+    ALW_EXPECT_EQ(inherited.listeners.size(), 1ul);
+    ALW_EXPECT_EQ(inherited.admin.has_value(), true);
+    ALW_EXPECT_EQ(inherited.tls.size(), 1ul);
+
+    /* the same socket under a new fd: still open once ours is closed */
+    int const fd = inherited.listeners[0].fd();
+    ALW_EXPECT_EQ(fd != main.fd(), true);
+    api.close(main.release());
+    int const client = connect_loopback(18614);
+    ALW_EXPECT_EQ(client >= 0, true);
+    int const accepted = ::accept4(fd, nullptr, nullptr, SOCK_CLOEXEC);
+    ALW_EXPECT_EQ(accepted >= 0, true);
+    ::close(accepted);
+    ::close(client);
+}
+
+ALW_TEST(handoff_restarts_epoll_server_without_dropping_clients)
+{
+    restart_while_serving<EpollIoApi>(fail_expr, 18616);
+}
+
+ALW_TEST(handoff_restarts_uring_server_without_dropping_clients)
+{
+    IoUringIoApi api;
+    if (!io::uring_supported(api)) { return; }
+    restart_while_serving<IoUringIoApi>(fail_expr, 18617);
+}
+
+}  // namespace alewa::test
@@ -0,0 +1,73 @@
+#include "histogram.hpp"
+
+#include <bit>
+#include <cmath>
+#include <algorithm>
+
+namespace alewa {
+
+void Histogram::record(std::uint64_t value, std::uint64_t n) noexcept
+{
+    if (n == 0) { return; }
+    counts[index(value)] += n;
+    total += n;
+    sum += value * n;
+    lowest = std::min(lowest, value);
+    highest = std::max(highest, value);
+}
+
+void Histogram::merge(Histogram const & other) noexcept
+{
+    for (std::size_t i = 0; i < BUCKETS; ++i) { counts[i] += other.counts[i]; }
+    total += other.total;
+    sum += other.sum;
+    lowest = std::min(lowest, other.lowest);
+    highest = std::max(highest, other.highest);
+}
+
+auto Histogram::min() const noexcept -> std::uint64_t
+{
+    return (total == 0) ? 0 : lowest;
+}
+
+auto Histogram::mean() const noexcept -> double
+{
+    return (total == 0) ? 0.0 : static_cast<double>(sum)
+                                 / static_cast<double>(total);
+}
+
+auto Histogram::quantile(double q) const noexcept -> std::uint64_t
+{
+    if (total == 0) { return 0; }
+    auto rank = static_cast<std::uint64_t>(
+            std::ceil(q * static_cast<double>(total)));
+    rank = std::clamp<std::uint64_t>(rank, 1, total);
+
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < BUCKETS; ++i) {
+        seen += counts[i];
+        if (seen >= rank) { return std::min(upper_bound(i), highest); }
+    }
+    return highest;
+}
+
+/* Values below SUB_BUCKETS index themselves; above, the top SUB_BITS + 1
+ * significant bits pick the bucket and the rest are dropped. */
+auto Histogram::index(std::uint64_t value) noexcept -> std::size_t
+{
+    if (value < SUB_BUCKETS) { return static_cast<std::size_t>(value); }
+    auto const shift = static_cast<unsigned>(std::bit_width(value))
+                       - SUB_BITS - 1;
+    return static_cast<std::size_t>(
+            ((shift + 1) << SUB_BITS) + ((value >> shift) - SUB_BUCKETS));
+}
+
+auto Histogram::upper_bound(std::size_t index) noexcept -> std::uint64_t
+{
+    if (index < SUB_BUCKETS) { return index; }
+    auto const shift = static_cast<unsigned>(index >> SUB_BITS) - 1;
+    std::uint64_t const base = SUB_BUCKETS + (index & (SUB_BUCKETS - 1));
+    return ((base + 1) << shift) - 1;
+}
+
+}  // namespace alewa
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace alewa {
+
+/* Log-linear histogram of non-negative samples (latencies in nanoseconds).
+ * Every power-of-two range is split into SUB_BUCKETS linear buckets, so a
+ * quantile is reported within 1/SUB_BUCKETS of the true value whatever its
+ * magnitude, in constant memory and with an O(1) record(). */
+class Histogram
+{
+public:
+    static int const SUB_BITS = 5;
+    static std::uint64_t const SUB_BUCKETS = std::uint64_t{1} << SUB_BITS;
+    static std::size_t const BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+private:
+    std::array<std::uint64_t, BUCKETS> counts{};
+    std::uint64_t total = 0;
+    std::uint64_t sum = 0;
+    std::uint64_t lowest = UINT64_MAX;
+    std::uint64_t highest = 0;
+
+public:
+    void record(std::uint64_t value) noexcept { record(value, 1); }
+    void record(std::uint64_t value, std::uint64_t n) noexcept;
+    void merge(Histogram const & other) noexcept;
+
+    [[nodiscard]] auto count() const noexcept -> std::uint64_t
+    {
+        return total;
+    }
+
+    /* 0 when empty. */
+    [[nodiscard]] auto min() const noexcept -> std::uint64_t;
+    [[nodiscard]] auto max() const noexcept -> std::uint64_t
+    {
+        return highest;
+    }
+    [[nodiscard]] auto mean() const noexcept -> double;
+
+    /* The value at or below which a fraction q of the samples lie, rounded
+     * up to its bucket's bound but never past max(). */
+    [[nodiscard]] auto quantile(double q) const noexcept -> std::uint64_t;
+
+    /* Bucket layout, for counts kept elsewhere (e.g. in atomics) and added
+     * back with record(upper_bound(i), n). */
+    static auto index(std::uint64_t value) noexcept -> std::size_t;
+    static auto upper_bound(std::size_t index) noexcept -> std::uint64_t;
+};
+
+}  // namespace alewa
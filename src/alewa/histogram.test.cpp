@@ -0,0 +1,43 @@
+#include "test/test_utils.hpp"
+
+#include "histogram.hpp"
+
+namespace alewa::test {
+
+ALW_TEST(histogram_small_values_are_exact)
+{
+    Histogram h;
+    ALW_EXPECT_EQ(h.quantile(0.5), 0ul);
+    for (std::uint64_t v = 1; v <= 10; ++v) { h.record(v); }
+    ALW_EXPECT_EQ(h.count(), 10ul);
+    ALW_EXPECT_EQ(h.min(), 1ul);
+    ALW_EXPECT_EQ(h.max(), 10ul);
+    ALW_EXPECT_EQ(h.quantile(0.5), 5ul);
+    ALW_EXPECT_EQ(h.quantile(0.91), 10ul);
+    ALW_EXPECT_EQ(h.quantile(1.0), 10ul);
+    ALW_EXPECT_EQ(h.mean(), 5.5);
+}
+
+ALW_TEST(histogram_large_values_within_bucket_precision)
+{
+    Histogram h;
+    for (std::uint64_t v = 1; v <= 100'000; ++v) { h.record(v * 1000); }
+
+    /* never under, and over by at most 1/32 */
+    for (double q : {0.5, 0.99, 0.999}) {
+        auto const exact = static_cast<std::uint64_t>(q * 100'000) * 1000;
+        auto const got = h.quantile(q);
+        ALW_EXPECT_EQ(got >= exact, true);
+        ALW_EXPECT_EQ(got <= exact + exact / Histogram::SUB_BUCKETS, true);
+    }
+    ALW_EXPECT_EQ(h.quantile(1.0), 100'000'000ul);
+
+    Histogram other;
+    other.record(UINT64_MAX);
+    h.merge(other);
+    ALW_EXPECT_EQ(h.count(), 100'001ul);
+    ALW_EXPECT_EQ(h.quantile(1.0), UINT64_MAX);
+    ALW_EXPECT_EQ(h.min(), 1000ul);
+}
+
+}  // namespace alewa::test
@@ -0,0 +1,281 @@
+#include "parser.hpp"
+
+#include <charconv>
+
+#include "scan.hpp"
+
+namespace alewa::http {
+
+namespace {
+
+/* RFC 9110 tchar */
+auto is_token_char(char c) noexcept -> bool
+{
+    if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z')
+        || (c >= 'A' && c <= 'Z')) {
+        return true;
+    }
+    switch (c) {
+    case '!': case '#': case '$': case '%': case '&': case '\'': case '*':
+    case '+': case '-': case '.': case '^': case '_': case '`': case '|':
+    case '~':
+        return true;
+    default:
+        return false;
+    }
+}
+
+auto is_token(std::string_view s) noexcept -> bool
+{
+    if (s.empty()) { return false; }
+    for (char c : s) {
+        if (!is_token_char(c)) { return false; }
+    }
+    return true;
+}
+
+/* visible ASCII, space and tab, plus obs-text */
+auto is_field_value(std::string_view s) noexcept -> bool
+{
+    for (char c : s) {
+        auto const u = static_cast<unsigned char>(c);
+        if ((u < 0x20 && c != '\t') || u == 0x7f) { return false; }
+    }
+    return true;
+}
+
+auto is_request_target(std::string_view s) noexcept -> bool
+{
+    if (s.empty()) { return false; }
+    for (char c : s) {
+        auto const u = static_cast<unsigned char>(c);
+        if (u <= 0x20 || u == 0x7f) { return false; }
+    }
+    return true;
+}
+
+auto trim(std::string_view s) noexcept -> std::string_view
+{
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+        s.remove_prefix(1);
+    }
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+auto lower(char c) noexcept -> char
+{
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+}  // namespace
+
+auto iequals(std::string_view a, std::string_view b) noexcept -> bool
+{
+    if (a.size() != b.size()) { return false; }
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (lower(a[i]) != lower(b[i])) { return false; }
+    }
+    return true;
+}
+
+auto Request::header(std::string_view name) const
+        -> std::optional<std::string_view>
+{
+    for (Header const & h : headers) {
+        if (iequals(h.name, name)) { return h.value; }
+    }
+    return std::nullopt;
+}
+
+auto Parser::parse(std::string_view data) -> Status
+{
+    for (;;) {
+        switch (state) {
+        case State::REQUEST_LINE: {
+            auto line = next_line(data);
+            if (!line) { return Status::INCOMPLETE; }
+            if (line->empty()) { continue; }  /* stray CRLF between requests */
+            if (!parse_request_line(data, *line)) { return Status::ERROR; }
+            state = State::HEADERS;
+            break;
+        }
+        case State::HEADERS: {
+            auto line = next_line(data);
+            if (!line) { return Status::INCOMPLETE; }
+            if (line->empty()) {
+                body_start = line_start;
+                if (!end_of_headers(data)) { return Status::ERROR; }
+                state = State::BODY;
+                break;
+            }
+            if (!parse_header(data, *line)) { return Status::ERROR; }
+            break;
+        }
+        case State::BODY:
+            if (data.size() - body_start < content_length.value_or(0)) {
+                return Status::INCOMPLETE;
+            }
+            complete(data);
+            state = State::DONE;
+            return Status::COMPLETE;
+        case State::DONE:
+            complete(data);  /* the input may have moved since */
+            return Status::COMPLETE;
+        case State::FAILED:
+            return Status::ERROR;
+        }
+    }
+}
+
+void Parser::reset() noexcept
+{
+    state = State::REQUEST_LINE;
+    err = Error::NONE;
+    line_start = 0;
+    scanned = 0;
+    nheaders = 0;
+    body_start = 0;
+    content_length.reset();
+    req = {};
+}
+
+/* The next CRLF- (or bare LF-) terminated line, without its terminator, or
+ * nullopt if it has not fully arrived yet. */
+auto Parser::next_line(std::string_view data)
+        -> std::optional<std::string_view>
+{
+    char const * begin = data.data();
+    char const * end = begin + data.size();
+    char const * lf = scan::find_any(begin + scanned, end, "\n");
+    if (lf == end) {
+        scanned = data.size();
+        return std::nullopt;
+    }
+
+    std::size_t const start = line_start;
+    std::size_t length = static_cast<std::size_t>(lf - begin) - start;
+    if (length > 0 && data[start + length - 1] == '\r') { --length; }
+
+    line_start = static_cast<std::size_t>(lf - begin) + 1;
+    scanned = line_start;
+    return data.substr(start, length);
+}
+
+auto Parser::parse_request_line(std::string_view data, std::string_view line)
+        -> bool
+{
+    auto const base = static_cast<std::size_t>(line.data() - data.data());
+    std::size_t const sp1 = line.find(' ');
+    std::size_t const sp2 = (sp1 == line.npos) ? line.npos
+                                               : line.find(' ', sp1 + 1);
+    if (sp2 == line.npos) { return fail(Error::BAD_REQUEST_LINE); }
+
+    std::string_view const m = line.substr(0, sp1);
+    std::string_view const t = line.substr(sp1 + 1, sp2 - sp1 - 1);
+    std::string_view const v = line.substr(sp2 + 1);
+    if (!is_token(m) || !is_request_target(t)) {
+        return fail(Error::BAD_REQUEST_LINE);
+    }
+
+    if (v.size() != 8 || v.substr(0, 5) != "HTTP/" || v[6] != '.'
+        || v[5] < '0' || v[5] > '9' || v[7] < '0' || v[7] > '9') {
+        return fail(Error::BAD_REQUEST_LINE);
+    }
+    if (v[5] != '1') { return fail(Error::UNSUPPORTED_VERSION); }
+
+    method = {static_cast<std::uint32_t>(base),
+              static_cast<std::uint32_t>(m.size())};
+    target = {static_cast<std::uint32_t>(base + sp1 + 1),
+              static_cast<std::uint32_t>(t.size())};
+    minor_version = v[7] - '0';
+    return true;
+}
+
+auto Parser::parse_header(std::string_view data, std::string_view line)
+        -> bool
+{
+    if (line.front() == ' ' || line.front() == '\t') {
+        return fail(Error::BAD_HEADER);  /* obsolete line folding */
+    }
+    if (nheaders == MAX_HEADERS) {
+        return fail(Error::TOO_MANY_HEADERS);
+    }
+
+    char const * colon = scan::find_any(line.data(),
+                                        line.data() + line.size(), ":");
+    std::size_t const name_len = static_cast<std::size_t>(colon
+                                                          - line.data());
+    if (name_len == line.size()) { return fail(Error::BAD_HEADER); }
+
+    std::string_view const name = line.substr(0, name_len);
+    std::string_view const value = trim(line.substr(name_len + 1));
+    if (!is_token(name) || !is_field_value(value)) {
+        return fail(Error::BAD_HEADER);
+    }
+
+    auto const base = static_cast<std::size_t>(line.data() - data.data());
+    auto const value_offset = static_cast<std::size_t>(value.data()
+                                                       - data.data());
+    names[nheaders] = {static_cast<std::uint32_t>(base),
+                       static_cast<std::uint32_t>(name.size())};
+    values[nheaders] = {static_cast<std::uint32_t>(value_offset),
+                        static_cast<std::uint32_t>(value.size())};
+    ++nheaders;
+    return true;
+}
+
+auto Parser::end_of_headers(std::string_view data) -> bool
+{
+    for (std::size_t i = 0; i < nheaders; ++i) {
+        std::string_view const name = data.substr(names[i].offset,
+                                                  names[i].length);
+        std::string_view const value = data.substr(values[i].offset,
+                                                   values[i].length);
+
+        if (iequals(name, "transfer-encoding")) {
+            return fail(Error::UNSUPPORTED_TRANSFER_ENCODING);
+        }
+        if (!iequals(name, "content-length")) { continue; }
+
+        std::size_t length = 0;
+        auto const [end, ec] = std::from_chars(value.data(),
+                                               value.data() + value.size(),
+                                               length);
+        if (value.empty() || ec != std::errc{}
+            || end != value.data() + value.size()
+            || (content_length && *content_length != length)) {
+            return fail(Error::BAD_CONTENT_LENGTH);
+        }
+        content_length = length;
+    }
+    return true;
+}
+
+auto Parser::fail(Error error) -> bool
+{
+    err = error;
+    state = State::FAILED;
+    return false;
+}
+
+void Parser::complete(std::string_view data)
+{
+    auto view = [data](Slice s) { return data.substr(s.offset, s.length); };
+
+    for (std::size_t i = 0; i < nheaders; ++i) {
+        headers[i] = {view(names[i]), view(values[i])};
+    }
+    std::size_t const body_length = content_length.value_or(0);
+
+    req.method = view(method);
+    req.target = view(target);
+    req.minor_version = minor_version;
+    req.headers = {headers.data(), nheaders};
+    req.body = data.substr(body_start, body_length);
+    req.size = body_start + body_length;
+}
+
+}  // namespace alewa::http
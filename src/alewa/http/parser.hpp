@@ -0,0 +1,113 @@
+#pragma once
+
+#include <span>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace alewa::http {
+
+struct Header
+{
+    std::string_view name;
+    std::string_view value;
+};
+
+/* A parsed request. The views point into the buffer that was passed to
+ * Parser::parse and stay valid as long as those bytes are not moved and the
+ * parser is not reset. */
+struct Request
+{
+    std::string_view method;
+    std::string_view target;
+    int minor_version = 1;  /* HTTP/1.x */
+    std::span<Header const> headers;
+    std::string_view body;
+
+    /* bytes the request occupies in the input, headers and body */
+    std::size_t size = 0;
+
+    /* Value of the first header called `name` (case-insensitive). */
+    [[nodiscard]]
+    auto header(std::string_view name) const -> std::optional<std::string_view>;
+};
+
+/* Resumable HTTP/1.1 request parser. parse() is handed all unconsumed input,
+ * starting at the first byte of the request; when it needs more it returns
+ * INCOMPLETE and remembers how far it got, so a request arriving in arbitrary
+ * pieces is scanned only once overall. Positions are kept as offsets, so the
+ * input may be moved (compacted, grown) between calls. Nothing is copied and
+ * nothing is allocated. Request bodies need a Content-Length; chunked request
+ * bodies are rejected as unsupported. */
+class Parser
+{
+public:
+    static constexpr std::size_t MAX_HEADERS = 64;
+
+    enum class Status { INCOMPLETE, COMPLETE, ERROR };
+
+    enum class Error
+    {
+        NONE,
+        BAD_REQUEST_LINE,
+        BAD_HEADER,
+        TOO_MANY_HEADERS,
+        BAD_CONTENT_LENGTH,
+        UNSUPPORTED_TRANSFER_ENCODING,
+        UNSUPPORTED_VERSION,
+    };
+
+private:
+    struct Slice
+    {
+        std::uint32_t offset = 0;
+        std::uint32_t length = 0;
+    };
+
+    enum class State { REQUEST_LINE, HEADERS, BODY, DONE, FAILED };
+
+    State state = State::REQUEST_LINE;
+    Error err = Error::NONE;
+    std::size_t line_start = 0;  /* first byte of the line being parsed */
+    std::size_t scanned = 0;     /* no line feed before this offset */
+
+    Slice method;
+    Slice target;
+    int minor_version = 1;
+    std::array<Slice, MAX_HEADERS> names{};
+    std::array<Slice, MAX_HEADERS> values{};
+    std::size_t nheaders = 0;
+    std::size_t body_start = 0;
+    std::optional<std::size_t> content_length;
+
+    Request req;
+    std::array<Header, MAX_HEADERS> headers{};
+
+public:
+    auto parse(std::string_view data) -> Status;
+
+    /* Only meaningful after parse returned COMPLETE. */
+    [[nodiscard]]
+    auto request() const noexcept -> Request const & { return req; }
+
+    [[nodiscard]]
+    auto error() const noexcept -> Error { return err; }
+
+    /* Forget the current request; the next parse starts a new one. */
+    void reset() noexcept;
+
+private:
+    auto next_line(std::string_view data) -> std::optional<std::string_view>;
+    auto parse_request_line(std::string_view data, std::string_view line)
+            -> bool;
+    auto parse_header(std::string_view data, std::string_view line) -> bool;
+    auto end_of_headers(std::string_view data) -> bool;
+    auto fail(Error error) -> bool;
+    void complete(std::string_view data);
+};
+
+/* Lower-case ASCII comparison, as header names are case-insensitive. */
+auto iequals(std::string_view a, std::string_view b) noexcept -> bool;
+
+}  // namespace alewa::http
@@ -0,0 +1,291 @@
+#include "test/test_utils.hpp"
+
+#include <random>
+#include <vector>
+
+#include "parser.hpp"
+#include "scan.hpp"
+
+namespace alewa::http::test {
+
+namespace {
+
+struct Parsed
+{
+    std::string method;
+    std::string target;
+    int minor_version;
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::string body;
+
+    auto operator==(Parsed const &) const -> bool = default;
+};
+
+auto to_parsed(Request const & r) -> Parsed
+{
+    Parsed p{std::string{r.method}, std::string{r.target}, r.minor_version,
+             {}, std::string{r.body}};
+    for (Header const & h : r.headers) {
+        p.headers.emplace_back(h.name, h.value);
+    }
+    return p;
+}
+
+struct FeedResult
+{
+    std::vector<Parsed> requests;
+    Parser::Status last;  /* after the final request was consumed */
+    Parser::Error error;
+};
+
+/* Deliver `stream` in chunks of the given sizes (the last one repeating),
+ * consuming complete requests as a connection would. The pending input is a
+ * std::string, so it moves around in memory as it grows. */
+auto feed(std::string const & stream, std::vector<std::size_t> const & sizes)
+        -> FeedResult
+{
+    Parser parser;
+    FeedResult result{{}, Parser::Status::INCOMPLETE, Parser::Error::NONE};
+    std::string pending;
+    std::size_t pos = 0;
+    std::size_t chunk = 0;
+    while (pos < stream.size()) {
+        std::size_t const n = std::min(sizes[std::min(chunk, sizes.size() - 1)],
+                                       stream.size() - pos);
+        pending.append(stream, pos, n);
+        pos += n;
+        ++chunk;
+
+        for (;;) {
+            result.last = parser.parse(pending);
+            if (result.last == Parser::Status::ERROR) {
+                result.error = parser.error();
+                return result;
+            }
+            if (result.last == Parser::Status::INCOMPLETE) { break; }
+            result.requests.push_back(to_parsed(parser.request()));
+            pending.erase(0, parser.request().size);
+            parser.reset();
+        }
+    }
+    return result;
+}
+
+auto parse_one(std::string const & text) -> FeedResult
+{
+    return feed(text, {text.size()});
+}
+
+auto random_token(std::mt19937& rng, std::size_t max_len) -> std::string
+{
+    static std::string const tchars =
+            "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"
+            "!#$%&'*+-.^_`|~";
+    std::string s(1 + rng() % max_len, ' ');
+    for (char& c : s) { c = tchars[rng() % tchars.size()]; }
+    return s;
+}
+
+auto random_request(std::mt19937& rng) -> std::pair<std::string, Parsed>
+{
+    Parsed p;
+    static char const * const methods[] = {"GET", "HEAD", "POST", "PUT"};
+    p.method = methods[rng() % 4];
+    p.target = "/" + random_token(rng, 40);
+    p.minor_version = static_cast<int>(rng() % 2);
+
+    std::string text = p.method + " " + p.target + " HTTP/1."
+                       + std::to_string(p.minor_version) + "\r\n";
+    std::size_t const nheaders = rng() % 12;
+    for (std::size_t i = 0; i < nheaders; ++i) {
+        std::string name = "X-" + random_token(rng, 16);
+        std::string value = random_token(rng, 60) + " " + random_token(rng, 8);
+        p.headers.emplace_back(name, value);
+        text += name + ":" + std::string(rng() % 3, ' ') + value
+                + std::string(rng() % 2, '\t') + "\r\n";
+    }
+    if (rng() % 3 == 0) {
+        p.body = random_token(rng, 200);
+        p.headers.emplace_back("Content-Length", std::to_string(p.body.size()));
+        text += "Content-Length: " + std::to_string(p.body.size()) + "\r\n";
+    }
+    text += "\r\n" + p.body;
+    return {text, p};
+}
+
+}  // namespace
+
+ALW_TEST(http_parser_simple_get)
+{
+    auto r = parse_one("GET /index.html?q=1 HTTP/1.1\r\n"
+                       "Host: example.com\r\n"
+                       "Accept:  text/html \t\r\n"
+                       "Empty:\r\n"
+                       "\r\n");
+    ALW_EXPECT_EQ(r.requests.size(), 1ul);
+
+    Parsed const & p = r.requests[0];
+    ALW_EXPECT_EQ(p.method, "GET");
+    ALW_EXPECT_EQ(p.target, "/index.html?q=1");
+    ALW_EXPECT_EQ(p.minor_version, 1);
+    ALW_EXPECT_EQ(p.headers.size(), 3ul);
+    ALW_EXPECT_EQ(p.headers[1].second, "text/html");
+    ALW_EXPECT_EQ(p.headers[2].second, "");
+    ALW_EXPECT_EQ(p.body, "");
+}
+
+ALW_TEST(http_parser_views_point_into_input)
+{
+    std::string const text = "HEAD / HTTP/1.0\nHost: a\n\nGET";
+    Parser parser;
+    ALW_EXPECT_EQ(parser.parse(text), Parser::Status::COMPLETE);
+
+    Request const & r = parser.request();
+    ALW_EXPECT_EQ(r.method.data(), text.data());
+    ALW_EXPECT_EQ(r.minor_version, 0);
+    ALW_EXPECT_EQ(r.size, text.size() - 3);
+    ALW_EXPECT_EQ(r.header("HOST").value_or(""), "a");
+    ALW_EXPECT_EQ(r.header("accept").has_value(), false);
+}
+
+ALW_TEST(http_parser_body)
+{
+    std::string const head = "POST /f HTTP/1.1\r\nContent-Length: 5\r\n\r\n";
+    Parser parser;
+    ALW_EXPECT_EQ(parser.parse(head + "hel"), Parser::Status::INCOMPLETE);
+    std::string const full = head + "helloGET";
+    ALW_EXPECT_EQ(parser.parse(full), Parser::Status::COMPLETE);
+    ALW_EXPECT_EQ(parser.request().body, "hello");
+    ALW_EXPECT_EQ(parser.request().size, head.size() + 5);
+}
+
+ALW_TEST(http_parser_pipelined)
+{
+    auto r = parse_one("GET /a HTTP/1.1\r\n\r\n"
+                       "\r\n"
+                       "GET /b HTTP/1.1\r\nContent-Length: 2\r\n\r\nok"
+                       "GET /c HTTP/1.1\r\n\r\n");
+    ALW_EXPECT_EQ(r.requests.size(), 3ul);
+    ALW_EXPECT_EQ(r.requests[0].target, "/a");
+    ALW_EXPECT_EQ(r.requests[1].body, "ok");
+    ALW_EXPECT_EQ(r.requests[2].target, "/c");
+}
+
+ALW_TEST(http_parser_errors)
+{
+    using E = Parser::Error;
+    std::pair<char const *, E> const cases[] = {
+        {"GET /\r\n\r\n", E::BAD_REQUEST_LINE},
+        {"GET  / HTTP/1.1\r\n\r\n", E::BAD_REQUEST_LINE},
+        {"G(T / HTTP/1.1\r\n\r\n", E::BAD_REQUEST_LINE},
+        {"GET / HTTP/1.1 \r\n\r\n", E::BAD_REQUEST_LINE},
+        {"GET / HTTX/1.1\r\n\r\n", E::BAD_REQUEST_LINE},
+        {"GET / HTTP/2.0\r\n\r\n", E::UNSUPPORTED_VERSION},
+        {"GET / HTTP/1.1\r\nA: b\r\n folded\r\n\r\n", E::BAD_HEADER},
+        {"GET / HTTP/1.1\r\nNoColon\r\n\r\n", E::BAD_HEADER},
+        {"GET / HTTP/1.1\r\nBad Name: x\r\n\r\n", E::BAD_HEADER},
+        {"GET / HTTP/1.1\r\nA: b\x01\r\n\r\n", E::BAD_HEADER},
+        {"GET / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n",
+         E::UNSUPPORTED_TRANSFER_ENCODING},
+        {"GET / HTTP/1.1\r\nContent-Length: -1\r\n\r\n",
+         E::BAD_CONTENT_LENGTH},
+        {"GET / HTTP/1.1\r\nContent-Length: 1\r\nContent-Length: 2\r\n\r\n",
+         E::BAD_CONTENT_LENGTH},
+    };
+    for (auto const & [text, error] : cases) {
+        auto r = parse_one(text);
+        ALW_EXPECT_EQ(r.last, Parser::Status::ERROR);
+        ALW_EXPECT_EQ(r.error, error);
+    }
+
+    std::string many = "GET / HTTP/1.1\r\n";
+    for (std::size_t i = 0; i <= Parser::MAX_HEADERS; ++i) {
+        many += "A: b\r\n";
+    }
+    ALW_EXPECT_EQ(parse_one(many + "\r\n").error, E::TOO_MANY_HEADERS);
+}
+
+ALW_TEST(http_parser_byte_by_byte)
+{
+    std::mt19937 rng{7};
+    for (int round = 0; round < 50; ++round) {
+        std::string stream;
+        std::vector<Parsed> expected;
+        for (int i = 0; i < 4; ++i) {
+            auto [text, parsed] = random_request(rng);
+            stream += text;
+            expected.push_back(parsed);
+        }
+
+        auto whole = feed(stream, {stream.size()});
+        auto bytes = feed(stream, {1});
+        ALW_EXPECT_EQ(whole.requests == expected, true);
+        ALW_EXPECT_EQ(bytes.requests == expected, true);
+    }
+}
+
+ALW_TEST(http_parser_arbitrary_splits)
+{
+    std::mt19937 rng{11};
+    for (int round = 0; round < 200; ++round) {
+        std::string stream;
+        std::vector<Parsed> expected;
+        for (int i = 0; i < 3; ++i) {
+            auto [text, parsed] = random_request(rng);
+            stream += text;
+            expected.push_back(parsed);
+        }
+
+        std::vector<std::size_t> sizes;
+        for (int i = 0; i < 16; ++i) { sizes.push_back(1 + rng() % 97); }
+        ALW_EXPECT_EQ(feed(stream, sizes).requests == expected, true);
+    }
+}
+
+ALW_TEST(http_parser_garbage_is_split_invariant)
+{
+    /* whatever the verdict on random input, it must not depend on how the
+     * bytes were split up */
+    std::mt19937 rng{13};
+    std::string const alphabet = "GET /HTP1.:\r\n \tabcXY-0\x01\x7f";
+    for (int round = 0; round < 300; ++round) {
+        std::string stream = (rng() % 2) ? "GET / HTTP/1.1\r\n" : "";
+        std::size_t const n = rng() % 120;
+        for (std::size_t i = 0; i < n; ++i) {
+            stream += alphabet[rng() % alphabet.size()];
+        }
+
+        auto whole = feed(stream, {stream.size()});
+        auto bytes = feed(stream, {1});
+        ALW_EXPECT_EQ(whole.requests == bytes.requests, true);
+        ALW_EXPECT_EQ(whole.last, bytes.last);
+        ALW_EXPECT_EQ(whole.error, bytes.error);
+    }
+}
+
+ALW_TEST(http_scan_implementations_agree)
+{
+    using scan::detail::FindAny;
+    FindAny const impls[] = {scan::detail::find_any_sse42(),
+                             scan::detail::find_any_avx2()};
+    std::string_view const sets[] = {"\n", ":", "\r\n", ":\r\n"};
+
+    std::mt19937 rng{17};
+    std::string const alphabet = "abcdefgh:\r\n ";
+    for (int round = 0; round < 500; ++round) {
+        std::string data(rng() % 150, ' ');
+        for (char& c : data) { c = alphabet[rng() % alphabet.size()]; }
+        char const * begin = data.data();
+        char const * end = begin + data.size();
+
+        for (std::string_view set : sets) {
+            char const * want = scan::detail::find_any_scalar(begin, end, set);
+            ALW_EXPECT_EQ(scan::find_any(begin, end, set), want);
+            for (FindAny impl : impls) {
+                if (impl) { ALW_EXPECT_EQ(impl(begin, end, set), want); }
+            }
+        }
+    }
+}
+
+}  // namespace alewa::http::test
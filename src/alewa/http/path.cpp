@@ -0,0 +1,64 @@
+#include "path.hpp"
+
+namespace alewa::http {
+
+namespace {
+
+auto hex_value(char c) noexcept -> int
+{
+    if (c >= '0' && c <= '9') { return c - '0'; }
+    if (c >= 'a' && c <= 'f') { return c - 'a' + 10; }
+    if (c >= 'A' && c <= 'F') { return c - 'A' + 10; }
+    return -1;
+}
+
+}  // namespace
+
+auto normalize_path(std::string_view target, std::string& out) -> bool
+{
+    if (target.empty() || target.front() != '/') { return false; }
+    target = target.substr(0, target.find_first_of("?#"));
+
+    out.clear();
+    std::size_t segment = 0;  /* where the current segment starts in out */
+    auto end_segment = [&out, &segment]() {
+        std::string_view const s{out.data() + segment, out.size() - segment};
+        if (s == "..") { return false; }
+        if (s.empty() || s == ".") { out.resize(segment); }
+        else { out += '/'; }
+        segment = out.size();
+        return true;
+    };
+
+    out += '/';
+    segment = 1;
+    for (std::size_t i = 1; i < target.size(); ++i) {
+        char c = target[i];
+        if (c == '/') {
+            if (!end_segment()) { return false; }
+            continue;
+        }
+        if (c == '%') {
+            int const hi = (i + 2 < target.size())
+                    ? hex_value(target[i + 1]) : -1;
+            int const lo = (hi >= 0) ? hex_value(target[i + 2]) : -1;
+            if (lo < 0) { return false; }
+            c = static_cast<char>(hi * 16 + lo);
+            i += 2;
+            if (c == '/') { return false; }  /* would change the segments */
+        }
+        if (c == '\0') { return false; }
+        out += c;
+    }
+
+    if (segment == out.size()) {
+        out += "index.html";  /* the target named a directory */
+        return true;
+    }
+    std::string_view const last{out.data() + segment, out.size() - segment};
+    if (last == "..") { return false; }
+    if (last == ".") { out.replace(segment, 1, "index.html"); }
+    return true;
+}
+
+}  // namespace alewa::http
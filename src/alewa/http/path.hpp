@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace alewa::http {
+
+/* Turn a request target into a path safe to resolve under a document root:
+ * the query is dropped, %XX escapes are decoded, empty and "." segments are
+ * removed, and a trailing slash names "index.html". The result starts with
+ * '/' and is written to `out`, reusing its storage. False for targets that
+ * are not origin-form, contain ".." segments, bad escapes or NUL. */
+auto normalize_path(std::string_view target, std::string& out) -> bool;
+
+}  // namespace alewa::http
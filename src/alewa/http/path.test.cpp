@@ -0,0 +1,35 @@
+#include "test/test_utils.hpp"
+
+#include <string>
+
+#include "path.hpp"
+
+namespace alewa::http::test {
+
+ALW_TEST(http_normalize_path)
+{
+    std::pair<char const *, char const *> const valid[] = {
+        {"/", "/index.html"},
+        {"/alewa.jpg", "/alewa.jpg"},
+        {"/a//b/./c.txt?x=../..", "/a/b/c.txt"},
+        {"/docs/", "/docs/index.html"},
+        {"/docs/.", "/docs/index.html"},
+        {"/my%20file.txt#top", "/my file.txt"},
+        {"/..foo/bar..", "/..foo/bar.."},
+    };
+    std::string out;
+    for (auto const & [target, expected] : valid) {
+        ALW_EXPECT_EQ(normalize_path(target, out), true);
+        ALW_EXPECT_EQ(out, expected);
+    }
+
+    char const * const invalid[] = {
+        "", "*", "http://example.com/", "/..", "/a/../../etc/passwd",
+        "/%2e%2e/x", "/a%2fb", "/a%00b", "/a%4", "/a%zz",
+    };
+    for (char const * target : invalid) {
+        ALW_EXPECT_EQ(normalize_path(target, out), false);
+    }
+}
+
+}  // namespace alewa::http::test
@@ -0,0 +1,264 @@
+#include "response.hpp"
+
+#include <ctime>
+#include <charconv>
+#include <cstring>
+
+namespace alewa::http {
+
+namespace {
+
+/* Appends to a fixed span, remembering whether anything was cut off. */
+class Writer
+{
+private:
+    std::span<char> out;
+    std::size_t pos = 0;
+    bool overflow = false;
+
+public:
+    explicit Writer(std::span<char> out) : out(out) {}
+
+    void put(std::string_view s) noexcept
+    {
+        if (overflow || s.size() > out.size() - pos) {
+            overflow = true;
+            return;
+        }
+        std::memcpy(out.data() + pos, s.data(), s.size());
+        pos += s.size();
+    }
+
+    void put(std::size_t n) noexcept
+    {
+        char digits[20];
+        auto const [end, ec] = std::to_chars(digits, digits + sizeof(digits),
+                                             n);
+        put({digits, static_cast<std::size_t>(end - digits)});
+    }
+
+    [[nodiscard]]
+    auto written() const noexcept -> std::size_t
+    {
+        return overflow ? 0 : pos;
+    }
+};
+
+auto trim(std::string_view s) noexcept -> std::string_view
+{
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+        s.remove_prefix(1);
+    }
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+/* Pass each item of the comma-separated header value `list`, trimmed, to
+ * f until it returns true; whether one did. */
+template <typename F>
+auto any_item(std::string_view list, F&& f) -> bool
+{
+    while (!list.empty()) {
+        std::size_t const comma = list.find(',');
+        if (f(trim(list.substr(0, comma)))) { return true; }
+        if (comma == list.npos) { break; }
+        list.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+/* Whether the comma-separated header value `list` contains `token`. */
+auto has_token(std::string_view list, std::string_view token) noexcept
+        -> bool
+{
+    return any_item(list, [token](std::string_view item) {
+        return iequals(item, token);
+    });
+}
+
+/* Whether the parameters after a token, e.g. ";q=0.5", set its weight to
+ * 0, which refuses it. */
+auto refused(std::string_view params) noexcept -> bool
+{
+    while (!params.empty()) {
+        std::size_t const semi = params.find(';', 1);
+        std::string_view const param = trim(params.substr(1, semi - 1));
+        if (param.size() >= 2 && (param[0] == 'q' || param[0] == 'Q')
+            && param[1] == '=') {
+            std::string_view const q = trim(param.substr(2));
+            return !q.empty() && q[0] == '0'
+                   && q.find_first_not_of("0.", 1) == q.npos;
+        }
+        if (semi == params.npos) { break; }
+        params.remove_prefix(semi);
+    }
+    return false;
+}
+
+}  // namespace
+
+auto reason(int status) noexcept -> std::string_view
+{
+    switch (status) {
+    case 200: return "OK";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 503: return "Service Unavailable";
+    case 505: return "HTTP Version Not Supported";
+    default: return "Unknown";
+    }
+}
+
+auto error_status(Parser::Error error) noexcept -> int
+{
+    switch (error) {
+    case Parser::Error::TOO_MANY_HEADERS: return 431;
+    case Parser::Error::UNSUPPORTED_TRANSFER_ENCODING: return 501;
+    case Parser::Error::UNSUPPORTED_VERSION: return 505;
+    default: return 400;
+    }
+}
+
+auto keep_alive(Request const & request) noexcept -> bool
+{
+    auto const connection = request.header("connection");
+    if (request.minor_version == 0) {
+        return connection && has_token(*connection, "keep-alive");
+    }
+    return !connection || !has_token(*connection, "close");
+}
+
+auto content_type(std::string_view path) noexcept -> std::string_view
+{
+    static std::pair<std::string_view, std::string_view> const types[] = {
+        {"html", "text/html; charset=utf-8"},
+        {"htm", "text/html; charset=utf-8"},
+        {"css", "text/css; charset=utf-8"},
+        {"js", "text/javascript; charset=utf-8"},
+        {"json", "application/json"},
+        {"txt", "text/plain; charset=utf-8"},
+        {"xml", "application/xml"},
+        {"svg", "image/svg+xml"},
+        {"jpg", "image/jpeg"},
+        {"jpeg", "image/jpeg"},
+        {"png", "image/png"},
+        {"gif", "image/gif"},
+        {"webp", "image/webp"},
+        {"ico", "image/x-icon"},
+        {"pdf", "application/pdf"},
+        {"wasm", "application/wasm"},
+        {"woff2", "font/woff2"},
+    };
+
+    std::size_t const dot = path.rfind('.');
+    std::size_t const slash = path.rfind('/');
+    if (dot != path.npos && (slash == path.npos || dot > slash)) {
+        std::string_view const ext = path.substr(dot + 1);
+        for (auto const & [e, type] : types) {
+            if (iequals(ext, e)) { return type; }
+        }
+    }
+    return "application/octet-stream";
+}
+
+auto coding_name(Coding coding) noexcept -> std::string_view
+{
+    switch (coding) {
+    case Coding::BR: return "br";
+    case Coding::ZSTD: return "zstd";
+    case Coding::GZIP: return "gzip";
+    }
+    return {};
+}
+
+auto coding_suffix(Coding coding) noexcept -> std::string_view
+{
+    switch (coding) {
+    case Coding::BR: return ".br";
+    case Coding::ZSTD: return ".zst";
+    case Coding::GZIP: return ".gz";
+    }
+    return {};
+}
+
+auto accepted_codings(std::string_view accept_encoding) noexcept -> unsigned
+{
+    unsigned named = 0;
+    unsigned allowed = 0;
+    bool any = false;
+    any_item(accept_encoding, [&](std::string_view item) {
+        std::size_t const semi = item.find(';');
+        std::string_view const token = trim(item.substr(0, semi));
+        bool const ok = (semi == item.npos) || !refused(item.substr(semi));
+        if (token == "*") { any = ok; }
+        for (Coding const coding : CODINGS) {
+            if (iequals(token, coding_name(coding))
+                || (coding == Coding::GZIP && iequals(token, "x-gzip"))) {
+                named |= coding_bit(coding);
+                if (ok) { allowed |= coding_bit(coding); }
+            }
+        }
+        return false;
+    });
+    if (any) {
+        for (Coding const coding : CODINGS) {
+            if (!(named & coding_bit(coding))) {
+                allowed |= coding_bit(coding);
+            }
+        }
+    }
+    return allowed;
+}
+
+auto compressible(std::string_view content_type) noexcept -> bool
+{
+    static std::string_view const types[] = {
+        "text/", "application/json", "application/xml", "image/svg+xml",
+        "application/wasm",
+    };
+    for (std::string_view const type : types) {
+        if (content_type.starts_with(type)) { return true; }
+    }
+    return false;
+}
+
+auto format_date(std::int64_t unix_seconds) -> std::string
+{
+    auto const t = static_cast<std::time_t>(unix_seconds);
+    std::tm tm{};
+    ::gmtime_r(&t, &tm);
+    char buf[32];
+    std::size_t const n = std::strftime(buf, sizeof(buf),
+                                        "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    return {buf, n};
+}
+
+auto write_head(Response const & response, std::span<char> out) noexcept
+        -> std::size_t
+{
+    Writer w{out};
+    w.put("HTTP/1.1 ");
+    w.put(static_cast<std::size_t>(response.status));
+    w.put(" ");
+    w.put(reason(response.status));
+    w.put("\r\nContent-Length: ");
+    w.put(response.content_length.value_or(response.body.size()));
+    if (!response.content_type.empty()) {
+        w.put("\r\nContent-Type: ");
+        w.put(response.content_type);
+    }
+    w.put(response.keep_alive ? "\r\nConnection: keep-alive\r\n"
+                              : "\r\nConnection: close\r\n");
+    w.put(response.headers);
+    w.put("\r\n");
+    return w.written();
+}
+
+}  // namespace alewa::http
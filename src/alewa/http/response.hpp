@@ -0,0 +1,79 @@
+#pragma once
+
+#include <span>
+#include <array>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include "parser.hpp"
+
+namespace alewa::http {
+
+/* The body is referenced, not copied: it has to stay valid until the
+ * connection has sent it. */
+struct Response
+{
+    int status = 200;
+    std::string_view content_type;
+    std::string_view body;
+    bool keep_alive = true;
+    bool head_only = false;  /* answer to HEAD: headers but no body */
+
+    /* extra header lines, each terminated by CRLF */
+    std::string_view headers{};
+
+    /* set when the body is sent from elsewhere, e.g. a file */
+    std::optional<std::size_t> content_length{};
+};
+
+/* Reason phrase for the status codes alewa produces. */
+auto reason(int status) noexcept -> std::string_view;
+
+/* Status to answer a request the parser rejected with. */
+auto error_status(Parser::Error error) noexcept -> int;
+
+/* Whether the connection persists after `request`: HTTP/1.1 unless it asks
+ * for "Connection: close", HTTP/1.0 only with "Connection: keep-alive". */
+auto keep_alive(Request const & request) noexcept -> bool;
+
+/* Media type for a file, by its extension. */
+auto content_type(std::string_view path) noexcept -> std::string_view;
+
+/* Content codings alewa serves, best first. */
+enum class Coding : unsigned { BR, ZSTD, GZIP };
+
+inline constexpr std::array<Coding, 3> CODINGS{Coding::BR, Coding::ZSTD,
+                                               Coding::GZIP};
+
+constexpr auto coding_bit(Coding coding) noexcept -> unsigned
+{
+    return 1u << static_cast<unsigned>(coding);
+}
+
+/* Its Content-Encoding token, e.g. "br". */
+auto coding_name(Coding coding) noexcept -> std::string_view;
+
+/* The suffix of a file precompressed with it, e.g. ".br". */
+auto coding_suffix(Coding coding) noexcept -> std::string_view;
+
+/* The codings an Accept-Encoding value allows, as coding_bit()s: those it
+ * names without q=0, and with "*" those it does not name. */
+auto accepted_codings(std::string_view accept_encoding) noexcept -> unsigned;
+
+/* Whether a body of this media type is worth compressing: text, scripts,
+ * JSON, XML, SVG and WebAssembly, not images or fonts that already are. */
+auto compressible(std::string_view content_type) noexcept -> bool;
+
+/* IMF-fixdate (RFC 9110), e.g. "Sun, 06 Nov 1994 08:49:37 GMT". */
+auto format_date(std::int64_t unix_seconds) -> std::string;
+
+/* Write the status line and headers, up to and including the blank line,
+ * into `out`. The body is sent from where it lies. Returns the number of
+ * bytes written, or 0 (leaving `out` unspecified) if they do not fit. */
+auto write_head(Response const & response, std::span<char> out) noexcept
+        -> std::size_t;
+
+}  // namespace alewa::http
@@ -0,0 +1,97 @@
+#include "test/test_utils.hpp"
+
+#include <string>
+
+#include "parser.hpp"
+#include "response.hpp"
+
+namespace alewa::http::test {
+
+namespace {
+
+auto parsed(std::string const & text, Parser& parser) -> Request const &
+{
+    [[maybe_unused]] auto status = parser.parse(text);
+    return parser.request();
+}
+
+}  // namespace
+
+ALW_TEST(http_response_write_head)
+{
+    char out[256];
+    Response response{404, "text/plain", "gone", false};
+    std::size_t const n = write_head(response, out);
+    ALW_EXPECT_EQ(std::string(out, n),
+                  "HTTP/1.1 404 Not Found\r\n"
+                  "Content-Length: 4\r\n"
+                  "Content-Type: text/plain\r\n"
+                  "Connection: close\r\n"
+                  "\r\n");
+    ALW_EXPECT_EQ(write_head(response, {out, n - 1}), 0ul);  /* no room */
+}
+
+ALW_TEST(http_response_keep_alive)
+{
+    std::pair<char const *, bool> const cases[] = {
+        {"GET / HTTP/1.1\r\n\r\n", true},
+        {"GET / HTTP/1.1\r\nConnection: Upgrade, CLOSE\r\n\r\n", false},
+        {"GET / HTTP/1.1\r\nConnection: closed\r\n\r\n", true},
+        {"GET / HTTP/1.0\r\n\r\n", false},
+        {"GET / HTTP/1.0\r\nConnection: keep-alive\r\n\r\n", true},
+    };
+    for (auto const & [text, expected] : cases) {
+        Parser parser;
+        ALW_EXPECT_EQ(keep_alive(parsed(text, parser)), expected);
+    }
+}
+
+ALW_TEST(http_response_file_headers)
+{
+    ALW_EXPECT_EQ(content_type("/a/photo.JPG"), "image/jpeg");
+    ALW_EXPECT_EQ(content_type("/index.html"), "text/html; charset=utf-8");
+    ALW_EXPECT_EQ(content_type("/v1.2/README"), "application/octet-stream");
+    ALW_EXPECT_EQ(format_date(784111777), "Sun, 06 Nov 1994 08:49:37 GMT");
+
+    char out[256];
+    Response response{200, "image/jpeg", {}, true};
+    response.content_length = 22520;
+    response.headers = "ETag: \"x\"\r\n";
+    std::size_t const n = write_head(response, out);
+    ALW_EXPECT_EQ(std::string(out, n),
+                  "HTTP/1.1 200 OK\r\n"
+                  "Content-Length: 22520\r\n"
+                  "Content-Type: image/jpeg\r\n"
+                  "Connection: keep-alive\r\n"
+                  "ETag: \"x\"\r\n"
+                  "\r\n");
+}
+
+ALW_TEST(http_response_accepted_codings)
+{
+    unsigned const br = coding_bit(Coding::BR);
+    unsigned const zstd = coding_bit(Coding::ZSTD);
+    unsigned const gzip = coding_bit(Coding::GZIP);
+    std::pair<char const *, unsigned> const cases[] = {
+        {"", 0},
+        {"identity", 0},
+        {"gzip, deflate, br, zstd", br | zstd | gzip},
+        {"GZIP;q=0.5, x-gzip", gzip},
+        {"br;q=0, gzip;q=0.001", gzip},
+        {"br; q=0.000 ,gzip", gzip},
+        {"*", br | zstd | gzip},
+        {"*;q=0.1, zstd;q=0", br | gzip},
+        {"gzip;q=0, *", br | zstd},
+        {"*;q=0", 0},
+    };
+    for (auto const & [value, expected] : cases) {
+        ALW_EXPECT_EQ(accepted_codings(value), expected);
+    }
+    ALW_EXPECT_EQ(coding_suffix(Coding::ZSTD), ".zst");
+    ALW_EXPECT_EQ(compressible(content_type("/app.js")), true);
+    ALW_EXPECT_EQ(compressible(content_type("/logo.svg")), true);
+    ALW_EXPECT_EQ(compressible(content_type("/photo.png")), false);
+    ALW_EXPECT_EQ(compressible(content_type("/font.woff2")), false);
+}
+
+}  // namespace alewa::http::test
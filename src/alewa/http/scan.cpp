@@ -0,0 +1,131 @@
+#include "scan.hpp"
+
+#include <cstring>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ALEWA_X86 1
+#endif
+
+namespace alewa::http::scan {
+
+namespace detail {
+
+auto find_any_scalar(char const * p, char const * end, std::string_view set)
+        -> char const *
+{
+    if (set.size() == 1) {
+        auto const * hit = static_cast<char const *>(
+                std::memchr(p, set[0], static_cast<std::size_t>(end - p)));
+        return hit ? hit : end;
+    }
+    for (; p != end; ++p) {
+        if (set.find(*p) != std::string_view::npos) { return p; }
+    }
+    return end;
+}
+
+#ifdef ALEWA_X86
+
+namespace {
+
+/* PCMPESTRI compares each 16-byte block against the whole set at once. */
+__attribute__((target("sse4.2")))
+auto sse42(char const * p, char const * end, std::string_view set)
+        -> char const *
+{
+    char chars[16] = {};
+    std::memcpy(chars, set.data(), set.size());
+    __m128i const needle = _mm_loadu_si128(
+            reinterpret_cast<__m128i const *>(chars));
+    int const nlen = static_cast<int>(set.size());
+
+    for (; end - p >= 16; p += 16) {
+        __m128i const block = _mm_loadu_si128(
+                reinterpret_cast<__m128i const *>(p));
+        int const i = _mm_cmpestri(needle, nlen, block, 16,
+                                   _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY
+                                   | _SIDD_LEAST_SIGNIFICANT);
+        if (i != 16) { return p + i; }
+    }
+    return find_any_scalar(p, end, set);
+}
+
+/* One compare per set byte over 32-byte blocks; sets here are tiny. */
+__attribute__((target("avx2")))
+auto avx2(char const * p, char const * end, std::string_view set)
+        -> char const *
+{
+    __m256i needles[16];
+    std::size_t const n = set.size();
+    for (std::size_t i = 0; i < n; ++i) {
+        needles[i] = _mm256_set1_epi8(set[i]);
+    }
+
+    for (; end - p >= 32; p += 32) {
+        __m256i const block = _mm256_loadu_si256(
+                reinterpret_cast<__m256i const *>(p));
+        __m256i hits = _mm256_cmpeq_epi8(block, needles[0]);
+        for (std::size_t i = 1; i < n; ++i) {
+            hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(block, needles[i]));
+        }
+        auto const mask = static_cast<std::uint32_t>(
+                _mm256_movemask_epi8(hits));
+        if (mask != 0) { return p + __builtin_ctz(mask); }
+    }
+    return find_any_scalar(p, end, set);
+}
+
+}  // namespace
+
+auto find_any_sse42() -> FindAny
+{
+    return __builtin_cpu_supports("sse4.2") ? &sse42 : nullptr;
+}
+
+auto find_any_avx2() -> FindAny
+{
+    return __builtin_cpu_supports("avx2") ? &avx2 : nullptr;
+}
+
+#else
+
+auto find_any_sse42() -> FindAny { return nullptr; }
+auto find_any_avx2() -> FindAny { return nullptr; }
+
+#endif
+
+}  // namespace alewa::http::scan::detail
+
+namespace {
+
+struct Dispatch
+{
+    detail::FindAny find_any;
+    std::string_view name;
+};
+
+auto resolve() -> Dispatch
+{
+    if (auto f = detail::find_any_avx2()) { return {f, "avx2"}; }
+    if (auto f = detail::find_any_sse42()) { return {f, "sse4.2"}; }
+    return {&detail::find_any_scalar, "scalar"};
+}
+
+Dispatch const dispatch = resolve();
+
+}  // namespace
+
+auto find_any(char const * p, char const * end, std::string_view set)
+        -> char const *
+{
+    return dispatch.find_any(p, end, set);
+}
+
+auto implementation() -> std::string_view
+{
+    return dispatch.name;
+}
+
+}  // namespace alewa::http::scan
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string_view>
+
+namespace alewa::http::scan {
+
+/* First byte in [p, end) that is one of `set` (at most 16 bytes), or end.
+ * Dispatches once, at startup, to the widest implementation the CPU
+ * supports. */
+auto find_any(char const * p, char const * end, std::string_view set)
+        -> char const *;
+
+/* Name of the implementation find_any dispatches to. */
+auto implementation() -> std::string_view;
+
+namespace detail {
+
+using FindAny = char const * (*)(char const *, char const *,
+                                 std::string_view);
+
+auto find_any_scalar(char const * p, char const * end, std::string_view set)
+        -> char const *;
+
+/* nullptr where the CPU or the build target lacks the instructions */
+auto find_any_sse42() -> FindAny;
+auto find_any_avx2() -> FindAny;
+
+}  // namespace alewa::http::scan::detail
+
+}  // namespace alewa::http::scan
@@ -0,0 +1 @@
+#include "instrumented_ioapi.hpp"
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <utility>
+
+#include "ioapi.hpp"
+#include "metrics.hpp"
+
+namespace alewa::io {
+
+/* Decorates any IoApi with the counters and per-call latency histograms of
+ * Metrics, and satisfies every concept T does, so a Server<Instrumented<T>>
+ * is measured without the rest of the code knowing. Only the calls on the
+ * event loop's hot path are wrapped; the others pass straight through to T.
+ * Nothing is compiled in unless this type is used.
+ *
+ * Sockets count towards accepts, bytes and active connections when they
+ * come from accept or accept4, so with the io_uring backend, which accepts
+ * and receives through the ring, only its waits and sends are seen. */
+template <IoApi T>
+class Instrumented : public T
+{
+private:
+    using Clock = std::chrono::steady_clock;
+
+    Metrics stats;
+
+public:
+    using typename T::SSize;
+    using typename T::Off;
+
+    Instrumented() = default;
+    explicit Instrumented(T api) : T(std::move(api)) {}
+
+    [[nodiscard]] auto metrics() const noexcept -> Metrics const &
+    {
+        return stats;
+    }
+
+    /* For a socket accepted on the calling thread and handed to another,
+     * which takes it over with adopted() if this returns true. */
+    auto released(int fd) const -> bool { return stats.local().released(fd); }
+
+    void adopted(int fd) const { stats.local().adopted(fd); }
+
+    auto poll(typename T::PollFd* fds, typename T::Nfds nfds, int timeout)
+            const -> int
+    {
+        Metrics::Local& local = stats.local();
+        int const n = timed(local, Syscall::POLL, [&] {
+            return T::poll(fds, nfds, timeout);
+        });
+        if (n != T::ERROR) { local.wakeup(n); }
+        return n;
+    }
+
+    template <EpollApi U = T>
+    auto epoll_wait(int epfd, typename U::EpollEvent* events, int maxevents,
+                    int timeout) const -> int
+    {
+        Metrics::Local& local = stats.local();
+        int const n = timed(local, Syscall::EPOLL_WAIT, [&] {
+            return U::epoll_wait(epfd, events, maxevents, timeout);
+        });
+        if (n != T::ERROR) { local.wakeup(n); }
+        return n;
+    }
+
+    template <EpollApi U = T>
+    auto epoll_ctl(int epfd, int op, int fd, typename U::EpollEvent* event)
+            const -> int
+    {
+        return timed(stats.local(), Syscall::EPOLL_CTL, [&] {
+            return U::epoll_ctl(epfd, op, fd, event);
+        });
+    }
+
+    /* Completions are not counted, only waits that may have blocked. */
+    template <UringApi U = T>
+    auto io_uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+                        unsigned flags, void* arg, std::size_t argsz) const
+            -> int
+    {
+        Metrics::Local& local = stats.local();
+        int const n = timed(local, Syscall::URING_ENTER, [&] {
+            return U::io_uring_enter(fd, to_submit, min_complete, flags, arg,
+                                     argsz);
+        });
+        if (min_complete > 0 && n != T::ERROR) { local.wakeup(-1); }
+        return n;
+    }
+
+    auto accept(int sockfd, typename T::SockAddr* addr,
+                typename T::SockLen* addrlen) const -> int
+    {
+        Metrics::Local& local = stats.local();
+        int const fd = timed(local, Syscall::ACCEPT, [&] {
+            return T::accept(sockfd, addr, addrlen);
+        });
+        if (fd != T::ERROR) { local.accepted(fd); }
+        return fd;
+    }
+
+    auto accept4(int sockfd, typename T::SockAddr* addr,
+                 typename T::SockLen* addrlen, int flags) const -> int
+    {
+        Metrics::Local& local = stats.local();
+        int const fd = timed(local, Syscall::ACCEPT, [&] {
+            return T::accept4(sockfd, addr, addrlen, flags);
+        });
+        if (fd != T::ERROR) { local.accepted(fd); }
+        return fd;
+    }
+
+    auto close(int fd) const -> int
+    {
+        Metrics::Local& local = stats.local();
+        int const ret = timed(local, Syscall::CLOSE, [&] {
+            return T::close(fd);
+        });
+        local.closed(fd);
+        return ret;
+    }
+
+    auto read(int fd, void* buf, std::size_t count) const -> SSize
+    {
+        Metrics::Local& local = stats.local();
+        SSize const n = timed(local, Syscall::READ, [&] {
+            return T::read(fd, buf, count);
+        });
+        local.received(fd, n);
+        return n;
+    }
+
+    auto readv(int fd, typename T::IoVec* iov, int iovcnt) const -> SSize
+    {
+        Metrics::Local& local = stats.local();
+        SSize const n = timed(local, Syscall::READ, [&] {
+            return T::readv(fd, iov, iovcnt);
+        });
+        local.received(fd, n);
+        return n;
+    }
+
+    auto write(int fd, void const * buf, std::size_t count) const -> SSize
+    {
+        Metrics::Local& local = stats.local();
+        SSize const n = timed(local, Syscall::WRITE, [&] {
+            return T::write(fd, buf, count);
+        });
+        local.sent(fd, n);
+        return n;
+    }
+
+    auto writev(int fd, typename T::IoVec const * iov, int iovcnt) const
+            -> SSize
+    {
+        Metrics::Local& local = stats.local();
+        SSize const n = timed(local, Syscall::WRITE, [&] {
+            return T::writev(fd, iov, iovcnt);
+        });
+        local.sent(fd, n);
+        return n;
+    }
+
+    auto sendmsg(int fd, typename T::MsgHdr const * msg, int flags) const
+            -> SSize
+    {
+        Metrics::Local& local = stats.local();
+        SSize const n = timed(local, Syscall::WRITE, [&] {
+            return T::sendmsg(fd, msg, flags);
+        });
+        local.sent(fd, n);
+        return n;
+    }
+
+    auto sendfile(int out_fd, int in_fd, Off* offset, std::size_t count) const
+            -> SSize
+    {
+        Metrics::Local& local = stats.local();
+        SSize const n = timed(local, Syscall::SENDFILE, [&] {
+            return T::sendfile(out_fd, in_fd, offset, count);
+        });
+        local.sent(out_fd, n);
+        return n;
+    }
+
+    auto open(char const * path, int flags) const -> int
+    {
+        return timed(stats.local(), Syscall::OPEN, [&] {
+            return T::open(path, flags);
+        });
+    }
+
+    auto fstat(int fd, typename T::Stat* statbuf) const -> int
+    {
+        return timed(stats.local(), Syscall::STAT, [&] {
+            return T::fstat(fd, statbuf);
+        });
+    }
+
+    auto stat(char const * path, typename T::Stat* statbuf) const -> int
+    {
+        return timed(stats.local(), Syscall::STAT, [&] {
+            return T::stat(path, statbuf);
+        });
+    }
+
+    auto pread(int fd, void* buf, std::size_t count, Off offset) const
+            -> SSize
+    {
+        return timed(stats.local(), Syscall::PREAD, [&] {
+            return T::pread(fd, buf, count, offset);
+        });
+    }
+
+private:
+    template <typename F>
+    static auto timed(Metrics::Local& local, Syscall call, F&& f)
+    {
+        auto const start = Clock::now();
+        auto const ret = f();
+        auto const ns = std::chrono::nanoseconds{Clock::now() - start};
+        local.timed(call, static_cast<std::uint64_t>(ns.count()),
+                    ret == T::ERROR);
+        return ret;
+    }
+};
+
+}  // namespace alewa::io
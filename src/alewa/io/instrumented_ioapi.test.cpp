@@ -0,0 +1,100 @@
+#include "test/test_utils.hpp"
+
+#include <thread>
+
+#include "io/instrumented_ioapi.hpp"
+#include "io/ioapi_sys.hpp"
+#include "io/sockapi_mock.hpp"
+#include "reactor.hpp"
+
+namespace alewa::test {
+
+using io::Instrumented;
+using io::test::MockEpollIoApi;
+
+static_assert(io::IoApi<Instrumented<io::SysIoApi>>);
+static_assert(!io::EpollApi<Instrumented<io::SysIoApi>>);
+static_assert(io::EpollApi<Instrumented<io::EpollIoApi>>);
+static_assert(!io::UringApi<Instrumented<io::EpollIoApi>>);
+static_assert(io::UringApi<Instrumented<io::IoUringIoApi>>);
+
+namespace {
+
+auto calls(MetricsSnapshot const & s, Syscall call)
+        -> MetricsSnapshot::Calls const &
+{
+    return s.syscalls[static_cast<std::size_t>(call)];
+}
+
+}  // namespace
+
+ALW_TEST(instrumented_ioapi_counts_reactor_traffic)
+{
+    int const LISTENER_FD = MockEpollIoApi::SUCCESS;
+    int const CLIENT_FD = 7;
+
+    Instrumented<MockEpollIoApi> api;
+    MockEpollIoApi::SockAddr addr{};
+    api.ai.ai_addr = &addr;
+    ServerConfig config;
+    Listeners<Instrumented<MockEpollIoApi>> listeners;
+    listeners.main.emplace(create_listener(api, "8080", false));
+    listeners.main->listen(10);
+    Reactor<Instrumented<MockEpollIoApi>> reactor{api, config,
+                                                  std::move(listeners)};
+
+    api.backlog.push_back(CLIENT_FD);
+    api.ready[LISTENER_FD] = io::EV_IN;
+    reactor.run_once();
+    api.ready.erase(LISTENER_FD);
+
+    std::string const request = "GET /missing HTTP/1.1\r\n\r\n";
+    api.inbox[CLIENT_FD] = request;
+    api.ready[CLIENT_FD] = io::EV_IN;
+    reactor.run_once();
+
+    auto s = api.metrics().scrape();
+    ALW_EXPECT_EQ(s.wakeups, 2ul);
+    ALW_EXPECT_EQ(s.ready, 2ul);
+    ALW_EXPECT_EQ(s.ready_per_wakeup.quantile(1.0), 1ul);
+    ALW_EXPECT_EQ(s.accepts, 1ul);
+    ALW_EXPECT_EQ(s.accepts_per_batch.count(), 1ul);  /* closed by 2nd */
+    ALW_EXPECT_EQ(s.active(), 1ul);
+    ALW_EXPECT_EQ(s.bytes_in, request.size());
+    ALW_EXPECT_EQ(s.bytes_out, api.writes[CLIENT_FD][0].size());
+    ALW_EXPECT_EQ(calls(s, Syscall::EPOLL_WAIT).calls, 2ul);
+    ALW_EXPECT_EQ(calls(s, Syscall::EPOLL_WAIT).latency.count(), 2ul);
+    ALW_EXPECT_EQ(calls(s, Syscall::ACCEPT).calls, 2ul);  /* then EAGAIN */
+    ALW_EXPECT_EQ(calls(s, Syscall::ACCEPT).errors, 1ul);
+    ALW_EXPECT_EQ(calls(s, Syscall::WRITE).calls, 1ul);
+
+    api.inbox[CLIENT_FD] = "GET / HTTP/1.1\r\nConnection: close\r\n\r\n";
+    reactor.run_once();
+    s = api.metrics().scrape();
+    ALW_EXPECT_EQ(s.closes, 1ul);
+    ALW_EXPECT_EQ(s.active(), 0ul);
+}
+
+ALW_TEST(instrumented_ioapi_sums_threads_on_scrape)
+{
+    Instrumented<MockEpollIoApi> api;
+    auto work = [&api] {
+        for (int i = 0; i < 1000; ++i) {
+            MockEpollIoApi::PollFd fd{};
+            api.poll(&fd, 1, 0);
+        }
+    };
+    std::thread a{work};
+    std::thread b{work};
+    work();
+    a.join();
+    b.join();
+
+    auto const s = api.metrics().scrape();
+    ALW_EXPECT_EQ(s.wakeups, 3000ul);
+    ALW_EXPECT_EQ(calls(s, Syscall::POLL).calls, 3000ul);
+    ALW_EXPECT_EQ(calls(s, Syscall::POLL).latency.count(), 3000ul);
+    ALW_EXPECT_EQ(calls(s, Syscall::READ).calls, 0ul);
+}
+
+}  // namespace alewa::test
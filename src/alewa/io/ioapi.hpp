@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <concepts>
 #include <string>
 
@@ -12,6 +13,7 @@ concept ErrorDescription = requires(T t)
     { T::SUCCESS } -> std::same_as<int const &>;
 
     { t.error() } -> std::same_as<std::string>;
+    { t.errnum() } -> std::same_as<int>;
 };
 
 template <typename T>
@@ -23,6 +25,9 @@ concept SocketApi = requires(T t)
     typename T::AiDeleter;
     typename T::SockAddr;
     typename T::SockLen;
+    typename T::SSize;
+    typename T::IoVec;
+    typename T::MsgHdr;
 
     requires requires(char const * node, char const * service,
                       typename T::AddrInfo const * hints,
@@ -54,6 +59,13 @@ concept SocketApi = requires(T t)
         { t.accept(sockfd, recv_addr, recv_addrlen) } -> std::same_as<int>;
     };
 
+    requires requires(int sockfd, typename T::SockAddr* recv_addr,
+                      typename T::SockLen* recv_addrlen, int flags)
+    {
+        { t.accept4(sockfd, recv_addr, recv_addrlen, flags) }
+                -> std::same_as<int>;
+    };
+
     requires requires(int sockfd, int level, int optname, void const * optval,
                       typename T::SockLen optlen, int cmd, int arg)
     {
@@ -62,12 +74,51 @@ concept SocketApi = requires(T t)
         { t.fcntl(sockfd, cmd, arg) } -> std::same_as<int>;
     };
 
+    requires requires(int fd, typename T::IoVec* iov,
+                      typename T::IoVec const * ciov, int iovcnt,
+                      typename T::MsgHdr const * msg,
+                      typename T::MsgHdr* recv_msg, int flags)
+    {
+        { t.readv(fd, iov, iovcnt) } -> std::same_as<typename T::SSize>;
+        { t.writev(fd, ciov, iovcnt) } -> std::same_as<typename T::SSize>;
+        { t.sendmsg(fd, msg, flags) } -> std::same_as<typename T::SSize>;
+        { t.recvmsg(fd, recv_msg, flags) }
+                -> std::same_as<typename T::SSize>;
+    };
+};
+
+/* Regular files: enough to open, validate and sendfile them to a socket,
+ * and to find and unlink a Unix socket's path before binding it. */
+template <typename T>
+concept FileApi = requires(T t)
+{
+    requires ErrorDescription<T>;
+
+    typename T::Stat;
+    typename T::Off;
+    typename T::SSize;
+
+    requires requires(char const * path, int flags, int fd, int out_fd,
+                      typename T::Stat* statbuf, typename T::Off* offset,
+                      std::size_t count, void* buf, typename T::Off at)
+    {
+        { t.open(path, flags) } -> std::same_as<int>;
+        { t.close(fd) } -> std::same_as<int>;
+        { t.fstat(fd, statbuf) } -> std::same_as<int>;
+        { t.stat(path, statbuf) } -> std::same_as<int>;
+        { t.lstat(path, statbuf) } -> std::same_as<int>;
+        { t.sendfile(out_fd, fd, offset, count) }
+                -> std::same_as<typename T::SSize>;
+        { t.pread(fd, buf, count, at) } -> std::same_as<typename T::SSize>;
+        { t.unlink(path) } -> std::same_as<int>;
+    };
 };
 
 template <typename T>
 concept IoApi = requires(T t)
 {
     requires SocketApi<T>;
+    requires FileApi<T>;
 
     typename T::PollFd;
     typename T::Nfds;
@@ -77,6 +128,75 @@ concept IoApi = requires(T t)
     {
         { t.poll(fds, nfds, timeout) } -> std::same_as<int>;
     };
+
+    requires requires (unsigned initval, int flags, int fd, void* buf,
+                       void const * cbuf, std::size_t count)
+    {
+        { t.eventfd(initval, flags) } -> std::same_as<int>;
+        { t.read(fd, buf, count) } -> std::same_as<typename T::SSize>;
+        { t.write(fd, cbuf, count) } -> std::same_as<typename T::SSize>;
+    };
+};
+
+/* Refinement for backends that keep the interest set in the kernel, so fds are
+ * registered once and each wait only returns the ready ones. */
+template <typename T>
+concept EpollApi = IoApi<T> && requires(T t)
+{
+    typename T::EpollEvent;
+
+    requires requires(int flags, int epfd, int op, int fd,
+                      typename T::EpollEvent* event, int maxevents,
+                      int timeout)
+    {
+        { t.epoll_create1(flags) } -> std::same_as<int>;
+        { t.epoll_ctl(epfd, op, fd, event) } -> std::same_as<int>;
+        { t.epoll_wait(epfd, event, maxevents, timeout) }
+                -> std::same_as<int>;
+    };
+};
+
+/* Refinement for backends that also offer io_uring, where the kernel performs
+ * queued operations and reports their completions. Refines EpollApi so that
+ * a kernel without io_uring can still be served through readiness. */
+template <typename T>
+concept UringApi = EpollApi<T> && requires(T t)
+{
+    typename T::UringParams;
+
+    requires requires(unsigned entries, typename T::UringParams* params,
+                      int fd, unsigned to_submit, unsigned min_complete,
+                      unsigned flags, void* arg, std::size_t argsz,
+                      unsigned opcode, unsigned nr_args)
+    {
+        { t.io_uring_setup(entries, params) } -> std::same_as<int>;
+        { t.io_uring_enter(fd, to_submit, min_complete, flags, arg, argsz) }
+                -> std::same_as<int>;
+        { t.io_uring_register(fd, opcode, arg, nr_args) }
+                -> std::same_as<int>;
+    };
+
+    requires requires(void* addr, std::size_t length, int prot, int flags,
+                      int fd, typename T::Off offset)
+    {
+        { t.mmap(addr, length, prot, flags, fd, offset) }
+                -> std::same_as<void*>;
+        { t.munmap(addr, length) } -> std::same_as<int>;
+    };
+};
+
+/* Refinement for backends whose sockets are the kernel's, which a TLS
+ * library can do its own I/O on, and which can relay between a connection
+ * and a socketpair for what the kernel does not encrypt itself. */
+template <typename T>
+concept TlsApi = IoApi<T> && requires(T t)
+{
+    requires requires(int domain, int type, int protocol, int* sv,
+                      int sockfd, int how)
+    {
+        { t.socketpair(domain, type, protocol, sv) } -> std::same_as<int>;
+        { t.shutdown(sockfd, how) } -> std::same_as<int>;
+    };
 };
 
 }  // namespace alewa::io
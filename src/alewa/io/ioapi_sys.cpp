@@ -1,5 +1,6 @@
 #include "ioapi_sys.hpp"
 
+#include <cerrno>
 #include <cstring>
 
 namespace alewa::io {
@@ -9,4 +10,9 @@ namespace alewa::io {
         return ::strerror(errno);
     }
 
+    int SysErrorDescription::errnum() const
+    {
+        return errno;
+    }
+
 }  // namespace alewa::io
@@ -4,6 +4,14 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <poll.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include <sys/stat.h>
+#include <sys/sendfile.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <string>
 
 namespace alewa::io {
@@ -14,6 +22,7 @@ struct SysErrorDescription
     static int const SUCCESS = 0;
 
     [[nodiscard]] std::string error() const;
+    [[nodiscard]] int errnum() const;
 };
 
 struct SysSocketApi : public SysErrorDescription
@@ -22,6 +31,9 @@ struct SysSocketApi : public SysErrorDescription
     using AiDeleter = decltype(&::freeaddrinfo);
     using SockAddr = ::sockaddr;
     using SockLen = ::socklen_t;
+    using SSize = ::ssize_t;
+    using IoVec = ::iovec;
+    using MsgHdr = ::msghdr;
 
     [[nodiscard]]
     auto getaddrinfo(char const * node, char const * service,
@@ -46,6 +58,17 @@ struct SysSocketApi : public SysErrorDescription
 
     auto close(int sockfd) const -> int { return ::close(sockfd); }
 
+    [[nodiscard]]
+    auto socketpair(int domain, int type, int protocol, int* sv) const -> int
+    {
+        return ::socketpair(domain, type, protocol, sv);
+    }
+
+    auto shutdown(int sockfd, int how) const -> int
+    {
+        return ::shutdown(sockfd, how);
+    }
+
     [[nodiscard]]
     auto bind(int sockfd, SockAddr const * addr, SockLen addrlen) const -> int
     {
@@ -73,6 +96,13 @@ struct SysSocketApi : public SysErrorDescription
         return ::accept(sockfd, recv_addr, recv_addrlen);
     }
 
+    [[nodiscard]]
+    auto accept4(int sockfd, SockAddr* recv_addr, SockLen* recv_addrlen,
+                 int flags) const -> int
+    {
+        return ::accept4(sockfd, recv_addr, recv_addrlen, flags);
+    }
+
     [[nodiscard]]
     auto setsockopt(int sockfd, int level, int optname, void const * optval,
                     SockLen optlen) const -> int
@@ -85,18 +115,158 @@ struct SysSocketApi : public SysErrorDescription
     {
         return ::fcntl(sockfd, cmd, arg);
     }
+
+    auto readv(int fd, IoVec* iov, int iovcnt) const -> SSize
+    {
+        return ::readv(fd, iov, iovcnt);
+    }
+
+    auto writev(int fd, IoVec const * iov, int iovcnt) const -> SSize
+    {
+        return ::writev(fd, iov, iovcnt);
+    }
+
+    auto sendmsg(int sockfd, MsgHdr const * msg, int flags) const -> SSize
+    {
+        return ::sendmsg(sockfd, msg, flags);
+    }
+
+    auto recvmsg(int sockfd, MsgHdr* msg, int flags) const -> SSize
+    {
+        return ::recvmsg(sockfd, msg, flags);
+    }
 };
 
 struct SysIoApi : public io::SysSocketApi
 {
     using PollFd = ::pollfd;
     using Nfds = ::nfds_t;
+    using Stat = struct ::stat;
+    using Off = ::off_t;
 
     [[nodiscard]]
     auto poll(PollFd* fds, Nfds nfds, int timeout) const -> int
     {
         return ::poll(fds, nfds, timeout);
     }
+
+    [[nodiscard]]
+    auto eventfd(unsigned initval, int flags) const -> int
+    {
+        return ::eventfd(initval, flags);
+    }
+
+    auto read(int fd, void* buf, std::size_t count) const -> SSize
+    {
+        return ::read(fd, buf, count);
+    }
+
+    auto write(int fd, void const * buf, std::size_t count) const -> SSize
+    {
+        return ::write(fd, buf, count);
+    }
+
+    [[nodiscard]]
+    auto open(char const * path, int flags) const -> int
+    {
+        return ::open(path, flags);
+    }
+
+    [[nodiscard]]
+    auto fstat(int fd, Stat* statbuf) const -> int
+    {
+        return ::fstat(fd, statbuf);
+    }
+
+    [[nodiscard]]
+    auto stat(char const * path, Stat* statbuf) const -> int
+    {
+        return ::stat(path, statbuf);
+    }
+
+    [[nodiscard]]
+    auto lstat(char const * path, Stat* statbuf) const -> int
+    {
+        return ::lstat(path, statbuf);
+    }
+
+    auto sendfile(int out_fd, int in_fd, Off* offset, std::size_t count) const
+            -> SSize
+    {
+        return ::sendfile(out_fd, in_fd, offset, count);
+    }
+
+    auto pread(int fd, void* buf, std::size_t count, Off offset) const
+            -> SSize
+    {
+        return ::pread(fd, buf, count, offset);
+    }
+
+    auto unlink(char const * path) const -> int { return ::unlink(path); }
+};
+
+struct EpollIoApi : public io::SysIoApi
+{
+    using EpollEvent = ::epoll_event;
+
+    [[nodiscard]]
+    auto epoll_create1(int flags) const -> int
+    {
+        return ::epoll_create1(flags);
+    }
+
+    [[nodiscard]]
+    auto epoll_ctl(int epfd, int op, int fd, EpollEvent* event) const -> int
+    {
+        return ::epoll_ctl(epfd, op, fd, event);
+    }
+
+    [[nodiscard]]
+    auto epoll_wait(int epfd, EpollEvent* events, int maxevents,
+                    int timeout) const -> int
+    {
+        return ::epoll_wait(epfd, events, maxevents, timeout);
+    }
+};
+
+/* glibc has no wrappers for the io_uring system calls. */
+struct IoUringIoApi : public io::EpollIoApi
+{
+    using UringParams = ::io_uring_params;
+
+    [[nodiscard]]
+    auto io_uring_setup(unsigned entries, UringParams* params) const -> int
+    {
+        return static_cast<int>(::syscall(SYS_io_uring_setup, entries,
+                                          params));
+    }
+
+    auto io_uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+                        unsigned flags, void* arg, std::size_t argsz) const
+            -> int
+    {
+        return static_cast<int>(::syscall(SYS_io_uring_enter, fd, to_submit,
+                                          min_complete, flags, arg, argsz));
+    }
+
+    auto io_uring_register(int fd, unsigned opcode, void* arg,
+                           unsigned nr_args) const -> int
+    {
+        return static_cast<int>(::syscall(SYS_io_uring_register, fd, opcode,
+                                          arg, nr_args));
+    }
+
+    [[nodiscard]]
+    auto mmap(void* addr, std::size_t length, int prot, int flags, int fd,
+              Off offset) const -> void*
+    {
+        return ::mmap(addr, length, prot, flags, fd, offset);
+    }
+
+    auto munmap(void* addr, std::size_t length) const -> int
+    {
+        return ::munmap(addr, length);
+    }
 };
 
 }  // namespace alewa::io
\ No newline at end of file
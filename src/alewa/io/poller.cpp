@@ -0,0 +1 @@
+#include "poller.hpp"
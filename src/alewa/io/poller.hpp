@@ -0,0 +1,266 @@
+#pragma once
+
+#include <span>
+#include <cerrno>
+#include <vector>
+#include <stdexcept>
+
+#include "ioapi.hpp"
+#include "result.hpp"
+
+namespace alewa::io {
+
+namespace detail {
+/* See reactor.hpp: only the macros and enum constants are wanted here. */
+#include <poll.h>
+#include <sys/epoll.h>
+
+static unsigned const EPOLL_EDGE = EPOLLET;
+static int const EPOLL_CLOEXEC_FLAG = EPOLL_CLOEXEC;
+}  // namespace alewa::io::detail
+
+/* Interest and readiness flags. epoll reuses the poll bit values for these on
+ * Linux, so both backends share them unchanged. */
+static unsigned const EV_IN = POLLIN;
+static unsigned const EV_OUT = POLLOUT;
+static unsigned const EV_ERR = POLLERR;
+static unsigned const EV_HUP = POLLHUP;
+static unsigned const EV_EDGE = detail::EPOLL_EDGE;
+
+struct Event
+{
+    int fd;
+    unsigned events;
+};
+
+/* Level-triggered readiness over poll(2). The whole interest set is handed to
+ * the kernel on every wait; EpollApi backends get the specialization below.
+ * pollfds is kept dense with swap-remove, and slots maps an fd to its index so
+ * modify and remove are O(1). */
+template <IoApi T>
+class Poller
+{
+private:
+    using PollFd = typename T::PollFd;
+
+    static int const NO_SLOT = -1;
+
+    T const & api;
+    std::vector<PollFd> pollfds;
+    std::vector<int> slots;
+    std::vector<Event> ready;
+
+public:
+    explicit Poller(T const & api, int max_events = 256) : api(api)
+    {
+        ready.reserve(static_cast<std::size_t>(max_events));
+    }
+
+    void add(int fd, unsigned events);
+    void modify(int fd, unsigned events);
+    void remove(int fd);
+
+    /* As the above, reporting errors instead of throwing: EINVAL for an
+     * edge-triggered registration, EEXIST and ENOENT as epoll would. */
+    auto try_add(int fd, unsigned events) -> Result<>;
+    auto try_modify(int fd, unsigned events) -> Result<>;
+    auto try_remove(int fd) -> Result<>;
+
+    /* An interrupted wait (EINTR) reports no events. */
+    auto wait(int timeout) -> std::span<Event const>;
+
+private:
+    auto slot(int fd) const -> int
+    {
+        auto const i = static_cast<std::size_t>(fd);
+        return (i < slots.size()) ? slots[i] : NO_SLOT;
+    }
+};
+
+template <IoApi T>
+void Poller<T>::add(int fd, unsigned events)
+{
+    if (events & EV_EDGE) {
+        throw std::runtime_error{"poll backend is level-triggered only"};
+    }
+    if (!try_add(fd, events)) {
+        throw std::runtime_error{"poll: socket " + std::to_string(fd)
+                                 + " already registered"};
+    }
+}
+
+template <IoApi T>
+void Poller<T>::modify(int fd, unsigned events)
+{
+    (void) try_modify(fd, events);
+}
+
+template <IoApi T>
+void Poller<T>::remove(int fd)
+{
+    (void) try_remove(fd);
+}
+
+template <IoApi T>
+auto Poller<T>::try_add(int fd, unsigned events) -> Result<>
+{
+    if (events & EV_EDGE) { return Result<>::failure(EINVAL); }
+    if (slot(fd) != NO_SLOT) { return Result<>::failure(EEXIST); }
+    auto const i = static_cast<std::size_t>(fd);
+    if (i >= slots.size()) { slots.resize(i + 1, NO_SLOT); }
+    slots[i] = static_cast<int>(pollfds.size());
+    pollfds.push_back({fd, static_cast<short>(events), 0});
+    return {};
+}
+
+template <IoApi T>
+auto Poller<T>::try_modify(int fd, unsigned events) -> Result<>
+{
+    int const s = slot(fd);
+    if (s == NO_SLOT) { return Result<>::failure(ENOENT); }
+    pollfds[static_cast<std::size_t>(s)].events = static_cast<short>(events);
+    return {};
+}
+
+template <IoApi T>
+auto Poller<T>::try_remove(int fd) -> Result<>
+{
+    int const s = slot(fd);
+    if (s == NO_SLOT) { return Result<>::failure(ENOENT); }
+
+    PollFd const & last = pollfds.back();
+    pollfds[static_cast<std::size_t>(s)] = last;
+    slots[static_cast<std::size_t>(last.fd)] = s;
+    pollfds.pop_back();
+    slots[static_cast<std::size_t>(fd)] = NO_SLOT;
+    return {};
+}
+
+template <IoApi T>
+auto Poller<T>::wait(int timeout) -> std::span<Event const>
+{
+    ready.clear();
+    int const ret = api.poll(pollfds.data(), pollfds.size(), timeout);
+    if (ret == T::ERROR && api.errnum() == EINTR) { return ready; }
+    if (ret == T::ERROR) {
+        throw std::runtime_error{"poll failed: " + api.error()};
+    }
+
+    int nready = ret;
+    for (auto it = pollfds.begin(); nready > 0 && it != pollfds.end(); ++it) {
+        if (it->revents == 0) { continue; }
+        ready.push_back({it->fd, static_cast<unsigned short>(it->revents)});
+        --nready;
+    }
+    return ready;
+}
+
+/* Kernel-side interest set: an fd is registered once and each wait only costs
+ * as much as the number of fds that are actually ready. Registrations may
+ * include EV_EDGE to request edge-triggered notification. */
+template <EpollApi T>
+class Poller<T>
+{
+private:
+    using EpollEvent = typename T::EpollEvent;
+
+    static int const CTL_ADD = EPOLL_CTL_ADD;
+    static int const CTL_MOD = EPOLL_CTL_MOD;
+    static int const CTL_DEL = EPOLL_CTL_DEL;
+
+    T const & api;
+    int epfd;
+    std::vector<EpollEvent> events;
+    std::vector<Event> ready;
+
+public:
+    explicit Poller(T const & api, int max_events = 256);
+    ~Poller();
+
+    Poller(Poller&) = delete;
+    Poller& operator=(Poller&) = delete;
+
+    void add(int fd, unsigned interest) { control(CTL_ADD, fd, interest); }
+    void modify(int fd, unsigned interest) { control(CTL_MOD, fd, interest); }
+    void remove(int fd) { control(CTL_DEL, fd, 0); }
+
+    /* As the above, reporting epoll_ctl's errno instead of throwing. */
+    auto try_add(int fd, unsigned interest) -> Result<>
+    {
+        return try_control(CTL_ADD, fd, interest);
+    }
+    auto try_modify(int fd, unsigned interest) -> Result<>
+    {
+        return try_control(CTL_MOD, fd, interest);
+    }
+    auto try_remove(int fd) -> Result<> { return try_control(CTL_DEL, fd, 0); }
+
+    /* The epoll instance, itself readable while any fd in it is ready. */
+    [[nodiscard]]
+    auto fd() const noexcept -> int { return epfd; }
+
+    /* An interrupted wait (EINTR) reports no events. */
+    auto wait(int timeout) -> std::span<Event const>;
+
+private:
+    void control(int op, int fd, unsigned interest);
+    auto try_control(int op, int fd, unsigned interest) -> Result<>;
+};
+
+template <EpollApi T>
+Poller<T>::Poller(T const & api, int max_events)
+        : api(api), epfd(api.epoll_create1(detail::EPOLL_CLOEXEC_FLAG)),
+          events(static_cast<std::size_t>(max_events))
+{
+    if (epfd == T::ERROR) {
+        throw std::runtime_error{"epoll_create1 failed: " + api.error()};
+    }
+    ready.reserve(events.size());
+}
+
+template <EpollApi T>
+Poller<T>::~Poller()
+{
+    api.close(epfd);
+}
+
+template <EpollApi T>
+void Poller<T>::control(int op, int fd, unsigned interest)
+{
+    if (!try_control(op, fd, interest)) {
+        throw std::runtime_error{"epoll_ctl on socket " + std::to_string(fd)
+                                 + ": " + api.error()};
+    }
+}
+
+template <EpollApi T>
+auto Poller<T>::try_control(int op, int fd, unsigned interest) -> Result<>
+{
+    EpollEvent ev{};
+    ev.events = interest;
+    ev.data.fd = fd;
+    if (T::ERROR == api.epoll_ctl(epfd, op, fd, &ev)) {
+        return Result<>::failure(api.errnum());
+    }
+    return {};
+}
+
+template <EpollApi T>
+auto Poller<T>::wait(int timeout) -> std::span<Event const>
+{
+    ready.clear();
+    int const ret = api.epoll_wait(epfd, events.data(),
+                                   static_cast<int>(events.size()), timeout);
+    if (ret == T::ERROR && api.errnum() == EINTR) { return ready; }
+    if (ret == T::ERROR) {
+        throw std::runtime_error{"epoll_wait failed: " + api.error()};
+    }
+
+    for (int i = 0; i < ret; ++i) {
+        auto const & ev = events[static_cast<std::size_t>(i)];
+        ready.push_back({ev.data.fd, ev.events});
+    }
+    return ready;
+}
+
+}  // namespace alewa::io
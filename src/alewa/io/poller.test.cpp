@@ -0,0 +1,201 @@
+#include "test/test_utils.hpp"
+
+#include <algorithm>
+
+#include "poller.hpp"
+#include "sockapi_mock.hpp"
+
+namespace alewa::io::test {
+
+ALW_TEST(poller_poll_reports_ready_fds)
+{
+    MockIoApi api;
+    Poller<MockIoApi> poller{api};
+    poller.add(3, EV_IN);
+    poller.add(4, EV_IN);
+    poller.add(5, EV_IN | EV_OUT);
+
+    api.ready[4] = EV_IN;
+    api.ready[5] = EV_OUT;
+    api.ready[6] = EV_IN;  /* not registered */
+
+    auto ready = poller.wait(7);
+    ALW_EXPECT_EQ(api.last_timeout, 7);
+    ALW_EXPECT_EQ(ready.size(), 2ul);
+    ALW_EXPECT_EQ(ready[0].fd, 4);
+    ALW_EXPECT_EQ(ready[0].events, EV_IN);
+    ALW_EXPECT_EQ(ready[1].fd, 5);
+    ALW_EXPECT_EQ(ready[1].events, EV_OUT);
+}
+
+ALW_TEST(poller_poll_modify_remove)
+{
+    MockIoApi api;
+    Poller<MockIoApi> poller{api};
+    poller.add(3, EV_IN);
+    poller.add(4, EV_IN);
+    api.ready[3] = EV_OUT;
+    api.ready[4] = EV_IN;
+
+    poller.modify(3, EV_OUT);
+    poller.remove(4);
+
+    auto ready = poller.wait(0);
+    ALW_EXPECT_EQ(ready.size(), 1ul);
+    ALW_EXPECT_EQ(ready[0].fd, 3);
+    ALW_EXPECT_EQ(ready[0].events, EV_OUT);
+}
+
+ALW_TEST(poller_try_variants_report_errno)
+{
+    MockIoApi api;
+    Poller<MockIoApi> poller{api};
+    ALW_EXPECT_EQ(static_cast<bool>(poller.try_add(3, EV_IN)), true);
+    ALW_EXPECT_EQ(poller.try_add(3, EV_IN).error(), EEXIST);
+    ALW_EXPECT_EQ(poller.try_add(4, EV_IN | EV_EDGE).error(), EINVAL);
+    ALW_EXPECT_EQ(poller.try_modify(4, EV_OUT).error(), ENOENT);
+    ALW_EXPECT_EQ(static_cast<bool>(poller.try_remove(3)), true);
+    ALW_EXPECT_EQ(poller.try_remove(3).error(), ENOENT);
+
+    MockEpollIoApi epoll_api;
+    Poller<MockEpollIoApi> epoller{epoll_api};
+    ALW_EXPECT_EQ(static_cast<bool>(epoller.try_add(3, EV_IN)), true);
+    ALW_EXPECT_EQ(epoller.try_add(3, EV_IN).error(), EEXIST);
+    ALW_EXPECT_EQ(epoller.try_modify(4, EV_OUT).error(), ENOENT);
+}
+
+ALW_TEST(poller_poll_swap_remove)
+{
+    MockIoApi api;
+    Poller<MockIoApi> poller{api};
+    for (int fd = 3; fd < 9; ++fd) {
+        poller.add(fd, EV_IN);
+        api.ready[fd] = EV_IN;
+    }
+    poller.remove(3);
+    poller.remove(6);
+    poller.remove(8);
+    poller.modify(4, EV_OUT);  /* moved slots are still tracked */
+    poller.add(3, EV_IN);
+
+    auto ready = poller.wait(0);
+    std::vector<int> fds;
+    for (Event const & event : ready) { fds.push_back(event.fd); }
+    std::sort(fds.begin(), fds.end());
+    ALW_EXPECT_EQ(fds == (std::vector<int>{3, 5, 7}), true);
+}
+
+ALW_TEST(poller_poll_errors)
+{
+    MockIoApi api;
+    Poller<MockIoApi> poller{api};
+
+    std::string error{};
+    try {
+        poller.add(3, EV_IN | EV_EDGE);
+    }
+    catch (std::runtime_error const & e) {
+        error = e.what();
+    }
+    ALW_EXPECT_EQ(error, "poll backend is level-triggered only");
+
+    error.clear();
+    try {
+        api.ret_code = MockIoApi::ERROR;
+        poller.wait(0);
+    }
+    catch (std::runtime_error const & e) {
+        error = e.what();
+    }
+    ALW_EXPECT_EQ(error, "poll failed: " + api.error());
+}
+
+ALW_TEST(poller_epoll_reports_ready_fds)
+{
+    MockEpollIoApi api;
+    Poller<MockEpollIoApi> poller{api};
+    poller.add(3, EV_IN);
+    poller.add(4, EV_OUT);
+    ALW_EXPECT_EQ(api.interest().size(), 2ul);
+
+    api.ready[3] = EV_IN;
+    api.ready[4] = EV_IN;  /* not interested */
+    api.ready[9] = EV_IN;  /* not registered */
+
+    auto ready = poller.wait(-1);
+    ALW_EXPECT_EQ(api.last_timeout, -1);
+    ALW_EXPECT_EQ(ready.size(), 1ul);
+    ALW_EXPECT_EQ(ready[0].fd, 3);
+
+    poller.modify(4, EV_IN);
+    poller.remove(3);
+    ready = poller.wait(0);
+    ALW_EXPECT_EQ(ready.size(), 1ul);
+    ALW_EXPECT_EQ(ready[0].fd, 4);
+}
+
+ALW_TEST(poller_epoll_edge_triggered)
+{
+    MockEpollIoApi api;
+    Poller<MockEpollIoApi> poller{api};
+    poller.add(3, EV_IN | EV_EDGE);
+    poller.add(4, EV_IN);
+    api.ready[3] = EV_IN;
+    api.ready[4] = EV_IN;
+
+    ALW_EXPECT_EQ(poller.wait(0).size(), 2ul);
+
+    /* the edge has been reported, only the level-triggered fd remains */
+    auto ready = poller.wait(0);
+    ALW_EXPECT_EQ(ready.size(), 1ul);
+    ALW_EXPECT_EQ(ready[0].fd, 4);
+}
+
+ALW_TEST(poller_epoll_max_events)
+{
+    MockEpollIoApi api;
+    Poller<MockEpollIoApi> poller{api, 2};
+    for (int fd = 3; fd < 8; ++fd) {
+        poller.add(fd, EV_IN);
+        api.ready[fd] = EV_IN;
+    }
+    ALW_EXPECT_EQ(poller.wait(0).size(), 2ul);
+}
+
+ALW_TEST(poller_interrupted_wait_is_empty)
+{
+    MockEpollIoApi api;
+    Poller<MockEpollIoApi> epoller{api};
+    Poller<MockIoApi> poller{api};
+    api.ret_code = MockEpollIoApi::ERROR;
+    api.errorno = EINTR;
+    ALW_EXPECT_EQ(epoller.wait(-1).size(), 0ul);
+    ALW_EXPECT_EQ(poller.wait(-1).size(), 0ul);
+}
+
+ALW_TEST(poller_epoll_errors)
+{
+    MockEpollIoApi api;
+    std::string error{};
+    try {
+        Poller<MockEpollIoApi> poller{api};
+        poller.add(3, EV_IN);
+        poller.add(3, EV_IN);
+    }
+    catch (std::runtime_error const & e) {
+        error = e.what();
+    }
+    ALW_EXPECT_EQ(error, "epoll_ctl on socket 3: " + api.error());
+
+    error.clear();
+    try {
+        api.ret_code = MockEpollIoApi::ERROR;
+        Poller<MockEpollIoApi> poller{api};
+    }
+    catch (std::runtime_error const & e) {
+        error = e.what();
+    }
+    ALW_EXPECT_EQ(error, "epoll_create1 failed: " + api.error());
+}
+
+}  // namespace alewa::io::test
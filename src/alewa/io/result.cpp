@@ -0,0 +1 @@
+#include "result.hpp"
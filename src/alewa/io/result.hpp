@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cerrno>
+#include <cassert>
+#include <utility>
+#include <optional>
+
+namespace alewa::io {
+
+/* What an errno means to the loop that got it. AGAIN: nothing to be done
+ * until the fd is ready. RETRY: make the same call again now. DROP: give up
+ * on the one client it concerns and carry on. EXHAUSTED: the process or the
+ * system is out of fds or memory; back off and shed load. FATAL: a bug or a
+ * broken setup, which the server cannot serve through. */
+enum class Fault { AGAIN, RETRY, DROP, EXHAUSTED, FATAL };
+
+constexpr auto classify(int err) noexcept -> Fault
+{
+    switch (err) {
+    case EAGAIN:
+#if EWOULDBLOCK != EAGAIN
+    case EWOULDBLOCK:
+#endif
+    case EINPROGRESS:
+        return Fault::AGAIN;
+    case EINTR:
+        return Fault::RETRY;
+    /* the peer went away, or a network error pending on it surfaced, which
+     * accept(2) says to treat like EAGAIN for the listener */
+    case ECONNABORTED:
+    case ECONNRESET:
+    case ECONNREFUSED:
+    case EPIPE:
+    case ETIMEDOUT:
+    case EPROTO:
+    case ENOPROTOOPT:
+    case EHOSTDOWN:
+    case EHOSTUNREACH:
+    case ENETDOWN:
+    case ENETUNREACH:
+    case ENONET:
+    case EOPNOTSUPP:
+    case EPERM:  /* refused by a firewall rule */
+        return Fault::DROP;
+    case EMFILE:
+    case ENFILE:
+    case ENOBUFS:
+    case ENOMEM:
+    case ENOSPC:  /* e.g. epoll's max_user_watches */
+        return Fault::EXHAUSTED;
+    default:
+        return Fault::FATAL;
+    }
+}
+
+/* Whether a failed read or write just has to wait for the fd. */
+constexpr auto transient(int err) noexcept -> bool
+{
+    Fault const fault = classify(err);
+    return fault == Fault::AGAIN || fault == Fault::RETRY;
+}
+
+/* The value of a call that may fail, or the errno it failed with: what
+ * std::expected<V, int> would be, for the hot path, where a failure is
+ * routine and must neither throw nor build a message. */
+template <typename V = void>
+class [[nodiscard]] Result
+{
+private:
+    std::optional<V> val;
+    int err = 0;
+
+public:
+    Result(V&& value) : val(std::move(value)) {}
+    Result(V const & value) : val(value) {}
+
+    static auto failure(int err) noexcept -> Result
+    {
+        assert(err != 0);
+        return Result{err, 0};
+    }
+
+    explicit operator bool() const noexcept { return val.has_value(); }
+
+    auto operator*() & noexcept -> V& { return *val; }
+    auto operator*() const & noexcept -> V const & { return *val; }
+    auto operator*() && noexcept -> V&& { return std::move(*val); }
+    auto operator->() noexcept -> V* { return &*val; }
+    auto operator->() const noexcept -> V const * { return &*val; }
+
+    /* 0 on success */
+    [[nodiscard]]
+    auto error() const noexcept -> int { return err; }
+
+    [[nodiscard]]
+    auto fault() const noexcept -> Fault { return classify(err); }
+
+private:
+    Result(int err, int) noexcept : err(err) {}
+};
+
+template <>
+class [[nodiscard]] Result<void>
+{
+private:
+    int err = 0;
+
+public:
+    Result() noexcept = default;
+
+    static auto failure(int err) noexcept -> Result
+    {
+        assert(err != 0);
+        Result r;
+        r.err = err;
+        return r;
+    }
+
+    explicit operator bool() const noexcept { return err == 0; }
+
+    [[nodiscard]]
+    auto error() const noexcept -> int { return err; }
+
+    [[nodiscard]]
+    auto fault() const noexcept -> Fault { return classify(err); }
+};
+
+}  // namespace alewa::io
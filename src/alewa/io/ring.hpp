@@ -0,0 +1,388 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include <linux/io_uring.h>  /* kernel ABI only: structs and constants */
+
+#include "ioapi.hpp"
+
+namespace alewa::io {
+
+namespace detail {
+/* See reactor.hpp: only the macros are wanted here. */
+#include <sys/mman.h>
+
+static int const PROT_RW = PROT_READ | PROT_WRITE;
+static int const MAP_RING = MAP_SHARED | MAP_POPULATE;
+static int const MAP_MEMORY = MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE;
+static void* const MAP_FAILURE = MAP_FAILED;
+}  // namespace alewa::io::detail
+
+/* A minimal io_uring: the submission and completion rings mapped from the
+ * kernel, driven through raw system calls. One thread at a time. */
+template <UringApi T>
+class Ring
+{
+private:
+    struct Mapping
+    {
+        void* addr = nullptr;
+        std::size_t size = 0;
+    };
+
+    T const & api;
+    int ringfd;
+    Mapping sq_ring;
+    Mapping cq_ring;
+    Mapping sqe_array;
+
+    unsigned* sq_tail = nullptr;
+    unsigned sq_mask = 0;
+    unsigned sq_entries = 0;
+    unsigned* sq_head = nullptr;
+    ::io_uring_sqe* sqes = nullptr;
+    unsigned queued = 0;  /* prepared, not yet handed to the kernel */
+
+    unsigned* cq_head = nullptr;
+    unsigned* cq_tail = nullptr;
+    unsigned cq_mask = 0;
+    ::io_uring_cqe* cqes = nullptr;
+
+public:
+    Ring(T const & api, unsigned entries, unsigned flags = 0);
+    ~Ring();
+
+    Ring(Ring&) = delete;
+    Ring& operator=(Ring&) = delete;
+
+    [[nodiscard]]
+    auto fd() const noexcept -> int { return ringfd; }
+
+    /* A zeroed submission entry to fill in; it is submitted with the next
+     * submit(). Flushes the queue to the kernel first if it is full. */
+    auto sqe() -> ::io_uring_sqe&;
+
+    /* Hand queued entries to the kernel and wait until at least wait_nr
+     * completions are ready or timeout_ms has passed (-1: no limit). An
+     * interrupted or timed out wait is not an error. */
+    void submit(unsigned wait_nr = 0, int timeout_ms = -1);
+
+    /* Call f on every ready completion, in order, and release them. */
+    template <typename F>
+    auto drain(F&& f) -> std::size_t;
+
+    [[nodiscard]]
+    auto register_resource(unsigned opcode, void* arg, unsigned nr_args)
+            -> int;
+
+private:
+    auto map(std::size_t size, std::uint64_t offset) -> Mapping;
+    void unmap() noexcept;
+    auto err_msg(std::string const & func) const -> std::string
+    {
+        return "io_uring " + func + ": " + api.error();
+    }
+};
+
+/* Buffers handed to the kernel up front (a "provided buffer ring"): a
+ * receive picks one when data arrives instead of each connection pinning
+ * its own, and reports which one it used. A buffer is the caller's until it
+ * is given back with recycle(). */
+template <UringApi T>
+class BufferRing
+{
+private:
+    T const & api;
+    Ring<T>& ring;
+    std::uint16_t group;
+    unsigned entries;
+    std::size_t buffer_size;
+    void* ring_memory;
+    char* buffers;
+    std::uint16_t tail = 0;
+
+public:
+    BufferRing(T const & api, Ring<T>& ring, std::uint16_t group,
+               unsigned entries, std::size_t buffer_size);
+    ~BufferRing();
+
+    BufferRing(BufferRing&) = delete;
+    BufferRing& operator=(BufferRing&) = delete;
+
+    [[nodiscard]]
+    auto group_id() const noexcept -> std::uint16_t { return group; }
+
+    /* The bytes a completion reported in buffer `id`. */
+    [[nodiscard]]
+    auto data(std::uint16_t id) const noexcept -> char const *
+    {
+        return buffers + id * buffer_size;
+    }
+
+    void recycle(std::uint16_t id) noexcept;
+
+private:
+    void provide(std::uint16_t id) noexcept;
+    void publish() noexcept;
+};
+
+/* Whether this kernel offers what the completion reactor relies on:
+ * multishot accept and receive and provided buffer rings (Linux 6.0). */
+template <UringApi T>
+auto uring_supported(T const & api) -> bool;
+
+template <UringApi T>
+Ring<T>::Ring(T const & api, unsigned entries, unsigned flags) : api(api)
+{
+    typename T::UringParams params{};
+    params.flags = flags;
+    ringfd = api.io_uring_setup(entries, &params);
+    if (ringfd == T::ERROR) { throw std::runtime_error{err_msg("setup")}; }
+
+    try {
+        auto const & so = params.sq_off;
+        auto const & co = params.cq_off;
+        std::size_t const sq_size = so.array + params.sq_entries
+                                               * sizeof(unsigned);
+        std::size_t const cq_size = co.cqes + params.cq_entries
+                                              * sizeof(::io_uring_cqe);
+        sq_ring = map(sq_size, IORING_OFF_SQ_RING);
+        cq_ring = map(cq_size, IORING_OFF_CQ_RING);
+        sqe_array = map(params.sq_entries * sizeof(::io_uring_sqe),
+                        IORING_OFF_SQES);
+
+        auto* sq = static_cast<char*>(sq_ring.addr);
+        sq_head = reinterpret_cast<unsigned*>(sq + so.head);
+        sq_tail = reinterpret_cast<unsigned*>(sq + so.tail);
+        sq_mask = *reinterpret_cast<unsigned*>(sq + so.ring_mask);
+        sq_entries = params.sq_entries;
+        sqes = static_cast<::io_uring_sqe*>(sqe_array.addr);
+
+        /* slot i always holds sqe i */
+        auto* array = reinterpret_cast<unsigned*>(sq + so.array);
+        for (unsigned i = 0; i < sq_entries; ++i) { array[i] = i; }
+
+        auto* cq = static_cast<char*>(cq_ring.addr);
+        cq_head = reinterpret_cast<unsigned*>(cq + co.head);
+        cq_tail = reinterpret_cast<unsigned*>(cq + co.tail);
+        cq_mask = *reinterpret_cast<unsigned*>(cq + co.ring_mask);
+        cqes = reinterpret_cast<::io_uring_cqe*>(cq + co.cqes);
+    }
+    catch (...) {
+        unmap();
+        api.close(ringfd);
+        throw;
+    }
+}
+
+template <UringApi T>
+Ring<T>::~Ring()
+{
+    unmap();
+    api.close(ringfd);
+}
+
+template <UringApi T>
+auto Ring<T>::sqe() -> ::io_uring_sqe&
+{
+    unsigned const head = std::atomic_ref{*sq_head}.load(
+            std::memory_order_acquire);
+    if (*sq_tail + queued - head >= sq_entries) { submit(); }
+
+    ::io_uring_sqe& entry = sqes[(*sq_tail + queued) & sq_mask];
+    std::memset(&entry, 0, sizeof(entry));
+    ++queued;
+    return entry;
+}
+
+template <UringApi T>
+void Ring<T>::submit(unsigned wait_nr, int timeout_ms)
+{
+    std::atomic_ref{*sq_tail}.store(*sq_tail + queued,
+                                    std::memory_order_release);
+    unsigned const to_submit = queued;
+    queued = 0;
+
+    unsigned flags = (wait_nr > 0) ? IORING_ENTER_GETEVENTS : 0u;
+    ::__kernel_timespec ts{};
+    ::io_uring_getevents_arg arg{};
+    if (wait_nr > 0 && timeout_ms >= 0) {
+        ts.tv_sec = timeout_ms / 1000;
+        ts.tv_nsec = (timeout_ms % 1000) * 1'000'000L;
+        arg.ts = reinterpret_cast<std::uint64_t>(&ts);
+        flags |= IORING_ENTER_EXT_ARG;
+    }
+    if (to_submit == 0 && wait_nr == 0) { return; }
+
+    void* const argp = (flags & IORING_ENTER_EXT_ARG) ? &arg : nullptr;
+    std::size_t const argsz = argp ? sizeof(arg) : 0;
+    if (api.io_uring_enter(ringfd, to_submit, wait_nr, flags, argp, argsz)
+        == T::ERROR) {
+        int const err = api.errnum();
+        if (err == EINTR || err == ETIME || err == EBUSY) { return; }
+        throw std::runtime_error{err_msg("enter")};
+    }
+}
+
+template <UringApi T>
+template <typename F>
+auto Ring<T>::drain(F&& f) -> std::size_t
+{
+    unsigned head = *cq_head;
+    unsigned const tail = std::atomic_ref{*cq_tail}.load(
+            std::memory_order_acquire);
+    std::size_t n = 0;
+    for (; head != tail; ++head, ++n) {
+        ::io_uring_cqe const cqe = cqes[head & cq_mask];
+        /* released before f runs, which may queue and submit more work */
+        std::atomic_ref{*cq_head}.store(head + 1, std::memory_order_release);
+        f(cqe);
+    }
+    return n;
+}
+
+template <UringApi T>
+auto Ring<T>::register_resource(unsigned opcode, void* arg, unsigned nr_args)
+        -> int
+{
+    return api.io_uring_register(ringfd, opcode, arg, nr_args);
+}
+
+template <UringApi T>
+auto Ring<T>::map(std::size_t size, std::uint64_t offset) -> Mapping
+{
+    void* addr = api.mmap(nullptr, size, detail::PROT_RW, detail::MAP_RING,
+                          ringfd, static_cast<typename T::Off>(offset));
+    if (addr == detail::MAP_FAILURE) {
+        throw std::runtime_error{err_msg("mmap")};
+    }
+    return {addr, size};
+}
+
+template <UringApi T>
+void Ring<T>::unmap() noexcept
+{
+    for (Mapping* m : {&sqe_array, &cq_ring, &sq_ring}) {
+        if (m->addr) { api.munmap(m->addr, m->size); }
+        *m = {};
+    }
+}
+
+template <UringApi T>
+BufferRing<T>::BufferRing(T const & api, Ring<T>& ring, std::uint16_t group,
+                          unsigned entries, std::size_t buffer_size)
+        : api(api), ring(ring), group(group), entries(entries),
+          buffer_size(buffer_size)
+{
+    if (entries == 0 || (entries & (entries - 1)) != 0 || entries > 32768) {
+        throw std::runtime_error{"buffer ring: entries must be a power of 2"
+                                 " no larger than 32768"};
+    }
+
+    std::size_t const ring_size = entries * sizeof(::io_uring_buf);
+    ring_memory = api.mmap(nullptr, ring_size, detail::PROT_RW,
+                           detail::MAP_MEMORY, -1, 0);
+    if (ring_memory == detail::MAP_FAILURE) {
+        throw std::runtime_error{"buffer ring mmap: " + api.error()};
+    }
+    void* memory = api.mmap(nullptr, entries * buffer_size, detail::PROT_RW,
+                            detail::MAP_MEMORY, -1, 0);
+    if (memory == detail::MAP_FAILURE) {
+        api.munmap(ring_memory, ring_size);
+        throw std::runtime_error{"buffer ring mmap: " + api.error()};
+    }
+    buffers = static_cast<char*>(memory);
+
+    ::io_uring_buf_reg reg{};
+    reg.ring_addr = reinterpret_cast<std::uint64_t>(ring_memory);
+    reg.ring_entries = entries;
+    reg.bgid = group;
+    if (ring.register_resource(IORING_REGISTER_PBUF_RING, &reg, 1)
+        == T::ERROR) {
+        std::string const msg = "buffer ring register: " + api.error();
+        api.munmap(buffers, entries * buffer_size);
+        api.munmap(ring_memory, ring_size);
+        throw std::runtime_error{msg};
+    }
+
+    for (unsigned i = 0; i < entries; ++i) {
+        provide(static_cast<std::uint16_t>(i));
+    }
+    publish();
+}
+
+template <UringApi T>
+BufferRing<T>::~BufferRing()
+{
+    ::io_uring_buf_reg reg{};
+    reg.bgid = group;
+    [[maybe_unused]] int const ret = ring.register_resource(
+            IORING_UNREGISTER_PBUF_RING, &reg, 1);
+    api.munmap(buffers, entries * buffer_size);
+    api.munmap(ring_memory, entries * sizeof(::io_uring_buf));
+}
+
+template <UringApi T>
+void BufferRing<T>::recycle(std::uint16_t id) noexcept
+{
+    provide(id);
+    publish();
+}
+
+template <UringApi T>
+void BufferRing<T>::provide(std::uint16_t id) noexcept
+{
+    auto* bufs = static_cast<::io_uring_buf*>(ring_memory);
+    ::io_uring_buf& buf = bufs[tail & (entries - 1)];
+    buf.addr = reinterpret_cast<std::uint64_t>(buffers + id * buffer_size);
+    buf.len = static_cast<std::uint32_t>(buffer_size);
+    buf.bid = id;
+    ++tail;
+}
+
+template <UringApi T>
+void BufferRing<T>::publish() noexcept
+{
+    auto* br = static_cast<::io_uring_buf_ring*>(ring_memory);
+    std::atomic_ref{br->tail}.store(tail, std::memory_order_release);
+}
+
+template <UringApi T>
+auto uring_supported(T const & api) -> bool
+{
+    try {
+        Ring<T> ring{api, 4};
+
+        std::size_t const OPS = 256;
+        alignas(::io_uring_probe) char memory[
+                sizeof(::io_uring_probe) + OPS * sizeof(::io_uring_probe_op)]
+                = {};
+        auto* probe = reinterpret_cast<::io_uring_probe*>(memory);
+        if (ring.register_resource(IORING_REGISTER_PROBE, probe, OPS)
+            == T::ERROR) {
+            return false;
+        }
+        /* IORING_OP_SEND_ZC arrived in 6.0 along with multishot receive,
+         * which the probe cannot report directly */
+        for (unsigned op : {IORING_OP_ACCEPT, IORING_OP_RECV,
+                            IORING_OP_SENDMSG, IORING_OP_SEND_ZC}) {
+            if (op > probe->last_op
+                || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+                return false;
+            }
+        }
+
+        BufferRing<T> buffers{api, ring, 0, 1, 64};
+        return true;
+    }
+    catch (std::runtime_error const &) {
+        return false;
+    }
+}
+
+}  // namespace alewa::io
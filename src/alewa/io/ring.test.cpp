@@ -0,0 +1,76 @@
+#include "test/test_utils.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <sys/socket.h>
+
+#include "ioapi_sys.hpp"
+#include "ring.hpp"
+
+namespace alewa::io::test {
+
+/* These run against the kernel, and pass trivially where it has no
+ * io_uring to offer (old kernels, seccomp'd containers). */
+
+ALW_TEST(ring_completes_in_submission_order)
+{
+    IoUringIoApi api;
+    if (!uring_supported(api)) { return; }
+
+    Ring<IoUringIoApi> ring{api, 4};
+    for (std::uint64_t i = 1; i <= 6; ++i) {  /* more than fit at once */
+        ::io_uring_sqe& sqe = ring.sqe();
+        sqe.opcode = IORING_OP_NOP;
+        sqe.user_data = i;
+    }
+    ring.submit(2, 1000);
+
+    std::vector<std::uint64_t> seen;
+    while (seen.size() < 6) {
+        std::size_t const n = ring.drain([&](::io_uring_cqe const & cqe) {
+            seen.push_back(cqe.user_data);
+        });
+        if (n == 0) { ring.submit(1, 1000); }
+    }
+    ALW_EXPECT_EQ(seen == (std::vector<std::uint64_t>{1, 2, 3, 4, 5, 6}),
+                  true);
+}
+
+ALW_TEST(ring_receives_into_provided_buffers)
+{
+    IoUringIoApi api;
+    if (!uring_supported(api)) { return; }
+
+    int fds[2];
+    ALW_EXPECT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    Ring<IoUringIoApi> ring{api, 8};
+    BufferRing<IoUringIoApi> buffers{api, ring, 3, 2, 16};
+
+    std::string received;
+    for (char const * message : {"hello", "world", "again"}) {
+        ALW_EXPECT_EQ(api.write(fds[1], message, 5), 5l);
+
+        ::io_uring_sqe& sqe = ring.sqe();
+        sqe.opcode = IORING_OP_RECV;
+        sqe.fd = fds[0];
+        sqe.flags = IOSQE_BUFFER_SELECT;
+        sqe.buf_group = buffers.group_id();
+        ring.submit(1, 1000);
+
+        std::size_t const n = ring.drain([&](::io_uring_cqe const & cqe) {
+            if (cqe.res <= 0 || !(cqe.flags & IORING_CQE_F_BUFFER)) { return; }
+            auto const id = static_cast<std::uint16_t>(
+                    cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            received.append(buffers.data(id),
+                            static_cast<std::size_t>(cqe.res));
+            buffers.recycle(id);  /* two buffers serve three receives */
+        });
+        ALW_EXPECT_EQ(n, 1ul);
+    }
+    ALW_EXPECT_EQ(received, "helloworldagain");
+
+    api.close(fds[0]);
+    api.close(fds[1]);
+}
+
+}  // namespace alewa::io::test
@@ -1,5 +1,11 @@
 #include "sockapi_mock.hpp"
 
+#include <cerrno>
+#include <algorithm>
+#include <cstring>
+#include <sys/stat.h>
+#include <sys/epoll.h>
+
 namespace alewa::io::test {
 
 bool* MockSocketApi::is_freed = nullptr;
@@ -28,6 +34,34 @@ auto MockSocketApi::close(int) const -> int
     return SUCCESS;
 }
 
+auto MockSocketApi::socket(int, int, int) const -> int
+{
+    if (sockets.empty()) { return ret_code; }
+    int const fd = sockets.front();
+    sockets.pop_front();
+    return fd;
+}
+
+auto MockSocketApi::socketpair(int, int, int, int* sv) const -> int
+{
+    if (sockets.size() < 2) {
+        errorno = EMFILE;
+        return ERROR;
+    }
+    sv[0] = sockets.front();
+    sockets.pop_front();
+    sv[1] = sockets.front();
+    sockets.pop_front();
+    return SUCCESS;
+}
+
+auto MockSocketApi::bind(int, SockAddr const* addr, SockLen addrlen) const
+        -> int
+{
+    if (addr) { bound.assign(reinterpret_cast<char const *>(addr), addrlen); }
+    return ret_code;
+}
+
 auto MockSocketApi::accept(int, SockAddr* addr, SockLen* addrlen) const
         -> int
 {
@@ -37,5 +71,297 @@ auto MockSocketApi::accept(int, SockAddr* addr, SockLen* addrlen) const
     return ret_code;
 }
 
+auto MockSocketApi::accept4(int sockfd, SockAddr* addr, SockLen* addrlen,
+                            int flags) const -> int
+{
+    if (ret_code == ERROR) { return ret_code; }
+    if (sockfd < 0) {
+        errorno = EBADF;
+        return ERROR;
+    }
+    if (backlog.empty()) {
+        errorno = EAGAIN;
+        return ERROR;
+    }
+    int const fd = backlog.front();
+    backlog.pop_front();
+    if (fd < 0) {
+        errorno = -fd;
+        return ERROR;
+    }
+    accept_flags = flags;
+    if (addr && !peer_addr.empty()) {
+        std::memcpy(addr, peer_addr.data(),
+                    std::min<std::size_t>(peer_addr.size(), *addrlen));
+        *addrlen = static_cast<SockLen>(peer_addr.size());
+    }
+    else if (addr) {
+        *addr = *ai.ai_addr;
+        *addrlen = sizeof(SockAddr);
+    }
+    return fd;
+}
+
+auto MockSocketApi::readv(int fd, IoVec* iov, int iovcnt) const -> SSize
+{
+    if (ret_code == ERROR) { return ret_code; }
+    std::string& data = inbox[fd];
+    if (data.empty()) {
+        errorno = EAGAIN;
+        return ERROR;
+    }
+    std::size_t n = 0;
+    for (int i = 0; i < iovcnt && n < data.size(); ++i) {
+        std::size_t const len = std::min(iov[i].iov_len, data.size() - n);
+        std::memcpy(iov[i].iov_base, data.data() + n, len);
+        n += len;
+    }
+    data.erase(0, n);
+    return static_cast<SSize>(n);
+}
+
+auto MockSocketApi::writev(int fd, IoVec const * iov, int iovcnt) const
+        -> SSize
+{
+    if (ret_code == ERROR) { return ret_code; }
+    if (write_limit == 0) {
+        errorno = EAGAIN;
+        return ERROR;
+    }
+    std::string sent;
+    for (int i = 0; i < iovcnt && sent.size() < write_limit; ++i) {
+        std::size_t const len = std::min(iov[i].iov_len,
+                                         write_limit - sent.size());
+        sent.append(static_cast<char const *>(iov[i].iov_base), len);
+    }
+    auto const n = static_cast<SSize>(sent.size());
+    writes[fd].push_back(std::move(sent));
+    return n;
+}
+
+auto MockSocketApi::sendmsg(int fd, MsgHdr const * msg, int flags) const
+        -> SSize
+{
+    send_flags = flags;
+    return writev(fd, msg->msg_iov, static_cast<int>(msg->msg_iovlen));
+}
+
+auto MockSocketApi::recvmsg(int fd, MsgHdr* msg, int) const -> SSize
+{
+    msg->msg_controllen = 0;
+    return readv(fd, msg->msg_iov, static_cast<int>(msg->msg_iovlen));
+}
+
+auto MockIoApi::poll(PollFd* fds, Nfds nfds, int timeout) const -> int
+{
+    if (ret_code == ERROR) { return ret_code; }
+    last_timeout = timeout;
+
+    int nready = 0;
+    for (Nfds i = 0; i < nfds; ++i) {
+        auto it = ready.find(fds[i].fd);
+        unsigned const mask = static_cast<unsigned short>(fds[i].events)
+                              | EPOLLERR | EPOLLHUP;
+        fds[i].revents = (it == ready.end())
+                ? short{0}
+                : static_cast<short>(it->second & mask);
+        if (fds[i].revents != 0) { ++nready; }
+    }
+    return nready;
+}
+
+auto MockIoApi::eventfd(unsigned initval, int) const -> int
+{
+    if (ret_code == ERROR) { return ret_code; }
+    counter = initval;
+    return EVENT_FD;
+}
+
+auto MockIoApi::read(int fd, void* buf, std::size_t count) const -> SSize
+{
+    if (ret_code == ERROR) { return ret_code; }
+    if (fd != EVENT_FD) {
+        IoVec iov{buf, count};
+        return readv(fd, &iov, 1);
+    }
+    if (count < sizeof(counter) || counter == 0) { return ERROR; }
+    std::memcpy(buf, &counter, sizeof(counter));
+    counter = 0;
+    return sizeof(counter);
+}
+
+auto MockIoApi::write(int fd, void const * buf, std::size_t count) const
+        -> SSize
+{
+    if (ret_code == ERROR) { return ret_code; }
+    if (fd != EVENT_FD) {
+        IoVec iov{const_cast<void*>(buf), count};
+        return writev(fd, &iov, 1);
+    }
+    if (count < sizeof(counter)) { return ERROR; }
+    unsigned long long value;
+    std::memcpy(&value, buf, sizeof(value));
+    counter += value;
+    return sizeof(counter);
+}
+
+auto MockIoApi::open(char const * path, int) const -> int
+{
+    if (ret_code == ERROR) { return ret_code; }
+    if (!files.contains(path)) {
+        errorno = ENOENT;
+        return ERROR;
+    }
+    int const fd = FILE_FD + opens++;
+    open_files[fd] = path;
+    return fd;
+}
+
+auto MockIoApi::fstat(int fd, Stat* statbuf) const -> int
+{
+    auto it = open_files.find(fd);
+    if (it == open_files.end()) {
+        errorno = EBADF;
+        return ERROR;
+    }
+    return describe(it->second, statbuf);
+}
+
+auto MockIoApi::stat(char const * path, Stat* statbuf) const -> int
+{
+    if (ret_code == ERROR) { return ret_code; }
+    ++stats;
+    return describe(path, statbuf);
+}
+
+auto MockIoApi::lstat(char const * path, Stat* statbuf) const -> int
+{
+    if (ret_code == ERROR) { return ret_code; }
+    return describe(path, statbuf);
+}
+
+auto MockIoApi::describe(std::string const & path, Stat* statbuf) const
+        -> int
+{
+    auto it = files.find(path);
+    if (it == files.end()) {
+        errorno = ENOENT;
+        return ERROR;
+    }
+    File const & file = it->second;
+    *statbuf = {};
+    statbuf->st_mode = file.directory ? S_IFDIR
+                       : file.socket ? S_IFSOCK : S_IFREG;
+    statbuf->st_size = static_cast<long>(file.content.size());
+    statbuf->st_ino = std::hash<std::string>{}(path);
+    statbuf->st_mtim.tv_sec = file.mtime;
+    return SUCCESS;
+}
+
+auto MockIoApi::sendfile(int out_fd, int in_fd, Off* offset,
+                         std::size_t count) const -> SSize
+{
+    auto it = open_files.find(in_fd);
+    if (it == open_files.end()) {
+        errorno = EBADF;
+        return ERROR;
+    }
+    std::string const & content = files[it->second].content;
+    auto const start = static_cast<std::size_t>(*offset);
+    std::size_t const n = std::min(count, content.size() - start);
+    IoVec iov{const_cast<char*>(content.data() + start), n};
+    SSize const sent = writev(out_fd, &iov, 1);
+    if (sent > 0) { *offset += sent; }
+    return sent;
+}
+
+auto MockIoApi::pread(int fd, void* buf, std::size_t count, Off offset) const
+        -> SSize
+{
+    auto it = open_files.find(fd);
+    if (it == open_files.end()) {
+        errorno = EBADF;
+        return ERROR;
+    }
+    ++preads;
+    std::string const & content = files[it->second].content;
+    auto const start = std::min(static_cast<std::size_t>(offset),
+                                content.size());
+    std::size_t const n = std::min(count, content.size() - start);
+    std::memcpy(buf, content.data() + start, n);
+    return static_cast<SSize>(n);
+}
+
+auto MockIoApi::unlink(char const * path) const -> int
+{
+    unlinked.emplace_back(path);
+    return ret_code;
+}
+
+auto MockEpollIoApi::epoll_create1(int) const -> int
+{
+    if (ret_code == ERROR) { return ret_code; }
+    int const epfd = EPOLL_FD + static_cast<int>(interests.size());
+    interests[epfd];
+    return epfd;
+}
+
+auto MockEpollIoApi::epoll_ctl(int epfd, int op, int fd, EpollEvent* event)
+        const -> int
+{
+    if (ret_code == ERROR) { return ret_code; }
+    auto& interest = interests[epfd];
+    switch (op) {
+    case EPOLL_CTL_ADD:
+        if (interest.contains(fd)) {
+            errorno = EEXIST;
+            return ERROR;
+        }
+        interest[fd] = event->events;
+        break;
+    case EPOLL_CTL_MOD:
+        if (!interest.contains(fd)) {
+            errorno = ENOENT;
+            return ERROR;
+        }
+        interest[fd] = event->events;
+        break;
+    case EPOLL_CTL_DEL:
+        if (interest.erase(fd) == 0) {
+            errorno = ENOENT;
+            return ERROR;
+        }
+        break;
+    default:
+        return ERROR;
+    }
+    return SUCCESS;
+}
+
+auto MockEpollIoApi::epoll_wait(int epfd, EpollEvent* events, int maxevents,
+                                int timeout) const -> int
+{
+    if (ret_code == ERROR) { return ret_code; }
+    last_timeout = timeout;
+    auto& interest = interests[epfd];
+
+    int n = 0;
+    for (auto it = ready.begin(); it != ready.end() && n < maxevents;) {
+        auto reg = interest.find(it->first);
+        unsigned const revents = (reg == interest.end())
+                ? 0u
+                : it->second & (reg->second | EPOLLERR | EPOLLHUP);
+        if (revents == 0) { ++it; continue; }
+
+        events[n].events = revents;
+        events[n].data.fd = it->first;
+        ++n;
+
+        bool const edge = reg->second & EPOLLET;
+        it = edge ? ready.erase(it) : std::next(it);
+    }
+    return n;
+}
+
 }  // namespace alewa::io::test
 
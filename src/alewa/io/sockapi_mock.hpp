@@ -1,6 +1,10 @@
 #pragma once
 
+#include <map>
+#include <deque>
+#include <cstdint>
 #include <string>
+#include <vector>
 
 namespace alewa::io::test {
 
@@ -13,6 +17,7 @@ struct MockSocketApi
 
     struct AddrInfo
     {
+        int ai_flags;
         int ai_family;
         int ai_socktype;
         int ai_protocol;
@@ -24,6 +29,24 @@ struct MockSocketApi
 
     using AiDeleter = void(*)(AddrInfo*);
     using SockLen = unsigned short;
+    using SSize = long;
+
+    struct IoVec
+    {
+        void* iov_base;
+        std::size_t iov_len;
+    };
+
+    struct MsgHdr
+    {
+        void* msg_name;
+        SockLen msg_namelen;
+        IoVec* msg_iov;
+        std::size_t msg_iovlen;
+        void* msg_control;
+        std::size_t msg_controllen;
+        int msg_flags;
+    };
 
     static constexpr char const * const err = "Error";
     static int const ERROR = -1;
@@ -35,7 +58,30 @@ struct MockSocketApi
 
     mutable AddrInfo ai{};
     int ret_code = SUCCESS;
-    int errorno = ERRORNO;
+    mutable int errorno = ERRORNO;
+
+    /* fds handed out by accept4, which fails with EAGAIN once it is empty,
+     * and with EBADF on a negative fd; a negative entry fails the call that
+     * takes it, with errno -entry.
+     * accept4 reports the peer's address as *ai.ai_addr, or as the raw bytes
+     * of peer_addr if set; bind records the bytes of its address. */
+    mutable std::deque<int> backlog{};
+    mutable int accept_flags = 0;
+    std::string peer_addr{};
+    mutable std::string bound{};
+
+    /* fds for socket() to hand out, after which it returns ret_code;
+     * socketpair() takes two, failing with EMFILE without them */
+    mutable std::deque<int> sockets{};
+
+    /* Data for readv and recvmsg to return per fd, EAGAIN when empty;
+     * writev and sendmsg record what they send per fd, taking at most
+     * write_limit bytes a call (EAGAIN if it is 0) to simulate a full socket
+     * buffer. No ancillary data is passed either way. */
+    mutable std::map<int, std::string> inbox;
+    mutable std::map<int, std::vector<std::string>> writes;
+    std::size_t write_limit = SIZE_MAX;
+    mutable int send_flags = 0;
 
     static
     void set_is_freed(bool* val) { is_freed = val; }
@@ -46,6 +92,9 @@ struct MockSocketApi
     [[nodiscard]]
     auto error() const -> std::string;
 
+    [[nodiscard]]
+    auto errnum() const -> int { return errorno; }
+
     [[nodiscard]]
     auto gai_strerror(int) const -> char const * { return err; }
 
@@ -56,22 +105,141 @@ struct MockSocketApi
     void freeaddrinfo(AddrInfo*);
 
     [[nodiscard]]
-    auto socket(int, int, int) const -> int { return ret_code; }
+    auto socket(int, int, int) const -> int;
 
     auto close(int) const -> int;
 
-    auto bind(int, SockAddr const*, SockLen) const { return ret_code; }
+    auto bind(int, SockAddr const* addr, SockLen addrlen) const -> int;
+
+    auto socketpair(int, int, int, int* sv) const -> int;
 
     auto connect(int, SockAddr const*, SockLen) const { return ret_code; }
 
+    auto shutdown(int, int) const { return ret_code; }
+
     auto listen(int, int) const { return ret_code; }
 
     auto accept(int, SockAddr* addr, SockLen* addrlen) const -> int;
 
+    auto accept4(int, SockAddr* addr, SockLen* addrlen, int flags) const
+            -> int;
+
     auto setsockopt(int, int, int, void const *, SockLen)
             const { return ret_code; }
 
     auto fcntl(int, int, int) const { return ret_code; }
+
+    auto readv(int fd, IoVec* iov, int iovcnt) const -> SSize;
+
+    auto writev(int fd, IoVec const * iov, int iovcnt) const -> SSize;
+
+    auto sendmsg(int fd, MsgHdr const * msg, int flags) const -> SSize;
+
+    auto recvmsg(int fd, MsgHdr* msg, int flags) const -> SSize;
+};
+
+/* Readiness is scripted by the test: set `ready[fd]` to the revents a wait
+ * should report for that fd. Reads on EVENT_FD and writes to it act on an
+ * eventfd counter; on other fds they behave like readv and writev. Files are
+ * served from `files`, keyed by path; sendfile records into `writes` like
+ * writev does. */
+struct MockIoApi : public MockSocketApi
+{
+    struct PollFd
+    {
+        int fd;
+        short events;
+        short revents;
+    };
+
+    using Nfds = unsigned long;
+    using Off = long;
+
+    struct Stat
+    {
+        unsigned st_mode;
+        long st_size;
+        unsigned long st_ino;
+        struct { long tv_sec; long tv_nsec; } st_mtim;
+    };
+
+    struct File
+    {
+        std::string content;
+        long mtime = 0;
+        bool directory = false;
+        bool socket = false;
+    };
+
+    static constexpr int EVENT_FD = 1000;
+    static constexpr int FILE_FD = 3000;  /* first fd open() hands out */
+
+    mutable std::map<int, unsigned> ready;
+    mutable int last_timeout = 0;
+    mutable unsigned long long counter = 0;  /* eventfd value */
+    mutable std::map<std::string, File> files;
+    mutable std::map<int, std::string> open_files;  /* fd to path */
+    mutable int opens = 0;
+    mutable int stats = 0;  /* by path; fstat is not counted */
+    mutable int preads = 0;
+    mutable std::vector<std::string> unlinked;
+
+    auto poll(PollFd* fds, Nfds nfds, int timeout) const -> int;
+
+    auto eventfd(unsigned initval, int) const -> int;
+
+    auto read(int, void* buf, std::size_t count) const -> SSize;
+
+    auto write(int, void const * buf, std::size_t count) const -> SSize;
+
+    auto open(char const * path, int) const -> int;
+
+    auto fstat(int fd, Stat* statbuf) const -> int;
+
+    auto stat(char const * path, Stat* statbuf) const -> int;
+
+    /* As stat, but not counted. */
+    auto lstat(char const * path, Stat* statbuf) const -> int;
+
+    auto sendfile(int out_fd, int in_fd, Off* offset, std::size_t count) const
+            -> SSize;
+
+    auto pread(int fd, void* buf, std::size_t count, Off offset) const
+            -> SSize;
+
+    auto unlink(char const * path) const -> int;
+
+private:
+    auto describe(std::string const & path, Stat* statbuf) const -> int;
+};
+
+/* Every epoll instance keeps its own interest set, keyed by epoll fd.
+ * Edge-triggered registrations consume their scripted readiness once it has
+ * been reported, level-triggered ones keep reporting it. */
+struct MockEpollIoApi : public MockIoApi
+{
+    struct EpollEvent
+    {
+        unsigned events;
+        struct { int fd; } data;
+    };
+
+    static constexpr int EPOLL_FD = 2000;
+
+    mutable std::map<int, std::map<int, unsigned>> interests;
+
+    auto epoll_create1(int) const -> int;
+
+    /* interest set of the first epoll instance created */
+    auto interest() const -> std::map<int, unsigned>&
+    {
+        return interests[EPOLL_FD];
+    }
+
+    auto epoll_ctl(int, int op, int fd, EpollEvent* event) const -> int;
+
+    auto epoll_wait(int, EpollEvent* events, int maxevents, int timeout) const
+            -> int;
 };
 
 }  // namespace alewa::io::test
@@ -1,9 +1,14 @@
 #pragma once
 
+#include <cerrno>
 #include <memory>
+#include <cstddef>
+#include <utility>
 #include <cassert>
+#include <concepts>
 
 #include "ioapi.hpp"
+#include "result.hpp"
 
 namespace alewa::io {
 
@@ -41,13 +46,33 @@ public:
     }
 };
 
+/* Bytes of address a peer of any family may have, as sockaddr_storage. */
+static std::size_t const SOCKADDR_SPACE = 128;
+
+/* A peer's address. T::SockAddr only has room for the families whose
+ * addresses fit in it, such as IPv4; the rest, a Unix peer's sockaddr_un
+ * included, fill the storage beneath it, and addrlen tells how much. */
 template <SocketApi T>
 struct SockInfo
 {
-    typename T::SockAddr addr;
+    union
+    {
+        typename T::SockAddr addr;
+        alignas(8) char storage[SOCKADDR_SPACE];
+    };
     typename T::SockLen addrlen;
 };
 
+/* How a batch of accepts ended: `count` clients were handed over, and
+ * `error` is the errno that cut it short for want of fds or memory (EMFILE,
+ * ENFILE, ENOBUFS, ENOMEM or ENOSPC), or 0 if the backlog drained or the batch was
+ * full. */
+struct Accepted
+{
+    std::size_t count;
+    int error;
+};
+
 template <SocketApi T>
 class Socket
 {
@@ -74,15 +99,40 @@ public:
     [[nodiscard]]
     auto fd() const noexcept -> int { return sockfd; }
 
+    /* Take ownership of an open socket, e.g. one accepted through a
+     * completion queue. */
+    static auto adopt(T const & api, int fd) -> Socket { return {api, fd}; }
+
+    /* Give up ownership without closing, e.g. to close asynchronously. */
+    auto release() noexcept -> int { return std::exchange(sockfd, NULL_FD); }
+
     void bind(AddrInfo const & target);
     void connect(AddrInfo const & target);
 
     void listen(int backlog);
     auto accept(SockInfo<T>& client_info) -> Socket;
 
+    /* Accept one client with accept4, passing flags (e.g. SOCK_NONBLOCK). */
+    auto try_accept(SockInfo<T>& client_info, int flags) -> Result<Socket>;
+
+    /* Accept until the backlog is drained or max_batch clients have been
+     * handed to on_accept, passing flags (e.g. SOCK_NONBLOCK) to accept4.
+     * Clients that went away before they were accepted are skipped, running
+     * out of fds or memory ends the batch early, and other errors throw. */
+    template <std::invocable<Socket&&, SockInfo<T> const &> F>
+    auto accept_batch(F&& on_accept, std::size_t max_batch, int flags)
+            -> Accepted;
+
     void set_file_option(int cmd, int arg);
     void set_socket_option(int level, int optname, int optval);
 
+    /* The non-throwing variants of the above, which report errno instead of
+     * formatting it into an exception. */
+    auto try_listen(int backlog) -> Result<>;
+    auto try_set_file_option(int cmd, int arg) -> Result<>;
+    auto try_set_socket_option(int level, int optname, int optval)
+            -> Result<>;
+
 private:
     Socket(T const & api, int sockfd) : api(api), sockfd(sockfd) {};
     auto err_msg(std::string const & func) -> std::string;
@@ -166,14 +216,24 @@ void Socket<T>::connect(AddrInfo const & target)
 template <SocketApi T>
 void Socket<T>::listen(int backlog)
 {
-    if (T::ERROR == api.listen(sockfd, backlog)) {
+    if (!try_listen(backlog)) {
         throw std::runtime_error{err_msg(__func__)};
     }
 }
 
+template <SocketApi T>
+auto Socket<T>::try_listen(int backlog) -> Result<>
+{
+    if (T::ERROR == api.listen(sockfd, backlog)) {
+        return Result<>::failure(api.errnum());
+    }
+    return {};
+}
+
 template <SocketApi T>
 auto Socket<T>::accept(SockInfo<T>& client_info) -> Socket<T>
 {
+    client_info.addrlen = sizeof(client_info.storage);
     int const fd = api.accept(sockfd, &client_info.addr, &client_info.addrlen);
     if (fd == NULL_FD) {
         throw std::runtime_error{err_msg(__func__)};
@@ -181,21 +241,76 @@ auto Socket<T>::accept(SockInfo<T>& client_info) -> Socket<T>
     return Socket{api, fd};
 }
 
+template <SocketApi T>
+auto Socket<T>::try_accept(SockInfo<T>& client_info, int flags)
+        -> Result<Socket<T>>
+{
+    client_info.addrlen = sizeof(client_info.storage);
+    int const fd = api.accept4(sockfd, &client_info.addr,
+                               &client_info.addrlen, flags);
+    if (fd == NULL_FD) { return Result<Socket>::failure(api.errnum()); }
+    return Socket{api, fd};
+}
+
+template <SocketApi T>
+template <std::invocable<Socket<T>&&, SockInfo<T> const &> F>
+auto Socket<T>::accept_batch(F&& on_accept, std::size_t max_batch, int flags)
+        -> Accepted
+{
+    Accepted result{.count = 0, .error = 0};
+    while (result.count < max_batch) {
+        SockInfo<T> client_info{};
+        Result<Socket> client = try_accept(client_info, flags);
+        if (!client) {
+            Fault const fault = client.fault();
+            if (fault == Fault::AGAIN) { break; }
+            if (fault == Fault::RETRY || fault == Fault::DROP) { continue; }
+            if (fault == Fault::EXHAUSTED) {
+                result.error = client.error();
+                break;
+            }
+            throw std::runtime_error{err_msg("accept4")};
+        }
+        on_accept(std::move(*client), client_info);
+        ++result.count;
+    }
+    return result;
+}
+
 template <SocketApi T>
 void Socket<T>::set_file_option(int cmd, int arg)
 {
-    if (T::ERROR == api.fcntl(sockfd, cmd, arg)) {
+    if (!try_set_file_option(cmd, arg)) {
         throw std::runtime_error{err_msg(__func__)};
     }
 }
 
 template <SocketApi T>
 void Socket<T>::set_socket_option(int level, int optname, int const optval)
+{
+    if (!try_set_socket_option(level, optname, optval)) {
+        throw std::runtime_error{err_msg(__func__)};
+    }
+}
+
+template <SocketApi T>
+auto Socket<T>::try_set_file_option(int cmd, int arg) -> Result<>
+{
+    if (T::ERROR == api.fcntl(sockfd, cmd, arg)) {
+        return Result<>::failure(api.errnum());
+    }
+    return {};
+}
+
+template <SocketApi T>
+auto Socket<T>::try_set_socket_option(int level, int optname,
+                                      int const optval) -> Result<>
 {
     if (T::ERROR == api.setsockopt(sockfd, level, optname,
                                    &optval, sizeof(optval))) {
-        throw std::runtime_error{err_msg(__func__)};
+        return Result<>::failure(api.errnum());
     }
+    return {};
 }
 
 template <SocketApi T>
@@ -0,0 +1,135 @@
+#include "bench/micro.hpp"
+
+#include <vector>
+
+#include "io/socket.hpp"
+#include "bench/null_ioapi.hpp"
+
+namespace alewa::bench {
+
+/* Each Socket benchmark has a *_direct twin making the same NullIoApi calls
+ * by hand: any difference is what the wrapper costs. */
+
+ALW_BENCH(socket_construct_direct)
+{
+    NullIoApi api;
+    api.resolve(1);
+    NullIoApi::AddrInfo const & ai = api.addresses.front();
+    state.time(state.size, [&] {
+        for (std::size_t i = 0; i < state.size; ++i) {
+            int const fd = api.socket(ai.ai_family, ai.ai_socktype,
+                                      ai.ai_protocol);
+            keep(fd);
+            api.close(fd);
+        }
+    });
+}
+
+ALW_BENCH(socket_construct)
+{
+    NullIoApi api;
+    api.resolve(1);
+    io::AddrInfoList<NullIoApi> spec{api, nullptr, "0", nullptr};
+    state.time(state.size, [&] {
+        for (std::size_t i = 0; i < state.size; ++i) {
+            io::Socket<NullIoApi> socket{api, spec};
+            keep(socket.fd());
+        }
+    });
+}
+
+ALW_BENCH(socket_accept_direct)
+{
+    NullIoApi api;
+    io::SockInfo<NullIoApi> info{};
+    state.time(state.size, [&] {
+        for (std::size_t i = 0; i < state.size; ++i) {
+            info.addrlen = sizeof(info.addr);
+            int const fd = api.accept(0, &info.addr, &info.addrlen);
+            keep(fd);
+            api.close(fd);
+        }
+    });
+}
+
+ALW_BENCH(socket_accept)
+{
+    NullIoApi api;
+    api.resolve(1);
+    io::AddrInfoList<NullIoApi> spec{api, nullptr, "0", nullptr};
+    io::Socket<NullIoApi> listener{api, spec};
+    io::SockInfo<NullIoApi> info{};
+    state.time(state.size, [&] {
+        for (std::size_t i = 0; i < state.size; ++i) {
+            info.addrlen = sizeof(info.addr);
+            io::Socket<NullIoApi> client = listener.accept(info);
+            keep(client.fd());
+        }
+    });
+}
+
+/* The clients are kept, as a reactor would, so this includes moving each
+ * Socket into a (reserved) vector. */
+ALW_BENCH(socket_accept_batch)
+{
+    NullIoApi api;
+    api.resolve(1);
+    io::AddrInfoList<NullIoApi> spec{api, nullptr, "0", nullptr};
+    io::Socket<NullIoApi> listener{api, spec};
+    std::vector<io::Socket<NullIoApi>> clients;
+    clients.reserve(state.size);
+
+    api.pending = state.size;
+    state.time(state.size, [&] {
+        auto const n = listener.accept_batch(
+                [&](io::Socket<NullIoApi>&& client,
+                    io::SockInfo<NullIoApi> const &) {
+                    clients.push_back(std::move(client));
+                },
+                state.size, 0);
+        keep(n.count);
+    });
+}
+
+ALW_BENCH(socket_set_option_direct)
+{
+    NullIoApi api;
+    state.time(state.size, [&] {
+        for (std::size_t i = 0; i < state.size; ++i) {
+            int const one = 1;
+            api.setsockopt(3, 1, 2, &one, sizeof(one));
+            keep(i);
+        }
+    });
+}
+
+ALW_BENCH(socket_set_option)
+{
+    NullIoApi api;
+    api.resolve(1);
+    io::AddrInfoList<NullIoApi> spec{api, nullptr, "0", nullptr};
+    io::Socket<NullIoApi> socket{api, spec};
+    state.time(state.size, [&] {
+        for (std::size_t i = 0; i < state.size; ++i) {
+            socket.set_socket_option(1, 2, 1);
+            keep(i);
+        }
+    });
+}
+
+/* Resolve a list of state.size addresses and walk it, per address. */
+ALW_BENCH(addrinfo_iterate)
+{
+    NullIoApi api;
+    api.resolve(state.size);
+    state.time(state.size, [&] {
+        io::AddrInfoList<NullIoApi> list{api, nullptr, "0", nullptr};
+        std::size_t n = 0;
+        for (auto it = list.current(); it != nullptr; it = list.advance()) {
+            ++n;
+        }
+        keep(n);
+    });
+}
+
+}  // namespace alewa::bench
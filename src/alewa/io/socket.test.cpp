@@ -211,6 +211,90 @@ ALW_TEST(socket_accept)
     ALW_EXPECT_EQ(error, err_msg("accept", api.error()));
 }
 
+ALW_TEST(socket_accept_batch)
+{
+    MockSocketApi api;
+    AddrInfoList<MockSocketApi> spec{api, nullptr, nullptr, nullptr};
+    Socket<MockSocketApi> sock{api, spec};
+
+    MockSocketApi::SockAddr addr = {0xB00, {0, 69, 2}};
+    api.ai.ai_addr = &addr;
+    api.backlog = {5, 6, 7};
+
+    std::vector<int> fds;
+    auto collect = [&](Socket<MockSocketApi>&& client,
+                       SockInfo<MockSocketApi> const & info) {
+        ALW_EXPECT_EQ(info.addr.sa_data[1], addr.sa_data[1]);
+        fds.push_back(client.fd());
+    };
+
+    ALW_EXPECT_EQ(sock.accept_batch(collect, 2, 42).count, 2ul);
+    ALW_EXPECT_EQ(api.accept_flags, 42);
+    ALW_EXPECT_EQ(fds.size(), 2ul);
+
+    /* drains the rest and stops on EAGAIN without throwing */
+    ALW_EXPECT_EQ(sock.accept_batch(collect, 64, 42).count, 1ul);
+    ALW_EXPECT_EQ(fds.size(), 3ul);
+    ALW_EXPECT_EQ(fds[2], 7);
+    ALW_EXPECT_EQ(sock.accept_batch(collect, 64, 42).count, 0ul);
+
+    /* an aborted client is skipped, running out of fds ends the batch and
+     * leaves the client waiting */
+    api.backlog = {-ECONNABORTED, 8, -EMFILE, 9};
+    auto const accepted = sock.accept_batch(collect, 64, 42);
+    ALW_EXPECT_EQ(accepted.count, 1ul);
+    ALW_EXPECT_EQ(accepted.error, EMFILE);
+    ALW_EXPECT_EQ(fds.back(), 8);
+    ALW_EXPECT_EQ(api.backlog.size(), 1ul);
+
+    std::string error{};
+    try {
+        api.ret_code = MockSocketApi::ERROR;
+        api.errorno = MockSocketApi::ERRORNO;
+        sock.accept_batch(collect, 64, 0);
+    }
+    catch (std::runtime_error const & e) {
+        error = e.what();
+    }
+    ALW_EXPECT_EQ(error, err_msg("accept4", api.error()));
+}
+
+ALW_TEST(socket_try_accept)
+{
+    MockSocketApi api;
+    AddrInfoList<MockSocketApi> spec{api, nullptr, nullptr, nullptr};
+    Socket<MockSocketApi> sock{api, spec};
+
+    MockSocketApi::SockAddr addr = {0xB00, {0, 69, 2}};
+    api.ai.ai_addr = &addr;
+    api.backlog = {5, -ECONNABORTED, -EBADF};
+
+    SockInfo<MockSocketApi> info{};
+    auto happy = sock.try_accept(info, 42);
+    ALW_EXPECT_EQ(static_cast<bool>(happy), true);
+    ALW_EXPECT_EQ(happy->fd(), 5);
+    ALW_EXPECT_EQ(happy.error(), 0);
+    ALW_EXPECT_EQ(info.addr.sa_data[1], addr.sa_data[1]);
+
+    /* failures are reported, classified, rather than thrown */
+    auto aborted = sock.try_accept(info, 42);
+    ALW_EXPECT_EQ(static_cast<bool>(aborted), false);
+    ALW_EXPECT_EQ(aborted.error(), ECONNABORTED);
+    ALW_EXPECT_EQ(aborted.fault() == Fault::DROP, true);
+    auto broken = sock.try_accept(info, 42);
+    ALW_EXPECT_EQ(broken.fault() == Fault::FATAL, true);
+    auto drained = sock.try_accept(info, 42);
+    ALW_EXPECT_EQ(drained.fault() == Fault::AGAIN, true);
+
+    api.ret_code = MockSocketApi::ERROR;
+    api.errorno = EINVAL;
+    ALW_EXPECT_EQ(sock.try_listen(0).error(), EINVAL);
+    ALW_EXPECT_EQ(sock.try_set_socket_option(1, 2, 3).error(), EINVAL);
+    ALW_EXPECT_EQ(sock.try_set_file_option(1, 2).error(), EINVAL);
+    api.ret_code = MockSocketApi::SUCCESS;
+    ALW_EXPECT_EQ(static_cast<bool>(sock.try_listen(0)), true);
+}
+
 ALW_TEST(socket_set_option)
 {
     MockSocketApi api;
@@ -0,0 +1 @@
+#include "waker.hpp"
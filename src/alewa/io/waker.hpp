@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+
+#include "ioapi.hpp"
+
+namespace alewa::io {
+
+namespace detail {
+/* See reactor.hpp: only the macros and enum constants are wanted here. */
+#include <sys/eventfd.h>
+
+static int const EVENTFD_FLAGS = EFD_NONBLOCK | EFD_CLOEXEC;
+}  // namespace alewa::io::detail
+
+/* An eventfd that another thread (or a signal handler) can use to interrupt
+ * a Poller blocked in wait. notify() only issues a write(2), so it is
+ * async-signal-safe. */
+template <IoApi T>
+class Waker
+{
+private:
+    T const & api;
+    int efd;
+
+public:
+    explicit Waker(T const & api)
+            : api(api), efd(api.eventfd(0, detail::EVENTFD_FLAGS))
+    {
+        if (efd == T::ERROR) {
+            throw std::runtime_error{"eventfd failed: " + api.error()};
+        }
+    }
+
+    ~Waker() { api.close(efd); }
+
+    Waker(Waker&) = delete;
+    Waker& operator=(Waker&) = delete;
+
+    [[nodiscard]]
+    auto fd() const noexcept -> int { return efd; }
+
+    void notify() const noexcept
+    {
+        std::uint64_t const one = 1;
+        (void) api.write(efd, &one, sizeof(one));  /* EAGAIN: already set */
+    }
+
+    void drain() const noexcept
+    {
+        std::uint64_t value;
+        (void) api.read(efd, &value, sizeof(value));
+    }
+};
+
+}  // namespace alewa::io
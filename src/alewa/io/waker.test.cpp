@@ -0,0 +1,44 @@
+#include "test/test_utils.hpp"
+
+#include "waker.hpp"
+#include "poller.hpp"
+#include "sockapi_mock.hpp"
+
+namespace alewa::io::test {
+
+ALW_TEST(waker_notify_and_drain)
+{
+    MockIoApi api;
+    Waker<MockIoApi> waker{api};
+    ALW_EXPECT_EQ(waker.fd(), MockIoApi::EVENT_FD);
+
+    waker.notify();
+    waker.notify();
+    ALW_EXPECT_EQ(api.counter, 2ull);
+    waker.drain();
+    ALW_EXPECT_EQ(api.counter, 0ull);
+}
+
+ALW_TEST(waker_construction)
+{
+    MockIoApi api;
+    bool is_closed = false;
+    MockIoApi::set_is_closed(&is_closed);
+    {
+        Waker<MockIoApi> waker{api};
+    }
+    MockIoApi::set_is_closed(nullptr);
+    ALW_EXPECT_EQ(is_closed, true);
+
+    std::string error{};
+    try {
+        api.ret_code = MockIoApi::ERROR;
+        Waker<MockIoApi> waker{api};
+    }
+    catch (std::runtime_error const & e) {
+        error = e.what();
+    }
+    ALW_EXPECT_EQ(error, "eventfd failed: " + api.error());
+}
+
+}  // namespace alewa::io::test
@@ -0,0 +1 @@
+#include "listener.hpp"
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cerrno>
+#include <string>
+#include <algorithm>
+#include <string_view>
+#include <cstddef>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+
+#include "io/socket.hpp"
+#include "io/ioapi.hpp"
+
+namespace alewa {
+
+namespace detail {
+/* Expose the various macros used by the system network API without polluting
+ * the main namespace with functions that mutate global state. */
+#include <netdb.h>
+#include <fcntl.h>
+#include <sys/un.h>
+
+using UnixAddr = sockaddr_un;
+
+static int const TCP_STREAM = SOCK_STREAM;
+static int const ACCEPT_FLAGS = SOCK_NONBLOCK | SOCK_CLOEXEC;
+static int const UNIX_STREAM = SOCK_STREAM | SOCK_CLOEXEC;
+static int const UNIX_LISTENER = SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC;
+static std::size_t const UNIX_PATH_OFFSET = offsetof(UnixAddr, sun_path);
+static unsigned const PATH_TYPE = S_IFMT;
+static unsigned const SOCKET_PATH = S_IFSOCK;
+
+/* `path` as a Unix socket address in `addr`, returning the length to bind
+ * or connect with. A leading '@' names a socket in the abstract namespace:
+ * the name follows a NUL byte and is exactly as long as the length says. */
+inline auto unix_address(std::string const & path, UnixAddr& addr)
+        -> std::size_t
+{
+    addr = {};
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+        throw std::runtime_error{"bad unix socket path: " + path};
+    }
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.data(), path.size());
+    if (path.front() != '@') { return sizeof(addr); }
+    addr.sun_path[0] = '\0';
+    return UNIX_PATH_OFFSET + path.size();
+}
+}  // namespace alewa::detail
+
+/* A non-blocking TCP socket bound to `port` on every local address, or on
+ * `host` if given, not yet listening. With reuse_port each reactor binds its
+ * own socket to the port and the kernel spreads incoming connections across
+ * them. */
+template <io::SocketApi T>
+auto create_listener(T const & ioapi, std::string const & port,
+                     bool reuse_port, char const * host = nullptr)
+        -> io::Socket<T>
+{
+    typename T::AddrInfo hints{};
+    hints.ai_flags = AI_PASSIVE;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = detail::TCP_STREAM;
+
+    io::AddrInfoList<T> spec{ioapi, host, port.c_str(), &hints};
+    io::Socket<T> socket{ioapi, spec};
+    socket.set_socket_option(SOL_SOCKET, SO_REUSEADDR, 1);
+    if (reuse_port) { socket.set_socket_option(SOL_SOCKET, SO_REUSEPORT, 1); }
+    socket.set_file_option(F_SETFL, O_NONBLOCK);
+    socket.bind(*spec.current());
+    return socket;
+}
+
+/* A non-blocking Unix stream socket bound to `path`, not yet listening. A
+ * path starting with '@' names a socket in the abstract namespace, which
+ * has no file and goes away with its last listener. A socket left at any
+ * other path by a server that exited is unlinked first and replaced;
+ * anything else there is left alone, and throws. */
+template <io::IoApi T>
+auto create_unix_listener(T const & ioapi, std::string const & path)
+        -> io::Socket<T>
+{
+    detail::UnixAddr addr;
+    std::size_t const addrlen = detail::unix_address(path, addr);
+    int const fd = ioapi.socket(AF_UNIX, detail::UNIX_LISTENER, 0);
+    if (fd == T::ERROR) {
+        throw std::runtime_error{"unix socket " + path + ": "
+                                 + ioapi.error()};
+    }
+    auto socket = io::Socket<T>::adopt(ioapi, fd);
+
+    typename T::Stat st{};
+    if (path.front() != '@') {
+        if (T::ERROR == ioapi.lstat(path.c_str(), &st)) {
+            if (ioapi.errnum() != ENOENT) {
+                throw std::runtime_error{"lstat " + path + ": "
+                                         + ioapi.error()};
+            }
+        }
+        else if ((st.st_mode & detail::PATH_TYPE) != detail::SOCKET_PATH) {
+            throw std::runtime_error{"not a socket, left in place: " + path};
+        }
+        else if (T::ERROR == ioapi.unlink(path.c_str())
+                 && ioapi.errnum() != ENOENT) {
+            throw std::runtime_error{"unlink " + path + ": " + ioapi.error()};
+        }
+    }
+    typename T::AddrInfo spec{};
+    spec.ai_addr = reinterpret_cast<typename T::SockAddr*>(&addr);
+    spec.ai_addrlen = static_cast<decltype(spec.ai_addrlen)>(addrlen);
+    socket.bind(spec);
+    return socket;
+}
+
+/* The Unix socket path a peer is bound to, "@name" for one in the abstract
+ * namespace; empty if it is unnamed, as clients usually are, or is not a
+ * Unix socket at all. */
+template <io::SocketApi T>
+auto unix_path(io::SockInfo<T> const & peer) -> std::string
+{
+    auto const * addr = reinterpret_cast<detail::UnixAddr const *>(
+            peer.storage);
+    std::size_t const len = peer.addrlen;
+    if (len <= detail::UNIX_PATH_OFFSET || addr->sun_family != AF_UNIX) {
+        return {};
+    }
+    std::size_t const n = std::min(len - detail::UNIX_PATH_OFFSET,
+                                   sizeof(addr->sun_path));
+    std::string_view const path{addr->sun_path, n};
+    if (path.front() == '\0') { return "@" + std::string{path.substr(1)}; }
+    return std::string{path.substr(0, path.find('\0'))};
+}
+
+template <io::IoApi T>
+class Handoff;
+
+template <io::IoApi T>
+class Dispatch;
+
+/* The sockets a reactor accepts on, all listening already: its own, and on
+ * one reactor of a server the Unix socket, the admin listener and the
+ * handoff socket. Clients of the Unix socket are served as those of the
+ * main listener are. In the single-acceptor topology only one reactor has
+ * a main listener, and every reactor is also handed clients through the
+ * dispatch, as its `worker`. */
+template <io::IoApi T>
+struct Listeners
+{
+    std::optional<io::Socket<T>> main{};
+    std::optional<io::Socket<T>> local{};
+    std::optional<io::Socket<T>> admin{};
+    Handoff<T>* handoff = nullptr;
+    Dispatch<T>* dispatch = nullptr;
+    std::size_t worker = 0;
+};
+
+}  // namespace alewa
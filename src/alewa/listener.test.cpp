@@ -0,0 +1,128 @@
+#include "test/test_utils.hpp"
+
+#include <string>
+#include <cstddef>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "listener.hpp"
+#include "io/ioapi_sys.hpp"
+#include "io/sockapi_mock.hpp"
+
+namespace alewa::test {
+
+using io::test::MockIoApi;
+
+namespace {
+
+auto raw_unix_address(std::string const & path) -> std::string
+{
+    detail::UnixAddr addr{};
+    addr.sun_family = AF_UNIX;
+    path.copy(addr.sun_path, path.size());
+    if (path.starts_with('@')) { addr.sun_path[0] = '\0'; }
+    std::size_t const len = path.starts_with('@')
+            ? detail::UNIX_PATH_OFFSET + path.size() : sizeof(addr);
+    return {reinterpret_cast<char const *>(&addr), len};
+}
+
+}  // namespace
+
+ALW_TEST(listener_unix_binds_and_replaces_stale_path)
+{
+    MockIoApi api;
+    auto fresh = create_unix_listener(api, "/tmp/alewa.sock");
+    ALW_EXPECT_EQ(api.bound, raw_unix_address("/tmp/alewa.sock"));
+    ALW_EXPECT_EQ(api.unlinked.empty(), true);  /* nothing there */
+
+    api.files["/tmp/alewa.sock"] = {"", 0, false, true};
+    auto socket = create_unix_listener(api, "/tmp/alewa.sock");
+    ALW_EXPECT_EQ(api.unlinked.size(), 1ul);
+    ALW_EXPECT_EQ(api.unlinked[0], "/tmp/alewa.sock");
+}
+
+ALW_TEST(listener_unix_leaves_other_files_alone)
+{
+    MockIoApi api;
+    api.files["/tmp/alewa.sock"] = {"data", 0};
+    std::string error{};
+    try {
+        create_unix_listener(api, "/tmp/alewa.sock");
+    }
+    catch (std::runtime_error const & e) {
+        error = e.what();
+    }
+    ALW_EXPECT_EQ(error, "not a socket, left in place: /tmp/alewa.sock");
+    ALW_EXPECT_EQ(api.unlinked.empty(), true);
+}
+
+ALW_TEST(listener_unix_abstract_name_has_no_file)
+{
+    MockIoApi api;
+    auto socket = create_unix_listener(api, "@alewa");
+    /* a NUL, the name, and no terminator */
+    ALW_EXPECT_EQ(api.bound, raw_unix_address("@alewa"));
+    ALW_EXPECT_EQ(api.bound.size(), detail::UNIX_PATH_OFFSET + 6);
+    ALW_EXPECT_EQ(api.unlinked.empty(), true);
+
+    std::string error{};
+    try {
+        create_unix_listener(api, std::string(200, 'x'));
+    }
+    catch (std::runtime_error const & e) {
+        error = e.what();
+    }
+    ALW_EXPECT_EQ(error.starts_with("bad unix socket path: "), true);
+}
+
+ALW_TEST(listener_unix_peer_address)
+{
+    MockIoApi api;
+    auto listener = create_unix_listener(api, "@alewa");
+    api.backlog = {7, 8, 9};
+
+    io::SockInfo<MockIoApi> peer{};
+    api.peer_addr = raw_unix_address("/run/proxy.sock");
+    auto named = listener.try_accept(peer, 0);
+    ALW_EXPECT_EQ(unix_path(peer), "/run/proxy.sock");
+
+    api.peer_addr = raw_unix_address("@proxy");
+    auto abstract = listener.try_accept(peer, 0);
+    ALW_EXPECT_EQ(unix_path(peer), "@proxy");
+
+    /* an unnamed client's address is only its family */
+    api.peer_addr = raw_unix_address("@").substr(0, detail::UNIX_PATH_OFFSET);
+    auto unnamed = listener.try_accept(peer, 0);
+    ALW_EXPECT_EQ(unix_path(peer), "");
+}
+
+ALW_TEST(listener_unix_accepts_over_abstract_socket)
+{
+    io::EpollIoApi api;
+    std::string const name = "@alewa-test-" + std::to_string(::getpid());
+    auto listener = create_unix_listener(api, name);
+    listener.listen(4);
+
+    int const client = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    std::string const target = raw_unix_address(name);
+    int const connected = ::connect(
+            client, reinterpret_cast<::sockaddr const *>(target.data()),
+            static_cast<::socklen_t>(target.size()));
+
+    std::size_t accepted = 0;
+    sa_family_t family = 0;
+    listener.accept_batch(
+            [&](io::Socket<io::EpollIoApi>&&,
+                io::SockInfo<io::EpollIoApi> const & peer) {
+                ++accepted;
+                family = peer.addr.sa_family;
+            },
+            4, 0);
+    ::close(client);
+
+    ALW_EXPECT_EQ(connected, 0);
+    ALW_EXPECT_EQ(accepted, 1ul);
+    ALW_EXPECT_EQ(family, AF_UNIX);
+}
+
+}  // namespace alewa::test
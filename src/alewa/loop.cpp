@@ -0,0 +1 @@
+#include "loop.hpp"
@@ -0,0 +1,555 @@
+#pragma once
+
+#include <span>
+#include <mutex>
+#include <queue>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <variant>
+#include <optional>
+#include <exception>
+#include <unordered_map>
+#include <coroutine>
+#include <functional>
+#include <type_traits>
+
+#include "io/socket.hpp"
+#include "io/ioapi.hpp"
+#include "io/poller.hpp"
+#include "io/result.hpp"
+#include "io/waker.hpp"
+#include "listener.hpp"
+#include "frame_pool.hpp"
+#include "task.hpp"
+#include "work_pool.hpp"
+
+namespace alewa {
+
+namespace detail {
+/* See listener.hpp. */
+#include <sys/socket.h>
+
+static int const TASK_SEND_FLAGS = MSG_NOSIGNAL;
+}  // namespace alewa::detail
+
+/* The sooner of two poll timeouts in milliseconds, where -1 is never. */
+constexpr auto sooner(int a, int b) noexcept -> int
+{
+    if (a < 0) { return b; }
+    if (b < 0) { return a; }
+    return a < b ? a : b;
+}
+
+/* Runs Tasks on a reactor's thread, between its own work: a task that would
+ * block on a socket is suspended until the reactor's poller reports the
+ * socket ready, and one that sleeps until its time is up or, given a
+ * ticket, until another task cancels the sleep. The reactor hands
+ * every event on an fd it does not know to wake() and calls run() once per
+ * turn of its loop, blocking no longer than poll_timeout(). An fd is in the
+ * poller only while a task waits on it, and at most one task may wait on it
+ * for reading and one for writing. Task frames come from the loop's
+ * FramePool, and the tasks still suspended when it goes are destroyed.
+ * With a WorkPool attached, a task can offload() a call to it and is posted
+ * back to the loop when the call returns, through a mailbox and the
+ * reactor's waker; post() is the one member other threads may call. */
+template <io::IoApi T>
+class Loop
+{
+public:
+    /* Names a sleep() that cancel() may cut short; never reused. */
+    using Ticket = std::uint64_t;
+
+    /* Taken by a task serving a client, e.g. through a TLS relay, for as
+     * long as it does; counted by held(). */
+    class Hold
+    {
+        Loop& owner;
+
+    public:
+        explicit Hold(Loop& owner) noexcept : owner(owner) { ++owner.holds; }
+        ~Hold() { --owner.holds; }
+
+        Hold(Hold&) = delete;
+        Hold& operator=(Hold&) = delete;
+    };
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Waiting
+    {
+        std::coroutine_handle<> reader{};
+        std::coroutine_handle<> writer{};
+
+        [[nodiscard]]
+        auto interest() const noexcept -> unsigned
+        {
+            return (reader ? io::EV_IN : 0u) | (writer ? io::EV_OUT : 0u);
+        }
+    };
+
+    struct Sleeper
+    {
+        Clock::time_point until;
+        std::uint64_t order;  /* first come, first woken at the same time */
+        std::coroutine_handle<> task;
+        bool ticketed;  /* its order is its ticket */
+
+        auto operator>(Sleeper const & other) const noexcept -> bool
+        {
+            return until != other.until ? until > other.until
+                                        : order > other.order;
+        }
+    };
+
+    /* Suspends until `fd` is ready for `events`, or not at all if the
+     * poller refuses it, which await_resume reports. */
+    struct Readiness
+    {
+        Loop& loop;
+        int fd;
+        unsigned events;
+        io::Result<> registered{};
+
+        auto await_ready() const noexcept -> bool { return false; }
+
+        auto await_suspend(std::coroutine_handle<> task) -> bool
+        {
+            registered = loop.wait(fd, events, task);
+            return static_cast<bool>(registered);
+        }
+
+        auto await_resume() const noexcept -> io::Result<>
+        {
+            return registered;
+        }
+    };
+
+    /* Suspends until `duration` has passed or, given a ticket, until it
+     * is cancelled, even before; true in the first case. */
+    struct Sleep
+    {
+        Loop& loop;
+        Clock::duration duration;
+        Ticket ticket;  /* 0 for none */
+
+        auto await_ready() const noexcept -> bool
+        {
+            return duration <= Clock::duration::zero()
+                   || (ticket != 0 && !loop.tickets.contains(ticket));
+        }
+
+        void await_suspend(std::coroutine_handle<> task)
+        {
+            Ticket const order = ticket ? ticket : ++loop.slept;
+            loop.sleepers.push({Clock::now() + duration, order, task,
+                                ticket != 0});
+            if (ticket) { loop.tickets[ticket] = task; }
+        }
+
+        auto await_resume() const noexcept -> bool
+        {
+            return ticket == 0 || loop.tickets.erase(ticket) > 0;
+        }
+    };
+
+    /* Runs `fn` on the pool, or inline without one, and resumes the task on
+     * the loop with its result or exception. */
+    template <typename F>
+    struct Offload : WorkPool::Job
+    {
+        using R = std::invoke_result_t<F&>;
+        using Value = std::conditional_t<std::is_void_v<R>, std::monostate,
+                                         R>;
+
+        Loop& loop;
+        F fn;
+        std::coroutine_handle<> task{};
+        std::optional<Value> value{};
+        std::exception_ptr error{};
+
+        Offload(Loop& loop, F fn)
+                : WorkPool::Job{&Offload::execute}, loop(loop),
+                  fn(std::move(fn)) {}
+
+        auto await_ready() const noexcept -> bool { return false; }
+
+        auto await_suspend(std::coroutine_handle<> suspended) -> bool
+        {
+            task = suspended;
+            /* inline, here, when there is no pool or it has no room */
+            if (!loop.workers || !loop.workers->submit(*this)) {
+                call();
+                return false;
+            }
+            return true;
+        }
+
+        auto await_resume() -> R
+        {
+            if (error) { std::rethrow_exception(error); }
+            if constexpr (!std::is_void_v<R>) { return std::move(*value); }
+        }
+
+        void call() noexcept
+        {
+            try {
+                if constexpr (std::is_void_v<R>) {
+                    fn();
+                    value.emplace();
+                }
+                else { value.emplace(fn()); }
+            }
+            catch (...) { error = std::current_exception(); }
+        }
+
+        static void execute(WorkPool::Job& job) noexcept
+        {
+            auto& self = static_cast<Offload&>(job);
+            self.call();
+            self.loop.post(self.task);
+        }
+    };
+
+    T const & ioapi;
+    io::Poller<T>& poller;
+    io::Waker<T> const * waker;
+    WorkPool* workers = nullptr;
+    FramePool pool;  /* outlives the frames below */
+    std::vector<Waiting> waiting;  /* by fd */
+    std::vector<std::coroutine_handle<>> runnable;
+    std::vector<std::coroutine_handle<>> batch;  /* runnable, being run */
+    std::priority_queue<Sleeper, std::vector<Sleeper>, std::greater<>>
+            sleepers;
+    std::uint64_t slept = 0;
+    /* tickets not cancelled or spent yet, with the task asleep on each
+     * until its time is up */
+    std::unordered_map<Ticket, std::coroutine_handle<>> tickets;
+    TaskList tasks;
+    std::size_t holds = 0;
+
+    std::mutex mailbox_lock;
+    std::vector<std::coroutine_handle<>> mailbox;  /* under mailbox_lock */
+    std::atomic<bool> posted{false};
+
+public:
+    /* `waker`, if any, is notified when another thread posts a task. */
+    Loop(T const & ioapi, io::Poller<T>& poller,
+         io::Waker<T> const * waker = nullptr)
+            : ioapi(ioapi), poller(poller), waker(waker) {}
+    ~Loop();
+
+    Loop(Loop&) = delete;
+    Loop& operator=(Loop&) = delete;
+
+    /* Run `task` from the next run() on, for as long as it takes. */
+    void spawn(Task<> task);
+
+    /* Read what `socket` has, up to into.size() bytes; 0 at EOF. */
+    auto read(io::Socket<T>& socket, std::span<char> into)
+            -> Task<io::Result<std::size_t>>;
+
+    /* Write all of `data`, which must stay valid until this returns. */
+    auto write(io::Socket<T>& socket, std::span<char const> data)
+            -> Task<io::Result<std::size_t>>;
+
+    /* The next client of `listener`, non-blocking like the reactor's.
+     * Clients that went away while waiting are skipped. */
+    auto accept(io::Socket<T>& listener) -> Task<io::Result<io::Socket<T>>>;
+
+    [[nodiscard]]
+    auto sleep(Clock::duration duration) noexcept -> Sleep
+    {
+        return {*this, duration, 0};
+    }
+
+    /* For one sleep, which must follow unless the ticket is cancelled. */
+    [[nodiscard]]
+    auto ticket() -> Ticket;
+
+    /* A sleep that cancel(`ticket`) may end early, or skip if it comes
+     * first. */
+    [[nodiscard]]
+    auto sleep(Clock::duration duration, Ticket ticket) noexcept -> Sleep
+    {
+        return {*this, duration, ticket};
+    }
+
+    /* Resume the task asleep on `ticket` from the next run() on, rather
+     * than when its time is up; nothing once the sleep is over. */
+    void cancel(Ticket ticket);
+
+    /* Before offloading: the pool to offload to, which must run every job
+     * it was given before the loop goes. */
+    void attach(WorkPool& pool) noexcept { workers = &pool; }
+
+    /* co_await to have a worker call `fn`, which must not touch the loop,
+     * while the reactor carries on; evaluates to what fn returns or
+     * rethrows what it threw. */
+    template <typename F>
+    [[nodiscard]]
+    auto offload(F fn) -> Offload<F>
+    {
+        return {*this, std::move(fn)};
+    }
+
+    /* Thread-safe: resume `task`, suspended on this loop, from its next
+     * run(). */
+    void post(std::coroutine_handle<> task);
+
+    /* Wake the tasks waiting on `fd` for `events`; false if none waits on
+     * it, which makes it someone else's. */
+    auto wake(int fd, unsigned events) -> bool;
+
+    /* Resume every task spawned, woken or done sleeping, and those they
+     * make runnable in turn. */
+    void run();
+
+    /* Milliseconds the reactor may block for on our account, -1 for as long
+     * as it likes. */
+    [[nodiscard]]
+    auto poll_timeout() const -> int;
+
+    [[nodiscard]]
+    auto frames() noexcept -> FramePool& { return pool; }
+
+    /* Spawned tasks that have not returned yet. */
+    [[nodiscard]]
+    auto size() const noexcept -> std::size_t { return tasks.size(); }
+
+    /* Holds not let go yet: a draining reactor runs on until there are
+     * none, as their clients are not in its registry. */
+    [[nodiscard]]
+    auto held() const noexcept -> std::size_t { return holds; }
+
+    /* Spawned tasks ended by an exception. */
+    [[nodiscard]]
+    auto failed() const noexcept -> std::uint64_t { return tasks.failed(); }
+
+    /* co_await until `fd` is ready for `events`, for a task whose I/O is
+     * made by someone else, e.g. a TLS library; evaluates to an error if
+     * the poller refuses the fd. */
+    [[nodiscard]]
+    auto readiness(int fd, unsigned events) noexcept -> Readiness
+    {
+        return {*this, fd, events};
+    }
+
+private:
+    auto wait(int fd, unsigned events, std::coroutine_handle<> task)
+            -> io::Result<>;
+};
+
+template <io::IoApi T>
+Loop<T>::~Loop()
+{
+    for (std::size_t fd = 0; fd < waiting.size(); ++fd) {
+        if (waiting[fd].interest() != 0) {
+            (void) poller.try_remove(static_cast<int>(fd));
+        }
+    }
+    tasks.clear();
+}
+
+template <io::IoApi T>
+void Loop<T>::spawn(Task<> task)
+{
+    runnable.reserve(runnable.size() + 1);  /* before the task is adopted */
+    runnable.push_back(tasks.adopt(std::move(task)));
+}
+
+template <io::IoApi T>
+auto Loop<T>::read(io::Socket<T>& socket, std::span<char> into)
+        -> Task<io::Result<std::size_t>>
+{
+    typename T::IoVec iov{};
+    iov.iov_base = into.data();
+    iov.iov_len = into.size();
+    for (;;) {
+        auto const n = ioapi.readv(socket.fd(), &iov, 1);
+        if (n >= 0) { co_return static_cast<std::size_t>(n); }
+
+        int const err = ioapi.errnum();
+        io::Fault const fault = io::classify(err);
+        if (fault == io::Fault::RETRY) { continue; }
+        if (fault != io::Fault::AGAIN) {
+            co_return io::Result<std::size_t>::failure(err);
+        }
+        auto const ready = co_await readiness(socket.fd(), io::EV_IN);
+        if (!ready) {
+            co_return io::Result<std::size_t>::failure(ready.error());
+        }
+    }
+}
+
+template <io::IoApi T>
+auto Loop<T>::write(io::Socket<T>& socket, std::span<char const> data)
+        -> Task<io::Result<std::size_t>>
+{
+    std::size_t sent = 0;
+    while (sent < data.size()) {
+        typename T::IoVec iov{};
+        iov.iov_base = const_cast<char*>(data.data() + sent);
+        iov.iov_len = data.size() - sent;
+        typename T::MsgHdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        auto const n = ioapi.sendmsg(socket.fd(), &msg,
+                                     detail::TASK_SEND_FLAGS);
+        if (n >= 0) {
+            sent += static_cast<std::size_t>(n);
+            continue;
+        }
+
+        int const err = ioapi.errnum();
+        io::Fault const fault = io::classify(err);
+        if (fault == io::Fault::RETRY) { continue; }
+        if (fault != io::Fault::AGAIN) {
+            co_return io::Result<std::size_t>::failure(err);
+        }
+        auto const ready = co_await readiness(socket.fd(), io::EV_OUT);
+        if (!ready) {
+            co_return io::Result<std::size_t>::failure(ready.error());
+        }
+    }
+    co_return sent;
+}
+
+template <io::IoApi T>
+auto Loop<T>::accept(io::Socket<T>& listener)
+        -> Task<io::Result<io::Socket<T>>>
+{
+    io::SockInfo<T> peer{};
+    for (;;) {
+        peer.addrlen = sizeof(peer.storage);
+        auto client = listener.try_accept(peer, detail::ACCEPT_FLAGS);
+        if (client) { co_return std::move(*client); }
+
+        io::Fault const fault = client.fault();
+        if (fault == io::Fault::RETRY || fault == io::Fault::DROP) {
+            continue;
+        }
+        if (fault != io::Fault::AGAIN) {
+            co_return io::Result<io::Socket<T>>::failure(client.error());
+        }
+        auto const ready = co_await readiness(listener.fd(), io::EV_IN);
+        if (!ready) {
+            co_return io::Result<io::Socket<T>>::failure(ready.error());
+        }
+    }
+}
+
+template <io::IoApi T>
+auto Loop<T>::wait(int fd, unsigned events, std::coroutine_handle<> task)
+        -> io::Result<>
+{
+    auto const i = static_cast<std::size_t>(fd);
+    if (i >= waiting.size()) { waiting.resize(i + 1); }
+    Waiting& w = waiting[i];
+    unsigned const before = w.interest();
+    (events == io::EV_IN ? w.reader : w.writer) = task;
+
+    auto const registered = (before == 0)
+            ? poller.try_add(fd, w.interest())
+            : poller.try_modify(fd, w.interest());
+    if (!registered) {
+        (events == io::EV_IN ? w.reader : w.writer) = {};
+    }
+    return registered;
+}
+
+template <io::IoApi T>
+auto Loop<T>::wake(int fd, unsigned events) -> bool
+{
+    auto const i = static_cast<std::size_t>(fd);
+    if (i >= waiting.size() || waiting[i].interest() == 0) { return false; }
+    Waiting& w = waiting[i];
+
+    /* an error or hangup wakes both, to find out from their next call */
+    unsigned const both = io::EV_ERR | io::EV_HUP;
+    if (w.reader && (events & (io::EV_IN | both))) {
+        runnable.push_back(std::exchange(w.reader, {}));
+    }
+    if (w.writer && (events & (io::EV_OUT | both))) {
+        runnable.push_back(std::exchange(w.writer, {}));
+    }
+    unsigned const rest = w.interest();
+    if (rest == 0) { (void) poller.try_remove(fd); }
+    else { (void) poller.try_modify(fd, rest); }
+    return true;
+}
+
+template <io::IoApi T>
+void Loop<T>::post(std::coroutine_handle<> task)
+{
+    {
+        std::lock_guard const guard{mailbox_lock};
+        mailbox.push_back(task);
+    }
+    posted.store(true, std::memory_order_release);
+    if (waker) { waker->notify(); }
+}
+
+template <io::IoApi T>
+auto Loop<T>::ticket() -> Ticket
+{
+    tickets.emplace(++slept, nullptr);
+    return slept;
+}
+
+template <io::IoApi T>
+void Loop<T>::cancel(Ticket ticket)
+{
+    auto const it = tickets.find(ticket);
+    if (it == tickets.end()) { return; }
+    if (it->second) { runnable.push_back(it->second); }
+    tickets.erase(it);
+}
+
+template <io::IoApi T>
+void Loop<T>::run()
+{
+    if (posted.exchange(false, std::memory_order_acquire)) {
+        std::lock_guard const guard{mailbox_lock};
+        runnable.insert(runnable.end(), mailbox.begin(), mailbox.end());
+        mailbox.clear();
+    }
+    auto const now = Clock::now();
+    while (!sleepers.empty()) {
+        Sleeper const & next = sleepers.top();
+        /* a cancelled sleeper is let go of as soon as it comes up */
+        bool const cancelled = next.ticketed
+                               && !tickets.contains(next.order);
+        if (!cancelled) {
+            if (next.until > now) { break; }
+            if (next.ticketed) { tickets[next.order] = {}; }
+            runnable.push_back(next.task);
+        }
+        sleepers.pop();
+    }
+    while (!runnable.empty()) {
+        batch.swap(runnable);
+        for (auto const task : batch) { task.resume(); }
+        batch.clear();
+    }
+}
+
+template <io::IoApi T>
+auto Loop<T>::poll_timeout() const -> int
+{
+    if (!runnable.empty() || posted.load(std::memory_order_acquire)) {
+        return 0;
+    }
+    if (sleepers.empty()) { return -1; }
+    auto const left = sleepers.top().until - Clock::now();
+    if (left <= Clock::duration::zero()) { return 0; }
+    /* rounded up, or the reactor would wake just before it is time */
+    return static_cast<int>(
+            std::chrono::ceil<std::chrono::milliseconds>(left).count());
+}
+
+}  // namespace alewa
@@ -0,0 +1,377 @@
+#include "test/test_utils.hpp"
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdexcept>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "loop.hpp"
+#include "reactor.hpp"
+#include "uring_reactor.hpp"
+#include "listener.hpp"
+#include "work_pool.hpp"
+#include "io/ring.hpp"
+#include "io/poller.hpp"
+#include "io/waker.hpp"
+#include "io/ioapi_sys.hpp"
+#include "io/sockapi_mock.hpp"
+
+namespace alewa::test {
+
+using io::test::MockIoApi;
+using io::test::MockEpollIoApi;
+
+namespace {
+
+template <io::IoApi T>
+auto echo(Loop<T>& loop, io::Socket<T>& client, std::string& seen) -> Task<>
+{
+    std::array<char, 16> buf;
+    auto const n = co_await loop.read(client, buf);
+    if (!n) { co_return; }
+    seen.assign(buf.data(), *n);
+    (void) co_await loop.write(client, {buf.data(), *n});
+}
+
+template <io::IoApi T>
+auto accept_and_echo(Loop<T>& loop, io::Socket<T>& listener,
+                     std::string& seen) -> Task<>
+{
+    auto client = co_await loop.accept(listener);
+    if (!client) { co_return; }
+    co_await echo(loop, *client, seen);
+}
+
+auto twice(Loop<MockIoApi>&, int x) -> Task<int> { co_return 2 * x; }
+
+auto fails(Loop<MockIoApi>&) -> Task<int>
+{
+    throw std::runtime_error{"boom"};
+    co_return 0;
+}
+
+auto caller(Loop<MockIoApi>& loop, int& out, std::string& error) -> Task<>
+{
+    out = co_await twice(loop, 21);
+    try {
+        co_await fails(loop);
+    }
+    catch (std::runtime_error const & e) {
+        error = e.what();
+    }
+}
+
+auto escapes(Loop<MockIoApi>& loop) -> Task<> { co_await fails(loop); }
+
+auto nap(Loop<MockIoApi>& loop, int ms, std::vector<int>& woken) -> Task<>
+{
+    co_await loop.sleep(std::chrono::milliseconds{ms});
+    woken.push_back(ms);
+}
+
+/* Sleeps an hour on `ticket`, unless cancelled, which it notes. */
+auto doze(Loop<MockIoApi>& loop, Loop<MockIoApi>::Ticket ticket,
+          bool& cut) -> Task<>
+{
+    bool const expired = co_await loop.sleep(std::chrono::hours{1}, ticket);
+    cut = !expired;
+}
+
+auto thread_id() -> std::thread::id { return std::this_thread::get_id(); }
+
+void throws() { throw std::runtime_error{"offloaded"}; }
+
+/* Offloads a call that reports the thread it ran on, then one that throws,
+ * and notes where the task itself resumed. */
+template <io::IoApi T>
+auto offloading(Loop<T>& loop, std::thread::id& worker,
+                std::thread::id& resumed, std::string& error) -> Task<>
+{
+    worker = co_await loop.offload(&thread_id);
+    resumed = std::this_thread::get_id();
+    try {
+        co_await loop.offload(&throws);
+    }
+    catch (std::runtime_error const & e) {
+        error = e.what();
+    }
+}
+
+template <io::IoApi T>
+void poll_once(io::Poller<T>& poller, Loop<T>& loop, int timeout)
+{
+    for (io::Event const & event : poller.wait(timeout)) {
+        loop.wake(event.fd, event.events);
+    }
+    loop.run();
+}
+
+}  // namespace
+
+ALW_TEST(loop_task_suspends_until_readable)
+{
+    MockIoApi api;
+    io::Poller<MockIoApi> poller{api};
+    Loop<MockIoApi> loop{api, poller};
+    auto client = io::Socket<MockIoApi>::adopt(api, 7);
+    std::string seen;
+
+    loop.spawn(echo(loop, client, seen));
+    ALW_EXPECT_EQ(loop.poll_timeout(), 0);
+    loop.run();  /* nothing to read yet */
+    ALW_EXPECT_EQ(loop.size(), 1ul);
+    ALW_EXPECT_EQ(loop.poll_timeout(), -1);
+    ALW_EXPECT_EQ(loop.wake(8, io::EV_IN), false);  /* not ours */
+
+    api.inbox[7] = "hello";
+    api.ready[7] = io::EV_IN;
+    poll_once(poller, loop, 0);
+    ALW_EXPECT_EQ(seen, "hello");
+    ALW_EXPECT_EQ(api.writes[7], (std::vector<std::string>{"hello"}));
+    ALW_EXPECT_EQ(loop.size(), 0ul);
+    ALW_EXPECT_EQ(loop.wake(7, io::EV_IN), false);  /* dropped from poller */
+
+    /* the frames of a finished request are reused by the next */
+    auto const misses = loop.frames().stats().misses;
+    api.inbox[7] = "again";
+    loop.spawn(echo(loop, client, seen));
+    loop.run();
+    ALW_EXPECT_EQ(seen, "again");
+    ALW_EXPECT_EQ(loop.frames().stats().misses, misses);
+    ALW_EXPECT_EQ(loop.frames().stats().in_use, 0ul);
+}
+
+ALW_TEST(loop_awaited_task_returns_value_and_rethrows)
+{
+    MockIoApi api;
+    io::Poller<MockIoApi> poller{api};
+    Loop<MockIoApi> loop{api, poller};
+    int out = 0;
+    std::string error;
+
+    loop.spawn(caller(loop, out, error));
+    loop.spawn(escapes(loop));
+    loop.run();
+    ALW_EXPECT_EQ(out, 42);
+    ALW_EXPECT_EQ(error, "boom");
+    ALW_EXPECT_EQ(loop.size(), 0ul);
+    ALW_EXPECT_EQ(loop.failed(), 1ul);  /* only the one it escaped */
+}
+
+ALW_TEST(loop_sleepers_wake_in_deadline_order)
+{
+    MockIoApi api;
+    io::Poller<MockIoApi> poller{api};
+    Loop<MockIoApi> loop{api, poller};
+    std::vector<int> woken;
+
+    loop.spawn(nap(loop, 2, woken));
+    loop.spawn(nap(loop, 0, woken));
+    loop.spawn(nap(loop, 1, woken));
+    loop.run();
+    ALW_EXPECT_EQ(woken, (std::vector<int>{0}));
+    ALW_EXPECT_EQ(loop.poll_timeout() >= 0 && loop.poll_timeout() <= 1,
+                  true);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds{3});
+    loop.run();
+    ALW_EXPECT_EQ(woken, (std::vector<int>{0, 1, 2}));
+    ALW_EXPECT_EQ(loop.poll_timeout(), -1);
+}
+
+/* A cancelled sleep ends on the next run(), and the loop no longer waits
+ * for its time. */
+ALW_TEST(loop_sleep_cancelled_by_ticket)
+{
+    MockIoApi api;
+    io::Poller<MockIoApi> poller{api};
+    Loop<MockIoApi> loop{api, poller};
+    bool cut = false;
+    bool kept = false;
+
+    auto const ticket = loop.ticket();
+    loop.spawn(doze(loop, ticket, cut));
+    loop.spawn(doze(loop, loop.ticket(), kept));
+    loop.run();
+    ALW_EXPECT_EQ(loop.size(), 2ul);
+    ALW_EXPECT_EQ(loop.poll_timeout() > 0, true);
+
+    loop.cancel(ticket);
+    ALW_EXPECT_EQ(loop.poll_timeout(), 0);
+    loop.run();
+    ALW_EXPECT_EQ(cut, true);
+    ALW_EXPECT_EQ(kept, false);
+    ALW_EXPECT_EQ(loop.size(), 1ul);
+    loop.cancel(ticket);  /* spent */
+    loop.run();
+    ALW_EXPECT_EQ(loop.size(), 1ul);
+
+    /* cancelled before the sleep begins, it never does */
+    bool early = false;
+    auto const skipped = loop.ticket();
+    loop.cancel(skipped);
+    loop.spawn(doze(loop, skipped, early));
+    loop.run();
+    ALW_EXPECT_EQ(early, true);
+    ALW_EXPECT_EQ(loop.size(), 1ul);
+}
+
+ALW_TEST(loop_suspended_tasks_destroyed_with_loop)
+{
+    MockIoApi api;
+    io::Poller<MockIoApi> poller{api};
+    auto client = io::Socket<MockIoApi>::adopt(api, 7);
+    std::string seen;
+    {
+        Loop<MockIoApi> loop{api, poller};
+        loop.spawn(echo(loop, client, seen));
+        loop.run();
+        ALW_EXPECT_EQ(loop.frames().stats().in_use, 2ul);  /* echo, read */
+    }
+    /* and the fd it waited on is no longer polled */
+    api.ready[7] = io::EV_IN;
+    ALW_EXPECT_EQ(poller.wait(0).size(), 0ul);
+}
+
+ALW_TEST(loop_offload_runs_inline_without_pool)
+{
+    MockIoApi api;
+    io::Poller<MockIoApi> poller{api};
+    Loop<MockIoApi> loop{api, poller};
+    std::thread::id worker;
+    std::thread::id resumed;
+    std::string error;
+
+    loop.spawn(offloading(loop, worker, resumed, error));
+    loop.run();
+    ALW_EXPECT_EQ(worker == std::this_thread::get_id(), true);
+    ALW_EXPECT_EQ(error, "offloaded");
+    ALW_EXPECT_EQ(loop.size(), 0ul);
+}
+
+ALW_TEST(loop_offload_posts_task_back_through_waker)
+{
+    io::SysIoApi api;
+    io::Poller<io::SysIoApi> poller{api};
+    io::Waker<io::SysIoApi> waker{api};
+    poller.add(waker.fd(), io::EV_IN);
+    Loop<io::SysIoApi> loop{api, poller, &waker};
+    WorkPool pool{2, 16};
+    loop.attach(pool);
+    std::thread::id worker;
+    std::thread::id resumed;
+    std::string error;
+
+    loop.spawn(offloading(loop, worker, resumed, error));
+    loop.run();  /* submits the first call and suspends */
+    for (int i = 0; i < 100 && loop.size() > 0; ++i) {
+        /* blocks until a worker posts the task back and notifies */
+        for (io::Event const & event : poller.wait(loop.poll_timeout())) {
+            if (event.fd == waker.fd()) { waker.drain(); }
+        }
+        loop.run();
+    }
+    ALW_EXPECT_EQ(loop.size(), 0ul);
+    ALW_EXPECT_EQ(worker != std::this_thread::get_id(), true);
+    ALW_EXPECT_EQ(resumed == std::this_thread::get_id(), true);
+    ALW_EXPECT_EQ(error, "offloaded");
+    ALW_EXPECT_EQ(pool.stats().submitted, 2ul);
+}
+
+ALW_TEST(loop_runs_on_reactor_poller)
+{
+    MockEpollIoApi api;
+    ServerConfig config;
+    auto client = io::Socket<MockEpollIoApi>::adopt(api, 7);
+    std::string seen;
+    Reactor<MockEpollIoApi> reactor{api, config, {}};
+
+    Loop<MockEpollIoApi>& loop = reactor.loop();
+    loop.spawn(echo(loop, client, seen));
+    reactor.run_once();
+    ALW_EXPECT_EQ(api.last_timeout, 0);  /* the task had yet to start */
+    ALW_EXPECT_EQ(api.interest().at(7), io::EV_IN);
+
+    api.inbox[7] = "ping";
+    api.ready[7] = io::EV_IN;
+    reactor.run_once();
+    ALW_EXPECT_EQ(api.writes[7], (std::vector<std::string>{"ping"}));
+    ALW_EXPECT_EQ(api.interest().contains(7), false);
+}
+
+ALW_TEST(loop_serves_real_socket)
+{
+    io::SysIoApi api;
+    io::Poller<io::SysIoApi> poller{api};
+    Loop<io::SysIoApi> loop{api, poller};
+    std::string const name = "@alewa-loop-" + std::to_string(::getpid());
+    auto listener = create_unix_listener(api, name);
+    listener.listen(4);
+    std::string seen;
+
+    loop.spawn(accept_and_echo(loop, listener, seen));
+    loop.run();  /* waits for a client */
+
+    detail::UnixAddr addr{};
+    std::size_t const len = detail::unix_address(name, addr);
+    int const client = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    int const connected = ::connect(
+            client, reinterpret_cast<::sockaddr const *>(&addr),
+            static_cast<::socklen_t>(len));
+    ALW_EXPECT_EQ(::write(client, "ping", 4), 4l);
+    for (int i = 0; i < 100 && loop.size() > 0; ++i) {
+        poll_once(poller, loop, 100);
+    }
+
+    std::array<char, 8> reply{};
+    auto const n = ::read(client, reply.data(), reply.size());
+    ::close(client);
+    ALW_EXPECT_EQ(connected, 0);
+    ALW_EXPECT_EQ(seen, "ping");
+    ALW_EXPECT_EQ(std::string(reply.data(), static_cast<std::size_t>(n)),
+                  "ping");
+}
+
+/* Passes trivially where io_uring is unavailable. */
+ALW_TEST(loop_runs_on_uring_reactor)
+{
+    io::IoUringIoApi api;
+    if (!io::uring_supported(api)) { return; }
+    ServerConfig config;
+    config.uring_entries = 64;
+    config.uring_buffers = 64;
+    UringReactor<io::IoUringIoApi> reactor{api, config, {}};
+    std::string const name = "@alewa-uring-loop-" + std::to_string(::getpid());
+    auto listener = create_unix_listener(api, name);
+    listener.listen(4);
+    std::string seen;
+
+    Loop<io::IoUringIoApi>& loop = reactor.loop();
+    loop.spawn(accept_and_echo(loop, listener, seen));
+    reactor.run_once();  /* waits for a client */
+
+    detail::UnixAddr addr{};
+    std::size_t const len = detail::unix_address(name, addr);
+    int const client = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    int const connected = ::connect(
+            client, reinterpret_cast<::sockaddr const *>(&addr),
+            static_cast<::socklen_t>(len));
+    ALW_EXPECT_EQ(::write(client, "pong", 4), 4l);
+    for (int turn = 0; turn < 100 && loop.size() > 0; ++turn) {
+        reactor.run_once();
+    }
+
+    std::array<char, 8> reply{};
+    auto const n = ::read(client, reply.data(), reply.size());
+    ::close(client);
+    ALW_EXPECT_EQ(connected, 0);
+    ALW_EXPECT_EQ(seen, "pong");
+    ALW_EXPECT_EQ(std::string(reply.data(), static_cast<std::size_t>(n)),
+                  "pong");
+}
+
+}  // namespace alewa::test
@@ -0,0 +1,166 @@
+#include "metrics.hpp"
+
+namespace alewa {
+
+namespace {
+
+using Counter = std::atomic<std::uint64_t>;
+
+void add(Counter& counter, std::uint64_t n)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + n,
+                  std::memory_order_relaxed);
+}
+
+auto get(Counter const & counter) -> std::uint64_t
+{
+    return counter.load(std::memory_order_relaxed);
+}
+
+template <typename Buckets>
+void fold(Histogram& into, Buckets const & buckets)
+{
+    for (std::size_t i = 0; i < buckets.size(); ++i) {
+        into.record(Histogram::upper_bound(i), get(buckets[i]));
+    }
+}
+
+}  // namespace
+
+auto syscall_name(Syscall call) -> std::string_view
+{
+    switch (call) {
+    case Syscall::POLL: return "poll";
+    case Syscall::EPOLL_WAIT: return "epoll_wait";
+    case Syscall::URING_ENTER: return "io_uring_enter";
+    case Syscall::ACCEPT: return "accept";
+    case Syscall::READ: return "read";
+    case Syscall::WRITE: return "write";
+    case Syscall::SENDFILE: return "sendfile";
+    case Syscall::CLOSE: return "close";
+    case Syscall::EPOLL_CTL: return "epoll_ctl";
+    case Syscall::OPEN: return "open";
+    case Syscall::STAT: return "stat";
+    case Syscall::PREAD: return "pread";
+    case Syscall::COUNT: break;
+    }
+    return "unknown";
+}
+
+/* A wakeup closes the accept batch begun after the previous one. nready is
+ * negative where the backend does not say how many fds are ready. */
+void Metrics::Local::wakeup(int nready)
+{
+    add(wakeups, 1);
+    if (nready >= 0) {
+        auto const n = static_cast<std::uint64_t>(nready);
+        add(ready, n);
+        add(ready_per_wakeup[Histogram::index(n)], 1);
+    }
+    if (batch > 0) {
+        add(accepts_per_batch[Histogram::index(batch)], 1);
+        batch = 0;
+    }
+}
+
+void Metrics::Local::accepted(int fd)
+{
+    add(accepts, 1);
+    ++batch;
+    auto const i = static_cast<std::size_t>(fd);
+    if (i >= sockets.size()) { sockets.resize(i + 1); }
+    sockets[i] = true;
+}
+
+void Metrics::Local::closed(int fd)
+{
+    if (!is_socket(fd)) { return; }
+    sockets[static_cast<std::size_t>(fd)] = false;
+    add(closes, 1);
+}
+
+/* A socket this thread accepted goes to another, e.g. through a Dispatch.
+ * True if it was counted here, in which case the other thread adopts it
+ * and counts its bytes and its close from then on. */
+auto Metrics::Local::released(int fd) -> bool
+{
+    if (!is_socket(fd)) { return false; }
+    sockets[static_cast<std::size_t>(fd)] = false;
+    return true;
+}
+
+void Metrics::Local::adopted(int fd)
+{
+    auto const i = static_cast<std::size_t>(fd);
+    if (i >= sockets.size()) { sockets.resize(i + 1); }
+    sockets[i] = true;
+}
+
+void Metrics::Local::received(int fd, long n)
+{
+    if (n > 0 && is_socket(fd)) {
+        add(bytes_in, static_cast<std::uint64_t>(n));
+    }
+}
+
+void Metrics::Local::sent(int fd, long n)
+{
+    if (n > 0 && is_socket(fd)) {
+        add(bytes_out, static_cast<std::uint64_t>(n));
+    }
+}
+
+void Metrics::Local::timed(Syscall call, std::uint64_t ns, bool failed)
+{
+    Calls& c = syscalls[static_cast<std::size_t>(call)];
+    add(c.calls, 1);
+    if (failed) { add(c.errors, 1); }
+    add(c.ns, ns);
+    add(c.latency[Histogram::index(ns)], 1);
+}
+
+/* A thread that alternates between instances finds its block again by
+ * owner; the cache only remembers the last one. */
+auto Metrics::attach() const -> Local&
+{
+    std::lock_guard const lock{mutex};
+    auto const self = std::this_thread::get_id();
+    Local* found = nullptr;
+    for (auto const & local : locals) {
+        if (local->owner == self) { found = local.get(); }
+    }
+    if (!found) {
+        locals.push_back(std::make_unique<Local>());
+        found = locals.back().get();
+        found->owner = self;
+    }
+    cache = {id, found};
+    return *found;
+}
+
+auto Metrics::scrape() const -> MetricsSnapshot
+{
+    MetricsSnapshot s;
+    std::lock_guard const lock{mutex};
+    for (auto const & local : locals) {
+        s.wakeups += get(local->wakeups);
+        s.ready += get(local->ready);
+        s.accepts += get(local->accepts);
+        s.closes += get(local->closes);
+        s.bytes_in += get(local->bytes_in);
+        s.bytes_out += get(local->bytes_out);
+        fold(s.ready_per_wakeup, local->ready_per_wakeup);
+        fold(s.accepts_per_batch, local->accepts_per_batch);
+        for (std::size_t i = 0; i < s.syscalls.size(); ++i) {
+            auto const & from = local->syscalls[i];
+            auto& to = s.syscalls[i];
+            to.calls += get(from.calls);
+            to.errors += get(from.errors);
+            to.ns += get(from.ns);
+            fold(to.latency, from.latency);
+        }
+    }
+    return s;
+}
+
+}  // namespace alewa
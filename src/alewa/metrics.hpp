@@ -0,0 +1,138 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+
+#include "histogram.hpp"
+
+namespace alewa {
+
+/* The calls timed by an instrumented IoApi; see io/instrumented_ioapi.hpp. */
+enum class Syscall
+{
+    POLL, EPOLL_WAIT, URING_ENTER, ACCEPT, READ, WRITE, SENDFILE, CLOSE,
+    EPOLL_CTL, OPEN, STAT, PREAD, COUNT
+};
+
+auto syscall_name(Syscall call) -> std::string_view;
+
+/* Everything recorded so far, summed over the threads. */
+struct MetricsSnapshot
+{
+    struct Calls
+    {
+        std::uint64_t calls = 0;
+        std::uint64_t errors = 0;
+        std::uint64_t ns = 0;  /* total time spent in the call */
+        Histogram latency{};  /* ns per call, to bucket precision */
+    };
+
+    std::uint64_t wakeups = 0;  /* waits that returned */
+    std::uint64_t ready = 0;  /* fds reported ready, over all wakeups */
+    std::uint64_t accepts = 0;
+    std::uint64_t closes = 0;  /* of accepted sockets */
+    std::uint64_t bytes_in = 0;  /* read from accepted sockets */
+    std::uint64_t bytes_out = 0;  /* written to them */
+    Histogram ready_per_wakeup{};
+    Histogram accepts_per_batch{};  /* per wakeup that accepted any */
+    std::array<Calls, static_cast<std::size_t>(Syscall::COUNT)> syscalls{};
+
+    [[nodiscard]] auto active() const noexcept -> std::uint64_t
+    {
+        return accepts - closes;
+    }
+};
+
+/* Counters and latency histograms that each thread updates in a block of
+ * its own, cache-line aligned so that reactors never share a line, with
+ * plain relaxed stores rather than read-modify-writes since no other thread
+ * writes the block. scrape() sums the blocks; it may run concurrently with
+ * the writers and sees each counter either before or after an update. */
+class Metrics
+{
+private:
+    using Counter = std::atomic<std::uint64_t>;
+    using Buckets = std::array<Counter, Histogram::BUCKETS>;
+
+    struct Calls
+    {
+        Counter calls{0};
+        Counter errors{0};
+        Counter ns{0};
+        Buckets latency{};
+    };
+
+public:
+    struct alignas(64) Local
+    {
+        std::thread::id owner;
+
+        Counter wakeups{0};
+        Counter ready{0};
+        Counter accepts{0};
+        Counter closes{0};
+        Counter bytes_in{0};
+        Counter bytes_out{0};
+        Buckets ready_per_wakeup{};
+        Buckets accepts_per_batch{};
+        std::array<Calls, static_cast<std::size_t>(Syscall::COUNT)> syscalls{};
+
+        /* owner only */
+        std::uint64_t batch = 0;  /* accepted since the last wakeup */
+        std::vector<bool> sockets{};  /* accepted and not yet closed, by fd */
+
+        void wakeup(int nready);
+        void accepted(int fd);
+        void closed(int fd);
+        auto released(int fd) -> bool;
+        void adopted(int fd);
+        void received(int fd, long n);
+        void sent(int fd, long n);
+        void timed(Syscall call, std::uint64_t ns, bool failed);
+
+        [[nodiscard]] auto is_socket(int fd) const -> bool
+        {
+            auto const i = static_cast<std::size_t>(fd);
+            return fd >= 0 && i < sockets.size() && sockets[i];
+        }
+    };
+
+private:
+    struct Cache
+    {
+        std::uint64_t id;
+        Local* local;
+    };
+
+    inline static std::atomic<std::uint64_t> next_id{1};
+    inline static thread_local Cache cache{0, nullptr};
+
+    std::uint64_t const id = next_id.fetch_add(1);
+    mutable std::mutex mutex;
+    mutable std::vector<std::unique_ptr<Local>> locals;
+
+public:
+    Metrics() = default;
+    Metrics(Metrics&) = delete;
+    Metrics& operator=(Metrics&) = delete;
+
+    /* The calling thread's block, created on first use. */
+    auto local() const -> Local&
+    {
+        if (cache.id == id) { return *cache.local; }
+        return attach();
+    }
+
+    [[nodiscard]] auto scrape() const -> MetricsSnapshot;
+
+private:
+    auto attach() const -> Local&;
+};
+
+}  // namespace alewa
@@ -0,0 +1 @@
+#include "mpmc_queue.hpp"
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <bit>
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+
+namespace alewa {
+
+/* A bounded multi-producer multi-consumer queue, with no locks and no
+ * allocation after construction. Each slot carries a sequence number that
+ * says whose turn it is: a producer claims the slot at the tail when its
+ * sequence equals the tail's position and publishes it by advancing the
+ * sequence one, and a consumer claims the slot at the head one lap behind
+ * and hands it back to producers a lap ahead. Head and tail sit on cache
+ * lines of their own. Capacity is rounded up to a power of 2. */
+template <typename V>
+    requires std::is_trivially_copyable_v<V>
+class MpmcQueue
+{
+private:
+    struct Slot
+    {
+        std::atomic<std::size_t> sequence{0};
+        V value{};
+    };
+
+    struct alignas(64) Index
+    {
+        std::atomic<std::size_t> value{0};
+    };
+
+    std::size_t mask;
+    std::unique_ptr<Slot[]> slots;
+    Index head;  /* next to pop */
+    Index tail;  /* next to push */
+
+public:
+    explicit MpmcQueue(std::size_t capacity)
+            : mask(std::bit_ceil(std::max<std::size_t>(capacity, 1)) - 1),
+              slots(std::make_unique<Slot[]>(mask + 1))
+    {
+        for (std::size_t i = 0; i <= mask; ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpmcQueue(MpmcQueue&) = delete;
+    MpmcQueue& operator=(MpmcQueue&) = delete;
+
+    [[nodiscard]]
+    auto capacity() const noexcept -> std::size_t { return mask + 1; }
+
+    /* Any thread. False if the queue is full. */
+    auto push(V value) noexcept -> bool
+    {
+        std::size_t pos = tail.value.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots[pos & mask];
+            std::size_t const seq =
+                    slot.sequence.load(std::memory_order_acquire);
+            if (seq == pos) {
+                if (tail.value.compare_exchange_weak(
+                            pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.value = value;
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            /* still holding last lap's value: full */
+            else if (seq < pos) { return false; }
+            else { pos = tail.value.load(std::memory_order_relaxed); }
+        }
+    }
+
+    /* Any thread. False if the queue is empty. */
+    auto pop(V& value) noexcept -> bool
+    {
+        std::size_t pos = head.value.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots[pos & mask];
+            std::size_t const seq =
+                    slot.sequence.load(std::memory_order_acquire);
+            if (seq == pos + 1) {
+                if (head.value.compare_exchange_weak(
+                            pos, pos + 1, std::memory_order_relaxed)) {
+                    value = slot.value;
+                    slot.sequence.store(pos + mask + 1,
+                                        std::memory_order_release);
+                    return true;
+                }
+            }
+            /* not yet published for this lap: empty */
+            else if (seq < pos + 1) { return false; }
+            else { pos = head.value.load(std::memory_order_relaxed); }
+        }
+    }
+
+    /* A snapshot, which may be stale by the time it is used. */
+    [[nodiscard]]
+    auto size() const noexcept -> std::size_t
+    {
+        std::size_t const h = head.value.load(std::memory_order_acquire);
+        std::size_t const t = tail.value.load(std::memory_order_acquire);
+        return (t > h) ? t - h : 0;
+    }
+};
+
+}  // namespace alewa
@@ -0,0 +1,74 @@
+#include "test/test_utils.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "mpmc_queue.hpp"
+
+namespace alewa::test {
+
+ALW_TEST(mpmc_queue_fifo_until_full)
+{
+    MpmcQueue<int> queue{3};  /* rounded up to 4 */
+    ALW_EXPECT_EQ(queue.capacity(), 4ul);
+
+    int value = 0;
+    ALW_EXPECT_EQ(queue.pop(value), false);
+    for (int i = 1; i <= 4; ++i) { ALW_EXPECT_EQ(queue.push(i), true); }
+    ALW_EXPECT_EQ(queue.push(5), false);
+    ALW_EXPECT_EQ(queue.size(), 4ul);
+
+    /* the indices wrap around the slots many times over */
+    for (int i = 5; i < 100; ++i) {
+        ALW_EXPECT_EQ(queue.pop(value), true);
+        ALW_EXPECT_EQ(value, i - 4);
+        ALW_EXPECT_EQ(queue.push(i), true);
+    }
+    for (int i = 96; i < 100; ++i) {
+        ALW_EXPECT_EQ(queue.pop(value), true);
+        ALW_EXPECT_EQ(value, i);
+    }
+    ALW_EXPECT_EQ(queue.pop(value), false);
+    ALW_EXPECT_EQ(queue.size(), 0ul);
+}
+
+ALW_TEST(mpmc_queue_every_item_taken_once)
+{
+    MpmcQueue<std::uint32_t> queue{64};
+    std::uint32_t const per_producer = 50'000;
+    std::atomic<std::uint32_t> taken{0};
+    std::atomic<std::uint64_t> sum{0};
+
+    std::vector<std::thread> threads;
+    for (std::uint32_t p = 0; p < 2; ++p) {
+        threads.emplace_back([&, p] {
+            for (std::uint32_t i = 1; i <= per_producer;) {
+                if (queue.push(p * per_producer + i)) { ++i; }
+                else { std::this_thread::yield(); }
+            }
+        });
+    }
+    for (int c = 0; c < 2; ++c) {
+        threads.emplace_back([&] {
+            std::uint32_t value;
+            while (taken.load() < 2 * per_producer) {
+                if (queue.pop(value)) {
+                    sum.fetch_add(value);
+                    taken.fetch_add(1);
+                }
+                else { std::this_thread::yield(); }
+            }
+        });
+    }
+    for (auto& thread : threads) { thread.join(); }
+
+    std::uint64_t const n = 2 * per_producer;
+    ALW_EXPECT_EQ(taken.load(), 2 * per_producer);
+    ALW_EXPECT_EQ(sum.load(), n * (n + 1) / 2);
+    ALW_EXPECT_EQ(queue.size(), 0ul);
+}
+
+}  // namespace alewa::test
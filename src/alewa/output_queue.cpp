@@ -0,0 +1,50 @@
+#include "output_queue.hpp"
+
+#include <cassert>
+
+namespace alewa {
+
+auto OutputQueue::push(std::string_view data) noexcept -> bool
+{
+    if (count == MAX_SEGMENTS) { return false; }
+    if (data.empty()) { return true; }
+    segments[count++] = {data.data(), data.size(), -1, 0};
+    pending += data.size();
+    return true;
+}
+
+auto OutputQueue::push_file(int fd, std::size_t offset, std::size_t size)
+        noexcept -> bool
+{
+    if (count == MAX_SEGMENTS) { return false; }
+    if (size == 0) { return true; }
+    segments[count++] = {nullptr, size, fd, offset};
+    pending += size;
+    return true;
+}
+
+void OutputQueue::consume(std::size_t n) noexcept
+{
+    assert(n <= pending);
+    pending -= n;
+    if (pending == 0) {
+        first = count = offset = 0;
+        return;
+    }
+
+    n += offset;
+    while (n >= segments[first].size) {
+        n -= segments[first].size;
+        ++first;
+    }
+    offset = n;
+}
+
+auto OutputQueue::front_file() const noexcept -> std::optional<FileRange>
+{
+    if (empty() || segments[first].data != nullptr) { return std::nullopt; }
+    Segment const & s = segments[first];
+    return FileRange{s.fd, s.file_offset + offset, s.size - offset};
+}
+
+}  // namespace alewa
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <span>
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+namespace alewa {
+
+/* Bytes waiting to go out on a connection, kept as a list of references to
+ * memory owned elsewhere (formatted response heads, bodies) or to ranges of
+ * open files, so that a batch of responses is sent with one gathering write
+ * per run of memory segments and one sendfile per file range, and nothing is
+ * copied. After a partial write the queue resumes from the exact byte the
+ * socket stopped at. Segments are only reclaimed once the queue is empty. */
+class OutputQueue
+{
+public:
+    static constexpr std::size_t MAX_SEGMENTS = 64;
+
+    struct FileRange
+    {
+        int fd;
+        std::size_t offset;
+        std::size_t size;
+    };
+
+private:
+    struct Segment
+    {
+        char const * data;  /* nullptr for a file range */
+        std::size_t size;
+        int fd;
+        std::size_t file_offset;
+    };
+
+    std::array<Segment, MAX_SEGMENTS> segments{};
+    std::size_t first = 0;   /* segments before this are fully sent */
+    std::size_t count = 0;
+    std::size_t offset = 0;  /* bytes of segments[first] already sent */
+    std::size_t pending = 0;
+
+public:
+    /* False, queueing nothing, if there is no free segment. Empty data is
+     * accepted and ignored. */
+    auto push(std::string_view data) noexcept -> bool;
+    auto push_file(int fd, std::size_t offset, std::size_t size) noexcept
+            -> bool;
+
+    /* Drop the first n pending bytes, as reported sent by the socket. */
+    void consume(std::size_t n) noexcept;
+
+    [[nodiscard]]
+    auto empty() const noexcept -> bool { return pending == 0; }
+
+    [[nodiscard]]
+    auto size() const noexcept -> std::size_t { return pending; }
+
+    /* Segments that can still be pushed. */
+    [[nodiscard]]
+    auto space() const noexcept -> std::size_t { return MAX_SEGMENTS - count; }
+
+    /* The rest of the file range at the front, if the next bytes to send
+     * come from a file. */
+    [[nodiscard]]
+    auto front_file() const noexcept -> std::optional<FileRange>;
+
+    /* Describe the pending bytes up to the next file range, in order, as up
+     * to iov.size() IoVecs (struct iovec or a look-alike). Returns the
+     * number filled in. */
+    template <typename IoVec>
+    auto gather(std::span<IoVec> iov) const noexcept -> std::size_t;
+};
+
+template <typename IoVec>
+auto OutputQueue::gather(std::span<IoVec> iov) const noexcept -> std::size_t
+{
+    std::size_t n = 0;
+    for (std::size_t i = first; i < count && n < iov.size(); ++i) {
+        Segment const & s = segments[i];
+        if (s.data == nullptr) { break; }
+        std::size_t const skip = (i == first) ? offset : 0;
+        iov[n].iov_base = const_cast<char*>(s.data + skip);
+        iov[n].iov_len = s.size - skip;
+        ++n;
+    }
+    return n;
+}
+
+}  // namespace alewa
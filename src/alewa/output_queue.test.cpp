@@ -0,0 +1,92 @@
+#include "test/test_utils.hpp"
+
+#include <string>
+
+#include "output_queue.hpp"
+
+namespace alewa::test {
+
+namespace {
+
+struct Vec
+{
+    void* iov_base;
+    std::size_t iov_len;
+};
+
+/* What a gathering write of the whole queue would send. */
+auto pending(OutputQueue const & queue) -> std::string
+{
+    std::array<Vec, OutputQueue::MAX_SEGMENTS> iov;
+    std::size_t const n = queue.gather(std::span<Vec>{iov});
+    std::string s;
+    for (std::size_t i = 0; i < n; ++i) {
+        s.append(static_cast<char const *>(iov[i].iov_base), iov[i].iov_len);
+    }
+    return s;
+}
+
+}  // namespace
+
+ALW_TEST(output_queue_resumes_after_partial_writes)
+{
+    OutputQueue queue;
+    ALW_EXPECT_EQ(queue.push("head1|"), true);
+    ALW_EXPECT_EQ(queue.push(""), true);
+    ALW_EXPECT_EQ(queue.push("body1|"), true);
+    ALW_EXPECT_EQ(queue.push("head2|"), true);
+    ALW_EXPECT_EQ(queue.size(), 18ul);
+    ALW_EXPECT_EQ(queue.space(), OutputQueue::MAX_SEGMENTS - 3);
+
+    queue.consume(3);
+    ALW_EXPECT_EQ(pending(queue), "d1|body1|head2|");
+    queue.consume(3);  /* exactly the end of a segment */
+    ALW_EXPECT_EQ(pending(queue), "body1|head2|");
+    queue.consume(10);
+    ALW_EXPECT_EQ(pending(queue), "2|");
+
+    queue.consume(2);
+    ALW_EXPECT_EQ(queue.empty(), true);
+    ALW_EXPECT_EQ(queue.space(), OutputQueue::MAX_SEGMENTS);
+    ALW_EXPECT_EQ(pending(queue), "");
+}
+
+ALW_TEST(output_queue_file_ranges)
+{
+    OutputQueue queue;
+    queue.push("head|");
+    queue.push_file(9, 100, 50);
+    queue.push("next|");
+    ALW_EXPECT_EQ(queue.size(), 60ul);
+    ALW_EXPECT_EQ(queue.front_file().has_value(), false);
+    ALW_EXPECT_EQ(pending(queue), "head|");  /* gathering stops at a file */
+
+    queue.consume(7);
+    auto range = queue.front_file();
+    ALW_EXPECT_EQ(range.has_value(), true);
+    ALW_EXPECT_EQ(range->fd, 9);
+    ALW_EXPECT_EQ(range->offset, 102ul);
+    ALW_EXPECT_EQ(range->size, 48ul);
+
+    queue.consume(48);
+    ALW_EXPECT_EQ(queue.front_file().has_value(), false);
+    ALW_EXPECT_EQ(pending(queue), "next|");
+}
+
+ALW_TEST(output_queue_full)
+{
+    OutputQueue queue;
+    for (std::size_t i = 0; i < OutputQueue::MAX_SEGMENTS; ++i) {
+        ALW_EXPECT_EQ(queue.push("x"), true);
+    }
+    ALW_EXPECT_EQ(queue.push("y"), false);
+    ALW_EXPECT_EQ(queue.size(), OutputQueue::MAX_SEGMENTS);
+
+    /* segments come back only once everything is sent */
+    queue.consume(1);
+    ALW_EXPECT_EQ(queue.space(), 0ul);
+    queue.consume(OutputQueue::MAX_SEGMENTS - 1);
+    ALW_EXPECT_EQ(queue.push("y"), true);
+}
+
+}  // namespace alewa::test
@@ -0,0 +1 @@
+#include "reactor.hpp"
@@ -0,0 +1,485 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+#include "io/socket.hpp"
+#include "io/ioapi.hpp"
+#include "io/poller.hpp"
+#include "io/result.hpp"
+#include "io/waker.hpp"
+#include "config.hpp"
+#include "admission.hpp"
+#include "listener.hpp"
+#include "registry.hpp"
+#include "service.hpp"
+#include "exporter.hpp"
+#include "handoff.hpp"
+#include "loop.hpp"
+#include "dispatch.hpp"
+#include "response_cache.hpp"
+#include "buffer_pool.hpp"
+#include "connection.hpp"
+#include "deadlines.hpp"
+
+namespace alewa {
+
+/* One event loop: a listener, the clients it accepted, their deadlines and a
+ * waker to interrupt it. A reactor is driven by exactly one thread and shares
+ * no mutable state with other reactors; only stop() and drain() may be
+ * called from elsewhere. Its main listener and Unix socket are dropped from
+ * the poller while admission control pauses accepting; the admin listener
+ * never is. Given an admin listener it serves the exporter's page to the
+ * clients accepted there, given a handoff socket it answers successors on
+ * it, and given stats it publishes its own there. Given a dispatch, it hands
+ * the clients it accepts to the least loaded reactor and takes those handed
+ * to it when its waker fires; the dispatch is the one state it shares. Tasks
+ * spawned on its loop() run on its thread, waiting on the same poller.
+ * Errors that concern one client cost only that client and are handled
+ * without throwing; what does throw is fatal. */
+template <io::IoApi T>
+class Reactor
+{
+private:
+    T const & ioapi;
+    ServerConfig const & config;
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> draining{false};
+    bool accepting = true;
+    bool listening = true;  /* the main and Unix listeners are polled */
+
+    io::Poller<T> poller;
+    io::Waker<T> waker;
+    BufferPool buffers;  /* outlives the connections borrowing from it */
+    Registry<T> registry;
+    Deadlines deadlines;
+    Loop<T> tasks;
+    Service<T> service;
+    Listeners<T> listeners;
+    /* called once accepting stops, with their contexts */
+    std::vector<std::pair<void (*)(void*) noexcept, void*>> drain_hooks;
+    Admission<T> admission;
+    ReactorStats* stats;
+
+public:
+    Reactor(T const & ioapi, ServerConfig const & config,
+            Listeners<T> listeners, ResponseCache* responses = nullptr,
+            ReactorStats* stats = nullptr,
+            Exporter const * exporter = nullptr,
+            Compressor* compressor = nullptr);
+
+    Reactor(Reactor&) = delete;
+    Reactor& operator=(Reactor&) = delete;
+
+    /* Serve until stop() is called, or until drain() has been and the last
+     * client is gone, those of tasks holding loop() included. */
+    void run();
+
+    /* Wait for readiness once, handle everything reported, expire timers. */
+    void run_once();
+
+    /* Async-signal-safe. */
+    void stop() noexcept;
+
+    /* Stop accepting, answer every request already on its way with
+     * Connection: close and hang up on idle clients. Async-signal-safe. */
+    void drain() noexcept;
+
+    [[nodiscard]]
+    auto buffer_pool() const noexcept -> BufferPool const & { return buffers; }
+
+    /* For tasks to spawn before run(), or from tasks already running. */
+    [[nodiscard]]
+    auto loop() noexcept -> Loop<T>& { return tasks; }
+
+    /* From a task on loop(): serve `client`, connected elsewhere, like one
+     * accepted here; e.g. once TLS has been terminated for it. Once the
+     * reactor has stopped accepting, its first request is answered with
+     * Connection: close, as that of a client it had already is. */
+    void serve_client(io::Socket<T> client)
+    {
+        adopt(std::move(client), false);
+    }
+
+    /* Before run(): have `hook` called with `context` on the reactor's
+     * thread once it stops accepting, e.g. to stop a TlsAcceptor on its
+     * loop() accepting too. */
+    void on_drain(void (*hook)(void*) noexcept, void* context)
+    {
+        drain_hooks.emplace_back(hook, context);
+    }
+
+private:
+    void accept_clients(io::Socket<T>& from, bool is_admin);
+    auto hand_off(int fd) noexcept -> bool;
+    void take_clients();
+    void adopt(io::Socket<T>&& client, bool is_admin);
+    auto load() const noexcept -> std::size_t;
+    void admit();
+    void stop_accepting();
+    void serve(Connection<T>& client, unsigned events);
+    auto receive(Connection<T>& client) -> bool;
+    auto flush(Connection<T>& client) -> bool;
+    void settle(Connection<T>& client);
+    auto watch(Connection<T>& client, unsigned events) -> bool;
+    void close(Connection<T>& client);
+};
+
+template <io::IoApi T>
+Reactor<T>::Reactor(T const & ioapi, ServerConfig const & config,
+                    Listeners<T> listeners, ResponseCache* responses,
+                    ReactorStats* stats, Exporter const * exporter,
+                    Compressor* compressor)
+        : ioapi(ioapi), config(config), poller(ioapi),
+          waker(ioapi), buffers(config.buffer_limits), registry(poller),
+          deadlines(config), tasks(ioapi, poller, &waker),
+          service(ioapi, config, buffers, responses, exporter, compressor),
+          listeners(std::move(listeners)), admission(ioapi, config),
+          stats(stats)
+{
+    poller.add(waker.fd(), io::EV_IN);
+    if (this->listeners.main) {
+        poller.add(this->listeners.main->fd(), io::EV_IN);
+    }
+    if (this->listeners.local) {
+        poller.add(this->listeners.local->fd(), io::EV_IN);
+    }
+    if (this->listeners.admin) {
+        poller.add(this->listeners.admin->fd(), io::EV_IN);
+    }
+    if (this->listeners.handoff) {
+        poller.add(this->listeners.handoff->fd(), io::EV_IN);
+    }
+    if (this->listeners.dispatch) {
+        this->listeners.dispatch->attach(this->listeners.worker, waker);
+    }
+}
+
+template <io::IoApi T>
+void Reactor<T>::run()
+{
+    while (!stopping.load(std::memory_order_relaxed)
+           && (accepting || registry.size() > 0 || tasks.held() > 0)) {
+        run_once();
+    }
+}
+
+template <io::IoApi T>
+void Reactor<T>::run_once()
+{
+    int const timeout = sooner(deadlines.poll_timeout(),
+                               admission.poll_timeout(deadlines.now()));
+    auto ready = poller.wait(sooner(timeout, tasks.poll_timeout()));
+    for (io::Event const & event : ready) {
+        if (event.fd == waker.fd()) {
+            waker.drain();
+            take_clients();
+            continue;
+        }
+        auto& [main, local, admin, handoff, dispatch, worker] = listeners;
+        if (main && event.fd == main->fd()) {
+            if (event.events & io::EV_IN) { accept_clients(*main, false); }
+            continue;
+        }
+        if (local && event.fd == local->fd()) {
+            if (event.events & io::EV_IN) { accept_clients(*local, false); }
+            continue;
+        }
+        if (admin && event.fd == admin->fd()) {
+            if (event.events & io::EV_IN) { accept_clients(*admin, true); }
+            continue;
+        }
+        if (handoff && event.fd == handoff->fd()) {
+            if (event.events & io::EV_IN) { handoff->serve(); }
+            continue;
+        }
+        if (tasks.wake(event.fd, event.events)) { continue; }
+        if (Connection<T>* client = registry.find(event.fd)) {
+            serve(*client, event.events);
+        }
+    }
+    tasks.run();
+    if (accepting && draining.load(std::memory_order_relaxed)) {
+        stop_accepting();
+    }
+    deadlines.expire([this](int fd) { registry.remove(fd); });
+    if (accepting) { admit(); }
+    if (listeners.dispatch) {
+        listeners.dispatch->publish(listeners.worker, registry.size());
+    }
+    if (stats) {
+        stats->publish(registry.size(), service.requests(), buffers,
+                       admission.paused(), admission.rejected());
+    }
+}
+
+template <io::IoApi T>
+void Reactor<T>::accept_clients(io::Socket<T>& from, bool is_admin)
+{
+    /* the listener stays level-triggered, so a capped batch that leaves
+     * clients in the backlog is picked up again on the next wakeup */
+    std::size_t const batch = is_admin
+            ? config.accept_batch
+            : std::min(config.accept_batch, admission.room(load()));
+    auto const accepted = from.accept_batch(
+            [this, is_admin](io::Socket<T>&& client, io::SockInfo<T> const &) {
+                if (!is_admin && hand_off(client.fd())) {
+                    (void) client.release();
+                    return;
+                }
+                adopt(std::move(client), is_admin);
+            },
+            batch, detail::ACCEPT_FLAGS);
+    if (listeners.dispatch) { listeners.dispatch->flush(); }
+    if (!is_admin
+        && (accepted.error == EMFILE || accepted.error == ENFILE)) {
+        admission.shed(from.fd(), load(), deadlines.now());
+    }
+}
+
+/* Queue a client for the least loaded reactor, unless that is this one or
+ * its queue is full. True if the client went. */
+template <io::IoApi T>
+auto Reactor<T>::hand_off(int fd) noexcept -> bool
+{
+    auto const & [main, local, admin, handoff, dispatch, worker] = listeners;
+    if (!dispatch) { return false; }
+    std::size_t const to = dispatch->pick();
+    return to != worker && dispatch->hand(to, fd);
+}
+
+/* Serve the clients the acceptor has handed this reactor. */
+template <io::IoApi T>
+void Reactor<T>::take_clients()
+{
+    auto const & [main, local, admin, handoff, dispatch, worker] = listeners;
+    if (!dispatch) { return; }
+    dispatch->take(worker, [this](int fd) {
+        adopt(io::Socket<T>::adopt(ioapi, fd), false);
+    });
+}
+
+template <io::IoApi T>
+void Reactor<T>::adopt(io::Socket<T>&& client, bool is_admin)
+{
+    /* one the poller refuses is closed as the batch moves on */
+    auto added = registry.try_add(std::move(client));
+    if (!added) { return; }
+    (*added)->admin = is_admin;
+    deadlines.arm(**added, Deadline::HEADER);
+    if (listeners.dispatch) {
+        listeners.dispatch->publish(listeners.worker, registry.size());
+    }
+}
+
+/* The clients admission control weighs: in the single-acceptor topology
+ * those of the reactor the next client would go to. */
+template <io::IoApi T>
+auto Reactor<T>::load() const noexcept -> std::size_t
+{
+    if (listeners.dispatch) { return listeners.dispatch->least_load(); }
+    return registry.size();
+}
+
+/* Drop the main and Unix listeners from the poller or put them back as
+ * admission control decides; clients wait in their backlogs meanwhile. */
+template <io::IoApi T>
+void Reactor<T>::admit()
+{
+    if (!listeners.main && !listeners.local) { return; }
+    bool const paused = admission.update(load(), buffers, deadlines.now());
+    if (paused != listening) { return; }
+
+    /* a listener the poller will not take back is retried next time */
+    bool done = true;
+    for (auto const * l : {&listeners.main, &listeners.local}) {
+        if (!*l) { continue; }
+        if (paused) {
+            (void) poller.try_remove((*l)->fd());
+            continue;
+        }
+        auto const added = poller.try_add((*l)->fd(), io::EV_IN);
+        done = done && (added || added.error() == EEXIST);
+    }
+    if (done) { listening = !paused; }
+}
+
+/* Close the listeners, which a successor may hold open, and let clients go
+ * once they have been answered: idle ones now, the others as settle() finds
+ * them with nothing left to answer. */
+template <io::IoApi T>
+void Reactor<T>::stop_accepting()
+{
+    accepting = false;
+    service.drain();
+    /* whether or not admission control left them there */
+    if (listeners.main) { (void) poller.try_remove(listeners.main->fd()); }
+    if (listeners.local) { (void) poller.try_remove(listeners.local->fd()); }
+    if (listeners.admin) { (void) poller.try_remove(listeners.admin->fd()); }
+    if (listeners.handoff) {
+        (void) poller.try_remove(listeners.handoff->fd());
+    }
+    /* clients already handed over are still taken, to be answered once */
+    listeners = {.dispatch = listeners.dispatch, .worker = listeners.worker};
+    for (auto const & [hook, context] : drain_hooks) { hook(context); }
+
+    std::vector<int> idle;
+    registry.for_each([&idle](Connection<T>& client) {
+        if (!client.in.empty()) { return; }  /* will be answered, closing */
+        client.keep_alive = false;
+        if (client.queue.empty()) { idle.push_back(client.fd()); }
+    });
+    for (int const fd : idle) { close(*registry.find(fd)); }
+}
+
+template <io::IoApi T>
+void Reactor<T>::serve(Connection<T>& client, unsigned events)
+{
+    bool const hung_up = (events & io::EV_HUP) && !(events & io::EV_IN);
+    if ((events & io::EV_ERR) || hung_up
+        || ((events & io::EV_OUT) && !flush(client))
+        || ((events & io::EV_IN) && !receive(client))) {
+        close(client);
+        return;
+    }
+
+    service.handle_input(client, deadlines.now());
+    if (!flush(client)) {
+        close(client);
+        return;
+    }
+    settle(client);
+}
+
+/* Read what is available into the client's input buffer, borrowing one from
+ * the pool if it has none and growing it if a request outgrows it. False on
+ * EOF, error or when no buffer is left. */
+template <io::IoApi T>
+auto Reactor<T>::receive(Connection<T>& client) -> bool
+{
+    if (!client.in) { client.in = buffers.acquire(); }
+    if (!client.in) { return false; }
+    if (client.in.full()) { client.in.compact(); }
+    if (client.in.full() && !buffers.grow(client.in)) { return false; }
+
+    auto space = client.in.writable();
+    auto const n = ioapi.read(client.fd(), space.data(), space.size());
+    if (n > 0) {
+        client.in.commit(static_cast<std::size_t>(n));
+        return true;
+    }
+    return n == T::ERROR && io::transient(ioapi.errnum());
+}
+
+/* Send queued output until it is gone or the socket stops taking it: runs
+ * of memory segments go out with one gathering write, file ranges with
+ * sendfile. What the socket does not take stays queued, and the next EV_OUT
+ * resumes at the exact byte it stopped at. False if the connection is
+ * broken. */
+template <io::IoApi T>
+auto Reactor<T>::flush(Connection<T>& client) -> bool
+{
+    std::array<typename T::IoVec, OutputQueue::MAX_SEGMENTS> iov;
+    while (!client.queue.empty()) {
+        std::size_t want = 0;
+        typename T::SSize n;
+        if (auto range = client.queue.front_file()) {
+            auto offset = static_cast<typename T::Off>(range->offset);
+            want = range->size;
+            n = ioapi.sendfile(client.fd(), range->fd, &offset, want);
+            if (n == 0) { return false; }  /* the file shrank under us */
+        }
+        else {
+            typename T::MsgHdr msg{};
+            msg.msg_iov = iov.data();
+            msg.msg_iovlen = client.queue.gather(
+                    std::span<typename T::IoVec>{iov});
+            for (std::size_t i = 0; i < msg.msg_iovlen; ++i) {
+                want += iov[i].iov_len;
+            }
+            n = ioapi.sendmsg(client.fd(), &msg, detail::SEND_FLAGS);
+        }
+
+        if (n < 0) { return io::transient(ioapi.errnum()); }
+        client.queue.consume(static_cast<std::size_t>(n));
+        if (static_cast<std::size_t>(n) < want) { break; }  /* socket full */
+    }
+
+    if (client.queue.empty()) {
+        client.out.consume(client.out.size());
+        client.sending.clear();
+    }
+    return true;
+}
+
+/* Point the poller and the timer wheel at what the client waits for next:
+ * the peer draining our output, the rest of a request, or a new request. */
+template <io::IoApi T>
+void Reactor<T>::settle(Connection<T>& client)
+{
+    if (!client.queue.empty()) {
+        /* no new input is read until the responses have gone out */
+        if (!watch(client, io::EV_OUT)) {
+            close(client);
+            return;
+        }
+        deadlines.arm(client, Deadline::WRITE);
+        return;
+    }
+    client.out.release();
+
+    if (!client.keep_alive) {
+        close(client);
+        return;
+    }
+    if (!watch(client, io::EV_IN)) {
+        close(client);
+        return;
+    }
+    if (client.in.empty()) {
+        client.in.release();
+        deadlines.arm(client, Deadline::IDLE);
+    }
+    else if (client.deadline != Deadline::HEADER) {
+        /* not re-armed while bytes trickle in, or a slow sender could hold
+         * the connection forever */
+        deadlines.arm(client, Deadline::HEADER);
+    }
+}
+
+/* False if the poller would not change what it watches the client for. */
+template <io::IoApi T>
+auto Reactor<T>::watch(Connection<T>& client, unsigned events) -> bool
+{
+    if (client.events == events) { return true; }
+    if (!poller.try_modify(client.fd(), events)) { return false; }
+    client.events = events;
+    return true;
+}
+
+template <io::IoApi T>
+void Reactor<T>::close(Connection<T>& client)
+{
+    deadlines.cancel(client.fd());
+    registry.remove(client.fd());
+}
+
+template <io::IoApi T>
+void Reactor<T>::stop() noexcept
+{
+    stopping.store(true, std::memory_order_relaxed);
+    waker.notify();
+}
+
+template <io::IoApi T>
+void Reactor<T>::drain() noexcept
+{
+    draining.store(true, std::memory_order_relaxed);
+    waker.notify();
+}
+
+}  // namespace alewa
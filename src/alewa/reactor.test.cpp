@@ -0,0 +1,311 @@
+#include "test/test_utils.hpp"
+
+#include <chrono>
+#include <thread>
+
+#include "reactor.hpp"
+#include "work_pool.hpp"
+#include "io/sockapi_mock.hpp"
+
+namespace alewa::test {
+
+using io::test::MockEpollIoApi;
+
+namespace {
+
+int const LISTENER_FD = MockEpollIoApi::SUCCESS;  /* returned by socket() */
+int const CLIENT_FD = 7;
+
+/* A reactor whose listener has accepted CLIENT_FD, which has `input`
+ * waiting to be read. */
+struct Fixture
+{
+    MockEpollIoApi api;
+    MockEpollIoApi::SockAddr addr{};
+    ServerConfig config;
+    std::optional<Reactor<MockEpollIoApi>> reactor;
+
+    explicit Fixture(std::string input, ResponseCache* responses = nullptr,
+                     Compressor* compressor = nullptr)
+    {
+        api.ai.ai_addr = &addr;
+        api.files["data/alewa.jpg"] = {std::string(3000, 'j'), 0};
+        api.files["data/index.html"] = {"<html></html>", 0};
+        api.files["data/app.js"] = {std::string(2000, 'x'), 0};
+        api.files["data/style.css"] = {std::string(500, 'c'), 0};
+        api.files["data/style.css.br"] = {"brotli", 0};
+        Listeners<MockEpollIoApi> listeners;
+        listeners.main.emplace(create_listener(api, "8080", false));
+        listeners.main->listen(10);
+        reactor.emplace(api, config, std::move(listeners), responses,
+                        nullptr, nullptr, compressor);
+
+        api.backlog.push_back(CLIENT_FD);
+        api.ready[LISTENER_FD] = io::EV_IN;
+        reactor->run_once();  /* accepts */
+
+        api.inbox[CLIENT_FD] = std::move(input);
+        api.ready[CLIENT_FD] = io::EV_IN;
+        reactor->run_once();  /* serves */
+    }
+
+    auto writes() -> std::vector<std::string>&
+    {
+        return api.writes[CLIENT_FD];
+    }
+
+    auto connected() -> bool { return api.interest().contains(CLIENT_FD); }
+};
+
+auto count(std::string const & s, std::string const & what) -> std::size_t
+{
+    std::size_t n = 0;
+    for (auto i = s.find(what); i != s.npos; i = s.find(what, i + 1)) { ++n; }
+    return n;
+}
+
+}  // namespace
+
+ALW_TEST(reactor_pipelined_requests_answered_in_one_write)
+{
+    Fixture f{"GET /a HTTP/1.1\r\n\r\n"
+              "HEAD /b HTTP/1.1\r\nHost: x\r\n\r\n"
+              "GET /c HTTP/1.1\r\n"};
+    ALW_EXPECT_EQ(f.writes().size(), 1ul);
+    ALW_EXPECT_EQ(count(f.writes()[0], "HTTP/1.1 404 Not Found\r\n"), 2ul);
+    ALW_EXPECT_EQ(count(f.writes()[0], "Not Found\n"), 1ul);  /* HEAD */
+    ALW_EXPECT_EQ(f.connected(), true);
+
+    /* the rest of the third request, asking to close afterwards */
+    f.api.inbox[CLIENT_FD] = "Connection: close\r\n\r\n";
+    f.reactor->run_once();
+    ALW_EXPECT_EQ(f.writes().size(), 2ul);
+    ALW_EXPECT_EQ(count(f.writes()[1], "Connection: close\r\n"), 1ul);
+    ALW_EXPECT_EQ(f.connected(), false);
+}
+
+ALW_TEST(reactor_serves_files_with_sendfile)
+{
+    Fixture f{"GET /alewa.jpg HTTP/1.1\r\n\r\n"
+              "HEAD / HTTP/1.1\r\n\r\n"
+              "GET /../data/alewa.jpg HTTP/1.1\r\n\r\n"
+              "DELETE / HTTP/1.1\r\n\r\n"
+              "GET / HTTP/1.1\r\n\r\n"};
+
+    /* heads and bodies in order: memory runs are gathered, files are
+     * sendfile'd, so five responses take four calls */
+    auto const & w = f.writes();
+    ALW_EXPECT_EQ(w.size(), 4ul);
+    ALW_EXPECT_EQ(count(w[0], "200 OK\r\nContent-Length: 3000\r\n"
+                              "Content-Type: image/jpeg"), 1ul);
+    ALW_EXPECT_EQ(w[1], std::string(3000, 'j'));
+    ALW_EXPECT_EQ(count(w[2], "HTTP/1.1 "), 4ul);
+    ALW_EXPECT_EQ(count(w[2], "Content-Length: 13\r\n"), 2ul);
+    ALW_EXPECT_EQ(count(w[2], "404 Not Found"), 1ul);
+    ALW_EXPECT_EQ(count(w[2], "405 Method Not Allowed"), 1ul);
+    ALW_EXPECT_EQ(count(w[2], "Allow: GET, HEAD\r\n"), 1ul);
+    ALW_EXPECT_EQ(w[3], "<html></html>");
+    ALW_EXPECT_EQ(f.api.opens, 2);  /* index.html came from the cache */
+}
+
+ALW_TEST(reactor_serves_small_files_from_response_cache)
+{
+    using namespace std::chrono_literals;
+    ResponseCache responses{1 << 20, 1024, 1000ms, 1};
+    Fixture f{"GET / HTTP/1.1\r\n\r\n"
+              "GET /alewa.jpg HTTP/1.1\r\n\r\n"
+              "HEAD /index.html HTTP/1.1\r\n\r\n",
+              &responses};
+
+    /* index.html is read once into a full response; the jpg is too big to
+     * cache and still goes out with sendfile */
+    auto const & w = f.writes();
+    ALW_EXPECT_EQ(w.size(), 3ul);
+    ALW_EXPECT_EQ(count(w[0], "Content-Length: 13\r\n"), 1ul);
+    ALW_EXPECT_EQ(count(w[0], "<html></html>HTTP/1.1 200 OK"), 1ul);
+    ALW_EXPECT_EQ(w[1], std::string(3000, 'j'));
+    ALW_EXPECT_EQ(count(w[2], "Content-Length: 13\r\n"), 1ul);
+    ALW_EXPECT_EQ(count(w[2], "<html>"), 0ul);
+    ALW_EXPECT_EQ(f.api.preads, 1);
+    ALW_EXPECT_EQ(responses.size(), 1ul);
+
+    /* a hit touches neither the file nor the file cache */
+    int const opens = f.api.opens;
+    f.api.inbox[CLIENT_FD] = "GET /index.html HTTP/1.1\r\n\r\n";
+    f.reactor->run_once();
+    ALW_EXPECT_EQ(w.size(), 4ul);
+    ALW_EXPECT_EQ(count(w[3], "\r\n\r\n<html></html>"), 1ul);
+    ALW_EXPECT_EQ(f.api.preads, 1);
+    ALW_EXPECT_EQ(f.api.opens, opens);
+
+    /* closing requests are not answered from the cache */
+    f.api.inbox[CLIENT_FD] = "GET / HTTP/1.1\r\nConnection: close\r\n\r\n";
+    f.reactor->run_once();
+    ALW_EXPECT_EQ(w.size(), 6ul);  /* head, then the body by sendfile */
+    ALW_EXPECT_EQ(count(w[4], "Connection: close\r\n"), 1ul);
+}
+
+ALW_TEST(reactor_negotiates_content_coding)
+{
+    using namespace std::chrono_literals;
+    ServerConfig config;
+    WorkPool pool{1, 16};
+    Compressor compressor{config, 1, &pool};
+    Fixture f{"GET /app.js HTTP/1.1\r\nAccept-Encoding: gzip, br\r\n\r\n",
+              nullptr, &compressor};
+
+    /* the plain script goes out while the pool reads and gzips it */
+    auto const & w = f.writes();
+    ALW_EXPECT_EQ(w.size(), 2ul);
+    ALW_EXPECT_EQ(count(w[0], "Content-Encoding"), 0ul);
+    ALW_EXPECT_EQ(count(w[0], "Vary: Accept-Encoding\r\n"), 1ul);
+    ALW_EXPECT_EQ(w[1], std::string(2000, 'x'));
+    for (int i = 0; i < 1000 && compressor.stats().compressed == 0; ++i) {
+        std::this_thread::sleep_for(1ms);
+    }
+    ALW_EXPECT_EQ(compressor.stats().compressed, 1ul);
+
+    /* gzip, now made; the stylesheet's brotli sibling; the plain script,
+     * and html the client refused br for */
+    f.api.inbox[CLIENT_FD] =
+            "GET /app.js HTTP/1.1\r\nAccept-Encoding: gzip, br\r\n\r\n"
+            "GET /style.css HTTP/1.1\r\nAccept-Encoding: br\r\n\r\n"
+            "GET /app.js HTTP/1.1\r\n\r\n"
+            "GET /index.html HTTP/1.1\r\nAccept-Encoding: br;q=0\r\n\r\n";
+    f.reactor->run_once();
+    ALW_EXPECT_EQ(w.size(), 6ul);
+    ALW_EXPECT_EQ(count(w[2], "Content-Encoding: gzip\r\n"), 1ul);
+    ALW_EXPECT_EQ(count(w[2], "-gzip\"\r\n"), 1ul);
+    ALW_EXPECT_EQ(count(w[2], "Content-Encoding: br\r\n"), 1ul);
+    ALW_EXPECT_EQ(count(w[2], "Content-Length: 6\r\n"
+                              "Content-Type: text/css"), 1ul);
+    ALW_EXPECT_EQ(count(w[2], "\r\n\r\nbrotliHTTP/1.1 200 OK\r\n"
+                              "Content-Length: 2000\r\n"), 1ul);
+    ALW_EXPECT_EQ(count(w[2], "Vary: Accept-Encoding\r\n"), 3ul);
+    ALW_EXPECT_EQ(w[3], std::string(2000, 'x'));
+    ALW_EXPECT_EQ(count(w[4], "Content-Encoding"), 0ul);
+    ALW_EXPECT_EQ(count(w[4], "Vary: Accept-Encoding\r\n"), 1ul);
+    ALW_EXPECT_EQ(w[5], "<html></html>");
+    ALW_EXPECT_EQ(compressor.stats().compressed, 1ul);
+
+    /* variants are served from memory, and missing siblings are not
+     * looked for again */
+    int const opens = f.api.opens;
+    int const preads = f.api.preads;
+    f.api.inbox[CLIENT_FD] =
+            "GET /app.js HTTP/1.1\r\nAccept-Encoding: br, gzip\r\n\r\n"
+            "GET /style.css HTTP/1.1\r\nAccept-Encoding: *\r\n\r\n";
+    f.reactor->run_once();
+    ALW_EXPECT_EQ(w.size(), 7ul);
+    ALW_EXPECT_EQ(count(w[6], "Content-Encoding: gzip\r\n"), 1ul);
+    ALW_EXPECT_EQ(count(w[6], "Content-Encoding: br\r\n"), 1ul);
+    ALW_EXPECT_EQ(f.api.opens, opens);
+    ALW_EXPECT_EQ(f.api.preads, preads);
+}
+
+/* Without a pool, gzip is never made on the reactor's thread; siblings are
+ * still sent. */
+ALW_TEST(reactor_gzips_only_on_pool)
+{
+    ServerConfig config;
+    Compressor compressor{config, 1};
+    Fixture f{"GET /app.js HTTP/1.1\r\nAccept-Encoding: gzip\r\n\r\n"
+              "GET /style.css HTTP/1.1\r\nAccept-Encoding: br\r\n\r\n",
+              nullptr, &compressor};
+
+    std::string sent;
+    for (std::string const & w : f.writes()) { sent += w; }
+    ALW_EXPECT_EQ(count(sent, "Content-Encoding: gzip\r\n"), 0ul);
+    ALW_EXPECT_EQ(count(sent, "Content-Encoding: br\r\n"), 1ul);
+    ALW_EXPECT_EQ(count(sent, std::string(2000, 'x')), 1ul);
+    ALW_EXPECT_EQ(compressor.stats().compressed, 0ul);
+}
+
+ALW_TEST(reactor_resumes_partial_writes)
+{
+    std::string const two = "GET /a HTTP/1.1\r\n\r\n"
+                            "GET /alewa.jpg HTTP/1.1\r\n\r\n"
+                            "GET /b HTTP/1.1\r\n\r\n";
+    Fixture all{two};
+    std::string expected;
+    for (std::string const & w : all.writes()) { expected += w; }
+    ALW_EXPECT_EQ(all.api.send_flags, detail::SEND_FLAGS);
+
+    Fixture f{""};
+    f.api.write_limit = 1000;
+    f.api.inbox[CLIENT_FD] = two;
+    f.reactor->run_once();
+    ALW_EXPECT_EQ(f.api.interest().at(CLIENT_FD), io::EV_OUT);
+
+    /* output drains a little per EV_OUT; nothing new is read meanwhile */
+    f.api.inbox[CLIENT_FD] = "GET /c HTTP/1.1\r\n\r\n";
+    f.api.ready[CLIENT_FD] = io::EV_IN | io::EV_OUT;
+    while (f.api.interest().at(CLIENT_FD) == io::EV_OUT) {
+        f.reactor->run_once();
+    }
+    std::string sent;
+    for (std::string const & w : f.writes()) { sent += w; }
+    ALW_EXPECT_EQ(sent, expected);
+    ALW_EXPECT_EQ(f.api.inbox[CLIENT_FD].empty(), false);
+    ALW_EXPECT_EQ(f.api.interest().at(CLIENT_FD), io::EV_IN);
+}
+
+ALW_TEST(reactor_keeps_http10_alive_only_on_request)
+{
+    Fixture f{"GET /x HTTP/1.0\r\nConnection: Keep-Alive\r\n\r\n"};
+    ALW_EXPECT_EQ(f.writes().size(), 1ul);
+    ALW_EXPECT_EQ(count(f.writes()[0], "Connection: keep-alive\r\n"), 1ul);
+    ALW_EXPECT_EQ(f.connected(), true);
+
+    f.api.inbox[CLIENT_FD] = "GET /x HTTP/1.0\r\n\r\n";
+    f.reactor->run_once();
+    ALW_EXPECT_EQ(f.writes().size(), 2ul);
+    ALW_EXPECT_EQ(f.connected(), false);
+}
+
+ALW_TEST(reactor_bad_request_answered_then_closed)
+{
+    Fixture f{"GET /x HTTP/1.1\r\n\r\nnonsense\r\n\r\nGET / HTTP/1.1\r\n\r\n"};
+    ALW_EXPECT_EQ(f.writes().size(), 1ul);
+    ALW_EXPECT_EQ(count(f.writes()[0], "HTTP/1.1 404"), 1ul);
+    ALW_EXPECT_EQ(count(f.writes()[0], "HTTP/1.1 400 Bad Request\r\n"), 1ul);
+    ALW_EXPECT_EQ(f.connected(), false);
+}
+
+ALW_TEST(reactor_drain_answers_what_was_sent_then_exits)
+{
+    int const IDLE_FD = 8;
+    Fixture f{"GET /a HTTP/1.1\r\n"};
+    f.api.backlog.push_back(IDLE_FD);
+    f.reactor->run_once();
+    ALW_EXPECT_EQ(f.api.interest().contains(IDLE_FD), true);
+
+    /* the listener goes, the idle client is hung up on */
+    f.reactor->drain();
+    f.reactor->run_once();
+    ALW_EXPECT_EQ(f.api.interest().contains(LISTENER_FD), false);
+    ALW_EXPECT_EQ(f.api.interest().contains(IDLE_FD), false);
+    ALW_EXPECT_EQ(f.connected(), true);
+
+    /* the request on its way is answered, closing */
+    f.api.inbox[CLIENT_FD] = "\r\n";
+    f.reactor->run_once();
+    ALW_EXPECT_EQ(f.writes().size(), 1ul);
+    ALW_EXPECT_EQ(count(f.writes()[0], "Connection: close\r\n"), 1ul);
+    ALW_EXPECT_EQ(f.connected(), false);
+
+    /* so is one that gets through its TLS handshake meanwhile */
+    int const LATE_FD = 9;
+    f.reactor->serve_client(io::Socket<MockEpollIoApi>::adopt(f.api,
+                                                              LATE_FD));
+    f.api.inbox[LATE_FD] = "GET /a HTTP/1.1\r\n\r\n";
+    f.api.ready[LATE_FD] = io::EV_IN;
+    f.reactor->run_once();
+    ALW_EXPECT_EQ(f.api.writes[LATE_FD].size(), 1ul);
+    ALW_EXPECT_EQ(count(f.api.writes[LATE_FD][0], "Connection: close\r\n"),
+                  1ul);
+    ALW_EXPECT_EQ(f.api.interest().contains(LATE_FD), false);
+    f.reactor->run();  /* nothing left: returns at once */
+}
+
+}  // namespace alewa::test
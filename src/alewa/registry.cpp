@@ -0,0 +1 @@
+#include "registry.hpp"
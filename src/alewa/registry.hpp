@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cerrno>
+#include <vector>
+#include <optional>
+#include <stdexcept>
+
+#include "io/ioapi.hpp"
+#include "io/poller.hpp"
+#include "io/result.hpp"
+#include "io/socket.hpp"
+#include "connection.hpp"
+
+namespace alewa {
+
+/* Connections stored inline in a slab indexed directly by fd: lookup is a
+ * bounds check and an array access, removal is O(1), and the slab only grows
+ * to the highest fd seen, which the kernel keeps dense. Adding or removing a
+ * client also (de)registers it with the reactor's poller, if it has one. */
+template <io::IoApi T>
+class Registry
+{
+private:
+    io::Poller<T>* poller = nullptr;
+    std::vector<std::optional<Connection<T>>> slots;
+    std::size_t count = 0;
+
+public:
+    Registry() = default;
+    explicit Registry(io::Poller<T>& poller) : poller(&poller) {}
+
+    Registry(Registry&) = delete;
+    Registry& operator=(Registry&) = delete;
+
+    auto add(io::Socket<T>&& client, unsigned events = io::EV_IN)
+            -> Connection<T>&;
+
+    /* As add(), but a client that is already registered or that the poller
+     * refuses is closed and the errno returned instead of thrown. */
+    auto try_add(io::Socket<T>&& client, unsigned events = io::EV_IN)
+            -> io::Result<Connection<T>*>;
+
+    void remove(int fd);
+
+    [[nodiscard]]
+    auto find(int fd) noexcept -> Connection<T>*
+    {
+        auto const i = static_cast<std::size_t>(fd);
+        if (fd < 0 || i >= slots.size() || !slots[i]) { return nullptr; }
+        return &*slots[i];
+    }
+
+    [[nodiscard]]
+    auto size() const noexcept -> std::size_t { return count; }
+
+    /* Visit every live connection; f must not add or remove clients. */
+    template <typename F>
+    void for_each(F&& f)
+    {
+        for (auto& slot : slots) {
+            if (slot) { f(*slot); }
+        }
+    }
+};
+
+template <io::IoApi T>
+auto Registry<T>::add(io::Socket<T>&& client, unsigned events)
+        -> Connection<T>&
+{
+    int const fd = client.fd();
+    if (find(fd) != nullptr) {
+        throw std::runtime_error{"registry: socket " + std::to_string(fd)
+                                 + " already registered"};
+    }
+
+    auto const i = static_cast<std::size_t>(fd);
+    if (i >= slots.size()) { slots.resize(i + 1); }
+    if (poller) { poller->add(fd, events); }
+    slots[i].emplace(std::move(client));
+    ++count;
+    return *slots[i];
+}
+
+template <io::IoApi T>
+auto Registry<T>::try_add(io::Socket<T>&& client, unsigned events)
+        -> io::Result<Connection<T>*>
+{
+    int const fd = client.fd();
+    if (find(fd) != nullptr) {
+        return io::Result<Connection<T>*>::failure(EEXIST);
+    }
+    if (poller) {
+        auto const added = poller->try_add(fd, events);
+        if (!added) {
+            return io::Result<Connection<T>*>::failure(added.error());
+        }
+    }
+
+    auto const i = static_cast<std::size_t>(fd);
+    if (i >= slots.size()) { slots.resize(i + 1); }
+    slots[i].emplace(std::move(client));
+    ++count;
+    return &*slots[i];
+}
+
+template <io::IoApi T>
+void Registry<T>::remove(int fd)
+{
+    Connection<T>* connection = find(fd);
+    if (connection == nullptr) { return; }
+    /* closing the socket unregisters it anyway */
+    if (poller) { (void) poller->try_remove(fd); }
+    slots[static_cast<std::size_t>(fd)].reset();  /* closes the socket */
+    --count;
+}
+
+}  // namespace alewa
@@ -0,0 +1,113 @@
+#include "bench/micro.hpp"
+
+#include <vector>
+
+#include "registry.hpp"
+#include "io/poller.hpp"
+#include "io/socket.hpp"
+#include "bench/null_ioapi.hpp"
+
+namespace alewa::bench {
+
+namespace {
+
+/* state.size open sockets with the consecutive fds a kernel would hand out,
+ * made outside the timed region. */
+auto clients(NullIoApi const & api, std::size_t n)
+        -> std::vector<io::Socket<NullIoApi>>
+{
+    io::AddrInfoList<NullIoApi> spec{api, nullptr, "0", nullptr};
+    io::Socket<NullIoApi> listener{api, spec};
+    api.next_fd = 3;
+    api.pending = n;
+
+    std::vector<io::Socket<NullIoApi>> sockets;
+    sockets.reserve(n);
+    listener.accept_batch([&](io::Socket<NullIoApi>&& client,
+                              io::SockInfo<NullIoApi> const &) {
+        sockets.push_back(std::move(client));
+    }, n, 0);
+    return sockets;
+}
+
+}  // namespace
+
+/* Adds to an empty registry, so the slab grows (and moves its connections)
+ * along the way. */
+ALW_BENCH(registry_add_cold)
+{
+    NullIoApi api;
+    api.resolve(1);
+    auto sockets = clients(api, state.size);
+    Registry<NullIoApi> registry;
+    state.time(state.size, [&] {
+        for (auto& socket : sockets) { registry.add(std::move(socket)); }
+    });
+}
+
+/* Adds once the slab has reached its high-water mark. */
+ALW_BENCH(registry_add_warm)
+{
+    NullIoApi api;
+    api.resolve(1);
+    Registry<NullIoApi> registry;
+    for (auto& socket : clients(api, state.size)) {
+        registry.add(std::move(socket));
+    }
+    for (std::size_t fd = 3; fd < state.size + 3; ++fd) {
+        registry.remove(static_cast<int>(fd));
+    }
+
+    auto sockets = clients(api, state.size);
+    state.time(state.size, [&] {
+        for (auto& socket : sockets) { registry.add(std::move(socket)); }
+    });
+}
+
+ALW_BENCH(registry_find)
+{
+    NullIoApi api;
+    api.resolve(1);
+    Registry<NullIoApi> registry;
+    for (auto& socket : clients(api, state.size)) {
+        registry.add(std::move(socket));
+    }
+    state.time(state.size, [&] {
+        for (std::size_t fd = 3; fd < state.size + 3; ++fd) {
+            keep(registry.find(static_cast<int>(fd)));
+        }
+    });
+}
+
+ALW_BENCH(registry_remove)
+{
+    NullIoApi api;
+    api.resolve(1);
+    Registry<NullIoApi> registry;
+    for (auto& socket : clients(api, state.size)) {
+        registry.add(std::move(socket));
+    }
+    state.time(state.size, [&] {
+        for (std::size_t fd = 3; fd < state.size + 3; ++fd) {
+            registry.remove(static_cast<int>(fd));
+        }
+    });
+}
+
+/* Add then remove everything through an epoll Poller, as a reactor does. */
+ALW_BENCH(registry_add_remove_polled)
+{
+    NullIoApi api;
+    api.resolve(1);
+    io::Poller<NullIoApi> poller{api};
+    Registry<NullIoApi> registry{poller};
+    auto sockets = clients(api, state.size);
+    state.time(2 * state.size, [&] {
+        for (auto& socket : sockets) { registry.add(std::move(socket)); }
+        for (std::size_t fd = 3; fd < state.size + 3; ++fd) {
+            registry.remove(static_cast<int>(fd));
+        }
+    });
+}
+
+}  // namespace alewa::bench
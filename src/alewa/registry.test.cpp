@@ -0,0 +1,120 @@
+#include "test/test_utils.hpp"
+
+#include "registry.hpp"
+#include "io/sockapi_mock.hpp"
+
+namespace alewa::test {
+
+using io::test::MockEpollIoApi;
+
+namespace {
+
+auto make_socket(MockEpollIoApi& api, int fd) -> io::Socket<MockEpollIoApi>
+{
+    io::AddrInfoList<MockEpollIoApi> spec{api, nullptr, nullptr, nullptr};
+    api.ret_code = fd;  /* returned by socket() */
+    io::Socket<MockEpollIoApi> socket{api, spec};
+    api.ret_code = MockEpollIoApi::SUCCESS;
+    return socket;
+}
+
+}  // namespace
+
+ALW_TEST(registry_add_registers_with_poller)
+{
+    MockEpollIoApi api;
+    io::Poller<MockEpollIoApi> poller{api};
+    Registry<MockEpollIoApi> registry{poller};
+
+    auto& connection = registry.add(make_socket(api, 7));
+    ALW_EXPECT_EQ(connection.fd(), 7);
+    ALW_EXPECT_EQ(registry.size(), 1ul);
+    ALW_EXPECT_EQ(registry.find(7), &connection);
+    ALW_EXPECT_EQ(registry.find(6) == nullptr, true);
+    ALW_EXPECT_EQ(registry.find(700) == nullptr, true);
+    ALW_EXPECT_EQ(api.interest().at(7), io::EV_IN);
+
+    registry.add(make_socket(api, 3), io::EV_IN | io::EV_OUT);
+    ALW_EXPECT_EQ(registry.size(), 2ul);
+    ALW_EXPECT_EQ(api.interest().at(3), io::EV_IN | io::EV_OUT);
+    ALW_EXPECT_EQ(registry.find(7)->fd(), 7);  /* survives slab growth */
+}
+
+ALW_TEST(registry_rejects_duplicate_fd)
+{
+    MockEpollIoApi api;
+    io::Poller<MockEpollIoApi> poller{api};
+    Registry<MockEpollIoApi> registry{poller};
+    registry.add(make_socket(api, 4));
+
+    std::string error{};
+    try {
+        registry.add(make_socket(api, 4));
+    }
+    catch (std::runtime_error const & e) {
+        error = e.what();
+    }
+    ALW_EXPECT_EQ(error, "registry: socket 4 already registered");
+    ALW_EXPECT_EQ(registry.size(), 1ul);
+}
+
+ALW_TEST(registry_try_add_reports_refusal)
+{
+    MockEpollIoApi api;
+    io::Poller<MockEpollIoApi> poller{api};
+    Registry<MockEpollIoApi> registry{poller};
+
+    auto added = registry.try_add(make_socket(api, 4));
+    ALW_EXPECT_EQ(static_cast<bool>(added), true);
+    ALW_EXPECT_EQ((*added)->fd(), 4);
+    ALW_EXPECT_EQ(registry.try_add(make_socket(api, 4)).error(), EEXIST);
+
+    /* e.g. epoll out of watches: the client is closed, nothing thrown */
+    bool is_closed = false;
+    MockEpollIoApi::set_is_closed(&is_closed);
+    {
+        auto socket = make_socket(api, 5);
+        api.ret_code = MockEpollIoApi::ERROR;
+        api.errorno = ENOSPC;
+        auto refused = registry.try_add(std::move(socket));
+        api.ret_code = MockEpollIoApi::SUCCESS;
+        ALW_EXPECT_EQ(refused.fault() == io::Fault::EXHAUSTED, true);
+    }
+    MockEpollIoApi::set_is_closed(nullptr);
+    ALW_EXPECT_EQ(is_closed, true);
+    ALW_EXPECT_EQ(registry.size(), 1ul);
+    ALW_EXPECT_EQ(registry.find(5) == nullptr, true);
+}
+
+ALW_TEST(registry_remove_closes_and_deregisters)
+{
+    MockEpollIoApi api;
+    io::Poller<MockEpollIoApi> poller{api};
+    Registry<MockEpollIoApi> registry{poller};
+    registry.add(make_socket(api, 5));
+    registry.add(make_socket(api, 6));
+
+    bool is_closed = false;
+    MockEpollIoApi::set_is_closed(&is_closed);
+    registry.remove(5);
+    MockEpollIoApi::set_is_closed(nullptr);
+
+    ALW_EXPECT_EQ(is_closed, true);
+    ALW_EXPECT_EQ(registry.size(), 1ul);
+    ALW_EXPECT_EQ(registry.find(5) == nullptr, true);
+    ALW_EXPECT_EQ(api.interest().contains(5), false);
+    ALW_EXPECT_EQ(api.interest().contains(6), true);
+
+    registry.remove(5);  /* no-op */
+    ALW_EXPECT_EQ(registry.size(), 1ul);
+
+    /* the fd may be handed out again by the kernel */
+    registry.add(make_socket(api, 5));
+    ALW_EXPECT_EQ(registry.size(), 2ul);
+
+    std::size_t visited = 0;
+    registry.for_each([&visited](Connection<MockEpollIoApi>&) { ++visited; });
+    ALW_EXPECT_EQ(visited, 2ul);
+}
+
+}  // namespace alewa::test
@@ -0,0 +1,166 @@
+#include "response_cache.hpp"
+
+#include <bit>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+
+namespace alewa {
+
+CachedResponse::CachedResponse(std::string_view head, std::size_t body_size,
+                               FileVersion version)
+        : bytes(std::make_unique_for_overwrite<char[]>(head.size()
+                                                        + body_size)),
+          head_size(head.size()), total(head.size() + body_size),
+          version(version)
+{
+    std::memcpy(bytes.get(), head.data(), head.size());
+}
+
+ResponseCache::ResponseCache(std::size_t budget, std::size_t max_file,
+                             std::chrono::milliseconds revalidate,
+                             std::size_t readers)
+        : budget(budget), max_file(max_file),
+          revalidate_after(static_cast<Tick>(revalidate.count())),
+          epoch(Clock::now()),
+          /* about one chain per 4 KiB of budget */
+          mask(std::bit_ceil(std::max<std::size_t>(budget / 4096, 64)) - 1),
+          buckets(std::make_unique<std::atomic<Node*>[]>(mask + 1)),
+          epochs(readers)
+{}
+
+ResponseCache::~ResponseCache()
+{
+    for (Node* node : clock) { delete node; }
+    for (auto const & [node, retired_at] : retired) { delete node; }
+}
+
+auto ResponseCache::find(std::size_t reader, std::string_view path)
+        -> Response
+{
+    std::size_t const hash = std::hash<std::string_view>{}(path);
+    auto const guard = epochs.pin(reader);
+
+    Node* node = locate(path, hash);
+    if (node == nullptr
+        || now() - node->checked.load(std::memory_order_relaxed)
+                   >= revalidate_after) {
+        return nullptr;
+    }
+    /* read before written: a hot entry's line stays shared */
+    if (!node->referenced.load(std::memory_order_relaxed)) {
+        node->referenced.store(true, std::memory_order_relaxed);
+    }
+    return node->response;
+}
+
+auto ResponseCache::revalidate(std::string_view path,
+                               FileVersion const & version) -> Response
+{
+    std::lock_guard lock{writer};
+    Node* node = locate(path, std::hash<std::string_view>{}(path));
+    if (node == nullptr || node->response->version != version) {
+        return nullptr;
+    }
+    node->checked.store(now(), std::memory_order_relaxed);
+    return node->response;
+}
+
+void ResponseCache::insert(std::string_view path, Response response)
+{
+    std::size_t const size = response->full().size();
+    if (response->version.size > max_file || size > budget) { return; }
+
+    std::lock_guard lock{writer};
+    std::size_t const hash = std::hash<std::string_view>{}(path);
+    if (Node* old = locate(path, hash)) { remove(old); }
+
+    /* CLOCK: a referenced node gets a second chance, the first one found
+     * unreferenced goes */
+    while (used + size > budget) {
+        if (hand >= clock.size()) { hand = 0; }
+        Node* node = clock[hand];
+        if (node->referenced.exchange(false, std::memory_order_relaxed)) {
+            ++hand;
+        }
+        else {
+            remove(node);  /* moves the last node to the hand */
+        }
+    }
+
+    auto* node = new Node{std::string{path}, hash, std::move(response), {},
+                          {false}, {now()}, clock.size()};
+    clock.push_back(node);
+    used += size;
+
+    std::atomic<Node*>& head = bucket(hash);
+    node->next.store(head.load(std::memory_order_relaxed),
+                     std::memory_order_relaxed);
+    head.store(node);  /* publishes the node, fully built */
+    reclaim();
+}
+
+auto ResponseCache::size() -> std::size_t
+{
+    std::lock_guard lock{writer};
+    return clock.size();
+}
+
+auto ResponseCache::bytes() -> std::size_t
+{
+    std::lock_guard lock{writer};
+    return used;
+}
+
+auto ResponseCache::pending() -> std::size_t
+{
+    std::lock_guard lock{writer};
+    reclaim();
+    return retired.size();
+}
+
+auto ResponseCache::now() const -> Tick
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+                   Clock::now() - epoch)
+            .count();
+}
+
+auto ResponseCache::locate(std::string_view path, std::size_t hash) const
+        -> Node*
+{
+    for (Node* node = bucket(hash).load(); node != nullptr;
+         node = node->next.load(std::memory_order_acquire)) {
+        if (node->hash == hash && node->path == path) { return node; }
+    }
+    return nullptr;
+}
+
+/* Unlink a node from its chain and from the clock, and retire it. Readers
+ * already on it may go on to its successors, which stay linked. */
+void ResponseCache::remove(Node* node)
+{
+    std::atomic<Node*>* link = &bucket(node->hash);
+    while (link->load() != node) { link = &link->load()->next; }
+    link->store(node->next.load());
+
+    Node* last = clock.back();
+    clock[node->position] = last;
+    last->position = node->position;
+    clock.pop_back();
+    used -= node->response->full().size();
+
+    retired.emplace_back(node, epochs.advance());
+}
+
+void ResponseCache::reclaim()
+{
+    EpochDomain::Epoch const oldest = epochs.oldest_pinned();
+    std::erase_if(retired, [oldest](auto const & entry) {
+        if (entry.second >= oldest) { return false; }
+        delete entry.first;
+        return true;
+    });
+}
+
+}  // namespace alewa
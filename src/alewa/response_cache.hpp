@@ -0,0 +1,158 @@
+#pragma once
+
+#include <span>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "epoch.hpp"
+
+namespace alewa {
+
+/* Which version of a file a cached response was made from. */
+struct FileVersion
+{
+    std::uint64_t ino;
+    std::size_t size;
+    std::int64_t mtime_sec;
+    std::int64_t mtime_nsec;
+
+    auto operator==(FileVersion const &) const -> bool = default;
+};
+
+/* A complete response, status line to last body byte, in one allocation,
+ * so that serving it is a single send. */
+class CachedResponse
+{
+private:
+    std::unique_ptr<char[]> bytes;
+    std::size_t head_size;
+    std::size_t total;
+
+public:
+    FileVersion const version;
+
+    CachedResponse(std::string_view head, std::size_t body_size,
+                   FileVersion version);
+
+    /* For filling in the body once, before the response is shared. */
+    [[nodiscard]]
+    auto body() noexcept -> std::span<char>
+    {
+        return {bytes.get() + head_size, total - head_size};
+    }
+
+    [[nodiscard]]
+    auto full() const noexcept -> std::string_view
+    {
+        return {bytes.get(), total};
+    }
+
+    /* The answer to HEAD. */
+    [[nodiscard]]
+    auto head() const noexcept -> std::string_view
+    {
+        return {bytes.get(), head_size};
+    }
+};
+
+/* Complete responses for small files, keyed by normalized path and shared
+ * by all reactors. Lookups take no lock: they walk hash chains under an
+ * epoch guard. Inserting, replacing and evicting are serialized by a mutex
+ * and rare next to hits; what they unlink is freed once no reader can still
+ * see it. The bytes cached stay within a budget, evicting by CLOCK, which
+ * unlike LRU costs a hit no more than setting a bit. A response is trusted
+ * for the revalidation interval, after which lookups miss until
+ * revalidate() has confirmed it against the file. */
+class ResponseCache
+{
+public:
+    using Response = std::shared_ptr<CachedResponse const>;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    using Tick = std::int64_t;  /* milliseconds since construction */
+
+    struct Node
+    {
+        std::string path;
+        std::size_t hash;
+        Response response;  /* shared: a send may outlive the node */
+        std::atomic<Node*> next{nullptr};
+        std::atomic<bool> referenced{false};  /* the CLOCK bit, set by hits */
+        std::atomic<Tick> checked;
+        std::size_t position = 0;  /* in clock */
+    };
+
+    std::size_t budget;
+    std::size_t max_file;
+    Tick revalidate_after;
+    Clock::time_point const epoch;
+
+    std::size_t mask;
+    std::unique_ptr<std::atomic<Node*>[]> buckets;
+    EpochDomain epochs;
+
+    std::mutex writer;
+    std::vector<Node*> clock;  /* every linked node, swept by hand */
+    std::size_t hand = 0;
+    std::size_t used = 0;  /* bytes of the linked responses */
+    std::vector<std::pair<Node*, EpochDomain::Epoch>> retired;
+
+public:
+    /* `readers` is the number of threads that will call find(). */
+    ResponseCache(std::size_t budget, std::size_t max_file,
+                  std::chrono::milliseconds revalidate, std::size_t readers);
+    ~ResponseCache();
+
+    ResponseCache(ResponseCache&) = delete;
+    ResponseCache& operator=(ResponseCache&) = delete;
+
+    /* A reader id for find(), one per thread. */
+    auto join() -> std::size_t { return epochs.join(); }
+
+    /* Largest file whose responses are worth caching. */
+    [[nodiscard]]
+    auto max_file_size() const noexcept -> std::size_t { return max_file; }
+
+    /* The trusted response for `path`, or nullptr. Lock-free. */
+    [[nodiscard]]
+    auto find(std::size_t reader, std::string_view path) -> Response;
+
+    /* Trust the response for `path` for another interval if it was made
+     * from `version` of the file, and return it; nullptr otherwise. */
+    auto revalidate(std::string_view path, FileVersion const & version)
+            -> Response;
+
+    /* Cache `response` for `path`, replacing any older one. Ignored if it
+     * is over the size limits. */
+    void insert(std::string_view path, Response response);
+
+    [[nodiscard]]
+    auto size() -> std::size_t;
+
+    [[nodiscard]]
+    auto bytes() -> std::size_t;
+
+    /* Unlinked nodes still waiting for readers to move on. */
+    [[nodiscard]]
+    auto pending() -> std::size_t;
+
+private:
+    auto now() const -> Tick;
+    auto bucket(std::size_t hash) const -> std::atomic<Node*>&
+    {
+        return buckets[hash & mask];
+    }
+    auto locate(std::string_view path, std::size_t hash) const -> Node*;
+    void remove(Node* node);
+    void reclaim();
+};
+
+}  // namespace alewa
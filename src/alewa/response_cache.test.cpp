@@ -0,0 +1,151 @@
+#include "test/test_utils.hpp"
+
+#include <thread>
+#include <vector>
+
+#include "epoch.hpp"
+#include "response_cache.hpp"
+
+namespace alewa::test {
+
+namespace {
+
+using namespace std::chrono_literals;
+
+auto make_response(std::string_view head, std::string_view body,
+                   std::uint64_t ino = 1) -> ResponseCache::Response
+{
+    auto r = std::make_shared<CachedResponse>(
+            head, body.size(), FileVersion{ino, body.size(), 0, 0});
+    std::copy(body.begin(), body.end(), r->body().begin());
+    return r;
+}
+
+}  // namespace
+
+ALW_TEST(epoch_reclaims_after_readers_move_on)
+{
+    EpochDomain epochs{2};
+    std::size_t const a = epochs.join();
+    std::size_t const b = epochs.join();
+    ALW_EXPECT_EQ(a != b, true);
+
+    EpochDomain::Epoch retired_at;
+    {
+        auto const guard = epochs.pin(a);
+        retired_at = epochs.advance();  /* unlinked while `a` may look */
+        ALW_EXPECT_EQ(epochs.oldest_pinned() > retired_at, false);
+        {
+            auto const late = epochs.pin(b);  /* cannot see it any more */
+        }
+    }
+    ALW_EXPECT_EQ(epochs.oldest_pinned() > retired_at, true);
+
+    bool threw = false;
+    try { epochs.join(); } catch (std::runtime_error const &) { threw = true; }
+    ALW_EXPECT_EQ(threw, true);
+}
+
+ALW_TEST(response_cache_hit_and_head)
+{
+    ResponseCache cache{1 << 20, 1 << 10, 1000ms, 1};
+    std::size_t const reader = cache.join();
+    ALW_EXPECT_EQ(cache.find(reader, "/a") == nullptr, true);
+
+    cache.insert("/a", make_response("HEAD\r\n\r\n", "body"));
+    auto hit = cache.find(reader, "/a");
+    ALW_EXPECT_EQ(hit != nullptr, true);
+    ALW_EXPECT_EQ(hit->full(), "HEAD\r\n\r\nbody");
+    ALW_EXPECT_EQ(hit->head(), "HEAD\r\n\r\n");
+    ALW_EXPECT_EQ(cache.find(reader, "/b") == nullptr, true);
+
+    /* replaced: a response already being sent stays valid */
+    cache.insert("/a", make_response("H\r\n\r\n", "new", 2));
+    ALW_EXPECT_EQ(cache.find(reader, "/a")->full(), "H\r\n\r\nnew");
+    ALW_EXPECT_EQ(hit->full(), "HEAD\r\n\r\nbody");
+    ALW_EXPECT_EQ(cache.size(), 1ul);
+    ALW_EXPECT_EQ(cache.bytes(), 8ul);
+    ALW_EXPECT_EQ(cache.pending(), 0ul);  /* no reader was pinned */
+
+    /* over the per-file limit */
+    cache.insert("/big", make_response("", std::string(2000, 'x')));
+    ALW_EXPECT_EQ(cache.find(reader, "/big") == nullptr, true);
+}
+
+ALW_TEST(response_cache_revalidation)
+{
+    ResponseCache cache{1 << 20, 1 << 10, 0ms, 1};
+    std::size_t const reader = cache.join();
+    cache.insert("/a", make_response("h", "body", 7));
+
+    /* never trusted without a check */
+    ALW_EXPECT_EQ(cache.find(reader, "/a") == nullptr, true);
+    ALW_EXPECT_EQ(cache.revalidate("/a", {7, 4, 0, 0}) != nullptr, true);
+    ALW_EXPECT_EQ(cache.revalidate("/a", {8, 4, 0, 0}) == nullptr, true);
+    ALW_EXPECT_EQ(cache.revalidate("/b", {7, 4, 0, 0}) == nullptr, true);
+}
+
+ALW_TEST(response_cache_clock_eviction)
+{
+    ResponseCache cache{30, 30, 1000ms, 1};
+    std::size_t const reader = cache.join();
+    cache.insert("/a", make_response("", std::string(10, 'a')));
+    cache.insert("/b", make_response("", std::string(10, 'b')));
+    cache.insert("/c", make_response("", std::string(10, 'c')));
+    ALW_EXPECT_EQ(cache.bytes(), 30ul);
+
+    /* /a and /c were used since they went in, /b was not */
+    ALW_EXPECT_EQ(cache.find(reader, "/a") != nullptr, true);
+    ALW_EXPECT_EQ(cache.find(reader, "/c") != nullptr, true);
+    cache.insert("/d", make_response("", std::string(10, 'd')));
+    ALW_EXPECT_EQ(cache.find(reader, "/b") == nullptr, true);
+    ALW_EXPECT_EQ(cache.find(reader, "/a") != nullptr, true);
+    ALW_EXPECT_EQ(cache.find(reader, "/c") != nullptr, true);
+    ALW_EXPECT_EQ(cache.find(reader, "/d") != nullptr, true);
+
+    /* one big enough to push out all but one */
+    cache.insert("/e", make_response("", std::string(20, 'e')));
+    ALW_EXPECT_EQ(cache.bytes() <= 30, true);
+    ALW_EXPECT_EQ(cache.size(), 2ul);
+    ALW_EXPECT_EQ(cache.find(reader, "/e") != nullptr, true);
+}
+
+ALW_TEST(response_cache_concurrent_readers_and_writers)
+{
+    /* readers race eviction and replacement: every hit must be intact */
+    int const THREADS = 4;
+    ResponseCache cache{2000, 100, 1000ms, THREADS};
+    std::atomic<int> corrupt{0};
+
+    auto work = [&](unsigned seed) {
+        std::size_t const reader = cache.join();
+        for (unsigned i = 0; i < 20'000; ++i) {
+            seed = seed * 1103515245 + 12345;
+            std::string path = std::to_string((seed >> 8) % 64);
+            path.insert(path.begin(), '/');
+            if (auto hit = cache.find(reader, path)) {
+                std::string_view const body = hit->full().substr(path.size());
+                if (hit->head() != path
+                    || body != std::string(body.size(), path.back())) {
+                    ++corrupt;
+                }
+            }
+            else {
+                cache.insert(path, make_response(path,
+                                                 std::string(50, path.back())));
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < THREADS; ++i) {
+        threads.emplace_back(work, static_cast<unsigned>(i + 1));
+    }
+    for (auto& thread : threads) { thread.join(); }
+
+    ALW_EXPECT_EQ(corrupt.load(), 0);
+    ALW_EXPECT_EQ(cache.bytes() <= 2000, true);
+    ALW_EXPECT_EQ(cache.pending(), 0ul);
+}
+
+}  // namespace alewa::test
@@ -1,104 +1,383 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <string>
+#include <thread>
 #include <vector>
-#include <unordered_map>
+#include <optional>
+#include <exception>
+#include <stdexcept>
+#include <functional>
 
-#include "io/socket.hpp"
+#include "io/ring.hpp"
 #include "io/ioapi.hpp"
+#include "affinity.hpp"
+#include "config.hpp"
+#include "reactor.hpp"
+#include "exporter.hpp"
+#include "handoff.hpp"
+#include "loop.hpp"
+#include "task.hpp"
+#include "dispatch.hpp"
+#include "compressor.hpp"
+#include "work_pool.hpp"
+#include "listener.hpp"
+#include "tls.hpp"
+#include "uring_reactor.hpp"
+#include "response_cache.hpp"
 
 namespace alewa {
 
-namespace detail {
-/* Expose the various macros used by the system network API without polluting
- * the main namespace with functions that mutate global state. */
-#include <netdb.h>
-#include <fcntl.h>
-#include <poll.h>
-
-static int const TCP_STREAM = SOCK_STREAM;
-}  // namespace alewa::detail
-
+/* Runs config.threads reactors, one per thread, each accepting on its own
+ * SO_REUSEPORT listener, or with config.single_acceptor reactor 0 accepting
+ * for all of them through a Dispatch. start() serves on the calling thread
+ * as reactor 0 and returns once stop() has been called and every reactor
+ * has exited.
+ * With an io_uring capable API and kernel the reactors are UringReactors,
+ * otherwise epoll Reactors; the choice is made once, in start(). With
+ * config.admin_port set, reactor 0 also serves the exporter's page for the
+ * whole server, with config.unix_path it also accepts on that Unix socket,
+ * and with config.handoff_path it takes the listeners over from a running
+ * server and later hands them on the same way. With config.tls_port every
+ * reactor also runs a TlsAcceptor on its loop, which needs an IoApi over
+ * the kernel's sockets. Tasks given to spawn() run on every reactor's loop
+ * besides, offloading to a WorkPool of config.pool_threads if there is
+ * one. */
 template <io::IoApi T>
 class Server
 {
+public:
+    /* Makes the task for one reactor, given its loop and its index. */
+    using TaskFactory = std::function<Task<>(Loop<T>&, unsigned)>;
+
 private:
-    using PollFd = typename T::PollFd;
+    /* A reactor of either kind, as far as stop() is concerned. */
+    struct Handle
+    {
+        void* reactor;
+        void (*stop)(void*) noexcept;
+        void (*drain)(void*) noexcept;
+    };
+
     T const & ioapi;
+    ServerConfig config;
+
+    std::atomic<bool> stop_requested{false};
+    std::atomic<bool> drain_requested{false};
+    std::vector<Handle> handles;
+    std::atomic<std::size_t> nreactors{0};  /* published to stop() */
+    std::vector<TaskFactory> factories;
 
 public:
-    Server(T const & ioapi) : ioapi(ioapi) {}
-    void start(std::string const & port, int backlog);
+    Server(T const & ioapi, ServerConfig config = {})
+            : ioapi(ioapi), config(std::move(config)) {}
 
-private:
-    auto create_listener(std::string const & port) -> io::Socket<T>;
-    auto poll(std::vector<PollFd>& pollfds, int timeout) -> int;
+    /* Serve on `port` with listeners of config.backlog. */
+    void start(std::string const & port);
 
-    class Registry
+    /* Before start(): have every reactor run a task made by `factory`, e.g.
+     * one that accepts on a listener of its own and spawns a task for each
+     * client. Tasks are not drained: those still suspended when their
+     * reactor exits are destroyed. */
+    void spawn(TaskFactory factory)
     {
-    private:
-        std::unordered_map<int, io::Socket<T>> clients;
-        std::vector<PollFd> pollfds;
+        factories.push_back(std::move(factory));
+    }
 
-    public:
-        auto fds() noexcept -> std::vector<PollFd>& { return pollfds; }
-        void add(io::Socket<T>&& client);
-    };
+    /* Async-signal-safe; may be called before or during start(). */
+    void stop() noexcept;
+
+    /* Stop accepting and let start() return once the clients connected now
+     * have been answered. Async-signal-safe; may be called before or during
+     * start(). */
+    void drain() noexcept;
+
+private:
+    template <typename R>
+    void serve(std::string const & port);
+
+    auto open_listeners(std::string const & port, unsigned n,
+                        std::vector<io::Socket<T>>& tls)
+            -> std::vector<Listeners<T>>;
+
+    template <typename R>
+    void accept_tls(std::vector<std::unique_ptr<TlsAcceptor<T>>>& acceptors,
+                    TlsContext& tls, io::Socket<T> listener, R& reactor);
+
+    void stop_reactors() noexcept;
+    void drain_reactors() noexcept;
 };
 
 template <io::IoApi T>
-void Server<T>::start(std::string const & port, int backlog)
+void Server<T>::start(std::string const & port)
 {
-    Registry registry;
-    io::Socket<T> listener = create_listener(port);
-    registry.fds().push_back({listener.fd(), POLLIN, 0});
-    listener.listen(backlog);
-
-    int nready;
-    for (;;) {
-        nready = poll(registry.fds(), 0);  // TODO: retry on exception
-        if (nready == 0) { continue; }
-
-        if (registry.fds()[0].revents & POLLIN) {
-            io::SockInfo<T> client_info;
-            io::Socket<T> client = listener.accept(client_info);
-            registry.add(std::move(client));
+    if constexpr (io::UringApi<T>) {
+        if (config.io_uring && io::uring_supported(ioapi)) {
+            serve<UringReactor<T>>(port);
+            return;
         }
     }
+    serve<Reactor<T>>(port);
 }
 
 template <io::IoApi T>
-auto Server<T>::create_listener(std::string const & port) -> io::Socket<T>
+template <typename R>
+void Server<T>::serve(std::string const & port)
 {
-    typename T::AddrInfo hints{};
-    hints.ai_flags = AI_PASSIVE;
-    hints.ai_family = AF_UNSPEC;
-    hints.ai_socktype = detail::TCP_STREAM;
-
-    io::AddrInfoList<T> spec{ioapi, nullptr, port.c_str(), &hints};
-    io::Socket<T> socket{ioapi, spec};
-    socket.set_socket_option(SOL_SOCKET, SO_REUSEADDR, 1);
-    socket.set_file_option(F_SETFL, O_NONBLOCK);
-    socket.bind(*spec.current());
-    return socket;
+    unsigned const n = (config.threads == 0) ? 1 : config.threads;
+
+    std::unique_ptr<ResponseCache> responses;
+    if (config.response_cache_bytes > 0) {
+        responses = std::make_unique<ResponseCache>(
+                config.response_cache_bytes, config.response_cache_max_file,
+                config.file_cache_revalidate, n);
+    }
+
+    /* joined before the reactors go, as its jobs post to their loops */
+    std::optional<WorkPool> pool;
+    if (config.pool_threads > 0) {
+        pool.emplace(config.pool_threads, config.pool_queue);
+    }
+
+    /* compresses on the pool, which is joined before either goes */
+    std::unique_ptr<Compressor> compressor;
+    if (config.compressed_cache_bytes > 0) {
+        compressor = std::make_unique<Compressor>(config, n,
+                                                  pool ? &*pool : nullptr);
+    }
+
+    std::unique_ptr<TlsContext> tls;
+    if (!config.tls_port.empty()) {
+        if constexpr (!io::TlsApi<T>) {
+            throw std::runtime_error{"TLS needs the kernel's sockets"};
+        }
+        tls = std::make_unique<TlsContext>(config.tls_cert, config.tls_key,
+                                           config.tls_sessions);
+    }
+
+    auto stats = std::make_unique<ReactorStats[]>(n);
+    Metrics const * metrics = nullptr;
+    if constexpr (requires { ioapi.metrics(); }) { metrics = &ioapi.metrics(); }
+    Exporter const exporter{{stats.get(), n}, responses.get(), metrics,
+                            pool ? &*pool : nullptr, tls.get()};
+
+    std::optional<Handoff<T>> handoff;
+    std::vector<io::Socket<T>> tls_listeners;
+    auto listeners = open_listeners(port, n, tls_listeners);
+    if (!config.handoff_path.empty()) {
+        handoff.emplace(ioapi, config.handoff_path, config.backlog,
+                        [](void* s) noexcept {
+                            static_cast<Server*>(s)->drain();
+                        },
+                        this);
+        for (auto const & l : listeners) {
+            if (l.main) { handoff->offer(l.main->fd(), ListenerKind::MAIN); }
+        }
+        for (auto const & l : tls_listeners) {
+            handoff->offer(l.fd(), ListenerKind::TLS);
+        }
+        if (auto const & admin = listeners[0].admin) {
+            handoff->offer(admin->fd(), ListenerKind::ADMIN);
+        }
+        if (auto const & local = listeners[0].local) {
+            handoff->offer(local->fd(), ListenerKind::LOCAL);
+        }
+        listeners[0].handoff = &*handoff;
+    }
+
+    /* outlives the reactors, which wake each other through it */
+    std::optional<Dispatch<T>> dispatch;
+    if (config.single_acceptor && n > 1) {
+        dispatch.emplace(ioapi, n, config.dispatch_queue);
+        for (unsigned i = 0; i < n; ++i) {
+            listeners[i].dispatch = &*dispatch;
+            listeners[i].worker = i;
+        }
+    }
+
+    /* outlive the reactors, whose loops hold their tasks */
+    std::vector<std::unique_ptr<TlsAcceptor<T>>> acceptors;
+
+    /* reserved up front so stop() never observes a reallocation */
+    std::vector<std::unique_ptr<R>> reactors;
+    reactors.reserve(n);
+    handles.reserve(n);
+    try {
+        for (unsigned i = 0; i < n; ++i) {
+            reactors.push_back(std::make_unique<R>(
+                    ioapi, config, std::move(listeners[i]), responses.get(),
+                    &stats[i], (i == 0) ? &exporter : nullptr,
+                    compressor.get()));
+            Loop<T>& loop = reactors.back()->loop();
+            if (pool) { loop.attach(*pool); }
+            if (tls) {
+                accept_tls<R>(acceptors, *tls, std::move(tls_listeners[i]),
+                              *reactors.back());
+            }
+            for (auto const & factory : factories) {
+                loop.spawn(factory(loop, i));
+            }
+            handles.push_back({
+                    reactors.back().get(),
+                    [](void* r) noexcept { static_cast<R*>(r)->stop(); },
+                    [](void* r) noexcept { static_cast<R*>(r)->drain(); }});
+            nreactors.store(i + 1, std::memory_order_release);
+        }
+    }
+    catch (...) {
+        nreactors.store(0, std::memory_order_release);
+        handles.clear();
+        throw;
+    }
+    if (drain_requested.load()) { drain_reactors(); }
+    if (stop_requested.load()) { stop_reactors(); }
+
+    std::vector<std::exception_ptr> errors(n);
+    auto run = [this, &reactors, &errors](std::size_t i) {
+        try {
+            if (!config.cpus.empty()) {
+                pin_current_thread(config.cpus[i % config.cpus.size()]);
+            }
+            reactors[i]->run();
+        }
+        catch (...) {
+            errors[i] = std::current_exception();
+            stop();  /* one reactor failing takes the server down */
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(n - 1);
+    for (std::size_t i = 1; i < n; ++i) {
+        threads.emplace_back(run, i);
+    }
+
+    run(0);
+    for (auto& thread : threads) { thread.join(); }
+
+    nreactors.store(0, std::memory_order_release);
+    handles.clear();
+    pool.reset();
+    reactors.clear();
+    for (auto const & error : errors) {
+        if (error) { std::rethrow_exception(error); }
+    }
+}
+
+/* A listener per reactor, or only for reactor 0 with a single acceptor,
+ * the Unix socket and admin listener for reactor 0, and into `tls` a TLS
+ * listener per reactor, taken over from the server at config.handoff_path
+ * if there is one, and listening. */
+template <io::IoApi T>
+auto Server<T>::open_listeners(std::string const & port, unsigned n,
+                               std::vector<io::Socket<T>>& tls)
+        -> std::vector<Listeners<T>>
+{
+    Inherited<T> inherited;
+    if (!config.handoff_path.empty()) {
+        inherited = inherit_listeners(ioapi, config.handoff_path);
+    }
+
+    bool const shared = config.single_acceptor && n > 1;
+    std::vector<Listeners<T>> listeners(n);
+    for (unsigned i = 0; i < (shared ? 1 : n); ++i) {
+        auto& main = listeners[i].main;
+        if (i < inherited.listeners.size()) {
+            main.emplace(std::move(inherited.listeners[i]));
+        }
+        else {
+            main.emplace(create_listener(ioapi, port, n > 1 && !shared));
+        }
+        main->listen(config.backlog);
+    }
+
+    if (!config.unix_path.empty()) {
+        auto& local = listeners[0].local;
+        if (inherited.local) { local.emplace(std::move(*inherited.local)); }
+        else { local.emplace(create_unix_listener(ioapi, config.unix_path)); }
+        local->listen(config.backlog);
+    }
+
+    if (!config.admin_port.empty()) {
+        auto& admin = listeners[0].admin;
+        if (inherited.admin) { admin.emplace(std::move(*inherited.admin)); }
+        else {
+            admin.emplace(create_listener(ioapi, config.admin_port, false,
+                                          config.admin_host.c_str()));
+        }
+        admin->listen(config.backlog);
+    }
+
+    if (!config.tls_port.empty()) {
+        for (unsigned i = 0; i < n; ++i) {
+            if (i < inherited.tls.size()) {
+                tls.push_back(std::move(inherited.tls[i]));
+            }
+            else {
+                tls.push_back(create_listener(ioapi, config.tls_port, true));
+            }
+            tls.back().listen(config.backlog);
+        }
+    }
+    return listeners;
+}
+
+/* An acceptor on `reactor`'s loop that serves it the clients of its TLS
+ * listener through their handshakes, and stops once the reactor drains. */
+template <io::IoApi T>
+template <typename R>
+void Server<T>::accept_tls(
+        std::vector<std::unique_ptr<TlsAcceptor<T>>>& acceptors,
+        TlsContext& tls, io::Socket<T> listener, R& reactor)
+{
+    if constexpr (io::TlsApi<T>) {
+        Loop<T>& loop = reactor.loop();
+        acceptors.push_back(std::make_unique<TlsAcceptor<T>>(
+                ioapi, loop, tls, std::move(listener), config.header_timeout,
+                [](void* r, io::Socket<T> client) {
+                    static_cast<R*>(r)->serve_client(std::move(client));
+                },
+                &reactor));
+        loop.spawn(acceptors.back()->run());
+        reactor.on_drain(
+                [](void* a) noexcept {
+                    static_cast<TlsAcceptor<T>*>(a)->stop();
+                },
+                acceptors.back().get());
+    }
+}
+
+template <io::IoApi T>
+void Server<T>::stop() noexcept
+{
+    stop_requested.store(true);
+    stop_reactors();
 }
 
 template <io::IoApi T>
-auto Server<T>::poll(std::vector<PollFd>& pollfds, int timeout) -> int
+void Server<T>::stop_reactors() noexcept
 {
-    int const ret = ioapi.poll(&pollfds[0], pollfds.size(), timeout);
-    if (ret == T::ERROR) {
-        throw std::runtime_error{"poll failed: " + ioapi.error()};
+    std::size_t const n = nreactors.load(std::memory_order_acquire);
+    for (std::size_t i = 0; i < n; ++i) {
+        handles[i].stop(handles[i].reactor);
     }
-    return ret;
 }
 
 template <io::IoApi T>
-void Server<T>::Registry::add(io::Socket<T>&& client)
+void Server<T>::drain() noexcept
 {
-    if (clients.find(client.fd()) == clients.end()) { return; }
-    pollfds.push_back({client.fd(), POLLIN, 0});
-    clients.insert(std::pair{client.fd(), std::move(client)});
+    drain_requested.store(true);
+    drain_reactors();
+}
+
+template <io::IoApi T>
+void Server<T>::drain_reactors() noexcept
+{
+    std::size_t const n = nreactors.load(std::memory_order_acquire);
+    for (std::size_t i = 0; i < n; ++i) {
+        handles[i].drain(handles[i].reactor);
+    }
 }
 
 }  // namespace alewa
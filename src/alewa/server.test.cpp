@@ -0,0 +1,73 @@
+#include "test/test_utils.hpp"
+
+#include "server.hpp"
+#include "io/sockapi_mock.hpp"
+
+namespace alewa::test {
+
+using io::test::MockEpollIoApi;
+
+ALW_TEST(server_stop_before_start_joins_all_reactors)
+{
+    MockEpollIoApi api;
+    MockEpollIoApi::SockAddr addr{};
+    api.ai.ai_addr = &addr;
+
+    ServerConfig config;
+    config.threads = 4;
+    Server<MockEpollIoApi> server{api, config};
+    server.stop();
+    server.start("8080");  /* returns once every reactor has exited */
+
+    /* each reactor registered its waker and listener with its own poller */
+    ALW_EXPECT_EQ(api.interests.size(), 4ul);
+    for (auto const & [epfd, interest] : api.interests) {
+        ALW_EXPECT_EQ(interest.size(), 2ul);
+        ALW_EXPECT_EQ(interest.at(MockEpollIoApi::EVENT_FD), io::EV_IN);
+    }
+}
+
+ALW_TEST(server_serves_unix_socket_from_reactor_zero)
+{
+    MockEpollIoApi api;
+    MockEpollIoApi::SockAddr addr{};
+    api.ai.ai_addr = &addr;
+
+    ServerConfig config;
+    config.threads = 2;
+    config.unix_path = "@alewa";
+    api.sockets = {10, 11, 12};  /* two TCP listeners, then the Unix one */
+    Server<MockEpollIoApi> server{api, config};
+    server.stop();
+    server.start("8080");
+
+    /* a waker and a TCP listener each, and the Unix socket on the first */
+    ALW_EXPECT_EQ(api.interests.size(), 2ul);
+    auto const & first = api.interests.at(MockEpollIoApi::EPOLL_FD);
+    ALW_EXPECT_EQ(first.size(), 3ul);
+    ALW_EXPECT_EQ(first.contains(12), true);
+    ALW_EXPECT_EQ(api.interests.at(MockEpollIoApi::EPOLL_FD + 1).size(), 2ul);
+    ALW_EXPECT_EQ(api.bound.size(), detail::UNIX_PATH_OFFSET + 6);
+}
+
+ALW_TEST(server_single_acceptor_listens_on_reactor_zero_only)
+{
+    MockEpollIoApi api;
+    MockEpollIoApi::SockAddr addr{};
+    api.ai.ai_addr = &addr;
+
+    ServerConfig config;
+    config.threads = 3;
+    config.single_acceptor = true;
+    Server<MockEpollIoApi> server{api, config};
+    server.stop();
+    server.start("8080");
+
+    /* the others only wait for their wakers, and for clients handed over */
+    ALW_EXPECT_EQ(api.interests.size(), 3ul);
+    ALW_EXPECT_EQ(api.interests.at(MockEpollIoApi::EPOLL_FD).size(), 2ul);
+    ALW_EXPECT_EQ(api.interests.at(MockEpollIoApi::EPOLL_FD + 1).size(), 1ul);
+    ALW_EXPECT_EQ(api.interests.at(MockEpollIoApi::EPOLL_FD + 2).size(), 1ul);
+}
+
+}  // namespace alewa::test
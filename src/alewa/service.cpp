@@ -0,0 +1 @@
+#include "service.hpp"
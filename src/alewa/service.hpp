@@ -0,0 +1,439 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <optional>
+#include <unordered_map>
+
+#include "io/ioapi.hpp"
+#include "config.hpp"
+#include "buffer_pool.hpp"
+#include "compressor.hpp"
+#include "connection.hpp"
+#include "exporter.hpp"
+#include "file_cache.hpp"
+#include "timer_wheel.hpp"
+#include "response_cache.hpp"
+#include "http/path.hpp"
+#include "http/parser.hpp"
+#include "http/response.hpp"
+
+namespace alewa {
+
+namespace detail {
+/* See listener.hpp. */
+#include <sys/socket.h>
+
+/* not writev: a vanished peer must not raise SIGPIPE */
+static int const SEND_FLAGS = MSG_NOSIGNAL;
+}  // namespace alewa::detail
+
+/* Caches must keep the variants of a compressible file apart. */
+inline constexpr std::string_view VARY_FIELD = "Vary: Accept-Encoding\r\n";
+
+/* The HTTP side of a reactor: turns the requests in a connection's input
+ * into responses queued on its output, whichever way the reactor moves the
+ * bytes. Owned by one reactor and used from its thread only, but it may
+ * share a response cache with the other reactors. Connections from the
+ * admin listener are answered from the exporter instead of the docroot.
+ * Given a compressor, compressible files are negotiated by Accept-Encoding:
+ * a precompressed sibling or a cached gzip variant goes to a client that
+ * accepts one, the plain file to the others and until the variant is made.
+ * Siblings found missing are not looked for again until the revalidation
+ * interval has passed. */
+template <io::IoApi T>
+class Service
+{
+private:
+    T const & ioapi;
+    BufferPool& buffers;
+    FileCache<T> files;
+    ResponseCache* responses;
+    Exporter const * exporter;
+    Compressor* compressor;
+    std::size_t reader = 0;  /* our id with responses */
+    std::size_t variant_reader = 0;  /* and with the compressor's cache */
+    std::string path;  /* scratch for the normalized request path */
+    std::string key;  /* scratch for a variant's cache key */
+    std::string sibling;  /* scratch for a precompressed file's path */
+    std::string fields;  /* scratch for a response's header lines */
+    std::unordered_map<std::string, TimerWheel::Tick> absent;  /* siblings */
+    std::size_t absent_limit;
+    TimerWheel::Tick revalidate;
+    std::uint64_t served = 0;
+    bool draining = false;
+
+public:
+    Service(T const & ioapi, ServerConfig const & config, BufferPool& buffers,
+            ResponseCache* responses = nullptr,
+            Exporter const * exporter = nullptr,
+            Compressor* compressor = nullptr)
+            : ioapi(ioapi), buffers(buffers),
+              files(ioapi, config.docroot, config.file_cache_entries,
+                    config.file_cache_revalidate),
+              responses(responses), exporter(exporter),
+              compressor(compressor),
+              absent_limit(config.file_cache_entries),
+              revalidate(static_cast<TimerWheel::Tick>(
+                      config.file_cache_revalidate.count()))
+    {
+        if (responses) { reader = responses->join(); }
+        if (compressor) { variant_reader = compressor->cache().join(); }
+    }
+
+    Service(Service&) = delete;
+    Service& operator=(Service&) = delete;
+
+    /* Answer every complete request in the input, in order, queueing the
+     * responses so that a pipelined batch goes out in one write. Stops at a
+     * partial request, at the last request of the connection, or when the
+     * output buffer is full; the rest is picked up once it drains. `now`
+     * dates file cache lookups. */
+    void handle_input(Connection<T>& client, TimerWheel::Tick now);
+
+    /* Answer every request from now on with Connection: close. */
+    void drain() noexcept { draining = true; }
+
+    /* Requests answered so far, malformed ones included. */
+    [[nodiscard]]
+    auto requests() const noexcept -> std::uint64_t { return served; }
+
+private:
+    auto handle(Connection<T>& client, http::Request const & request,
+                bool keep_alive, TimerWheel::Tick now) -> bool;
+    auto handle_admin(Connection<T>& client, http::Request const & request,
+                      bool keep_alive) -> bool;
+    auto respond(Connection<T>& client, http::Response const & response,
+                 std::shared_ptr<StaticFile const> file = nullptr) -> bool;
+    auto respond(Connection<T>& client, ResponseCache::Response response,
+                 bool head_only) -> bool;
+    auto encoded(Connection<T>& client,
+                 std::shared_ptr<StaticFile const> const & file,
+                 unsigned codings, TimerWheel::Tick now, bool head_only)
+            -> std::optional<bool>;
+    auto precompressed(http::Coding coding, TimerWheel::Tick now)
+            -> std::shared_ptr<StaticFile const>;
+    auto plain_fields(StaticFile const & file, bool varies)
+            -> std::string_view;
+    auto render(StaticFile const & file, std::string_view content_type,
+                std::string_view lines) -> ResponseCache::Response;
+    static auto read(T const & ioapi, StaticFile const & file,
+                     std::span<char> into) -> bool;
+
+    static auto version(StaticFile const & file) noexcept -> FileVersion
+    {
+        return {file.ino, file.size, file.mtime_sec, file.mtime_nsec};
+    }
+};
+
+template <io::IoApi T>
+void Service<T>::handle_input(Connection<T>& client, TimerWheel::Tick now)
+{
+    using Status = http::Parser::Status;
+
+    while (client.keep_alive && !client.in.empty()) {
+        auto const data = client.in.readable();
+        Status const status = client.parser.parse({data.data(), data.size()});
+        if (status == Status::INCOMPLETE) { return; }
+
+        if (status == Status::ERROR) {
+            /* the stream cannot be resynchronized: answer and hang up */
+            int const code = http::error_status(client.parser.error());
+            client.keep_alive = false;
+            client.in.consume(client.in.size());
+            if (respond(client, {code, "text/plain", http::reason(code),
+                                 false})) {
+                ++served;
+            }
+            return;
+        }
+
+        http::Request const & request = client.parser.request();
+        bool const keep_alive = !draining && http::keep_alive(request);
+        bool const handled = client.admin
+                             ? handle_admin(client, request, keep_alive)
+                             : handle(client, request, keep_alive, now);
+        if (!handled) { return; }
+
+        ++served;
+        client.keep_alive = keep_alive;
+        client.in.consume(request.size);
+        client.parser.reset();
+    }
+}
+
+/* Answer a request from the document root. Returns what respond() does. */
+template <io::IoApi T>
+auto Service<T>::handle(Connection<T>& client, http::Request const & request,
+                        bool keep_alive, TimerWheel::Tick now) -> bool
+{
+    http::Response response{404, "text/plain", "Not Found\n", keep_alive,
+                            request.method == "HEAD"};
+
+    if (request.method != "GET" && !response.head_only) {
+        response = {405, "text/plain", "Method Not Allowed\n", keep_alive};
+        response.headers = "Allow: GET, HEAD\r\n";
+        return respond(client, response);
+    }
+    if (!http::normalize_path(request.target, path)) {
+        return respond(client, response);
+    }
+
+    /* cached responses say keep-alive, so a closing request makes its own;
+     * one that could take a variant not cached yet goes to the file */
+    bool const varies = compressor
+                        && http::compressible(http::content_type(path));
+    unsigned const codings = (varies && keep_alive)
+            ? http::accepted_codings(
+                      request.header("accept-encoding").value_or(""))
+            : 0;
+    for (http::Coding const coding : http::CODINGS) {
+        if (!(codings & http::coding_bit(coding))) { continue; }
+        Compressor::variant_key(path, coding, key);
+        if (auto cached = compressor->cache().find(variant_reader, key)) {
+            return respond(client, std::move(cached), response.head_only);
+        }
+    }
+    bool const cacheable = responses && keep_alive;
+    if (cacheable && codings == 0) {
+        if (auto cached = responses->find(reader, path)) {
+            return respond(client, std::move(cached), response.head_only);
+        }
+    }
+
+    auto file = files.find(path, now);
+    if (!file) { return respond(client, response); }
+
+    if (codings != 0) {
+        if (auto const served = encoded(client, file, codings, now,
+                                        response.head_only)) {
+            return *served;
+        }
+    }
+
+    if (cacheable && file->size <= responses->max_file_size()) {
+        auto cached = responses->revalidate(path, version(*file));
+        if (!cached
+            && (cached = render(*file, file->content_type,
+                                plain_fields(*file, varies)))) {
+            responses->insert(path, cached);
+        }
+        if (cached) {
+            return respond(client, std::move(cached), response.head_only);
+        }
+    }
+
+    response.status = 200;
+    response.content_type = file->content_type;
+    response.body = {};
+    response.headers = plain_fields(*file, varies);
+    response.content_length = file->size;
+    return respond(client, response, std::move(file));
+}
+
+/* The admin listener serves nothing but the exporter's page. */
+template <io::IoApi T>
+auto Service<T>::handle_admin(Connection<T>& client,
+                              http::Request const & request, bool keep_alive)
+        -> bool
+{
+    http::Response response{404, "text/plain", "Not Found\n", keep_alive,
+                            request.method == "HEAD"};
+
+    if (request.method != "GET" && !response.head_only) {
+        response = {405, "text/plain", "Method Not Allowed\n", keep_alive};
+        response.headers = "Allow: GET, HEAD\r\n";
+        return respond(client, response);
+    }
+    if (exporter == nullptr || !http::normalize_path(request.target, path)
+        || path != "/metrics") {
+        return respond(client, response);
+    }
+
+    auto page = std::make_shared<std::string const>(exporter->render());
+    response.status = 200;
+    response.content_type = Exporter::CONTENT_TYPE;
+    response.body = *page;
+    if (!respond(client, response)) { return false; }
+    client.sending.push_back(std::move(page));
+    return true;
+}
+
+/* Queue a response: its head is formatted into the output buffer, its body
+ * is referenced where it lies or sent straight from `file`. False if it has
+ * to wait for queued output to drain; if no buffer is to be had the
+ * connection is given up. */
+template <io::IoApi T>
+auto Service<T>::respond(Connection<T>& client,
+                         http::Response const & response,
+                         std::shared_ptr<StaticFile const> file) -> bool
+{
+    if (client.queue.space() < 2) { return false; }
+    if (!client.out) { client.out = buffers.acquire(); }
+    if (!client.out) {
+        client.keep_alive = false;
+        return false;
+    }
+
+    auto const space = client.out.writable();
+    std::size_t const n = http::write_head(response, space);
+    if (n == 0) {
+        /* heads already queued point into the buffer, so it cannot be
+         * compacted until they are sent */
+        if (client.queue.empty()) { client.keep_alive = false; }
+        return false;
+    }
+    client.out.commit(n);
+    client.queue.push({space.data(), n});
+    if (response.head_only) { return true; }
+
+    if (file) {
+        client.queue.push_file(file->fd, 0, file->size);
+        client.sending.push_back(std::move(file));
+    }
+    else {
+        client.queue.push(response.body);
+    }
+    return true;
+}
+
+/* Queue a cached response: a single segment, nothing to format. */
+template <io::IoApi T>
+auto Service<T>::respond(Connection<T>& client,
+                         ResponseCache::Response response, bool head_only)
+        -> bool
+{
+    if (client.queue.space() < 1) { return false; }
+    client.queue.push(head_only ? response->head() : response->full());
+    client.sending.push_back(std::move(response));
+    return true;
+}
+
+/* Answer with the best variant of `file` at `path` that the client
+ * accepts: a precompressed sibling, or gzip, which the pool reads and makes
+ * for later requests if there is one. Nothing if there is no variant to
+ * send yet. */
+template <io::IoApi T>
+auto Service<T>::encoded(Connection<T>& client,
+                         std::shared_ptr<StaticFile const> const & file,
+                         unsigned codings, TimerWheel::Tick now,
+                         bool head_only) -> std::optional<bool>
+{
+    ResponseCache& variants = compressor->cache();
+    for (http::Coding const coding : http::CODINGS) {
+        if (!(codings & http::coding_bit(coding))) { continue; }
+        auto stored = precompressed(coding, now);
+        if (!stored) { continue; }
+
+        Compressor::variant_key(path, coding, key);
+        fields = encoded_fields(plain_fields(*stored, true), coding,
+                                false);
+        if (stored->size <= variants.max_file_size()) {
+            auto cached = variants.revalidate(key, version(*stored));
+            if (!cached && (cached = render(*stored, file->content_type,
+                                            fields))) {
+                variants.insert(key, cached);
+            }
+            if (cached) {
+                return respond(client, std::move(cached), head_only);
+            }
+        }
+        http::Response response{200, file->content_type, {}, true, head_only};
+        response.headers = fields;
+        response.content_length = stored->size;
+        return respond(client, response, std::move(stored));
+    }
+
+    /* gzip on our own thread would stall every client of the reactor */
+    if (!compressor->offloads()
+        || !(codings & http::coding_bit(http::Coding::GZIP))
+        || file->size > variants.max_file_size()) {
+        return std::nullopt;
+    }
+    Compressor::variant_key(path, http::Coding::GZIP, key);
+    if (auto cached = variants.revalidate(key, version(*file))) {
+        return respond(client, std::move(cached), head_only);
+    }
+    if (!compressor->claim(key)) { return std::nullopt; }  /* under way */
+
+    /* the job keeps the file open until it has read it */
+    compressor->compress({key, file->content_type,
+                          std::string{plain_fields(*file, true)}, file->size,
+                          [&ioapi = ioapi, file](std::span<char> into) {
+                              return read(ioapi, *file, into);
+                          },
+                          version(*file)});
+    return std::nullopt;
+}
+
+/* The sibling of the file at `path` precompressed with `coding`, or
+ * nullptr. A missing one is remembered for the revalidation interval, so
+ * that a file without siblings costs no failed open per request. */
+template <io::IoApi T>
+auto Service<T>::precompressed(http::Coding coding, TimerWheel::Tick now)
+        -> std::shared_ptr<StaticFile const>
+{
+    sibling.assign(path);
+    sibling += http::coding_suffix(coding);
+    if (auto it = absent.find(sibling); it != absent.end()) {
+        if (now - it->second < revalidate) { return nullptr; }
+        absent.erase(it);
+    }
+    auto file = files.find(sibling, now);
+    if (!file) {
+        if (absent.size() >= absent_limit) { absent.clear(); }
+        absent.emplace(sibling, now);
+    }
+    return file;
+}
+
+/* The header lines of `file`'s plain response, which name Accept-Encoding
+ * in Vary if the file has variants. Valid until the next call. */
+template <io::IoApi T>
+auto Service<T>::plain_fields(StaticFile const & file, bool varies)
+        -> std::string_view
+{
+    if (!varies) { return file.headers; }
+    fields.assign(file.headers);
+    fields += VARY_FIELD;
+    return fields;
+}
+
+/* The complete 200 response with the contents of `file`, read into memory,
+ * or nullptr if the file could not be read in full. */
+template <io::IoApi T>
+auto Service<T>::render(StaticFile const & file,
+                        std::string_view content_type,
+                        std::string_view lines) -> ResponseCache::Response
+{
+    http::Response response{200, content_type, {}, true};
+    response.headers = lines;
+    response.content_length = file.size;
+
+    char head[1024];
+    std::size_t const n = http::write_head(response, head);
+    if (n == 0) { return nullptr; }
+
+    auto cached = std::make_shared<CachedResponse>(
+            std::string_view{head, n}, file.size, version(file));
+    if (!read(ioapi, file, cached->body())) { return nullptr; }
+    return cached;
+}
+
+/* False on an error, or if the file shrank. */
+template <io::IoApi T>
+auto Service<T>::read(T const & ioapi, StaticFile const & file,
+                      std::span<char> into) -> bool
+{
+    while (!into.empty()) {
+        auto const offset = static_cast<typename T::Off>(file.size
+                                                         - into.size());
+        auto const got = ioapi.pread(file.fd, into.data(), into.size(),
+                                     offset);
+        if (got <= 0) { return false; }
+        into = into.subspan(static_cast<std::size_t>(got));
+    }
+    return true;
+}
+
+}  // namespace alewa
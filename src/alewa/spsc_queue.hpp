@@ -0,0 +1,81 @@
+#pragma once
+
+#include <bit>
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+
+namespace alewa {
+
+/* A bounded single-producer single-consumer queue: one thread may push and
+ * one other thread pop, with no locks and no allocation after construction.
+ * Head and tail sit on cache lines of their own, and each side keeps a
+ * stale copy of the other's index so that it only reads the shared one when
+ * the queue looks full or empty. Capacity is rounded up to a power of 2. */
+template <typename V>
+    requires std::is_trivially_copyable_v<V>
+class SpscQueue
+{
+private:
+    struct alignas(64) Index
+    {
+        std::atomic<std::size_t> value{0};
+        std::size_t cached = 0;  /* the other side's, as last seen */
+    };
+
+    std::size_t mask;
+    std::unique_ptr<V[]> items;
+    Index head;  /* next to pop, advanced by the consumer */
+    Index tail;  /* next to push, advanced by the producer */
+
+public:
+    explicit SpscQueue(std::size_t capacity)
+            : mask(std::bit_ceil(std::max<std::size_t>(capacity, 1)) - 1),
+              items(std::make_unique<V[]>(mask + 1)) {}
+
+    SpscQueue(SpscQueue&) = delete;
+    SpscQueue& operator=(SpscQueue&) = delete;
+
+    [[nodiscard]]
+    auto capacity() const noexcept -> std::size_t { return mask + 1; }
+
+    /* Producer only. False if the queue is full. */
+    auto push(V value) noexcept -> bool
+    {
+        std::size_t const t = tail.value.load(std::memory_order_relaxed);
+        if (t - tail.cached > mask) {
+            tail.cached = head.value.load(std::memory_order_acquire);
+            if (t - tail.cached > mask) { return false; }
+        }
+        items[t & mask] = value;
+        tail.value.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /* Consumer only. False if the queue is empty. */
+    auto pop(V& value) noexcept -> bool
+    {
+        std::size_t const h = head.value.load(std::memory_order_relaxed);
+        if (h == head.cached) {
+            head.cached = tail.value.load(std::memory_order_acquire);
+            if (h == head.cached) { return false; }
+        }
+        value = items[h & mask];
+        head.value.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    /* From either side or a third thread: a snapshot, which may be stale by
+     * the time it is used. */
+    [[nodiscard]]
+    auto size() const noexcept -> std::size_t
+    {
+        std::size_t const h = head.value.load(std::memory_order_acquire);
+        std::size_t const t = tail.value.load(std::memory_order_acquire);
+        return t - h;
+    }
+};
+
+}  // namespace alewa
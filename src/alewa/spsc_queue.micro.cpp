@@ -0,0 +1,36 @@
+#include "bench/micro.hpp"
+
+#include <thread>
+
+#include "spsc_queue.hpp"
+
+namespace alewa::bench {
+
+/* The cost of one fd handed from an acceptor to a worker thread: state.size
+ * ints pushed by one thread and popped by another through a queue of 1024,
+ * as the single-acceptor topology does. */
+ALW_BENCH(spsc_queue_handoff)
+{
+    SpscQueue<int> queue{1024};
+    std::size_t const n = state.size;
+    state.time(n, [&] {
+        std::thread consumer{[&] {
+            int fd;
+            for (std::size_t got = 0; got < n;) {
+                if (!queue.pop(fd)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                keep(fd);
+                ++got;
+            }
+        }};
+        for (std::size_t i = 0; i < n;) {
+            if (queue.push(static_cast<int>(i))) { ++i; }
+            else { std::this_thread::yield(); }
+        }
+        consumer.join();
+    });
+}
+
+}  // namespace alewa::bench
@@ -0,0 +1,59 @@
+#include "test/test_utils.hpp"
+
+#include <thread>
+#include <cstddef>
+
+#include "spsc_queue.hpp"
+
+namespace alewa::test {
+
+ALW_TEST(spsc_queue_fifo_until_full)
+{
+    SpscQueue<int> queue{3};  /* rounded up to 4 */
+    ALW_EXPECT_EQ(queue.capacity(), 4ul);
+
+    int value = 0;
+    ALW_EXPECT_EQ(queue.pop(value), false);
+    for (int i = 1; i <= 4; ++i) { ALW_EXPECT_EQ(queue.push(i), true); }
+    ALW_EXPECT_EQ(queue.push(5), false);
+    ALW_EXPECT_EQ(queue.size(), 4ul);
+
+    /* the indices wrap around the slots many times over */
+    for (int i = 5; i < 100; ++i) {
+        ALW_EXPECT_EQ(queue.pop(value), true);
+        ALW_EXPECT_EQ(value, i - 4);
+        ALW_EXPECT_EQ(queue.push(i), true);
+    }
+    for (int i = 96; i < 100; ++i) {
+        ALW_EXPECT_EQ(queue.pop(value), true);
+        ALW_EXPECT_EQ(value, i);
+    }
+    ALW_EXPECT_EQ(queue.pop(value), false);
+    ALW_EXPECT_EQ(queue.size(), 0ul);
+}
+
+ALW_TEST(spsc_queue_between_threads)
+{
+    SpscQueue<std::size_t> queue{64};
+    std::size_t const n = 200'000;
+
+    std::thread producer{[&] {
+        for (std::size_t i = 0; i < n;) {
+            if (queue.push(i)) { ++i; }
+        }
+    }};
+    std::size_t expected = 0;
+    bool in_order = true;
+    while (expected < n) {
+        std::size_t value;
+        if (!queue.pop(value)) { continue; }
+        in_order = in_order && value == expected;
+        ++expected;
+    }
+    producer.join();
+
+    ALW_EXPECT_EQ(in_order, true);
+    ALW_EXPECT_EQ(queue.size(), 0ul);
+}
+
+}  // namespace alewa::test
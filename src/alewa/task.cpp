@@ -0,0 +1,34 @@
+#include "task.hpp"
+
+namespace alewa {
+
+auto TaskList::adopt(Task<>&& task) -> std::coroutine_handle<>
+{
+    auto& promise = task.frame.promise();
+    running.push_back({task.frame, &promise});
+    promise.owner = this;
+    promise.index = running.size() - 1;
+    return std::exchange(task.frame, {});
+}
+
+void TaskList::finish(detail::PromiseBase& promise) noexcept
+{
+    std::size_t const i = promise.index;
+    std::coroutine_handle<> const frame = running[i].frame;
+    if (promise.error) { ++failures; }
+
+    running[i] = running.back();
+    running[i].promise->index = i;
+    running.pop_back();
+    frame.destroy();
+}
+
+void TaskList::clear() noexcept
+{
+    /* a frame's destruction must not see the list it is being taken from */
+    std::vector<Entry> suspended;
+    suspended.swap(running);
+    for (Entry const & entry : suspended) { entry.frame.destroy(); }
+}
+
+}  // namespace alewa
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <optional>
+#include <concepts>
+#include <coroutine>
+#include <exception>
+
+#include "frame_pool.hpp"
+
+namespace alewa {
+
+template <typename V = void>
+class Task;
+
+class TaskList;
+
+namespace detail {
+
+/* What the first parameter of a task must be, or for a member task its
+ * object: the loop it runs on, whose pool its frame is taken from. A task
+ * declared otherwise does not compile, rather than quietly allocating. */
+template <typename L>
+concept FrameSource = requires(L& l)
+{
+    { l.frames() } -> std::same_as<FramePool&>;
+};
+
+struct PromiseBase
+{
+    std::coroutine_handle<> continuation{};  /* awaiting us, if awaited */
+    std::exception_ptr error{};
+    TaskList* owner = nullptr;  /* if spawned: the list to leave when done */
+    std::size_t index = 0;      /* in owner */
+
+    struct Final
+    {
+        auto await_ready() const noexcept -> bool { return false; }
+
+        template <typename P>
+        auto await_suspend(std::coroutine_handle<P> self) noexcept
+                -> std::coroutine_handle<>;
+
+        void await_resume() const noexcept {}
+    };
+
+    template <FrameSource L, typename... A>
+    static auto operator new(std::size_t size, L& loop, A&...) -> void*
+    {
+        return loop.frames().allocate(size);
+    }
+
+    static void operator delete(void* frame, std::size_t size) noexcept
+    {
+        FramePool::deallocate(frame, size);
+    }
+
+    auto initial_suspend() const noexcept -> std::suspend_always { return {}; }
+    auto final_suspend() const noexcept -> Final { return {}; }
+    void unhandled_exception() noexcept { error = std::current_exception(); }
+
+    void rethrow() const
+    {
+        if (error) { std::rethrow_exception(error); }
+    }
+};
+
+template <typename V>
+struct Promise : PromiseBase
+{
+    std::optional<V> value{};
+
+    template <std::convertible_to<V> U>
+    void return_value(U&& v) { value.emplace(std::forward<U>(v)); }
+
+    auto result() -> V
+    {
+        rethrow();
+        return std::move(*value);
+    }
+};
+
+template <>
+struct Promise<void> : PromiseBase
+{
+    void return_void() const noexcept {}
+    void result() const { rethrow(); }
+};
+
+}  // namespace alewa::detail
+
+/* A coroutine that yields a V: lazy, so nothing runs until it is awaited,
+ * which resumes the awaiting coroutine once it returns, or spawned on a
+ * Loop, which runs it on its own. An exception it lets escape is rethrown
+ * to the coroutine awaiting it. Its frame comes from its loop's FramePool
+ * and goes back there when the Task is destroyed. */
+template <typename V>
+class [[nodiscard]] Task
+{
+public:
+    struct promise_type : detail::Promise<V>
+    {
+        auto get_return_object() noexcept -> Task
+        {
+            return Task{std::coroutine_handle<promise_type>::from_promise(
+                    *this)};
+        }
+    };
+
+private:
+    using Handle = std::coroutine_handle<promise_type>;
+
+    friend class TaskList;
+
+    Handle frame;
+
+    struct Awaiter
+    {
+        Handle frame;
+
+        auto await_ready() const noexcept -> bool { return false; }
+
+        auto await_suspend(std::coroutine_handle<> awaiting) noexcept
+                -> std::coroutine_handle<>
+        {
+            frame.promise().continuation = awaiting;
+            return frame;
+        }
+
+        auto await_resume() -> V { return frame.promise().result(); }
+    };
+
+public:
+    Task(Task&& other) noexcept : frame(std::exchange(other.frame, {})) {}
+
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other) {
+            if (frame) { frame.destroy(); }
+            frame = std::exchange(other.frame, {});
+        }
+        return *this;
+    }
+
+    ~Task()
+    {
+        if (frame) { frame.destroy(); }
+    }
+
+    Task(Task&) = delete;
+    Task& operator=(Task&) = delete;
+
+    auto operator co_await() && noexcept -> Awaiter { return {frame}; }
+
+private:
+    explicit Task(Handle frame) noexcept : frame(frame) {}
+};
+
+/* The tasks a loop has spawned and not yet seen return. Each destroys its
+ * frame as it returns; the list destroys those still suspended when it is
+ * cleared or goes. An exception that escapes a spawned task ends only that
+ * task, and is counted. */
+class TaskList
+{
+private:
+    struct Entry
+    {
+        std::coroutine_handle<> frame;
+        detail::PromiseBase* promise;
+    };
+
+    std::vector<Entry> running;
+    std::uint64_t failures = 0;
+
+public:
+    TaskList() = default;
+    ~TaskList() { clear(); }
+
+    TaskList(TaskList&) = delete;
+    TaskList& operator=(TaskList&) = delete;
+
+    /* Take over `task`, which has not started; returns the handle that
+     * starts it. */
+    auto adopt(Task<>&& task) -> std::coroutine_handle<>;
+
+    /* Called by a spawned task as it returns: forget and destroy it. */
+    void finish(detail::PromiseBase& promise) noexcept;
+
+    void clear() noexcept;
+
+    [[nodiscard]]
+    auto size() const noexcept -> std::size_t { return running.size(); }
+
+    [[nodiscard]]
+    auto failed() const noexcept -> std::uint64_t { return failures; }
+};
+
+/* A spawned task leaves its list; an awaited one resumes its awaiter. */
+template <typename P>
+auto detail::PromiseBase::Final::await_suspend(
+        std::coroutine_handle<P> self) noexcept -> std::coroutine_handle<>
+{
+    PromiseBase& promise = self.promise();
+    if (promise.owner) {
+        promise.owner->finish(promise);
+        return std::noop_coroutine();
+    }
+    if (promise.continuation) { return promise.continuation; }
+    return std::noop_coroutine();
+}
+
+}  // namespace alewa
@@ -1 +1,39 @@
 #include "test_utils.hpp"
+
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+namespace alewa::test {
+
+auto connect_loopback(std::uint16_t port) -> int
+{
+    int const fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    ::sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<::sockaddr*>(&addr), sizeof(addr))) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+auto receive(int fd, std::string const & until) -> std::string
+{
+    std::string got;
+    ::pollfd pending{fd, POLLIN, 0};
+    while (::poll(&pending, 1, 5'000) == 1) {
+        char chunk[4096];
+        auto const n = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) { break; }
+        got.append(chunk, static_cast<std::size_t>(n));
+        if (!until.empty() && got.ends_with(until)) { break; }
+    }
+    return got;
+}
+
+}  // namespace alewa::test
@@ -2,6 +2,7 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
 #include <iostream>
 #include <sstream>
 
@@ -61,4 +62,11 @@ std::string pretty_err(std::string const & expr, T const & a, U const & x)
            + to_str(x);
 }
 
+/* A blocking TCP socket connected to `port` on 127.0.0.1, or -1. */
+auto connect_loopback(std::uint16_t port) -> int;
+
+/* What `fd` receives until the peer has sent `until`, or hangs up if it is
+ * empty; gives up after a few seconds of silence. */
+auto receive(int fd, std::string const & until = {}) -> std::string;
+
 }  // namespace alewa::test
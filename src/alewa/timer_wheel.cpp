@@ -0,0 +1,126 @@
+#include "timer_wheel.hpp"
+
+namespace alewa {
+
+TimerWheel::TimerWheel(Tick now) : current(now)
+{
+    for (auto& level : heads) { level.fill(NIL); }
+}
+
+void TimerWheel::schedule(int id, Tick deadline)
+{
+    if (static_cast<std::size_t>(id) >= nodes.size()) {
+        nodes.resize(static_cast<std::size_t>(id) + 1);
+    }
+    if (scheduled(id)) { unlink(id); }
+
+    at(id).deadline = deadline;
+    place(id, (deadline > current) ? deadline : current + 1);
+}
+
+void TimerWheel::cancel(int id)
+{
+    if (scheduled(id)) { unlink(id); }
+}
+
+auto TimerWheel::scheduled(int id) const -> bool
+{
+    return static_cast<std::size_t>(id) < nodes.size()
+           && nodes[static_cast<std::size_t>(id)].level != NIL;
+}
+
+auto TimerWheel::next_timeout() const -> std::optional<Tick>
+{
+    for (int level = 0; level < LEVELS; ++level) {
+        if (occupied[static_cast<std::size_t>(level)] == 0) { continue; }
+
+        int const shift = SLOT_BITS * level;
+        int const index = static_cast<int>((current >> shift) & (SLOTS - 1));
+        Tick const block = Tick{1} << (shift + SLOT_BITS);
+        Tick const base = current & ~(block - 1);
+
+        /* slots past the current index belong to this rotation, the rest
+         * (only possible for clamped far deadlines) to the next one */
+        std::uint64_t const bits = occupied[static_cast<std::size_t>(level)];
+        std::uint64_t const later = (index == SLOTS - 1)
+                ? 0
+                : bits >> (index + 1);
+        Tick start;
+        if (later != 0) {
+            int const slot = index + 1 + __builtin_ctzll(later);
+            start = base + (static_cast<Tick>(slot) << shift);
+        }
+        else {
+            int const slot = __builtin_ctzll(bits);
+            start = base + block + (static_cast<Tick>(slot) << shift);
+        }
+        return start - current;
+    }
+    return std::nullopt;
+}
+
+void TimerWheel::place(int id, Tick deadline)
+{
+    if (deadline < current) { deadline = current; }
+    if (deadline - current > MAX_SPAN) { deadline = current + MAX_SPAN; }
+
+    /* the lowest level whose higher-order bits agree with the current time is
+     * the one that will be swept exactly when the deadline is reached */
+    int level = 0;
+    while (level < LEVELS - 1
+           && (deadline >> (SLOT_BITS * (level + 1)))
+              != (current >> (SLOT_BITS * (level + 1)))) {
+        ++level;
+    }
+    int const slot = static_cast<int>((deadline >> (SLOT_BITS * level))
+                                      & (SLOTS - 1));
+    link(id, level, slot);
+}
+
+void TimerWheel::link(int id, int level, int slot)
+{
+    int& head = heads[static_cast<std::size_t>(level)]
+                     [static_cast<std::size_t>(slot)];
+    Node& node = at(id);
+    node.level = level;
+    node.slot = slot;
+    node.prev = NIL;
+    node.next = head;
+    if (node.next != NIL) { at(node.next).prev = id; }
+    head = id;
+    auto const l = static_cast<std::size_t>(level);
+    occupied[l] |= std::uint64_t{1} << slot;
+    ++count;
+}
+
+void TimerWheel::unlink(int id)
+{
+    Node& node = at(id);
+    auto const l = static_cast<std::size_t>(node.level);
+    int& head = heads[l][static_cast<std::size_t>(node.slot)];
+    if (node.prev != NIL) { at(node.prev).next = node.next; }
+    else { head = node.next; }
+    if (node.next != NIL) { at(node.next).prev = node.prev; }
+    if (head == NIL) { occupied[l] &= ~(std::uint64_t{1} << node.slot); }
+    node.level = NIL;
+    --count;
+}
+
+void TimerWheel::cascade()
+{
+    for (int level = 1; level < LEVELS; ++level) {
+        int const shift = SLOT_BITS * level;
+        auto const slot = static_cast<std::size_t>((current >> shift)
+                                                   & (SLOTS - 1));
+        int id = heads[static_cast<std::size_t>(level)][slot];
+        while (id != NIL) {
+            int const next = at(id).next;
+            unlink(id);
+            place(id, at(id).deadline);
+            id = next;
+        }
+        if (slot != 0) { return; }
+    }
+}
+
+}  // namespace alewa
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <optional>
+
+namespace alewa {
+
+/* Hierarchical timing wheel keyed by small integer ids (file descriptors).
+ * Each id has at most one pending deadline; scheduling, rescheduling and
+ * cancelling are O(1), and expiry is O(1) amortized per timer: an entry is
+ * cascaded at most once per level on its way down to level 0. Time is an
+ * abstract, monotonically increasing tick count supplied by the caller. */
+class TimerWheel
+{
+public:
+    using Tick = std::uint64_t;
+
+    static int const SLOT_BITS = 6;
+    static int const SLOTS = 1 << SLOT_BITS;
+    static int const LEVELS = 4;
+    static Tick const MAX_SPAN = (Tick{1} << (SLOT_BITS * LEVELS)) - 1;
+
+private:
+    static int const NIL = -1;
+
+    struct Node
+    {
+        int prev = NIL;
+        int next = NIL;
+        int level = NIL;  /* NIL when not scheduled */
+        int slot = 0;
+        Tick deadline = 0;
+    };
+
+    Tick current;
+    std::size_t count = 0;
+    std::vector<Node> nodes;
+    std::array<std::array<int, SLOTS>, LEVELS> heads;
+    std::array<std::uint64_t, LEVELS> occupied{};
+
+public:
+    explicit TimerWheel(Tick now = 0);
+
+    /* Deadlines at or before now() fire on the next advance. */
+    void schedule(int id, Tick deadline);
+    void cancel(int id);
+
+    [[nodiscard]] auto scheduled(int id) const -> bool;
+    [[nodiscard]] auto size() const noexcept -> std::size_t { return count; }
+    [[nodiscard]] auto now() const noexcept -> Tick { return current; }
+
+    /* Ticks until the wheel next needs to advance, or nullopt when empty.
+     * May be earlier than the nearest deadline when a higher level has to
+     * cascade first; it is never later. */
+    [[nodiscard]] auto next_timeout() const -> std::optional<Tick>;
+
+    /* Move time forward to `now`, calling on_expire(id) for every timer whose
+     * deadline has passed. The callback may schedule or cancel timers. */
+    template <typename F>
+    void advance(Tick now, F&& on_expire);
+
+private:
+    auto at(int id) -> Node& { return nodes[static_cast<std::size_t>(id)]; }
+
+    void place(int id, Tick deadline);
+    void link(int id, int level, int slot);
+    void unlink(int id);
+    void cascade();
+};
+
+template <typename F>
+void TimerWheel::advance(Tick now, F&& on_expire)
+{
+    while (current < now) {
+        if (count == 0) { current = now; return; }
+
+        /* skip straight to the block boundary when the rest of the current
+         * level-0 block is empty */
+        int const index = static_cast<int>(current & (SLOTS - 1));
+        std::uint64_t const later = (index == SLOTS - 1)
+                ? 0
+                : occupied[0] >> (index + 1);
+        if (later == 0) {
+            Tick const boundary = (current | (SLOTS - 1)) + 1;
+            current = (boundary <= now) ? boundary : now;
+        }
+        else {
+            current += static_cast<Tick>(__builtin_ctzll(later)) + 1;
+            if (current > now) { current = now; return; }
+        }
+
+        if ((current & (SLOTS - 1)) == 0) { cascade(); }
+
+        int const slot = static_cast<int>(current & (SLOTS - 1));
+        while (heads[0][static_cast<std::size_t>(slot)] != NIL) {
+            int const id = heads[0][static_cast<std::size_t>(slot)];
+            unlink(id);
+            on_expire(id);
+        }
+    }
+}
+
+}  // namespace alewa
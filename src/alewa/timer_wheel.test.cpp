@@ -0,0 +1,141 @@
+#include "test/test_utils.hpp"
+
+#include <map>
+#include <random>
+#include <algorithm>
+
+#include "timer_wheel.hpp"
+
+namespace alewa::test {
+
+ALW_TEST(timer_wheel_expires_in_order)
+{
+    TimerWheel wheel{100};
+    wheel.schedule(1, 105);
+    wheel.schedule(2, 103);
+    wheel.schedule(3, 5000);
+    ALW_EXPECT_EQ(wheel.size(), 3ul);
+    ALW_EXPECT_EQ(*wheel.next_timeout(), TimerWheel::Tick{3});
+
+    std::vector<int> fired;
+    auto collect = [&fired](int id) { fired.push_back(id); };
+
+    wheel.advance(104, collect);
+    ALW_EXPECT_EQ(fired.size(), 1ul);
+    ALW_EXPECT_EQ(fired[0], 2);
+
+    wheel.advance(4999, collect);
+    ALW_EXPECT_EQ(fired.size(), 2ul);
+    ALW_EXPECT_EQ(fired[1], 1);
+
+    wheel.advance(5000, collect);
+    ALW_EXPECT_EQ(fired.size(), 3ul);
+    ALW_EXPECT_EQ(fired[2], 3);
+    ALW_EXPECT_EQ(wheel.size(), 0ul);
+    ALW_EXPECT_EQ(wheel.next_timeout().has_value(), false);
+}
+
+ALW_TEST(timer_wheel_reschedule_and_cancel)
+{
+    TimerWheel wheel;
+    wheel.schedule(7, 10);
+    wheel.schedule(7, 20);  /* replaces the earlier deadline */
+    wheel.schedule(8, 15);
+    wheel.cancel(8);
+    ALW_EXPECT_EQ(wheel.scheduled(7), true);
+    ALW_EXPECT_EQ(wheel.scheduled(8), false);
+    ALW_EXPECT_EQ(wheel.size(), 1ul);
+
+    int fired = 0;
+    wheel.advance(19, [&fired](int) { ++fired; });
+    ALW_EXPECT_EQ(fired, 0);
+    wheel.advance(20, [&fired](int) { ++fired; });
+    ALW_EXPECT_EQ(fired, 1);
+}
+
+ALW_TEST(timer_wheel_past_deadline_fires_on_next_tick)
+{
+    TimerWheel wheel{50};
+    wheel.schedule(1, 10);
+    ALW_EXPECT_EQ(*wheel.next_timeout(), TimerWheel::Tick{1});
+
+    int fired = 0;
+    wheel.advance(50, [&fired](int) { ++fired; });
+    ALW_EXPECT_EQ(fired, 0);
+    wheel.advance(51, [&fired](int) { ++fired; });
+    ALW_EXPECT_EQ(fired, 1);
+}
+
+ALW_TEST(timer_wheel_far_deadline_is_clamped_not_lost)
+{
+    TimerWheel wheel;
+    TimerWheel::Tick const far = TimerWheel::MAX_SPAN * 3;
+    wheel.schedule(1, far);
+
+    int fired = 0;
+    wheel.advance(far - 1, [&fired](int) { ++fired; });
+    ALW_EXPECT_EQ(fired, 0);
+    wheel.advance(far, [&fired](int) { ++fired; });
+    ALW_EXPECT_EQ(fired, 1);
+}
+
+ALW_TEST(timer_wheel_callback_may_reschedule)
+{
+    TimerWheel wheel;
+    wheel.schedule(1, 10);
+
+    int fired = 0;
+    wheel.advance(100, [&](int id) {
+        if (++fired < 5) { wheel.schedule(id, wheel.now() + 10); }
+    });
+    ALW_EXPECT_EQ(fired, 5);
+    ALW_EXPECT_EQ(wheel.size(), 0ul);
+}
+
+ALW_TEST(timer_wheel_matches_reference_model)
+{
+    std::mt19937_64 rng{42};
+    TimerWheel::Tick now = 1000;
+    TimerWheel wheel{now};
+    std::map<int, TimerWheel::Tick> model;
+
+    for (int round = 0; round < 2000; ++round) {
+        int const id = static_cast<int>(rng() % 64);
+        switch (rng() % 4) {
+        case 0:
+            wheel.cancel(id);
+            model.erase(id);
+            break;
+        default: {
+            TimerWheel::Tick const span = TimerWheel::Tick{1} << (rng() % 22);
+            TimerWheel::Tick const deadline = now + 1 + rng() % span;
+            wheel.schedule(id, deadline);
+            model[id] = deadline;
+        }
+        }
+
+        if (!model.empty()) {
+            auto earliest = std::min_element(
+                    model.begin(), model.end(),
+                    [](auto& a, auto& b) { return a.second < b.second; });
+            ALW_EXPECT_EQ(*wheel.next_timeout() <= earliest->second - now,
+                          true);
+        }
+
+        now += rng() % 4096;
+        std::vector<int> fired;
+        wheel.advance(now, [&fired](int id) { fired.push_back(id); });
+
+        std::vector<int> expected;
+        for (auto it = model.begin(); it != model.end();) {
+            if (it->second > now) { ++it; continue; }
+            expected.push_back(it->first);
+            it = model.erase(it);
+        }
+        std::sort(fired.begin(), fired.end());
+        ALW_EXPECT_EQ(fired == expected, true);
+        ALW_EXPECT_EQ(wheel.size(), model.size());
+    }
+}
+
+}  // namespace alewa::test
@@ -0,0 +1,172 @@
+#include "tls.hpp"
+
+#include <stdexcept>
+
+#include <openssl/bio.h>
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+
+namespace alewa {
+
+namespace {
+
+/* Sessions from another server, or another version of this one, are not
+ * resumed. */
+constexpr unsigned char SESSION_CONTEXT[] = "alewa";
+
+/* `what`, with the reason OpenSSL gave for the last error, if any. */
+auto failure(std::string what) -> std::runtime_error
+{
+    if (unsigned long const err = ::ERR_get_error()) {
+        char reason[256];
+        ::ERR_error_string_n(err, reason, sizeof(reason));
+        what += ": ";
+        what += reason;
+    }
+    ::ERR_clear_error();
+    return std::runtime_error{what};
+}
+
+}  // namespace
+
+TlsContext::TlsContext(std::string const & cert, std::string const & key,
+                       std::size_t sessions)
+        : ctx(::SSL_CTX_new(::TLS_server_method()))
+{
+    if (!ctx) { throw failure("cannot create TLS context"); }
+    try {
+        ::SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+        /* a client going away without close_notify ends its session like
+         * one that sent it: HTTP frames its own messages */
+        ::SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS
+                                   | SSL_OP_NO_RENEGOTIATION
+                                   | SSL_OP_CIPHER_SERVER_PREFERENCE
+                                   | SSL_OP_IGNORE_UNEXPECTED_EOF);
+        /* idle relays hold no record buffers */
+        ::SSL_CTX_set_mode(ctx, SSL_MODE_RELEASE_BUFFERS);
+
+        if (::SSL_CTX_use_certificate_chain_file(ctx, cert.c_str()) != 1) {
+            throw failure("cannot load TLS certificate " + cert);
+        }
+        if (::SSL_CTX_use_PrivateKey_file(ctx, key.c_str(),
+                                          SSL_FILETYPE_PEM) != 1
+            || ::SSL_CTX_check_private_key(ctx) != 1) {
+            throw failure("cannot load TLS key " + key);
+        }
+
+        ::SSL_CTX_set_session_id_context(ctx, SESSION_CONTEXT,
+                                         sizeof(SESSION_CONTEXT) - 1);
+        if (sessions > 0) {
+            ::SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+            ::SSL_CTX_sess_set_cache_size(ctx, static_cast<long>(sessions));
+        }
+        else { ::SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF); }
+    }
+    catch (...) {
+        ::SSL_CTX_free(ctx);
+        throw;
+    }
+}
+
+TlsContext::~TlsContext() { ::SSL_CTX_free(ctx); }
+
+void TlsContext::count(bool resumption, bool offload) noexcept
+{
+    auto constexpr relaxed = std::memory_order_relaxed;
+    handshakes.fetch_add(1, relaxed);
+    if (resumption) { resumed.fetch_add(1, relaxed); }
+    if (offload) { offloaded.fetch_add(1, relaxed); }
+}
+
+void TlsContext::count_failure() noexcept
+{
+    failed.fetch_add(1, std::memory_order_relaxed);
+}
+
+auto TlsContext::stats() const noexcept -> Stats
+{
+    auto constexpr relaxed = std::memory_order_relaxed;
+    return {handshakes.load(relaxed), resumed.load(relaxed),
+            offloaded.load(relaxed), failed.load(relaxed)};
+}
+
+TlsSession::TlsSession(TlsContext const & context, int fd)
+        : ssl(::SSL_new(context.native()))
+{
+    if (!ssl || ::SSL_set_fd(ssl, fd) != 1) {
+        ::SSL_free(ssl);
+        throw failure("cannot start TLS session");
+    }
+    ::SSL_set_accept_state(ssl);
+}
+
+TlsSession::~TlsSession() { ::SSL_free(ssl); }
+
+/* The error queue is per thread and shared by every session on it, so each
+ * call starts from an empty one and leaves it so. */
+auto TlsSession::handshake() noexcept -> TlsWait
+{
+    ::ERR_clear_error();
+    int const ret = ::SSL_do_handshake(ssl);
+    return (ret == 1) ? TlsWait::NONE : wait(ret);
+}
+
+auto TlsSession::read(std::span<char> into, std::size_t& n) noexcept
+        -> TlsWait
+{
+    ::ERR_clear_error();
+    int const ret = ::SSL_read_ex(ssl, into.data(), into.size(), &n);
+    return (ret == 1) ? TlsWait::NONE : wait(ret);
+}
+
+auto TlsSession::write(std::span<char const> data, std::size_t& n) noexcept
+        -> TlsWait
+{
+    ::ERR_clear_error();
+    int const ret = ::SSL_write_ex(ssl, data.data(), data.size(), &n);
+    return (ret == 1) ? TlsWait::NONE : wait(ret);
+}
+
+void TlsSession::close() noexcept
+{
+    ::ERR_clear_error();
+    (void) ::SSL_shutdown(ssl);
+    ::ERR_clear_error();
+}
+
+auto TlsSession::resumed() const noexcept -> bool
+{
+    return ::SSL_session_reused(ssl) == 1;
+}
+
+auto TlsSession::sends_offloaded() const noexcept -> bool
+{
+    return BIO_get_ktls_send(::SSL_get_wbio(ssl)) != 0;
+}
+
+auto TlsSession::receives_offloaded() const noexcept -> bool
+{
+    return BIO_get_ktls_recv(::SSL_get_rbio(ssl)) != 0;
+}
+
+auto TlsSession::pending() const noexcept -> bool
+{
+    return ::SSL_has_pending(ssl) == 1;
+}
+
+auto TlsSession::wait(int ret) noexcept -> TlsWait
+{
+    switch (::SSL_get_error(ssl, ret)) {
+    case SSL_ERROR_WANT_READ:
+        return TlsWait::READ;
+    case SSL_ERROR_WANT_WRITE:
+        return TlsWait::WRITE;
+    case SSL_ERROR_ZERO_RETURN:
+        return TlsWait::CLOSED;
+    default:
+        ::ERR_clear_error();
+        return TlsWait::FAILED;
+    }
+}
+
+}  // namespace alewa
@@ -0,0 +1,381 @@
+#pragma once
+
+#include <span>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "io/socket.hpp"
+#include "io/ioapi.hpp"
+#include "io/poller.hpp"
+#include "frame_pool.hpp"
+#include "loop.hpp"
+#include "task.hpp"
+
+/* OpenSSL's SSL_CTX and SSL, whose insides only tls.cpp sees. */
+struct ssl_ctx_st;
+struct ssl_st;
+
+namespace alewa {
+
+namespace detail {
+/* See listener.hpp. */
+#include <sys/socket.h>
+
+static int const RELAY_DOMAIN = AF_UNIX;
+static int const RELAY_TYPE = SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC;
+static int const SHUT_BOTH = SHUT_RDWR;
+}  // namespace alewa::detail
+
+/* What a TlsSession call that did not complete is waiting for: the socket
+ * to be readable or writable, or nothing more, as the peer closed the
+ * session or it failed. */
+enum class TlsWait { NONE, READ, WRITE, CLOSED, FAILED };
+
+/* A server's certificate, key and TLS settings, shared by every reactor:
+ * TLS 1.2 and 1.3 without renegotiation, with kernel TLS wherever the
+ * kernel and the negotiated cipher allow it. A client resumes its session
+ * from a ticket, or failing that from a cache of `sessions` entries, none
+ * if 0. Throws if the certificate chain or key at the given PEM paths
+ * cannot be loaded. Thread-safe. */
+class TlsContext
+{
+public:
+    struct Stats
+    {
+        std::uint64_t handshakes = 0;
+        std::uint64_t resumed = 0;
+        std::uint64_t offloaded = 0;  /* kernel TLS both ways */
+        std::uint64_t failed = 0;     /* timeouts included */
+    };
+
+private:
+    ssl_ctx_st* ctx;
+
+    std::atomic<std::uint64_t> handshakes{0};
+    std::atomic<std::uint64_t> resumed{0};
+    std::atomic<std::uint64_t> offloaded{0};
+    std::atomic<std::uint64_t> failed{0};
+
+public:
+    TlsContext(std::string const & cert, std::string const & key,
+               std::size_t sessions);
+    ~TlsContext();
+
+    TlsContext(TlsContext&) = delete;
+    TlsContext& operator=(TlsContext&) = delete;
+
+    [[nodiscard]]
+    auto native() const noexcept -> ssl_ctx_st* { return ctx; }
+
+    /* For the acceptors: a handshake done, and how; or one given up on. */
+    void count(bool resumption, bool offload) noexcept;
+    void count_failure() noexcept;
+
+    [[nodiscard]]
+    auto stats() const noexcept -> Stats;
+};
+
+/* The server side of one connection's TLS session, over a non-blocking
+ * socket that stays its owner's. Every call returns at once, saying what
+ * it waits for if it could not complete. */
+class TlsSession
+{
+private:
+    ssl_st* ssl;
+
+public:
+    /* Throws if OpenSSL cannot make one. */
+    TlsSession(TlsContext const & context, int fd);
+    ~TlsSession();
+
+    TlsSession(TlsSession&& other) noexcept
+            : ssl(std::exchange(other.ssl, nullptr)) {}
+    TlsSession& operator=(TlsSession&&) = delete;
+
+    auto handshake() noexcept -> TlsWait;
+
+    /* Decrypt into `into`, setting `n` to the bytes it got. */
+    auto read(std::span<char> into, std::size_t& n) noexcept -> TlsWait;
+
+    /* Encrypt from `data`, setting `n` to the bytes it took; after READ or
+     * WRITE the same data must be passed again. */
+    auto write(std::span<char const> data, std::size_t& n) noexcept
+            -> TlsWait;
+
+    /* Send close_notify if the socket takes it now. */
+    void close() noexcept;
+
+    [[nodiscard]]
+    auto resumed() const noexcept -> bool;
+
+    /* Whether the kernel encrypts what is written to the socket, and
+     * decrypts what is read from it. */
+    [[nodiscard]]
+    auto sends_offloaded() const noexcept -> bool;
+    [[nodiscard]]
+    auto receives_offloaded() const noexcept -> bool;
+
+    /* Whether OpenSSL holds received bytes that the socket no longer
+     * does. */
+    [[nodiscard]]
+    auto pending() const noexcept -> bool;
+
+private:
+    auto wait(int ret) noexcept -> TlsWait;
+};
+
+/* Terminates TLS for the clients of one listener, with tasks on a
+ * reactor's loop, and hands each client to the reactor once it is through
+ * the handshake, which must take no longer than `timeout`. When the kernel
+ * took the session over in both directions the reactor gets the socket
+ * itself, and serves it as any other, writev and sendfile included.
+ * Otherwise it gets one end of a socketpair, and two tasks relay between
+ * the other end and the session: one decrypting what the client sends, the
+ * other encrypting what the reactor answers, which kernel TLS still
+ * offloads where only sending is offloaded. Either one ending ends both.
+ * Handshakes and relays hold the loop, so that a draining reactor sees
+ * them through before it exits. Tasks and the acceptor must not outlive
+ * each other's loop; spawn run() there once, which needs an io::TlsApi. */
+template <io::IoApi T>
+class TlsAcceptor
+{
+public:
+    /* Hands a client the acceptor is done with to `reactor`. */
+    using Serve = void (*)(void* reactor, io::Socket<T> client);
+
+    /* A TLS record's worth of plaintext. */
+    static constexpr std::size_t CHUNK = 16 << 10;
+
+    /* How long a relay task waits for readiness the other one waits for
+     * already, as only a post-handshake message makes a read write or a
+     * write read. */
+    static constexpr std::chrono::milliseconds RETRY{1};
+
+    /* How long run() waits for fds or memory to be freed when out of
+     * either, before it accepts again. */
+    static constexpr std::chrono::milliseconds BACKOFF{10};
+
+private:
+    /* Shared by a relay's two tasks. */
+    struct Relay
+    {
+        io::Socket<T> client;
+        TlsSession session;
+        io::Socket<T> inner;  /* the reactor serves the other end */
+        std::array<char, CHUNK> received;
+        std::array<char, CHUNK> answered;
+        typename Loop<T>::Hold hold;  /* until both tasks are done */
+
+        Relay(io::Socket<T> client, TlsSession session, io::Socket<T> inner,
+              Loop<T>& loop)
+                : client(std::move(client)), session(std::move(session)),
+                  inner(std::move(inner)), hold(loop) {}
+    };
+
+    T const & ioapi;
+    Loop<T>& loop;
+    TlsContext& context;
+    io::Socket<T> listener;
+    std::chrono::milliseconds timeout;
+    Serve serve;
+    void* reactor;
+
+public:
+    TlsAcceptor(T const & ioapi, Loop<T>& loop, TlsContext& context,
+                io::Socket<T> listener, std::chrono::milliseconds timeout,
+                Serve serve, void* reactor)
+            : ioapi(ioapi), loop(loop), context(context),
+              listener(std::move(listener)), timeout(timeout), serve(serve),
+              reactor(reactor) {}
+
+    TlsAcceptor(TlsAcceptor&) = delete;
+    TlsAcceptor& operator=(TlsAcceptor&) = delete;
+
+    /* Accept until the listener fails for good or the loop goes; while the
+     * process or the system is out of fds or memory, back off instead. */
+    auto run() -> Task<>;
+
+    /* From the loop's thread: close the listener, whose clients are left
+     * to whoever else listens on its socket, and so end run(). Handshakes
+     * already under way go on. */
+    void stop() noexcept;
+
+    /* Where the acceptor's tasks take their frames from. */
+    [[nodiscard]]
+    auto frames() noexcept -> FramePool& { return loop.frames(); }
+
+private:
+    auto handshake(io::Socket<T> client) -> Task<>;
+    auto negotiate(TlsSession& session, int fd) -> Task<bool>;
+    auto expire(typename Loop<T>::Ticket ticket, int fd) -> Task<>;
+    void relay(io::Socket<T> client, TlsSession session);
+    auto inbound(std::shared_ptr<Relay> relay) -> Task<>;
+    auto outbound(std::shared_ptr<Relay> relay) -> Task<>;
+    auto settle(int fd, TlsWait wait, unsigned owned) -> Task<bool>;
+    void finish(Relay& relay) noexcept;
+};
+
+template <io::IoApi T>
+auto TlsAcceptor<T>::run() -> Task<>
+{
+    for (;;) {
+        auto client = co_await loop.accept(listener);
+        if (!client) {
+            if (client.fault() != io::Fault::EXHAUSTED) { co_return; }
+            co_await loop.sleep(BACKOFF);
+            continue;
+        }
+        loop.spawn(handshake(std::move(*client)));
+    }
+}
+
+template <io::IoApi T>
+void TlsAcceptor<T>::stop() noexcept
+{
+    /* run(), woken if it waits on the listener, finds it closed */
+    (void) loop.wake(listener.fd(), io::EV_IN);
+    io::Socket<T> const closed{std::move(listener)};
+}
+
+/* A client that stalls is shut down by expire(), which wakes the handshake
+ * to find it failed; one that gets through cancels expire()'s sleep, so
+ * that it goes before the fd can be someone else's. */
+template <io::IoApi T>
+auto TlsAcceptor<T>::handshake(io::Socket<T> client) -> Task<>
+{
+    typename Loop<T>::Hold const hold{loop};
+    TlsSession session{context, client.fd()};
+    auto const ticket = loop.ticket();
+    loop.spawn(expire(ticket, client.fd()));
+    bool const through = co_await negotiate(session, client.fd());
+    loop.cancel(ticket);
+    if (!through) {
+        context.count_failure();
+        co_return;
+    }
+
+    bool const offload = session.sends_offloaded()
+                         && session.receives_offloaded()
+                         && !session.pending();
+    context.count(session.resumed(), offload);
+    if (offload) {
+        /* the kernel holds the keys now, and the session goes without
+         * touching the socket */
+        serve(reactor, std::move(client));
+        co_return;
+    }
+    relay(std::move(client), std::move(session));
+}
+
+template <io::IoApi T>
+auto TlsAcceptor<T>::negotiate(TlsSession& session, int fd) -> Task<bool>
+{
+    for (;;) {
+        TlsWait const wait = session.handshake();
+        if (wait == TlsWait::NONE) { co_return true; }
+        if (!co_await settle(fd, wait, io::EV_IN | io::EV_OUT)) {
+            co_return false;
+        }
+    }
+}
+
+template <io::IoApi T>
+auto TlsAcceptor<T>::expire(typename Loop<T>::Ticket ticket, int fd)
+        -> Task<>
+{
+    bool const expired = co_await loop.sleep(timeout, ticket);
+    if (expired) { (void) ioapi.shutdown(fd, detail::SHUT_BOTH); }
+}
+
+template <io::IoApi T>
+void TlsAcceptor<T>::relay(io::Socket<T> client, TlsSession session)
+{
+    int pair[2];
+    if (ioapi.socketpair(detail::RELAY_DOMAIN, detail::RELAY_TYPE, 0, pair)
+        == T::ERROR) {
+        return;  /* out of fds: the client goes */
+    }
+    auto inner = io::Socket<T>::adopt(ioapi, pair[0]);
+    auto outer = io::Socket<T>::adopt(ioapi, pair[1]);
+    auto shared = std::make_shared<Relay>(std::move(client),
+                                          std::move(session),
+                                          std::move(inner), loop);
+    loop.spawn(inbound(shared));
+    loop.spawn(outbound(std::move(shared)));
+    serve(reactor, std::move(outer));
+}
+
+/* From the client to the reactor, until either hangs up. */
+template <io::IoApi T>
+auto TlsAcceptor<T>::inbound(std::shared_ptr<Relay> relay) -> Task<>
+{
+    int const fd = relay->client.fd();
+    for (;;) {
+        std::size_t n = 0;
+        TlsWait const wait = relay->session.read(relay->received, n);
+        if (wait == TlsWait::NONE) {
+            auto const sent = co_await loop.write(
+                    relay->inner, {relay->received.data(), n});
+            if (!sent) { break; }
+        }
+        else if (!co_await settle(fd, wait, io::EV_IN)) { break; }
+    }
+    finish(*relay);
+}
+
+/* From the reactor to the client, until the reactor closes its end, when
+ * the client is told with a close_notify. */
+template <io::IoApi T>
+auto TlsAcceptor<T>::outbound(std::shared_ptr<Relay> relay) -> Task<>
+{
+    int const fd = relay->client.fd();
+    bool broken = false;
+    while (!broken) {
+        auto const got = co_await loop.read(relay->inner, relay->answered);
+        if (!got || *got == 0) { break; }
+        std::span<char const> left{relay->answered.data(), *got};
+        while (!left.empty() && !broken) {
+            std::size_t n = 0;
+            TlsWait const wait = relay->session.write(left, n);
+            if (wait == TlsWait::NONE) { left = left.subspan(n); }
+            else { broken = !co_await settle(fd, wait, io::EV_OUT); }
+        }
+    }
+    if (!broken) { relay->session.close(); }
+    finish(*relay);
+}
+
+/* Wait for what the session waits for on `fd`, if `owned` is ours to wait
+ * for, else for RETRY. False if there is nothing to wait for. */
+template <io::IoApi T>
+auto TlsAcceptor<T>::settle(int fd, TlsWait wait, unsigned owned)
+        -> Task<bool>
+{
+    unsigned const events = (wait == TlsWait::READ) ? io::EV_IN
+                          : (wait == TlsWait::WRITE) ? io::EV_OUT
+                          : 0u;
+    if (events == 0) { co_return false; }
+    if ((events & owned) == 0) {
+        co_await loop.sleep(RETRY);
+        co_return true;
+    }
+    auto const ready = co_await loop.readiness(fd, events);
+    co_return static_cast<bool>(ready);
+}
+
+/* Wake the other task, and the reactor, to find the relay over. What was
+ * written to the client still goes out before its FIN. */
+template <io::IoApi T>
+void TlsAcceptor<T>::finish(Relay& relay) noexcept
+{
+    (void) ioapi.shutdown(relay.client.fd(), detail::SHUT_BOTH);
+    (void) ioapi.shutdown(relay.inner.fd(), detail::SHUT_BOTH);
+}
+
+}  // namespace alewa
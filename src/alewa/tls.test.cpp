@@ -0,0 +1,460 @@
+#include "test/test_utils.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <csignal>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <stdexcept>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+
+#include "io/ioapi_sys.hpp"
+#include "io/ring.hpp"
+#include "io/poller.hpp"
+#include "io/sockapi_mock.hpp"
+#include "server.hpp"
+#include "tls.hpp"
+
+namespace alewa::test {
+
+using namespace std::chrono_literals;
+using io::EpollIoApi;
+using io::IoUringIoApi;
+using io::test::MockIoApi;
+
+namespace {
+
+/* A self-signed certificate for localhost and its key, as PEM files in
+ * `dir`; their paths go to `cert` and `key`. */
+void make_certificate(std::string const & dir, std::string& cert,
+                      std::string& key)
+{
+    ::EVP_PKEY* pkey = ::EVP_PKEY_Q_keygen(nullptr, nullptr, "EC", "P-256");
+    ::X509* x509 = ::X509_new();
+    ::ASN1_INTEGER_set(::X509_get_serialNumber(x509), 1);
+    ::X509_gmtime_adj(::X509_getm_notBefore(x509), 0);
+    ::X509_gmtime_adj(::X509_getm_notAfter(x509), 3600);
+    ::X509_set_pubkey(x509, pkey);
+    ::X509_NAME* name = ::X509_get_subject_name(x509);
+    ::X509_NAME_add_entry_by_txt(
+            name, "CN", MBSTRING_ASC,
+            reinterpret_cast<unsigned char const *>("localhost"), -1, -1, 0);
+    ::X509_set_issuer_name(x509, name);
+    ::X509_sign(x509, pkey, ::EVP_sha256());
+
+    cert = dir + "/cert.pem";
+    key = dir + "/key.pem";
+    std::FILE* out = std::fopen(cert.c_str(), "w");
+    ::PEM_write_X509(out, x509);
+    std::fclose(out);
+    out = std::fopen(key.c_str(), "w");
+    ::PEM_write_PrivateKey(out, pkey, nullptr, nullptr, 0, nullptr, nullptr);
+    std::fclose(out);
+    ::X509_free(x509);
+    ::EVP_PKEY_free(pkey);
+}
+
+/* A temporary directory holding a certificate from make_certificate() and
+ * whatever files a test adds; all of it goes with this. */
+class TlsFiles
+{
+    std::vector<std::string> paths{};
+
+public:
+    std::string dir{};
+    std::string cert{};
+    std::string key{};
+
+    TlsFiles()
+    {
+        char name[] = "/tmp/alewa-tls-XXXXXX";
+        if (!::mkdtemp(name)) { throw std::runtime_error{"mkdtemp failed"}; }
+        dir = name;
+        make_certificate(dir, cert, key);
+        paths = {cert, key};
+    }
+
+    ~TlsFiles()
+    {
+        for (auto const & path : paths) { std::remove(path.c_str()); }
+        ::rmdir(dir.c_str());
+    }
+
+    TlsFiles(TlsFiles&) = delete;
+    TlsFiles& operator=(TlsFiles&) = delete;
+
+    /* `content` as `name` in dir. */
+    void add(std::string const & name, std::string const & content)
+    {
+        paths.push_back(dir + "/" + name);
+        std::ofstream{paths.back()} << content;
+    }
+};
+
+struct Fetched
+{
+    std::string response;
+    bool resumed = false;
+};
+
+/* One request over a new TLS connection, resuming `session` if there is
+ * one and replacing it with the one the server hands out; the answer, read
+ * until the server closes, and whether the session was resumed. */
+auto fetch_tls(::SSL_CTX* ctx, std::uint16_t port, ::SSL_SESSION*& session,
+               std::string const & request) -> Fetched
+{
+    Fetched fetched;
+    int const fd = connect_loopback(port);
+    if (fd < 0) { return fetched; }
+    ::SSL* ssl = ::SSL_new(ctx);
+    ::SSL_set_fd(ssl, fd);
+    if (session) { ::SSL_set_session(ssl, session); }
+    if (::SSL_connect(ssl) == 1) {
+        fetched.resumed = ::SSL_session_reused(ssl) == 1;
+        ::SSL_write(ssl, request.data(), static_cast<int>(request.size()));
+        char chunk[4096];
+        int n;
+        while ((n = ::SSL_read(ssl, chunk, sizeof(chunk))) > 0) {
+            fetched.response.append(chunk, static_cast<std::size_t>(n));
+        }
+        if (session) { ::SSL_SESSION_free(session); }
+        session = ::SSL_get1_session(ssl);
+        ::SSL_shutdown(ssl);
+    }
+    ::SSL_free(ssl);
+    ::close(fd);
+    return fetched;
+}
+
+/* A server serving HTTPS over loopback at `version`: a small file from the
+ * response cache, then, on a resumed session, one too large for it that
+ * goes out with sendfile. */
+template <io::IoApi T>
+void serve_over_tls(std::string& fail_expr, std::uint16_t port,
+                    int version)
+{
+    std::signal(SIGPIPE, SIG_IGN);  /* as the server's main does */
+    TlsFiles files;
+    std::string const big(300'000, 'b');
+    files.add("small.txt", "hello");
+    files.add("big.txt", big);
+
+    T api;
+    ServerConfig config;
+    config.docroot = files.dir;
+    config.tls_port = std::to_string(port + 1);
+    config.tls_cert = files.cert;
+    config.tls_key = files.key;
+    config.compressed_cache_bytes = 0;
+    Server<T> server{api, config};
+    std::thread thread{[&] { server.start(std::to_string(port)); }};
+
+    ::SSL_CTX* ctx = ::SSL_CTX_new(::TLS_client_method());
+    ::SSL_CTX_set_min_proto_version(ctx, version);
+    ::SSL_CTX_set_max_proto_version(ctx, version);
+    ::SSL_SESSION* session = nullptr;
+    auto const tls_port = static_cast<std::uint16_t>(port + 1);
+    Fetched first;
+    for (int i = 0; i < 500 && first.response.empty(); ++i) {
+        first = fetch_tls(ctx, tls_port, session,
+                          "GET /small.txt HTTP/1.1\r\n"
+                          "Connection: close\r\n\r\n");
+        if (first.response.empty()) { std::this_thread::sleep_for(1ms); }
+    }
+    Fetched const second = fetch_tls(ctx, tls_port, session,
+                                     "GET /big.txt HTTP/1.1\r\n"
+                                     "Connection: close\r\n\r\n");
+    ::SSL_SESSION_free(session);
+    ::SSL_CTX_free(ctx);
+    server.stop();
+    thread.join();
+
+    ALW_EXPECT_EQ(first.response.starts_with("HTTP/1.1 200 OK\r\n"), true);
+    ALW_EXPECT_EQ(first.response.ends_with("\r\n\r\nhello"), true);
+    ALW_EXPECT_EQ(first.resumed, false);
+    ALW_EXPECT_EQ(second.resumed, true);
+    ALW_EXPECT_EQ(second.response.starts_with("HTTP/1.1 200 OK\r\n"), true);
+    ALW_EXPECT_EQ(second.response.ends_with("\r\n\r\n" + big), true);
+}
+
+/* A server drained while a TLS client waits on its second request, of a
+ * file large enough that most of it is still to be encrypted when the
+ * reactor is done with it: it is answered in full, closing, before start()
+ * returns. */
+template <io::IoApi T>
+void drain_with_tls_client(std::string& fail_expr, std::uint16_t port)
+{
+    std::signal(SIGPIPE, SIG_IGN);
+    TlsFiles files;
+    std::string const big(300'000, 'b');
+    files.add("big.txt", big);
+
+    T api;
+    ServerConfig config;
+    config.docroot = files.dir;
+    config.tls_port = std::to_string(port + 1);
+    config.tls_cert = files.cert;
+    config.tls_key = files.key;
+    config.compressed_cache_bytes = 0;
+    Server<T> server{api, config};
+    std::thread thread{[&] { server.start(std::to_string(port)); }};
+
+    int fd = -1;
+    for (int i = 0; i < 500 && fd < 0; ++i) {
+        fd = connect_loopback(static_cast<std::uint16_t>(port + 1));
+        if (fd < 0) { std::this_thread::sleep_for(1ms); }
+    }
+    ::SSL_CTX* ctx = ::SSL_CTX_new(::TLS_client_method());
+    ::SSL_CTX_set_min_proto_version(ctx, TLS1_3_VERSION);
+    ::SSL* ssl = ::SSL_new(ctx);
+    ::SSL_set_fd(ssl, fd);
+    bool const connected = ::SSL_connect(ssl) == 1;
+
+    /* the first answer shows the reactor has the client */
+    std::string const request = "GET /big.txt HTTP/1.1\r\n\r\n";
+    std::string first;
+    std::string last;
+    char chunk[4096];
+    int n = 0;
+    ::SSL_write(ssl, request.data(), static_cast<int>(request.size()));
+    while (!first.ends_with(big)
+           && (n = ::SSL_read(ssl, chunk, sizeof(chunk))) > 0) {
+        first.append(chunk, static_cast<std::size_t>(n));
+    }
+    ::SSL_write(ssl, request.data(), static_cast<int>(request.size() - 2));
+    std::this_thread::sleep_for(50ms);  /* for the reactor to read it */
+    server.drain();
+    ::SSL_write(ssl, "\r\n", 2);
+    while ((n = ::SSL_read(ssl, chunk, sizeof(chunk))) > 0) {
+        last.append(chunk, static_cast<std::size_t>(n));
+    }
+    thread.join();
+    ::SSL_free(ssl);
+    ::SSL_CTX_free(ctx);
+    ::close(fd);
+
+    ALW_EXPECT_EQ(connected, true);
+    ALW_EXPECT_EQ(first.find("Connection: keep-alive\r\n") != first.npos,
+                  true);
+    ALW_EXPECT_EQ(last.starts_with("HTTP/1.1 200 OK\r\n"), true);
+    ALW_EXPECT_EQ(last.find("Connection: close\r\n") != last.npos, true);
+    ALW_EXPECT_EQ(last.ends_with("\r\n\r\n" + big), true);
+}
+
+}  // namespace
+
+ALW_TEST(tls_context_rejects_missing_certificate)
+{
+    std::string error;
+    try { TlsContext{"/nonexistent/cert.pem", "/nonexistent/key.pem", 16}; }
+    catch (std::runtime_error const & e) { error = e.what(); }
+    ALW_EXPECT_EQ(error.starts_with("cannot load TLS certificate"), true);
+}
+
+ALW_TEST(tls_handshakes_rendered_by_exporter)
+{
+    TlsFiles files;
+    TlsContext context{files.cert, files.key, 16};
+
+    context.count(false, false);
+    context.count(true, true);
+    context.count_failure();
+    ReactorStats stats;
+    Exporter const exporter{{&stats, 1}, nullptr, nullptr, nullptr,
+                            &context};
+    std::string const page = exporter.render();
+    ALW_EXPECT_EQ(page.find("# TYPE alewa_tls_handshakes_total counter\n")
+                  != page.npos, true);
+    ALW_EXPECT_EQ(page.find("alewa_tls_handshakes_total 2\n") != page.npos,
+                  true);
+    ALW_EXPECT_EQ(page.find("alewa_tls_resumed_total 1\n") != page.npos,
+                  true);
+    ALW_EXPECT_EQ(page.find("alewa_tls_offloaded_total 1\n") != page.npos,
+                  true);
+    ALW_EXPECT_EQ(page.find("alewa_tls_failed_total 1\n") != page.npos,
+                  true);
+}
+
+ALW_TEST(tls_epoll_server_serves_and_resumes_tls12)
+{
+    serve_over_tls<EpollIoApi>(fail_expr, 18618, TLS1_2_VERSION);
+}
+
+ALW_TEST(tls_epoll_server_serves_and_resumes_tls13)
+{
+    serve_over_tls<EpollIoApi>(fail_expr, 18620, TLS1_3_VERSION);
+}
+
+ALW_TEST(tls_uring_server_serves_and_resumes_tls13)
+{
+    IoUringIoApi api;
+    if (!io::uring_supported(api)) { return; }
+    serve_over_tls<IoUringIoApi>(fail_expr, 18622, TLS1_3_VERSION);
+}
+
+ALW_TEST(tls_epoll_server_drains_relayed_client)
+{
+    drain_with_tls_client<EpollIoApi>(fail_expr, 18629);
+}
+
+ALW_TEST(tls_uring_server_drains_relayed_client)
+{
+    IoUringIoApi api;
+    if (!io::uring_supported(api)) { return; }
+    drain_with_tls_client<IoUringIoApi>(fail_expr, 18631);
+}
+
+/* A client that never says hello is hung up on after header_timeout. */
+ALW_TEST(tls_handshake_times_out)
+{
+    TlsFiles files;
+
+    EpollIoApi api;
+    ServerConfig config;
+    config.docroot = files.dir;
+    config.tls_port = "18625";
+    config.tls_cert = files.cert;
+    config.tls_key = files.key;
+    config.header_timeout = 50ms;
+    Server<EpollIoApi> server{api, config};
+    std::thread thread{[&] { server.start("18624"); }};
+
+    int client = -1;
+    for (int i = 0; i < 500 && client < 0; ++i) {
+        client = connect_loopback(18625);
+        if (client < 0) { std::this_thread::sleep_for(1ms); }
+    }
+    ::pollfd hangup{client, POLLIN, 0};
+    int const ready = ::poll(&hangup, 1, 5'000);
+    char byte;
+    auto const n = ::recv(client, &byte, 1, 0);
+    ::close(client);
+    server.stop();
+    thread.join();
+
+    ALW_EXPECT_EQ(ready, 1);
+    ALW_EXPECT_EQ(n, 0l);
+}
+
+/* Out of fds, the acceptor waits a while and accepts again; a listener that
+ * is broken ends it, as does stopping it. */
+ALW_TEST(tls_acceptor_backs_off_and_stops)
+{
+    TlsFiles files;
+    TlsContext context{files.cert, files.key, 0};
+
+    MockIoApi api;
+    io::Poller<MockIoApi> poller{api};
+    Loop<MockIoApi> loop{api, poller};
+    TlsAcceptor<MockIoApi> acceptor{
+            api, loop, context, io::Socket<MockIoApi>::adopt(api, 7), 50ms,
+            [](void*, io::Socket<MockIoApi>) {}, nullptr};
+    api.backlog = {-EMFILE};
+
+    loop.spawn(acceptor.run());
+    loop.run();
+    ALW_EXPECT_EQ(loop.size(), 1ul);
+    ALW_EXPECT_EQ(loop.poll_timeout() > 0, true);
+
+    std::this_thread::sleep_for(TlsAcceptor<MockIoApi>::BACKOFF);
+    loop.run();  /* accepting again, with an empty backlog */
+    ALW_EXPECT_EQ(loop.size(), 1ul);
+    ALW_EXPECT_EQ(loop.poll_timeout(), -1);
+
+    api.backlog = {-EBADF};
+    ALW_EXPECT_EQ(loop.wake(7, io::EV_IN), true);
+    loop.run();
+    ALW_EXPECT_EQ(loop.size(), 0ul);
+
+    loop.spawn(acceptor.run());
+    loop.run();
+    ALW_EXPECT_EQ(loop.size(), 1ul);
+    acceptor.stop();
+    ALW_EXPECT_EQ(loop.wake(7, io::EV_IN), false);  /* no longer waited on */
+    loop.run();
+    ALW_EXPECT_EQ(loop.size(), 0ul);
+}
+
+/* A server restarted while a client keeps it serving: the successor takes
+ * its TLS listener over, and it stops accepting there itself, so that the
+ * successor alone answers TLS clients from then on. */
+ALW_TEST(tls_listener_handed_off_on_restart)
+{
+    std::signal(SIGPIPE, SIG_IGN);
+    TlsFiles files;
+    files.add("small.txt", "hello");
+
+    EpollIoApi api;
+    ServerConfig config;
+    config.docroot = files.dir;
+    config.tls_port = "18627";
+    config.tls_cert = files.cert;
+    config.tls_key = files.key;
+    config.compressed_cache_bytes = 0;
+    config.handoff_path = "/tmp/alewa-handoff-18626";
+    std::string const request = "GET /small.txt HTTP/1.1\r\n\r\n";
+
+    /* both answered by the old server before it drains: `idle` is hung up
+     * on as it does, `busy` once the request it has begun is answered */
+    Server<EpollIoApi> old_server{api, config};
+    std::thread old_thread{[&] { old_server.start("18626"); }};
+    int busy = -1;
+    for (int i = 0; i < 500 && busy < 0; ++i) {
+        busy = connect_loopback(18626);
+        if (busy < 0) { std::this_thread::sleep_for(1ms); }
+    }
+    int const idle = connect_loopback(18626);
+    char chunk[4096];
+    for (int const fd : {busy, idle}) {
+        ::send(fd, request.data(), request.size(), 0);
+        ::pollfd answer{fd, POLLIN, 0};
+        (void) ::poll(&answer, 1, 5'000);
+        (void) ::recv(fd, chunk, sizeof(chunk), 0);
+    }
+    ::send(busy, request.data(), request.size() - 2, 0);
+
+    Server<EpollIoApi> new_server{api, config};
+    std::thread new_thread{[&] { new_server.start("18626"); }};
+    ::pollfd hangup{idle, POLLIN, 0};
+    int const drained = ::poll(&hangup, 1, 5'000);
+    auto const eof = ::recv(idle, chunk, sizeof(chunk), 0);
+    ::close(idle);
+
+    ::SSL_CTX* ctx = ::SSL_CTX_new(::TLS_client_method());
+    int answered = 0;
+    for (int i = 0; i < 8; ++i) {
+        ::SSL_SESSION* session = nullptr;
+        Fetched const fetched = fetch_tls(ctx, 18627, session,
+                                          "GET /small.txt HTTP/1.1\r\n"
+                                          "Connection: close\r\n\r\n");
+        if (session) { ::SSL_SESSION_free(session); }
+        answered += fetched.response.ends_with("\r\n\r\nhello") ? 1 : 0;
+    }
+    ::SSL_CTX_free(ctx);
+
+    ::send(busy, "\r\n", 2, 0);
+    ::pollfd last{busy, POLLIN, 0};
+    while (::poll(&last, 1, 5'000) == 1
+           && ::recv(busy, chunk, sizeof(chunk), 0) > 0) {}
+    ::close(busy);
+    old_thread.join();
+    new_server.stop();
+    new_thread.join();
+    std::remove(config.handoff_path.c_str());
+
+    ALW_EXPECT_EQ(drained, 1);
+    ALW_EXPECT_EQ(eof, 0l);
+    ALW_EXPECT_EQ(answered, 8);
+}
+
+}  // namespace alewa::test
@@ -0,0 +1 @@
+#include "uring_reactor.hpp"
@@ -0,0 +1,720 @@
+#pragma once
+
+#include <span>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <deque>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <algorithm>
+
+#include <linux/io_uring.h>  /* kernel ABI only: structs and constants */
+
+#include "io/ring.hpp"
+#include "io/socket.hpp"
+#include "io/ioapi.hpp"
+#include "io/result.hpp"
+#include "io/waker.hpp"
+#include "config.hpp"
+#include "admission.hpp"
+#include "listener.hpp"
+#include "registry.hpp"
+#include "service.hpp"
+#include "exporter.hpp"
+#include "handoff.hpp"
+#include "loop.hpp"
+#include "dispatch.hpp"
+#include "response_cache.hpp"
+#include "buffer_pool.hpp"
+#include "connection.hpp"
+#include "deadlines.hpp"
+#include "output_queue.hpp"
+
+namespace alewa {
+
+namespace detail {
+/* See listener.hpp. */
+#include <poll.h>
+
+static unsigned const RING_FLAGS = IORING_SETUP_SUBMIT_ALL
+                                   | IORING_SETUP_COOP_TASKRUN;
+static unsigned const POLL_IN = POLLIN;
+static unsigned const POLL_OUT = POLLOUT;
+static std::size_t const RECV_BUFFER_SIZE = 4096;
+}  // namespace alewa::detail
+
+/* The completion-driven counterpart of Reactor: instead of waiting for
+ * readiness and then making system calls, it queues accepts, receives and
+ * sends on an io_uring and reacts to their completions, so a busy loop
+ * enters the kernel once per batch. One multishot accept keeps the listener
+ * fed; each client has one multishot receive that draws from a ring of
+ * provided buffers, so idle clients pin no receive memory. Response heads
+ * and bodies in memory go out with SENDMSG; file ranges are still sent with
+ * a synchronous sendfile, falling back to a poll for writability when the
+ * socket is full. Pausing accepts cancels the main and Unix listeners'
+ * accepts.
+ * Threading, draining, the other listeners, the dispatch and stats are as
+ * for Reactor. Its loop's tasks wait on an epoll instance of their own,
+ * which the ring polls. */
+template <io::UringApi T>
+class UringReactor
+{
+private:
+    enum class Op : std::uint8_t {
+        ACCEPT, RECV, SEND, WRITABLE, WAKE, CANCEL, HANDOFF, TASKS
+    };
+
+    /* What is in flight for an fd. Slots outlive their connections: the
+     * generation tells completions for a closed client from those for a
+     * new client that was given the same fd. */
+    struct Slot
+    {
+        std::uint32_t generation = 0;
+        bool receiving = false;
+        std::optional<Op> writing{};  /* SEND or WRITABLE */
+        std::array<typename T::IoVec, OutputQueue::MAX_SEGMENTS> iov{};
+        typename T::MsgHdr msg{};  /* read by the kernel until SEND ends */
+    };
+
+    /* A main or Unix listener's multishot accept: armed until its last
+     * completion, and whether a cancel for it has been submitted since it
+     * was armed, as one is all it takes. */
+    struct Arming
+    {
+        bool armed = false;
+        bool cancelling = false;
+    };
+
+    T const & ioapi;
+    ServerConfig const & config;
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> draining{false};
+    bool accepting = true;
+    Arming main_arming{};
+    Arming local_arming{};
+
+    std::deque<Slot> slots;  /* a deque: growing it must not move a msg */
+    io::Ring<T> ring;
+    io::BufferRing<T> inbound;
+    io::Waker<T> waker;
+    BufferPool buffers;  /* outlives the connections borrowing from it */
+    Registry<T> registry;
+    Deadlines deadlines;
+    io::Poller<T> waits;  /* the fds tasks wait on */
+    Loop<T> tasks;
+    Service<T> service;
+    Listeners<T> listeners;
+    /* called once accepting stops, with their contexts */
+    std::vector<std::pair<void (*)(void*) noexcept, void*>> drain_hooks;
+    Admission<T> admission;
+    ReactorStats* stats;
+
+public:
+    UringReactor(T const & ioapi, ServerConfig const & config,
+                 Listeners<T> listeners, ResponseCache* responses = nullptr,
+                 ReactorStats* stats = nullptr,
+                 Exporter const * exporter = nullptr,
+                 Compressor* compressor = nullptr);
+
+    UringReactor(UringReactor&) = delete;
+    UringReactor& operator=(UringReactor&) = delete;
+
+    /* Serve until stop() is called, or until drain() has been and the last
+     * client is gone, those of tasks holding loop() included. */
+    void run();
+
+    /* Submit queued work, wait for at least one completion, handle every
+     * completion that is ready, expire timers. */
+    void run_once();
+
+    /* Async-signal-safe. */
+    void stop() noexcept;
+
+    /* As Reactor::drain. */
+    void drain() noexcept;
+
+    [[nodiscard]]
+    auto buffer_pool() const noexcept -> BufferPool const & { return buffers; }
+
+    /* As Reactor::loop. */
+    [[nodiscard]]
+    auto loop() noexcept -> Loop<T>& { return tasks; }
+
+    /* As Reactor::serve_client. */
+    void serve_client(io::Socket<T> client)
+    {
+        adopt(client.release(), false);
+    }
+
+    /* As Reactor::on_drain. */
+    void on_drain(void (*hook)(void*) noexcept, void* context)
+    {
+        drain_hooks.emplace_back(hook, context);
+    }
+
+private:
+    static auto tag(Op op, std::uint32_t generation, int fd) noexcept
+            -> std::uint64_t
+    {
+        return std::uint64_t{static_cast<std::uint8_t>(op)} << 56
+               | std::uint64_t{generation & 0xffffff} << 32
+               | static_cast<std::uint32_t>(fd);
+    }
+
+    auto slot(int fd) -> Slot&;
+    auto arming(int listener) noexcept -> Arming*;
+
+    void accept(io::Socket<T> const & from);
+    auto hand_off(int fd) noexcept -> bool;
+    void take_clients();
+    void adopt(int fd, bool is_admin);
+    auto load() const noexcept -> std::size_t;
+    void admit();
+    void watch_waker();
+    void watch_handoff();
+    void watch_tasks();
+    void stop_accepting();
+    void receive(Connection<T>& client);
+    void poll_writable(Connection<T>& client);
+    void cancel(std::uint64_t user_data);
+
+    void complete(::io_uring_cqe const & cqe);
+    void accepted(::io_uring_cqe const & cqe, int from);
+    void received(Connection<T>& client, ::io_uring_cqe const & cqe);
+    void written(Connection<T>& client, Op op, int res);
+    auto append(Connection<T>& client, char const * data, std::size_t n)
+            -> bool;
+    void process(Connection<T>& client);
+    auto send(Connection<T>& client) -> bool;
+    void settle(Connection<T>& client);
+    void close(Connection<T>& client);
+};
+
+template <io::UringApi T>
+UringReactor<T>::UringReactor(T const & ioapi, ServerConfig const & config,
+                              Listeners<T> listeners,
+                              ResponseCache* responses, ReactorStats* stats,
+                              Exporter const * exporter,
+                              Compressor* compressor)
+        : ioapi(ioapi), config(config),
+          ring(ioapi, config.uring_entries, detail::RING_FLAGS),
+          inbound(ioapi, ring, 0, config.uring_buffers,
+                  detail::RECV_BUFFER_SIZE),
+          waker(ioapi), buffers(config.buffer_limits), deadlines(config),
+          waits(ioapi), tasks(ioapi, waits, &waker),
+          service(ioapi, config, buffers, responses, exporter, compressor),
+          listeners(std::move(listeners)), admission(ioapi, config),
+          stats(stats)
+{
+    watch_waker();
+    watch_tasks();
+    if (this->listeners.main) { accept(*this->listeners.main); }
+    if (this->listeners.local) { accept(*this->listeners.local); }
+    if (this->listeners.admin) { accept(*this->listeners.admin); }
+    if (this->listeners.handoff) { watch_handoff(); }
+    if (this->listeners.dispatch) {
+        this->listeners.dispatch->attach(this->listeners.worker, waker);
+    }
+}
+
+template <io::UringApi T>
+void UringReactor<T>::run()
+{
+    while (!stopping.load(std::memory_order_relaxed)
+           && (accepting || registry.size() > 0 || tasks.held() > 0)) {
+        run_once();
+    }
+}
+
+template <io::UringApi T>
+void UringReactor<T>::run_once()
+{
+    int const timeout = sooner(deadlines.poll_timeout(),
+                               admission.poll_timeout(deadlines.now()));
+    ring.submit(1, sooner(timeout, tasks.poll_timeout()));
+    ring.drain([this](::io_uring_cqe const & cqe) { complete(cqe); });
+    tasks.run();
+    if (listeners.dispatch) { listeners.dispatch->flush(); }
+    if (accepting && draining.load(std::memory_order_relaxed)) {
+        stop_accepting();
+    }
+    deadlines.expire([this](int fd) {
+        if (Connection<T>* client = registry.find(fd)) { close(*client); }
+    });
+    if (accepting) { admit(); }
+    if (listeners.dispatch) {
+        listeners.dispatch->publish(listeners.worker, registry.size());
+    }
+    if (stats) {
+        stats->publish(registry.size(), service.requests(), buffers,
+                       admission.paused(), admission.rejected());
+    }
+}
+
+template <io::UringApi T>
+void UringReactor<T>::stop() noexcept
+{
+    stopping.store(true, std::memory_order_relaxed);
+    waker.notify();
+}
+
+template <io::UringApi T>
+void UringReactor<T>::drain() noexcept
+{
+    draining.store(true, std::memory_order_relaxed);
+    waker.notify();
+}
+
+template <io::UringApi T>
+auto UringReactor<T>::slot(int fd) -> Slot&
+{
+    auto const i = static_cast<std::size_t>(fd);
+    if (i >= slots.size()) { slots.resize(i + 1); }
+    return slots[i];
+}
+
+template <io::UringApi T>
+void UringReactor<T>::accept(io::Socket<T> const & from)
+{
+    ::io_uring_sqe& sqe = ring.sqe();
+    sqe.opcode = IORING_OP_ACCEPT;
+    sqe.fd = from.fd();
+    sqe.ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe.accept_flags = static_cast<std::uint32_t>(detail::ACCEPT_FLAGS);
+    sqe.user_data = tag(Op::ACCEPT, 0, from.fd());
+    if (Arming* a = arming(from.fd())) { *a = {true, false}; }
+}
+
+/* The state of the main or Unix listener `listener`'s accept; nullptr for
+ * the admin listener, which admission control leaves alone. */
+template <io::UringApi T>
+auto UringReactor<T>::arming(int listener) noexcept -> Arming*
+{
+    if (listeners.main && listener == listeners.main->fd()) {
+        return &main_arming;
+    }
+    if (listeners.local && listener == listeners.local->fd()) {
+        return &local_arming;
+    }
+    return nullptr;
+}
+
+/* As Reactor::admit, except that pausing cancels the multishot accepts and
+ * resuming waits for their last completions before arming others. */
+template <io::UringApi T>
+void UringReactor<T>::admit()
+{
+    if (!listeners.main && !listeners.local) { return; }
+    bool const paused = admission.update(load(), buffers, deadlines.now());
+    for (auto const * l : {&listeners.main, &listeners.local}) {
+        if (!*l) { continue; }
+        Arming& a = *arming((*l)->fd());
+        if (paused && a.armed && !a.cancelling) {
+            cancel(tag(Op::ACCEPT, 0, (*l)->fd()));
+            a.cancelling = true;
+        }
+        else if (!paused && !a.armed) { accept(**l); }
+    }
+}
+
+template <io::UringApi T>
+void UringReactor<T>::watch_waker()
+{
+    ::io_uring_sqe& sqe = ring.sqe();
+    sqe.opcode = IORING_OP_POLL_ADD;
+    sqe.fd = waker.fd();
+    sqe.len = IORING_POLL_ADD_MULTI;
+    sqe.poll32_events = detail::POLL_IN;
+    sqe.user_data = tag(Op::WAKE, 0, waker.fd());
+}
+
+template <io::UringApi T>
+void UringReactor<T>::watch_tasks()
+{
+    ::io_uring_sqe& sqe = ring.sqe();
+    sqe.opcode = IORING_OP_POLL_ADD;
+    sqe.fd = waits.fd();
+    sqe.len = IORING_POLL_ADD_MULTI;
+    sqe.poll32_events = detail::POLL_IN;
+    sqe.user_data = tag(Op::TASKS, 0, waits.fd());
+}
+
+template <io::UringApi T>
+void UringReactor<T>::watch_handoff()
+{
+    int const fd = listeners.handoff->fd();
+    ::io_uring_sqe& sqe = ring.sqe();
+    sqe.opcode = IORING_OP_POLL_ADD;
+    sqe.fd = fd;
+    sqe.len = IORING_POLL_ADD_MULTI;
+    sqe.poll32_events = detail::POLL_IN;
+    sqe.user_data = tag(Op::HANDOFF, 0, fd);
+}
+
+/* As Reactor::stop_accepting. The multishot accepts and the handoff poll
+ * hold their own references to the sockets, so they are cancelled, which
+ * for poll-armed requests is done once the submission returns, before the
+ * listeners are closed. */
+template <io::UringApi T>
+void UringReactor<T>::stop_accepting()
+{
+    accepting = false;
+    service.drain();
+    if (listeners.main) { cancel(tag(Op::ACCEPT, 0, listeners.main->fd())); }
+    if (listeners.local) {
+        cancel(tag(Op::ACCEPT, 0, listeners.local->fd()));
+    }
+    if (listeners.admin) {
+        cancel(tag(Op::ACCEPT, 0, listeners.admin->fd()));
+    }
+    if (listeners.handoff) {
+        cancel(tag(Op::HANDOFF, 0, listeners.handoff->fd()));
+    }
+    ring.submit();
+    listeners = {.dispatch = listeners.dispatch, .worker = listeners.worker};
+    for (auto const & [hook, context] : drain_hooks) { hook(context); }
+
+    std::vector<int> idle;
+    registry.for_each([this, &idle](Connection<T>& client) {
+        if (!client.in.empty()) { return; }  /* will be answered, closing */
+        client.keep_alive = false;
+        if (!slot(client.fd()).writing && client.queue.empty()) {
+            idle.push_back(client.fd());
+        }
+    });
+    for (int const fd : idle) { close(*registry.find(fd)); }
+}
+
+template <io::UringApi T>
+void UringReactor<T>::receive(Connection<T>& client)
+{
+    Slot& s = slot(client.fd());
+    ::io_uring_sqe& sqe = ring.sqe();
+    sqe.opcode = IORING_OP_RECV;
+    sqe.fd = client.fd();
+    sqe.ioprio = IORING_RECV_MULTISHOT;
+    sqe.flags = IOSQE_BUFFER_SELECT;
+    sqe.buf_group = inbound.group_id();
+    sqe.user_data = tag(Op::RECV, s.generation, client.fd());
+    s.receiving = true;
+}
+
+template <io::UringApi T>
+void UringReactor<T>::poll_writable(Connection<T>& client)
+{
+    Slot& s = slot(client.fd());
+    ::io_uring_sqe& sqe = ring.sqe();
+    sqe.opcode = IORING_OP_POLL_ADD;
+    sqe.fd = client.fd();
+    sqe.poll32_events = detail::POLL_OUT;
+    sqe.user_data = tag(Op::WRITABLE, s.generation, client.fd());
+    s.writing = Op::WRITABLE;
+}
+
+template <io::UringApi T>
+void UringReactor<T>::cancel(std::uint64_t user_data)
+{
+    ::io_uring_sqe& sqe = ring.sqe();
+    sqe.opcode = IORING_OP_ASYNC_CANCEL;
+    sqe.addr = user_data;
+    sqe.user_data = tag(Op::CANCEL, 0, -1);
+}
+
+template <io::UringApi T>
+void UringReactor<T>::complete(::io_uring_cqe const & cqe)
+{
+    auto const op = static_cast<Op>(cqe.user_data >> 56);
+    auto const generation = static_cast<std::uint32_t>(
+            (cqe.user_data >> 32) & 0xffffff);
+    auto const fd = static_cast<int>(
+            static_cast<std::uint32_t>(cqe.user_data));
+    bool const more = cqe.flags & IORING_CQE_F_MORE;
+
+    switch (op) {
+    case Op::ACCEPT:
+        accepted(cqe, fd);
+        return;
+    case Op::WAKE:
+        waker.drain();
+        take_clients();
+        if (!more) { watch_waker(); }
+        return;
+    case Op::CANCEL:
+        return;
+    case Op::TASKS:
+        /* waking takes each fd out of the set, so this ends */
+        for (auto ready = waits.wait(0); !ready.empty();
+             ready = waits.wait(0)) {
+            for (io::Event const & event : ready) {
+                tasks.wake(event.fd, event.events);
+            }
+        }
+        if (!more) { watch_tasks(); }
+        return;
+    case Op::HANDOFF:
+        if (!accepting) { return; }
+        listeners.handoff->serve();
+        if (!more) { watch_handoff(); }
+        return;
+    default:
+        break;
+    }
+
+    Connection<T>* client = registry.find(fd);
+    if (client == nullptr || slot(fd).generation != generation) {
+        /* late news for a closed client; a buffer it took is still ours */
+        if (cqe.flags & IORING_CQE_F_BUFFER) {
+            inbound.recycle(static_cast<std::uint16_t>(
+                    cqe.flags >> IORING_CQE_BUFFER_SHIFT));
+        }
+        return;
+    }
+
+    if (op == Op::RECV) { received(*client, cqe); }
+    else { written(*client, op, cqe.res); }
+}
+
+/* `from` is the fd of the listener that accepted. */
+template <io::UringApi T>
+void UringReactor<T>::accepted(::io_uring_cqe const & cqe, int from)
+{
+    auto const & [main, local, admin, handoff, dispatch, worker] = listeners;
+    bool const is_admin = admin && from == admin->fd();
+    if (!is_admin && (cqe.res == -EMFILE || cqe.res == -ENFILE)) {
+        admission.shed(from, load(), deadlines.now());
+    }
+    if (!(cqe.flags & IORING_CQE_F_MORE)) {
+        if (Arming* a = arming(from)) { *a = {}; }
+        if (accepting && (is_admin || !admission.paused())) {
+            accept(is_admin ? *admin : (main && from == main->fd()) ? *main
+                                                                   : *local);
+        }
+    }
+    if (cqe.res < 0) { return; }  /* the re-armed accept retries */
+
+    /* handed off clients are woken for once the batch is done */
+    if (!is_admin && hand_off(cqe.res)) { return; }
+    adopt(cqe.res, is_admin);
+    if (!is_admin) { admit(); }
+}
+
+/* As Reactor::hand_off. */
+template <io::UringApi T>
+auto UringReactor<T>::hand_off(int fd) noexcept -> bool
+{
+    auto const & [main, local, admin, handoff, dispatch, worker] = listeners;
+    if (!dispatch) { return false; }
+    std::size_t const to = dispatch->pick();
+    return to != worker && dispatch->hand(to, fd);
+}
+
+template <io::UringApi T>
+void UringReactor<T>::take_clients()
+{
+    auto const & [main, local, admin, handoff, dispatch, worker] = listeners;
+    if (!dispatch) { return; }
+    dispatch->take(worker, [this](int fd) { adopt(fd, false); });
+}
+
+/* Register a client accepted here or handed over and start receiving. */
+template <io::UringApi T>
+void UringReactor<T>::adopt(int fd, bool is_admin)
+{
+    Slot& s = slot(fd);
+    s.receiving = false;
+    s.writing.reset();
+    auto added = registry.try_add(io::Socket<T>::adopt(ioapi, fd));
+    if (!added) { return; }  /* and closed */
+    Connection<T>& client = **added;
+    client.admin = is_admin;
+    deadlines.arm(client, Deadline::HEADER);
+    receive(client);
+    if (listeners.dispatch) {
+        listeners.dispatch->publish(listeners.worker, registry.size());
+    }
+}
+
+/* As Reactor::load. */
+template <io::UringApi T>
+auto UringReactor<T>::load() const noexcept -> std::size_t
+{
+    if (listeners.dispatch) { return listeners.dispatch->least_load(); }
+    return registry.size();
+}
+
+template <io::UringApi T>
+void UringReactor<T>::received(Connection<T>& client,
+                               ::io_uring_cqe const & cqe)
+{
+    Slot& s = slot(client.fd());
+    if (!(cqe.flags & IORING_CQE_F_MORE)) { s.receiving = false; }
+
+    if (cqe.res == -ENOBUFS) {
+        /* every buffer was taken: the ones this batch frees will do */
+        receive(client);
+        return;
+    }
+    if (cqe.res <= 0) {
+        close(client);  /* EOF or error */
+        return;
+    }
+
+    auto const id = static_cast<std::uint16_t>(
+            cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+    bool const kept = append(client, inbound.data(id),
+                             static_cast<std::size_t>(cqe.res));
+    inbound.recycle(id);
+    if (!kept) {
+        close(client);
+        return;
+    }
+    if (!s.receiving) { receive(client); }
+    process(client);
+}
+
+template <io::UringApi T>
+void UringReactor<T>::written(Connection<T>& client, Op op, int res)
+{
+    slot(client.fd()).writing.reset();
+    if (res < 0 && !io::transient(-res)) {
+        close(client);
+        return;
+    }
+    if (op == Op::SEND && res > 0) {
+        client.queue.consume(static_cast<std::size_t>(res));
+    }
+    process(client);
+}
+
+/* Copy received bytes into the client's input buffer, borrowing one from
+ * the pool if it has none and growing it if a request outgrows it. False
+ * when no buffer is left. */
+template <io::UringApi T>
+auto UringReactor<T>::append(Connection<T>& client, char const * data,
+                             std::size_t n) -> bool
+{
+    while (n > 0) {
+        if (!client.in) { client.in = buffers.acquire(); }
+        if (!client.in) { return false; }
+        if (client.in.full()) { client.in.compact(); }
+        if (client.in.full() && !buffers.grow(client.in)) { return false; }
+
+        auto const space = client.in.writable();
+        std::size_t const k = std::min(n, space.size());
+        std::memcpy(space.data(), data, k);
+        client.in.commit(k);
+        data += k;
+        n -= k;
+    }
+    return true;
+}
+
+/* Answer what the input holds and send what that queued. A send in flight
+ * only references bytes already in the output buffer and queue, which new
+ * responses are appended behind, so this is safe at any time. */
+template <io::UringApi T>
+void UringReactor<T>::process(Connection<T>& client)
+{
+    service.handle_input(client, deadlines.now());
+    if (!send(client)) {
+        close(client);
+        return;
+    }
+    settle(client);
+}
+
+/* Start sending queued output unless a send is already in flight: memory
+ * segments go out with one SENDMSG, file ranges with sendfile until the
+ * socket is full. False if the connection is broken. */
+template <io::UringApi T>
+auto UringReactor<T>::send(Connection<T>& client) -> bool
+{
+    Slot& s = slot(client.fd());
+    while (!s.writing && !client.queue.empty()) {
+        if (auto range = client.queue.front_file()) {
+            auto offset = static_cast<typename T::Off>(range->offset);
+            auto const n = ioapi.sendfile(client.fd(), range->fd, &offset,
+                                          range->size);
+            if (n == 0) { return false; }  /* the file shrank under us */
+            if (n > 0) {
+                client.queue.consume(static_cast<std::size_t>(n));
+            }
+            else if (io::classify(ioapi.errnum()) == io::Fault::AGAIN) {
+                poll_writable(client);
+            }
+            else if (!io::transient(ioapi.errnum())) {
+                return false;
+            }
+            continue;
+        }
+
+        s.msg = {};
+        s.msg.msg_iov = s.iov.data();
+        s.msg.msg_iovlen = client.queue.gather(
+                std::span<typename T::IoVec>{s.iov});
+        ::io_uring_sqe& sqe = ring.sqe();
+        sqe.opcode = IORING_OP_SENDMSG;
+        sqe.fd = client.fd();
+        sqe.addr = reinterpret_cast<std::uint64_t>(&s.msg);
+        sqe.len = 1;
+        sqe.msg_flags = static_cast<std::uint32_t>(detail::SEND_FLAGS);
+        sqe.user_data = tag(Op::SEND, s.generation, client.fd());
+        s.writing = Op::SEND;
+    }
+
+    if (!s.writing && client.queue.empty()) {
+        client.out.consume(client.out.size());
+        client.sending.clear();
+    }
+    return true;
+}
+
+/* Point the timer wheel at what the client waits for next, as
+ * Reactor::settle does; the receive stays armed throughout. */
+template <io::UringApi T>
+void UringReactor<T>::settle(Connection<T>& client)
+{
+    if (slot(client.fd()).writing || !client.queue.empty()) {
+        deadlines.arm(client, Deadline::WRITE);
+        return;
+    }
+    client.out.release();
+
+    if (!client.keep_alive) {
+        close(client);
+        return;
+    }
+    if (client.in.empty()) {
+        client.in.release();
+        deadlines.arm(client, Deadline::IDLE);
+    }
+    else if (client.deadline != Deadline::HEADER) {
+        deadlines.arm(client, Deadline::HEADER);
+    }
+}
+
+/* Cancel what is in flight before the socket goes: a pending SENDMSG must
+ * not read the output buffer once it is back in the pool. The cancellations
+ * are submitted right away, and a poll-armed request is cancelled before
+ * the submission returns. */
+template <io::UringApi T>
+void UringReactor<T>::close(Connection<T>& client)
+{
+    int const fd = client.fd();
+    Slot& s = slot(fd);
+    if (s.receiving) { cancel(tag(Op::RECV, s.generation, fd)); }
+    if (s.writing) { cancel(tag(*s.writing, s.generation, fd)); }
+    if (s.receiving || s.writing) { ring.submit(); }
+
+    s.receiving = false;
+    s.writing.reset();
+    ++s.generation;
+    deadlines.cancel(fd);
+    registry.remove(fd);
+}
+
+}  // namespace alewa
@@ -0,0 +1,72 @@
+#include "test/test_utils.hpp"
+
+#include <string>
+#include <fstream>
+#include <cstdlib>
+#include <sys/socket.h>
+
+#include "io/ioapi_sys.hpp"
+#include "io/ring.hpp"
+#include "uring_reactor.hpp"
+
+namespace alewa::test {
+
+using io::IoUringIoApi;
+
+/* Against the kernel over loopback, like the ring tests; passes trivially
+ * where io_uring is unavailable. */
+ALW_TEST(uring_reactor_serves_pipelined_requests)
+{
+    IoUringIoApi api;
+    if (!io::uring_supported(api)) { return; }
+
+    char dir[] = "/tmp/alewa-uring-XXXXXX";
+    ALW_EXPECT_EQ(::mkdtemp(dir) != nullptr, true);
+    std::string const body(100'000, 'b');  /* more than one socket buffer */
+    std::ofstream{std::string{dir} + "/big.txt"} << body;
+
+    ServerConfig config;
+    config.docroot = dir;
+    config.uring_entries = 64;
+    config.uring_buffers = 64;
+    Listeners<IoUringIoApi> listeners;
+    listeners.main.emplace(create_listener(api, "18611", false));
+    listeners.main->listen(16);
+    UringReactor<IoUringIoApi> reactor{api, config, std::move(listeners)};
+
+    int const client = connect_loopback(18611);
+    ALW_EXPECT_EQ(client >= 0, true);
+
+    std::string const request = "GET /big.txt HTTP/1.1\r\n\r\n"
+                                "GET /missing HTTP/1.1\r\n\r\n"
+                                "HEAD /big.txt HTTP/1.1\r\n"
+                                "Connection: close\r\n\r\n";
+    ALW_EXPECT_EQ(api.write(client, request.data(), request.size()),
+                  static_cast<long>(request.size()));
+
+    /* the reactor and the client take turns until the server hangs up */
+    std::string response;
+    for (int turn = 0; turn < 1000; ++turn) {
+        reactor.run_once();
+        char chunk[65536];
+        auto const n = ::recv(client, chunk, sizeof(chunk), MSG_DONTWAIT);
+        if (n == 0) { break; }
+        if (n > 0) { response.append(chunk, static_cast<std::size_t>(n)); }
+    }
+    api.close(client);
+    std::remove((std::string{dir} + "/big.txt").c_str());
+    ::rmdir(dir);
+
+    std::size_t const second = response.find("HTTP/1.1 404");
+    ALW_EXPECT_EQ(response.starts_with("HTTP/1.1 200 OK\r\n"), true);
+    ALW_EXPECT_EQ(second != response.npos, true);
+    ALW_EXPECT_EQ(response.find("\r\n\r\n" + body + "HTTP/1.1 404")
+                          != response.npos,
+                  true);
+    ALW_EXPECT_EQ(response.find("Connection: close", second)
+                          != response.npos,
+                  true);
+    ALW_EXPECT_EQ(response.ends_with("\r\n\r\n"), true);  /* HEAD: no body */
+}
+
+}  // namespace alewa::test
@@ -0,0 +1 @@
+#include "work_deque.hpp"
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <bit>
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+
+namespace alewa {
+
+/* A bounded Chase-Lev work-stealing deque, with the memory orders of Lê et
+ * al., "Correct and Efficient Work-Stealing for Weak Memory Models": its
+ * owner pushes and pops at the bottom, last in first out, while any other
+ * thread may steal from the top, oldest first. Only a pop of the last item
+ * or a steal costs a compare-and-swap. Capacity is rounded up to a power
+ * of 2, and a push to a full deque fails rather than growing it. */
+template <typename V>
+    requires std::is_trivially_copyable_v<V>
+class WorkDeque
+{
+private:
+    std::size_t mask;
+    std::unique_ptr<std::atomic<V>[]> items;
+    alignas(64) std::atomic<std::int64_t> top{0};
+    alignas(64) std::atomic<std::int64_t> bottom{0};
+
+public:
+    explicit WorkDeque(std::size_t capacity)
+            : mask(std::bit_ceil(std::max<std::size_t>(capacity, 1)) - 1),
+              items(std::make_unique<std::atomic<V>[]>(mask + 1)) {}
+
+    WorkDeque(WorkDeque&) = delete;
+    WorkDeque& operator=(WorkDeque&) = delete;
+
+    [[nodiscard]]
+    auto capacity() const noexcept -> std::size_t { return mask + 1; }
+
+    /* Owner only. False if the deque is full. */
+    auto push(V value) noexcept -> bool
+    {
+        std::int64_t const b = bottom.load(std::memory_order_relaxed);
+        std::int64_t const t = top.load(std::memory_order_acquire);
+        if (static_cast<std::size_t>(b - t) > mask) { return false; }
+        slot(b).store(value, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /* Owner only: the item pushed last. False if there is none, or a thief
+     * took the last one first. */
+    auto pop(V& value) noexcept -> bool
+    {
+        std::int64_t const b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        value = slot(b).load(std::memory_order_relaxed);
+        if (t < b) { return true; }
+
+        /* the last item: race the thieves for it */
+        bool const won = top.compare_exchange_strong(
+                t, t + 1, std::memory_order_seq_cst,
+                std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return won;
+    }
+
+    /* Any thread: the item pushed first. False if there is none, or another
+     * thread took it first. */
+    auto steal(V& value) noexcept -> bool
+    {
+        std::int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t const b = bottom.load(std::memory_order_acquire);
+        if (t >= b) { return false; }
+        V const taken = slot(t).load(std::memory_order_relaxed);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                         std::memory_order_relaxed)) {
+            return false;
+        }
+        value = taken;
+        return true;
+    }
+
+    /* A snapshot from any thread, which may be stale by the time it is
+     * used. */
+    [[nodiscard]]
+    auto size() const noexcept -> std::size_t
+    {
+        std::int64_t const t = top.load(std::memory_order_acquire);
+        std::int64_t const b = bottom.load(std::memory_order_acquire);
+        return b > t ? static_cast<std::size_t>(b - t) : 0;
+    }
+
+private:
+    auto slot(std::int64_t i) const noexcept -> std::atomic<V>&
+    {
+        return items[static_cast<std::size_t>(i) & mask];
+    }
+};
+
+}  // namespace alewa
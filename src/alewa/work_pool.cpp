@@ -0,0 +1,143 @@
+#include "work_pool.hpp"
+
+#include <algorithm>
+
+namespace alewa {
+
+namespace {
+
+/* The pool and worker the calling thread belongs to, if any. */
+struct Current
+{
+    WorkPool const * pool = nullptr;
+    std::size_t worker = 0;
+};
+
+thread_local Current current{};
+
+}  // namespace
+
+WorkPool::WorkPool(unsigned nworkers, std::size_t capacity)
+{
+    nworkers = std::max(nworkers, 1u);
+    workers.reserve(nworkers);
+    for (unsigned i = 0; i < nworkers; ++i) {
+        workers.push_back(std::make_unique<Worker>(capacity));
+    }
+    try {
+        for (std::size_t i = 0; i < workers.size(); ++i) {
+            workers[i]->thread = std::thread{[this, i] { work(i); }};
+        }
+    }
+    catch (...) {
+        join();
+        throw;
+    }
+}
+
+WorkPool::~WorkPool() { join(); }
+
+void WorkPool::join() noexcept
+{
+    {
+        std::lock_guard const guard{lock};
+        stopping = true;
+    }
+    idle.notify_all();
+    for (auto& worker : workers) {
+        if (worker->thread.joinable()) { worker->thread.join(); }
+    }
+}
+
+auto WorkPool::submit(Job& job) -> bool
+{
+    /* counted before it can be found, see work() */
+    std::size_t const depth = queued.fetch_add(1) + 1;
+    if (!place(job)) {
+        queued.fetch_sub(1);
+        rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    submitted.fetch_add(1, std::memory_order_relaxed);
+    std::size_t seen = peak.load(std::memory_order_relaxed);
+    while (depth > seen
+           && !peak.compare_exchange_weak(seen, depth,
+                                          std::memory_order_relaxed)) {}
+
+    /* pairs with the sleeper counting itself before it checks queued, so
+     * one of the two sees the other */
+    if (sleeping.load() > 0) {
+        std::lock_guard const guard{lock};
+        idle.notify_one();
+    }
+    return true;
+}
+
+/* A worker's own jobs go to its deque; the rest, and those that find it
+ * full, to the first inbox with room, starting from the next in turn. */
+auto WorkPool::place(Job& job) noexcept -> bool
+{
+    if (current.pool == this && workers[current.worker]->deque.push(&job)) {
+        return true;
+    }
+    std::size_t const first = next.fetch_add(1, std::memory_order_relaxed);
+    for (std::size_t i = 0; i < workers.size(); ++i) {
+        if (workers[(first + i) % workers.size()]->inbox.push(&job)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+auto WorkPool::stats() const noexcept -> Stats
+{
+    auto constexpr relaxed = std::memory_order_relaxed;
+    return {
+        .workers = workers.size(),
+        .submitted = submitted.load(relaxed),
+        .executed = executed.load(relaxed),
+        .rejected = rejected.load(relaxed),
+        .stolen = stolen.load(relaxed),
+        .queued = queued.load(relaxed),
+        .peak = peak.load(relaxed),
+    };
+}
+
+void WorkPool::work(std::size_t self)
+{
+    current = {this, self};
+    for (;;) {
+        if (Job* job = find(self)) {
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            job->run(*job);
+            executed.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        /* queued counts a job before it can be found, so a worker that sees
+         * it non-zero tries again instead of sleeping */
+        std::unique_lock guard{lock};
+        sleeping.fetch_add(1);
+        idle.wait(guard, [this] { return stopping || queued.load() > 0; });
+        sleeping.fetch_sub(1);
+        if (stopping && queued.load() == 0) { return; }
+    }
+}
+
+auto WorkPool::find(std::size_t self) -> Job*
+{
+    Job* job = nullptr;
+    if (workers[self]->deque.pop(job) || workers[self]->inbox.pop(job)) {
+        return job;
+    }
+    for (std::size_t i = 1; i < workers.size(); ++i) {
+        Worker& victim = *workers[(self + i) % workers.size()];
+        if (victim.deque.steal(job) || victim.inbox.pop(job)) {
+            stolen.fetch_add(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+}  // namespace alewa
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <condition_variable>
+
+#include "mpmc_queue.hpp"
+#include "work_deque.hpp"
+
+namespace alewa {
+
+/* Worker threads for the blocking or CPU-heavy work a reactor must not do
+ * on its own thread. Each worker has a WorkDeque for the jobs it submits
+ * itself and a bounded inbox for those from other threads, which spread
+ * them round-robin over the workers' inboxes. A worker runs its own deque
+ * newest first, then its inbox, and when both are empty steals from the
+ * other workers' deques and inboxes. Idle workers sleep until there is
+ * work. Every queue is bounded, so a pool that is falling behind refuses
+ * jobs rather than queueing them without end, and the submitter runs or
+ * sheds them itself. Jobs are intrusive: the submitter owns each one and
+ * must keep it alive until it has run, which is how a Loop's offload()
+ * posts a task back to its reactor. Jobs still queued when the pool goes
+ * are run before its workers are joined. */
+class WorkPool
+{
+public:
+    struct Job
+    {
+        void (*run)(Job&) noexcept;
+    };
+
+    struct Stats
+    {
+        std::size_t workers = 0;
+        std::uint64_t submitted = 0;
+        std::uint64_t executed = 0;
+        std::uint64_t rejected = 0;  /* refused, every queue being full */
+        std::uint64_t stolen = 0;  /* taken from another worker's queues */
+        std::size_t queued = 0;    /* submitted and not started yet */
+        std::size_t peak = 0;      /* the most ever queued at once */
+    };
+
+private:
+    struct alignas(64) Worker
+    {
+        WorkDeque<Job*> deque;  /* submitted by this worker */
+        MpmcQueue<Job*> inbox;  /* submitted from other threads */
+        std::thread thread{};
+
+        explicit Worker(std::size_t capacity)
+                : deque(capacity), inbox(capacity) {}
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::mutex lock;
+    std::condition_variable idle;
+    bool stopping = false;  /* under lock */
+
+    alignas(64) std::atomic<std::size_t> queued{0};
+    std::atomic<std::size_t> sleeping{0};
+    std::atomic<std::size_t> peak{0};
+    std::atomic<std::size_t> next{0};  /* the inbox to try first */
+    std::atomic<std::uint64_t> submitted{0};
+    std::atomic<std::uint64_t> executed{0};
+    std::atomic<std::uint64_t> rejected{0};
+    std::atomic<std::uint64_t> stolen{0};
+
+public:
+    /* `nworkers` threads, at least one, each with a deque and an inbox of
+     * `capacity` jobs. */
+    WorkPool(unsigned nworkers, std::size_t capacity);
+    ~WorkPool();
+
+    WorkPool(WorkPool&) = delete;
+    WorkPool& operator=(WorkPool&) = delete;
+
+    /* Thread-safe: run job.run(job) on some worker, soon. False, with the
+     * job left to the caller, if every queue it could go to is full. */
+    [[nodiscard]]
+    auto submit(Job& job) -> bool;
+
+    [[nodiscard]]
+    auto size() const noexcept -> std::size_t { return workers.size(); }
+
+    /* Thread-safe; a snapshot of counters that keep moving. */
+    [[nodiscard]]
+    auto stats() const noexcept -> Stats;
+
+private:
+    void join() noexcept;
+
+    auto place(Job& job) noexcept -> bool;
+
+    void work(std::size_t self);
+
+    auto find(std::size_t self) -> Job*;
+};
+
+}  // namespace alewa
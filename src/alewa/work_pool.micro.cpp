@@ -0,0 +1,70 @@
+#include "bench/micro.hpp"
+
+#include <atomic>
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <cstdint>
+
+#include "work_pool.hpp"
+
+namespace alewa::bench {
+
+namespace {
+
+/* A job of about `spin` iterations of arithmetic, counted when done. */
+struct Spin : WorkPool::Job
+{
+    std::atomic<std::size_t>* done = nullptr;
+    std::uint64_t spin = 0;
+
+    static void execute(WorkPool::Job& job) noexcept
+    {
+        auto& self = static_cast<Spin&>(job);
+        std::uint64_t x = self.spin;
+        for (std::uint64_t i = 0; i < self.spin; ++i) {
+            x = x * 6364136223846793005u + 1442695040888963407u;
+        }
+        keep(x);
+        self.done->fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+/* state.size jobs of `spin` each, submitted as fast as one thread can from
+ * outside the pool, as reactors do, with a worker per CPU. */
+void saturate(State& state, std::uint64_t spin)
+{
+    unsigned const cpus = std::max(std::thread::hardware_concurrency(), 1u);
+    WorkPool pool{cpus, 1024};
+    std::atomic<std::size_t> done{0};
+    std::vector<Spin> jobs(state.size);
+    for (Spin& job : jobs) {
+        job = Spin{{&Spin::execute}, &done, spin};
+    }
+    state.time(jobs.size(), [&] {
+        for (Spin& job : jobs) {
+            while (!pool.submit(job)) { std::this_thread::yield(); }
+        }
+        while (done.load(std::memory_order_relaxed) < jobs.size()) {
+            std::this_thread::yield();
+        }
+    });
+}
+
+}  // namespace
+
+/* The pool's own overhead per job: submission, the inboxes, waking and
+ * stealing, with next to nothing to run. */
+ALW_BENCH(work_pool_saturate_empty_jobs)
+{
+    saturate(state, 0);
+}
+
+/* Jobs of a few microseconds, about what a small compression or a blocking
+ * stat costs, for the throughput of a pool kept saturated. */
+ALW_BENCH(work_pool_saturate_small_jobs)
+{
+    saturate(state, 2'000);
+}
+
+}  // namespace alewa::bench
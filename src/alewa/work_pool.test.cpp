@@ -0,0 +1,200 @@
+#include "test/test_utils.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "work_deque.hpp"
+#include "work_pool.hpp"
+
+namespace alewa::test {
+
+namespace {
+
+/* Counts itself and, while depth lasts, submits two more from the worker
+ * running it, which the other workers can only steal, running itself
+ * those the pool has no room for. */
+struct Split : WorkPool::Job
+{
+    WorkPool* pool;
+    std::atomic<std::size_t>* ran;
+    std::vector<Split>* jobs;
+    std::size_t index;
+
+    static void execute(WorkPool::Job& job) noexcept
+    {
+        auto& self = static_cast<Split&>(job);
+        self.ran->fetch_add(1);
+        for (std::size_t child : {2 * self.index + 1, 2 * self.index + 2}) {
+            if (child < self.jobs->size()
+                && !self.pool->submit((*self.jobs)[child])) {
+                execute((*self.jobs)[child]);
+            }
+        }
+    }
+};
+
+}  // namespace
+
+ALW_TEST(work_deque_owner_lifo_thieves_fifo)
+{
+    WorkDeque<int> deque{3};  /* rounded up to 4 */
+    ALW_EXPECT_EQ(deque.capacity(), 4ul);
+
+    int value = 0;
+    ALW_EXPECT_EQ(deque.pop(value), false);
+    ALW_EXPECT_EQ(deque.steal(value), false);
+    for (int i = 1; i <= 4; ++i) { ALW_EXPECT_EQ(deque.push(i), true); }
+    ALW_EXPECT_EQ(deque.push(5), false);
+    ALW_EXPECT_EQ(deque.size(), 4ul);
+
+    ALW_EXPECT_EQ(deque.pop(value), true);
+    ALW_EXPECT_EQ(value, 4);
+    ALW_EXPECT_EQ(deque.steal(value), true);
+    ALW_EXPECT_EQ(value, 1);
+    ALW_EXPECT_EQ(deque.push(6), true);
+    ALW_EXPECT_EQ(deque.steal(value), true);
+    ALW_EXPECT_EQ(value, 2);
+    ALW_EXPECT_EQ(deque.pop(value), true);
+    ALW_EXPECT_EQ(value, 6);
+    ALW_EXPECT_EQ(deque.pop(value), true);
+    ALW_EXPECT_EQ(value, 3);
+    ALW_EXPECT_EQ(deque.pop(value), false);
+    ALW_EXPECT_EQ(deque.size(), 0ul);
+}
+
+ALW_TEST(work_deque_every_item_taken_once_under_theft)
+{
+    WorkDeque<std::uint32_t> deque{64};
+    std::uint32_t const n = 100'000;
+    std::atomic<bool> done{false};
+    std::atomic<std::uint64_t> stolen_sum{0};
+    std::atomic<std::uint32_t> stolen{0};
+
+    auto thief = [&] {
+        std::uint32_t value;
+        while (!done.load() || deque.size() > 0) {
+            if (deque.steal(value)) {
+                stolen_sum.fetch_add(value);
+                stolen.fetch_add(1);
+            }
+            else { std::this_thread::yield(); }
+        }
+    };
+    std::thread first{thief};
+    std::thread second{thief};
+
+    std::uint64_t popped_sum = 0;
+    std::uint32_t popped = 0;
+    std::uint32_t value;
+    for (std::uint32_t i = 1; i <= n;) {
+        if (deque.push(i)) { ++i; }
+        /* the owner works through its own, newest first, every so often */
+        if (i % 3 == 0 || deque.size() == deque.capacity()) {
+            if (deque.pop(value)) {
+                popped_sum += value;
+                ++popped;
+            }
+        }
+    }
+    while (deque.pop(value)) {
+        popped_sum += value;
+        ++popped;
+    }
+    done.store(true);
+    first.join();
+    second.join();
+
+    ALW_EXPECT_EQ(popped + stolen.load(), n);
+    ALW_EXPECT_EQ(popped_sum + stolen_sum.load(),
+                  std::uint64_t{n} * (n + 1) / 2);
+}
+
+ALW_TEST(work_pool_runs_jobs_submitted_from_anywhere)
+{
+    std::atomic<std::size_t> ran{0};
+    std::vector<Split> jobs(1023);
+    {
+        WorkPool pool{3, 8};  /* small deques, so some spill over */
+        for (std::size_t i = 0; i < jobs.size(); ++i) {
+            jobs[i] = Split{{&Split::execute}, &pool, &ran, &jobs, i};
+        }
+        /* the rest follow from the workers */
+        ALW_EXPECT_EQ(pool.submit(jobs[0]), true);
+        while (ran.load() < jobs.size()) { std::this_thread::yield(); }
+
+        auto const stats = pool.stats();
+        ALW_EXPECT_EQ(stats.workers, 3ul);
+        ALW_EXPECT_EQ(stats.submitted + stats.rejected,
+                      std::uint64_t{jobs.size()});
+        ALW_EXPECT_EQ(stats.queued, 0ul);
+        ALW_EXPECT_EQ(stats.peak >= 1, true);
+    }
+    ALW_EXPECT_EQ(ran.load(), jobs.size());
+
+    /* jobs still queued when the pool goes are run first */
+    ran.store(0);
+    std::vector<Split> flat(100);
+    {
+        WorkPool pool{1, 4};
+        for (std::size_t i = 0; i < flat.size(); ++i) {
+            flat[i] = Split{{&Split::execute}, &pool, &ran, &flat,
+                            flat.size()};  /* no children */
+            if (!pool.submit(flat[i])) { Split::execute(flat[i]); }
+        }
+    }
+    ALW_EXPECT_EQ(ran.load(), flat.size());
+}
+
+/* Jobs from outside the pool fill the workers' inboxes and no more; the
+ * rest are refused, for the caller to run or shed. */
+ALW_TEST(work_pool_refuses_jobs_when_full)
+{
+    struct Gate : WorkPool::Job
+    {
+        std::atomic<bool> started{false};
+        std::atomic<bool> open{false};
+
+        static void execute(WorkPool::Job& job) noexcept
+        {
+            auto& self = static_cast<Gate&>(job);
+            self.started.store(true);
+            while (!self.open.load()) { std::this_thread::yield(); }
+        }
+    };
+
+    std::atomic<std::size_t> ran{0};
+    std::vector<Split> more(6);
+    Gate first{{&Gate::execute}};
+    Gate second{{&Gate::execute}};
+    bool gated = false;
+    std::size_t accepted = 0;
+    WorkPool::Stats stats;
+    {
+        WorkPool pool{2, 2};
+        gated = pool.submit(first) && pool.submit(second);
+        /* both workers held, so nothing leaves the inboxes */
+        while (gated && !(first.started.load() && second.started.load())) {
+            std::this_thread::yield();
+        }
+        for (std::size_t i = 0; i < more.size(); ++i) {
+            more[i] = Split{{&Split::execute}, &pool, &ran, &more,
+                            more.size()};
+            if (pool.submit(more[i])) { ++accepted; }
+        }
+        stats = pool.stats();
+        first.open.store(true);
+        second.open.store(true);
+    }
+
+    ALW_EXPECT_EQ(gated, true);
+    ALW_EXPECT_EQ(accepted, 4ul);
+    ALW_EXPECT_EQ(stats.rejected, 2ul);
+    ALW_EXPECT_EQ(stats.queued, 4ul);
+    ALW_EXPECT_EQ(stats.peak, 4ul);
+    ALW_EXPECT_EQ(ran.load(), 4ul);
+}
+
+}  // namespace alewa::test